@@ -50,7 +50,7 @@ void LongUI::UIXmlRich::SetSelectionColor() noexcept {
 template<typename T>
 void LongUI::UIXmlRich::set_selection_helper(T call) noexcept {
     LongUI::CUIDxgiAutoLocker locker;
-    if (const auto layout = m_text.RefLayout()) {
+    if (const auto layout = m_text.RefLayout().RefSingleLayout()) {
         auto range = m_text.GetSelectionRange();
         if (range.length) {
             call(range, layout);
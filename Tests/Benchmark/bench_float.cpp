@@ -0,0 +1,85 @@
+﻿#include "lui_bench.h"
+#include <luibase.h>
+#include <luiconf.h>
+#include <Platless/luiPlUtil.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // old path: copy each token into buffer then AtoF, separators only
+    static auto legacy_floats(const char*& itr, const char* end, float out[], uint32_t count) noexcept -> uint32_t {
+        uint32_t i = 0;
+        while (i < count) {
+            while (itr != end && (*itr == ' ' || *itr == ',' || *itr == '\r' || *itr == '\n')) ++itr;
+            if (itr == end) break;
+            char buf[64]; uint32_t len = 0;
+            while (itr != end && *itr != ' ' && *itr != ',' && *itr != '\r' && *itr != '\n' && len < 63) {
+                buf[len++] = *itr++;
+            }
+            buf[len] = 0;
+            out[i++] = LongUI::AtoF(buf);
+        }
+        return i;
+    }
+    // std::strtof, skip separators manually
+    static auto strtof_floats(const char*& itr, const char* end, float out[], uint32_t count) noexcept -> uint32_t {
+        uint32_t i = 0;
+        for (; i < count; ++i) {
+            while (itr != end && (*itr == ' ' || *itr == ',' || *itr == '\r' || *itr == '\n')) ++itr;
+            char* next = nullptr;
+            out[i] = std::strtof(itr, &next);
+            if (next == itr) break;
+            itr = next;
+        }
+        return i;
+    }
+    // mixed-token corpus: svg-ish coords, exponents, ints, comma and space
+    static auto make_corpus(uint32_t count) noexcept -> std::string {
+        static const char* const TOKENS[] = {
+            "12.5", "-0.75", "3", "1e-3", "100", "-42.125", ".5", "6.02E2",
+            "0", "255", "-1", "0.333333", "1024.0625", "7e1", "-8.5e-2", "90",
+        };
+        const char* const SEPS[] = { " ", ",", ", ", "\n" };
+        std::string corpus;
+        corpus.reserve(count * 8);
+        uint32_t seed = 1;
+        for (uint32_t i = 0; i != count; ++i) {
+            seed = seed * 1103515245u + 12345u;
+            corpus += TOKENS[(seed >> 16) & 15];
+            corpus += SEPS[(seed >> 8) & 3];
+        }
+        return corpus;
+    }
+    // run parser over corpus rounds times, 8 floats each call
+    template<typename Func>
+    static void bench_parser(const char* what, Func func, const std::string& corpus, uint32_t rounds) noexcept {
+        using namespace Bench;
+        const auto begin = corpus.c_str();
+        const auto end = begin + corpus.size();
+        float out[8];
+        double total = 0.0, sum = 0.0;
+        Stopwatch sw;
+        for (uint32_t r = 0; r != rounds; ++r) {
+            const char* itr = begin;
+            while (itr != end) {
+                const auto n = func(itr, end, out, 8);
+                if (!n) break;
+                total += n; sum += out[0];
+            }
+        }
+        Report(what, sw.Ms(), total, "float");
+        Sink(uint64_t(sum));
+    }
+}}
+
+// 100k mixed tokens, 20 rounds
+LUI_BENCH(parse_floats) {
+    using namespace LongUI;
+    const auto corpus = impl::make_corpus(100000);
+    std::printf("  %u bytes, 100000 tokens x 20\n", uint32_t(corpus.size()));
+    impl::bench_parser("ParseFloats", LongUI::ParseFloats, corpus, 20);
+    impl::bench_parser("copy + AtoF (old)", impl::legacy_floats, corpus, 20);
+    impl::bench_parser("std::strtof", impl::strtof_floats, corpus, 20);
+}
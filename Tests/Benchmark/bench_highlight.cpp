@@ -0,0 +1,76 @@
+﻿#include "lui_bench.h"
+#include <luibase.h>
+#include <luiconf.h>
+#include <Platless/luiPlUtil.h>
+#include <Platless/luiPlToken.h>
+#include <cstdio>
+#include <string>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // make xml document of bytes in utf-16
+    static void make_xml(std::wstring& text, size_t bytes) noexcept {
+        const wchar_t item[] =
+            L"  <item id=\"42\" name='widget' enabled=\"true\">\n"
+            L"    <!-- comment line -->\n"
+            L"    <value>3.14 &amp; 2.72</value>\n"
+            L"  </item>\n";
+        const auto count = bytes / sizeof(wchar_t);
+        text.clear();
+        text.reserve(count);
+        text += L"<?xml version=\"1.0\"?>\n<root>\n";
+        while (text.size() + 256 < count) text += item;
+        text += L"</root>\n";
+    }
+    // edit text, line index and highlighter together
+    static void edit(CUIPieceTable& table, CUILineIndex& lines, CUIHighlighter& hl, 
+        uint32_t pos, uint32_t removed, const wchar_t* str, uint32_t inserted) noexcept {
+        if (removed) table.Remove(pos, removed);
+        if (inserted) table.Insert(pos, str, inserted);
+        lines.Update(table, pos, removed, inserted);
+        uint32_t begin, end;
+        hl.Update(table, lines, pos, removed, inserted, begin, end);
+        Bench::Sink(end - begin);
+    }
+    // benchmark highlighting xml of bytes
+    static void bench_highlight(size_t bytes) noexcept {
+        using namespace LongUI::Bench;
+        enum : uint32_t { KEY_OPS = 10 * 1000, CDATA_OPS = 20 };
+        char name[64];
+        std::wstring text;
+        make_xml(text, bytes);
+        const auto mb = uint32_t(bytes >> 20);
+        CUIPieceTable table;
+        CUILineIndex lines;
+        CUIXmlTokenizer tokenizer;
+        CUIHighlighter hl;
+        table.Set(text.c_str(), uint32_t(text.size()));
+        lines.Build(table);
+        hl.SetTokenizer(&tokenizer);
+        // 全文分词
+        Stopwatch sw;
+        hl.Build(table, lines);
+        std::snprintf(name, sizeof(name), "highlight build %uMB", mb);
+        ReportMBps(name, sw.Ms(), double(table.GetLength()) * sizeof(wchar_t));
+        Sink(hl.RefRuns().GetCount());
+        // 文档中部文本节点内输入, 状态立即收敛
+        const auto middle = uint32_t(text.find(L"<value>", text.size() / 2) + 7);
+        sw.Restart();
+        for (uint32_t i = 0; i != KEY_OPS; ++i) edit(table, lines, hl, middle + i, 0, L"x", 1);
+        for (uint32_t i = 0; i != KEY_OPS; ++i) edit(table, lines, hl, middle + KEY_OPS - 1 - i, 1, nullptr, 0);
+        std::snprintf(name, sizeof(name), "highlight type+backspace in text %uMB", mb);
+        Report(name, sw.Ms(), KEY_OPS * 2., "key");
+        // 文档中部打开未闭合的CDATA, 之后全部重新分词
+        sw.Restart();
+        for (uint32_t i = 0; i != CDATA_OPS; ++i) {
+            edit(table, lines, hl, middle, 0, L"<![CDATA[", 9);
+            edit(table, lines, hl, middle, 9, nullptr, 0);
+        }
+        std::snprintf(name, sizeof(name), "highlight open+close cdata %uMB", mb);
+        Report(name, sw.Ms(), CDATA_OPS * 2., "edit");
+        Sink(hl.RefRuns().GetCount());
+    }
+}}
+
+// highlight 5MB xml
+LUI_BENCH(highlight_5mb) { LongUI::impl::bench_highlight(5 << 20); }
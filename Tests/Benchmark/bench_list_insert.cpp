@@ -0,0 +1,85 @@
+﻿#include "lui_bench.h"
+#include "LongUI.h"
+#include <cstdio>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // list with 2-column line template
+    static const char* const LIST_XML =
+        "<Window><List name=\"lst\" linetemplate=\"Text, Text\"/></Window>";
+    // create window and find the list
+    static auto create_list(XUIBaseWindow*& window) noexcept -> UIList* {
+        window = UIManager.CreateUIWindow(LIST_XML);
+        if (!window) { std::printf("  failed to create window\n"); return nullptr; }
+        const auto list = longui_cast<UIList*>(window->FindControl("lst"));
+        if (!list) { std::printf("  failed to find list\n"); window->Dispose(); window = nullptr; }
+        return list;
+    }
+    // fill 2 columns of line
+    static void fill_line(UIListLine* line) noexcept {
+        auto itr = line->begin();
+        (*itr)->SetText(L"name"); ++itr;
+        (*itr)->SetText(L"value");
+    }
+    // benchmark pushing count rows: per-row vs batch
+    static void bench_push(uint32_t count) noexcept {
+        using namespace Bench;
+        XUIBaseWindow* window = nullptr;
+        const auto list = impl::create_list(window);
+        if (!list) return;
+        // 旧路径: 逐行添加
+        Stopwatch sw;
+        for (uint32_t i = 0; i != count; ++i) {
+            list->PushLineElement(L"name", L"value");
+        }
+        Report("PushLineElement (per-row)", sw.Ms(), double(count), "row");
+        Sink(list->GetRowCount());
+        list->ClearList();
+        // 批量添加
+        sw.Restart();
+        list->PushLines(count, [](UIListLine* line, uint32_t) noexcept { impl::fill_line(line); });
+        Report("PushLines (batch)", sw.Ms(), double(count), "row");
+        Sink(list->GetRowCount());
+        window->Dispose();
+    }
+    // benchmark inserting count rows at front of base rows with selection
+    static void bench_insert_front(uint32_t base, uint32_t count) noexcept {
+        using namespace Bench;
+        XUIBaseWindow* window = nullptr;
+        const auto list = impl::create_list(window);
+        if (!list) return;
+        list->PushLines(base, [](UIListLine* line, uint32_t) noexcept { impl::fill_line(line); });
+        // 间隔多选, 插入时选择整体后移
+        list->list_flag = UIList::UIListFlag(list->list_flag | UIList::Flag_MultiSelect);
+        for (uint32_t i = 0; i < base; i += 64) list->SelectChild(i, false);
+        // 旧路径: 逐行插入
+        Stopwatch sw;
+        for (uint32_t i = 0; i != count; ++i) {
+            list->InsertLineElement(0, L"name", L"value");
+        }
+        Report("InsertLineElement (per-row, front)", sw.Ms(), double(count), "row");
+        // 批量插入
+        sw.Restart();
+        list->InsertLines(0, count, [](UIListLine* line, uint32_t) noexcept { impl::fill_line(line); });
+        Report("InsertLines (batch, front)", sw.Ms(), double(count), "row");
+        Sink(list->GetRowCount());
+        window->Dispose();
+    }
+}}
+
+// 100k rows: per-row vs batch
+LUI_BENCH(list_insert_100k) {
+    using namespace LongUI;
+    ::OleInitialize(nullptr);
+    if (FAILED(UIManager.Initialize())) {
+        std::printf("  failed to initialize UIManager\n");
+        ::OleUninitialize();
+        return;
+    }
+    std::printf("  push 100k rows\n");
+    impl::bench_push(100000);
+    std::printf("  insert 1k rows at front of 100k rows\n");
+    impl::bench_insert_front(100000, 1000);
+    UIManager.Uninitialize();
+    ::OleUninitialize();
+}
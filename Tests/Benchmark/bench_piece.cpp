@@ -0,0 +1,72 @@
+﻿#include "lui_bench.h"
+#include <luibase.h>
+#include <luiconf.h>
+#include <Platless/luiPlUtil.h>
+#include <Platless/luiPlPiece.h>
+#include <cstdio>
+#include <string>
+#include <random>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // make log-like text of bytes in utf-16
+    static void make_text(std::wstring& text, size_t bytes) noexcept {
+        const wchar_t line[] = L"2016-01-01 00:00:00 [info] request handled in 12 ms\n";
+        const auto count = bytes / sizeof(wchar_t);
+        text.clear();
+        text.reserve(count);
+        while (text.size() + 64 < count) text += line;
+        text.resize(count, L'.');
+    }
+    // benchmark editing text of bytes
+    static void bench_piece(size_t bytes) noexcept {
+        using namespace LongUI::Bench;
+        enum : uint32_t { PIECE_OPS = 100 * 1000, STRING_OPS = 200 };
+        char name[64];
+        std::wstring text;
+        make_text(text, bytes);
+        const auto mb = uint32_t(bytes >> 20);
+        // 载入
+        CUIPieceTable table;
+        Stopwatch sw;
+        table.Set(text.c_str(), uint32_t(text.size()));
+        std::snprintf(name, sizeof(name), "piece set %uMB", mb);
+        ReportMBps(name, sw.Ms(), double(bytes));
+        // 文档开头连续输入再退格
+        sw.Restart();
+        for (uint32_t i = 0; i != PIECE_OPS; ++i) table.Insert(16 + i, L"x", 1);
+        for (uint32_t i = 0; i != PIECE_OPS; ++i) table.Remove(16 + PIECE_OPS - 1 - i, 1);
+        std::snprintf(name, sizeof(name), "piece type+backspace at head %uMB", mb);
+        Report(name, sw.Ms(), PIECE_OPS * 2., "key");
+        // 随机位置编辑
+        std::mt19937 rng(mb);
+        sw.Restart();
+        for (uint32_t i = 0; i != PIECE_OPS; ++i) {
+            const auto pos = uint32_t(rng() % table.GetLength());
+            if (i & 1) table.Remove(pos, 1 + rng() % 8);
+            else table.Insert(pos, L"hello", 5);
+        }
+        std::snprintf(name, sizeof(name), "piece random edit %uMB", mb);
+        Report(name, sw.Ms(), PIECE_OPS, "edit");
+        Sink(table.GetPieceCount());
+        // 连续视图
+        sw.Restart();
+        Sink(table.c_str()[0]);
+        std::snprintf(name, sizeof(name), "piece contiguous view %uMB", mb);
+        ReportMBps(name, sw.Ms(), double(table.GetLength()) * sizeof(wchar_t));
+        // 对比: 连续字符串, 每次编辑移动尾部
+        sw.Restart();
+        for (uint32_t i = 0; i != STRING_OPS; ++i) text.insert(16 + i, 1, L'x');
+        for (uint32_t i = 0; i != STRING_OPS; ++i) text.erase(16 + STRING_OPS - 1 - i, 1);
+        std::snprintf(name, sizeof(name), "contiguous type+backspace at head %uMB", mb);
+        Report(name, sw.Ms(), STRING_OPS * 2., "key");
+        Sink(text.size());
+    }
+}}
+
+// edit 1MB text
+LUI_BENCH(piece_1mb) { LongUI::impl::bench_piece(1 << 20); }
+// edit 10MB text
+LUI_BENCH(piece_10mb) { LongUI::impl::bench_piece(10 << 20); }
+// edit 100MB text
+LUI_BENCH(piece_100mb) { LongUI::impl::bench_piece(100 << 20); }
@@ -0,0 +1,110 @@
+﻿#include "lui_bench.h"
+#include <luibase.h>
+#include <luiconf.h>
+#include <Platless/luiPlUtil.h>
+#include <Platless/luiPlSort.h>
+#include <algorithm>
+#include <cstdio>
+#include <cwchar>
+#include <string>
+#include <thread>
+#include <vector>
+#include <random>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // make random row texts, few distinct prefixes to stress tie-breaking
+    static void make_rows(std::vector<std::wstring>& rows, uint32_t count) noexcept {
+        std::mt19937 rng(count);
+        rows.resize(count);
+        wchar_t buf[32];
+        for (auto& row : rows) {
+            const auto len = 4 + rng() % 12;
+            for (uint32_t i = 0; i != len; ++i) buf[i] = wchar_t(L'a' + rng() % (i < 2 ? 4 : 26));
+            buf[len] = 0;
+            row = buf;
+        }
+    }
+    // parallel stable merge sort, same scheme as UIList uses
+    static void parallel_sort(const StringSortKey keys[], uint32_t index[], uint32_t tmp[], uint32_t count) noexcept {
+        enum : uint32_t { TASK = 4 };
+        const auto chunk = (count + TASK - 1) / TASK;
+        std::thread threads[TASK];
+        for (uint32_t i = 0; i != TASK; ++i) {
+            const auto start = i * chunk;
+            const auto n = std::min(chunk, count - start);
+            threads[i] = std::thread([=]() noexcept { LongUI::MergeSortIndex(keys, index + start, tmp + start, n); });
+        }
+        for (auto& t : threads) t.join();
+        auto src = index, des = tmp;
+        for (auto width = chunk; width < count; width *= 2) {
+            for (uint32_t bn = 0; bn < count; bn += width * 2) {
+                const auto mid = std::min(bn + width, count);
+                const auto ed = std::min(bn + width * 2, count);
+                LongUI::MergeIndex(keys, src + bn, mid - bn, src + mid, ed - mid, des + bn);
+            }
+            std::swap(src, des);
+        }
+        if (src != index) std::copy(src, src + count, index);
+    }
+    // benchmark sorting of count rows
+    static void bench_sort(uint32_t count) noexcept {
+        using namespace LongUI::Bench;
+        char name[64];
+        std::vector<std::wstring> rows;
+        make_rows(rows, count);
+        std::vector<uint32_t> numbers(count), index(count), tmp(count);
+        std::mt19937 rng(count * 3);
+        for (auto& n : numbers) n = rng();
+        auto reset = [&]() noexcept { for (uint32_t i = 0; i != count; ++i) index[i] = i; };
+        // 旧路径: 每次比较都重新读取文本
+        reset();
+        Stopwatch sw;
+        std::stable_sort(index.begin(), index.end(), [&rows](uint32_t a, uint32_t b) noexcept {
+            return std::wcscmp(rows[a].c_str(), rows[b].c_str()) < 0;
+        });
+        std::snprintf(name, sizeof(name), "string comparator %u", count);
+        Report(name, sw.Ms(), count, "row");
+        const auto expected = index;
+        // 提取键值 + 归并排序
+        std::vector<StringSortKey> keys(count);
+        reset();
+        sw.Restart();
+        for (uint32_t i = 0; i != count; ++i) keys[i] = LongUI::MakeStringSortKey(rows[i].c_str());
+        LongUI::MergeSortIndex(keys.data(), index.data(), tmp.data(), count);
+        std::snprintf(name, sizeof(name), "string key merge %u", count);
+        Report(name, sw.Ms(), count, "row");
+        if (index != expected) std::printf("  MISMATCH: string key merge\n");
+        // 提取键值 + 并行归并排序
+        reset();
+        sw.Restart();
+        for (uint32_t i = 0; i != count; ++i) keys[i] = LongUI::MakeStringSortKey(rows[i].c_str());
+        parallel_sort(keys.data(), index.data(), tmp.data(), count);
+        std::snprintf(name, sizeof(name), "string key parallel merge %u", count);
+        Report(name, sw.Ms(), count, "row");
+        if (index != expected) std::printf("  MISMATCH: string key parallel merge\n");
+        // 数值: 比较器 vs 基数排序
+        reset();
+        sw.Restart();
+        std::stable_sort(index.begin(), index.end(), [&numbers](uint32_t a, uint32_t b) noexcept {
+            return numbers[a] < numbers[b];
+        });
+        std::snprintf(name, sizeof(name), "number comparator %u", count);
+        Report(name, sw.Ms(), count, "row");
+        const auto expected_num = index;
+        reset();
+        sw.Restart();
+        LongUI::RadixSortIndex(numbers.data(), index.data(), tmp.data(), count);
+        std::snprintf(name, sizeof(name), "number radix %u", count);
+        Report(name, sw.Ms(), count, "row");
+        if (index != expected_num) std::printf("  MISMATCH: number radix\n");
+        Sink(index[0]);
+    }
+}}
+
+// sort 10k rows
+LUI_BENCH(sort_10k) { LongUI::impl::bench_sort(10 * 1000); }
+// sort 100k rows
+LUI_BENCH(sort_100k) { LongUI::impl::bench_sort(100 * 1000); }
+// sort 1M rows
+LUI_BENCH(sort_1m) { LongUI::impl::bench_sort(1000 * 1000); }
@@ -0,0 +1,106 @@
+﻿#include "lui_bench.h"
+#include "LongUI.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <random>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // append subtree in xml, budget for count of nodes
+    static void append_tree(std::string& xml, uint32_t depth, uint32_t branch, uint32_t& budget) noexcept {
+        if (!budget) return;
+        --budget;
+        if (!depth) { xml += "<Null/>"; return; }
+        xml += "<VerticalLayout>";
+        for (uint32_t i = 0; i != branch && budget; ++i) {
+            append_tree(xml, depth - 1, branch, budget);
+        }
+        xml += "</VerticalLayout>";
+    }
+    // collect controls in subtree
+    static void collect_tree(UIControl* ctrl, std::vector<UIControl*>& list) noexcept {
+        list.push_back(ctrl);
+        if (ctrl->flags & Flag_UIContainer) {
+            const auto container = static_cast<UIContainer*>(ctrl);
+            container->ForEachChild([container, &list](UIControl* child) noexcept {
+                if (child->parent == container) collect_tree(child, list);
+            });
+        }
+    }
+    // query ancestor test for random pairs
+    static auto query_pairs(const std::vector<UIControl*>& list, const std::vector<uint32_t>& pairs) noexcept {
+        uint64_t hit = 0;
+        for (size_t i = 0; i < pairs.size(); i += 2) {
+            hit += list[pairs[i]]->IsPosterityForSelf(list[pairs[i + 1]]);
+        }
+        return hit;
+    }
+    // benchmark the tree
+    static void bench_tree(const char* shape, const std::string& xml) noexcept {
+        using namespace Bench;
+        const auto window = UIManager.CreateUIWindow(xml.c_str());
+        if (!window) { std::printf("  failed to create window\n"); return; }
+        const auto viewport = window->GetViewport();
+        std::vector<UIControl*> list;
+        impl::collect_tree(viewport, list);
+        std::printf("  %s: %u controls\n", shape, uint32_t(list.size()));
+        // 全树编号
+        constexpr uint32_t LOOP = 100;
+        Stopwatch sw;
+        for (uint32_t i = 0; i != LOOP; ++i) {
+            viewport->InvalidateTreeOrder();
+            uint32_t index = 0;
+            viewport->RefreshTreeOrder(index);
+        }
+        Report("RefreshTreeOrder", sw.Ms(), double(LOOP), "tree");
+        // 随机查询, 祖先候选偏向浅层以覆盖较长路径
+        constexpr uint32_t QUERY = 1000000;
+        std::mt19937 rng(2016);
+        std::vector<uint32_t> pairs(QUERY * 2);
+        const auto count = uint32_t(list.size());
+        for (uint32_t i = 0; i != QUERY; ++i) {
+            pairs[i * 2 + 0] = rng() % (rng() % count + 1);
+            pairs[i * 2 + 1] = rng() % count;
+        }
+        sw.Restart();
+        Sink(impl::query_pairs(list, pairs));
+        Report("IsPosterityForSelf (interval)", sw.Ms(), double(QUERY), "query");
+        // 树序无效: 回退到父结点查找
+        viewport->InvalidateTreeOrder();
+        sw.Restart();
+        Sink(impl::query_pairs(list, pairs));
+        Report("IsPosterityForSelf (parent walk)", sw.Ms(), double(QUERY), "query");
+        window->Dispose();
+    }
+}}
+
+// 10k-node trees: wide and deep
+LUI_BENCH(tree_order_10k) {
+    using namespace LongUI;
+    ::OleInitialize(nullptr);
+    if (FAILED(UIManager.Initialize())) {
+        std::printf("  failed to initialize UIManager\n");
+        ::OleUninitialize();
+        return;
+    }
+    constexpr uint32_t NODE_COUNT = 10000;
+    // 宽树: 8叉
+    {
+        std::string xml = "<Window>";
+        uint32_t budget = NODE_COUNT;
+        while (budget) impl::append_tree(xml, 4, 8, budget);
+        xml += "</Window>";
+        impl::bench_tree("wide(8-ary)", xml);
+    }
+    // 深树: 100条深度为100的链
+    {
+        std::string xml = "<Window>";
+        uint32_t budget = NODE_COUNT;
+        while (budget) impl::append_tree(xml, 99, 1, budget);
+        xml += "</Window>";
+        impl::bench_tree("deep(100x100)", xml);
+    }
+    UIManager.Uninitialize();
+    ::OleUninitialize();
+}
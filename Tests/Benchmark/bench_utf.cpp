@@ -0,0 +1,172 @@
+﻿#include "lui_bench.h"
+#include <luibase.h>
+#include <luiconf.h>
+#include <Platless/luiPlUtil.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // old two-pass transcoders: length pass then convert pass, valid input only
+    namespace legacy {
+        // utf-8 byte length of lead byte
+        static const char BYTES_FOR_UTF8[256] = {
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+            2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, 2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+            3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3, 4,4,4,4,4,4,4,4,5,5,5,5,6,6,6,6
+        };
+        // offset of decoded value
+        static const char32_t OFFSETS_FROM_UTF8[6] = {
+            0x00000000UL, 0x00003080UL, 0x000E2080UL,
+            0x03C82080UL, 0xFA082080UL, 0x82082080UL
+        };
+        // mark for first byte
+        static const char32_t FIRST_BYTE_MARK[7] = {
+            0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC
+        };
+        // utf-16 to utf-8 length including null
+        static auto u16_to_u8_len(const char16_t* src) noexcept -> uint32_t {
+            uint32_t length = 1;
+            char16_t ch = 0;
+            while ((ch = *src)) {
+                src += 1;
+                if (ch < 0x0080) length += 1;
+                else if (ch >= 0xD800 && ch <= 0xDBFF) { src += 1; length += 4; }
+                else if (ch > 0x07FFF) length += 3;
+                else length += 2;
+            }
+            return length;
+        }
+        // utf-16 to utf-8
+        static auto u16_to_u8(const char16_t* src, char* des) noexcept -> char* {
+            while (*src) {
+                char32_t ch = 0;
+                uint32_t move = 0;
+                if (((*src) & 0xD800) == 0xD800) {
+                    ch = char32_t((src[0] - 0xD800) << 10 | (src[1] - 0xDC00)) + 0x10000;
+                    src += 2;
+                    move = 4;
+                }
+                else {
+                    ch = char32_t(*src);
+                    src += 1;
+                    move = ch < 0x80 ? 1 : (ch < 0x800 ? 2 : 3);
+                }
+                constexpr char32_t byteMask = 0xBF;
+                constexpr char32_t byteMark = 0x80;
+                des += move;
+                switch (move) {
+                case 4: *--des = char((ch | byteMark) & byteMask); ch >>= 6;
+                case 3: *--des = char((ch | byteMark) & byteMask); ch >>= 6;
+                case 2: *--des = char((ch | byteMark) & byteMask); ch >>= 6;
+                case 1: *--des = char(ch | FIRST_BYTE_MARK[move]);
+                }
+                des += move;
+            }
+            return des;
+        }
+        // utf-8 to utf-16 length including null
+        static auto u8_to_u16_len(const char* src) noexcept -> uint32_t {
+            uint32_t length = 1;
+            unsigned char ch = 0;
+            while ((ch = *src)) {
+                const auto blen = BYTES_FOR_UTF8[ch];
+                src += blen;
+                length += 1 + (blen >> 2);
+            }
+            return length;
+        }
+        // utf-8 to utf-16
+        static auto u8_to_u16(const char* src, char16_t* des) noexcept -> char16_t* {
+            while (*src) {
+                char32_t ch = 0;
+                const unsigned char read = BYTES_FOR_UTF8[(unsigned char)(*src)] - 1;
+                switch (read)
+                {
+                case 3: ch += (unsigned char)(*src++); ch <<= 6;
+                case 2: ch += (unsigned char)(*src++); ch <<= 6;
+                case 1: ch += (unsigned char)(*src++); ch <<= 6;
+                case 0: ch += (unsigned char)(*src++);
+                }
+                ch -= OFFSETS_FROM_UTF8[read];
+                if (ch > 0xFFFF) {
+                    des[0] = char16_t(0xD800 + (ch >> 10) - (0x10000 >> 10));
+                    des[1] = char16_t(0xDC00 + (ch & 0x3FF));
+                    des += 2;
+                }
+                else *des++ = char16_t(ch);
+            }
+            return des;
+        }
+    }
+    // repeat sample to units of utf-16
+    static void make_corpus(std::u16string& text, const char16_t* sample, size_t units) noexcept {
+        const auto len = std::char_traits<char16_t>::length(sample);
+        text.clear();
+        text.reserve(units + len);
+        while (text.size() < units) text.append(sample, len);
+    }
+    // benchmark transcoding corpus, old two-pass code vs one-pass code
+    static void bench_utf(const char* corpus, const char16_t* sample) noexcept {
+        using namespace LongUI::Bench;
+        enum : uint32_t { UNITS = 2 << 20, ROUND = 10 };
+        char name[64];
+        std::u16string text;
+        make_corpus(text, sample, UNITS);
+        const auto len16 = uint32_t(text.size());
+        // 最坏情况的缓冲
+        std::vector<char> u8(len16 * 3 + 1);
+        std::vector<char16_t> u16(len16 * 3 + 1);
+        const auto len8 = uint32_t(LongUI::UTF16toUTF8(text.c_str(), len16, u8.data()) - u8.data());
+        u8[len8] = 0;
+        // UTF-16 -> UTF-8
+        Stopwatch sw;
+        for (uint32_t i = 0; i != ROUND; ++i) {
+            Sink(legacy::u16_to_u8_len(text.c_str()));
+            Sink(uint64_t(legacy::u16_to_u8(text.c_str(), u8.data()) - u8.data()));
+        }
+        std::snprintf(name, sizeof(name), "utf16->8 %s old", corpus);
+        ReportMBps(name, sw.Ms(), double(len16) * sizeof(char16_t) * ROUND);
+        sw.Restart();
+        for (uint32_t i = 0; i != ROUND; ++i) {
+            const auto len = uint32_t(std::char_traits<char16_t>::length(text.c_str()));
+            Sink(uint64_t(LongUI::UTF16toUTF8(text.c_str(), len, u8.data()) - u8.data()));
+        }
+        std::snprintf(name, sizeof(name), "utf16->8 %s new", corpus);
+        ReportMBps(name, sw.Ms(), double(len16) * sizeof(char16_t) * ROUND);
+        // UTF-8 -> UTF-16
+        sw.Restart();
+        for (uint32_t i = 0; i != ROUND; ++i) {
+            Sink(legacy::u8_to_u16_len(u8.data()));
+            Sink(uint64_t(legacy::u8_to_u16(u8.data(), u16.data()) - u16.data()));
+        }
+        std::snprintf(name, sizeof(name), "utf8->16 %s old", corpus);
+        ReportMBps(name, sw.Ms(), double(len8) * ROUND);
+        sw.Restart();
+        for (uint32_t i = 0; i != ROUND; ++i) {
+            const auto len = uint32_t(std::strlen(u8.data()));
+            Sink(uint64_t(LongUI::UTF8toUTF16(u8.data(), len, u16.data()) - u16.data()));
+        }
+        std::snprintf(name, sizeof(name), "utf8->16 %s new", corpus);
+        ReportMBps(name, sw.Ms(), double(len8) * ROUND);
+    }
+}}
+
+// ascii markup
+LUI_BENCH(utf_ascii) { 
+    LongUI::impl::bench_utf("ascii", u"<item name=\"widget\" value=\"3.14\">hello world</item>\n");
+}
+// cjk text
+LUI_BENCH(utf_cjk) {
+    LongUI::impl::bench_utf("cjk", u"中文界面库的文本编辑与排版测试，包含标点符号。\n");
+}
+// emoji, surrogate pairs
+LUI_BENCH(utf_emoji) {
+    LongUI::impl::bench_utf("emoji", u"😀😃😄😁😆😅🤣😂🙂🙃 \n");
+}
@@ -0,0 +1,42 @@
+﻿#pragma once
+
+// minimal benchmark helper, run the release build for real numbers
+#include <cstdint>
+#include <chrono>
+
+// longui::bench namespace
+namespace LongUI { namespace Bench {
+    // benchmark function
+    using BenchFunc = void(*)() noexcept;
+    // register benchmark, return index of benchmark
+    auto Register(const char* name, BenchFunc func) noexcept -> uint32_t;
+    // report a result: total time for count operations
+    void Report(const char* what, double ms, double count, const char* unit) noexcept;
+    // report throughput: total time for bytes processed
+    void ReportMBps(const char* what, double ms, double bytes) noexcept;
+    // keep value alive, avoid optimized out
+    void Sink(uint64_t value) noexcept;
+    // simple stopwatch
+    class Stopwatch {
+        // clock
+        using Clock = std::chrono::steady_clock;
+    public:
+        // ctor
+        Stopwatch() noexcept : m_start(Clock::now()) {}
+        // restart
+        void Restart() noexcept { m_start = Clock::now(); }
+        // elapsed time in ms
+        auto Ms() const noexcept -> double {
+            return std::chrono::duration<double, std::milli>(Clock::now() - m_start).count();
+        }
+    private:
+        // start time
+        Clock::time_point   m_start;
+    };
+}}
+
+// define a benchmark
+#define LUI_BENCH(name) \
+    static void lui_bench_##name() noexcept;\
+    static const auto lui_bench_index_##name = LongUI::Bench::Register(#name, lui_bench_##name);\
+    static void lui_bench_##name() noexcept
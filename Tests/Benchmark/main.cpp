@@ -0,0 +1,81 @@
+﻿#include "lui_bench.h"
+#include <cstdio>
+#include <cstring>
+
+// longui::bench namespace
+namespace LongUI { namespace Bench {
+    // benchmark unit
+    struct Unit { const char* name; BenchFunc func; };
+    // max count of benchmarks
+    enum : uint32_t { BENCH_MAX = 128 };
+    // benchmarks
+    static Unit s_aBenches[BENCH_MAX];
+    // count of benchmarks
+    static uint32_t s_uCount = 0;
+    // sink
+    static volatile uint64_t s_uSink = 0;
+}}
+
+/// <summary>
+/// Registers the benchmark.
+/// </summary>
+/// <param name="name">The name.</param>
+/// <param name="func">The function.</param>
+/// <returns>index of benchmark</returns>
+auto LongUI::Bench::Register(const char* name, BenchFunc func) noexcept -> uint32_t {
+    if (s_uCount == BENCH_MAX) {
+        std::printf("too many benchmarks, '%s' ignored\n", name);
+        return BENCH_MAX;
+    }
+    s_aBenches[s_uCount] = { name, func };
+    return s_uCount++;
+}
+
+/// <summary>
+/// Reports the result.
+/// </summary>
+/// <param name="what">The description.</param>
+/// <param name="ms">The total time in ms.</param>
+/// <param name="count">The count of operations.</param>
+/// <param name="unit">The unit name of operation.</param>
+/// <returns></returns>
+void LongUI::Bench::Report(const char* what, double ms, double count, const char* unit) noexcept {
+    const auto ns = count > 0. ? ms * 1e6 / count : 0.;
+    std::printf("  %-40s %10.3f ms %12.1f ns/%s\n", what, ms, ns, unit);
+}
+
+/// <summary>
+/// Reports the throughput.
+/// </summary>
+/// <param name="what">The description.</param>
+/// <param name="ms">The total time in ms.</param>
+/// <param name="bytes">The bytes processed.</param>
+/// <returns></returns>
+void LongUI::Bench::ReportMBps(const char* what, double ms, double bytes) noexcept {
+    const auto mbps = ms > 0. ? bytes / (1024. * 1024.) / (ms / 1000.) : 0.;
+    std::printf("  %-40s %10.3f ms %12.1f MB/s\n", what, ms, mbps);
+}
+
+/// <summary>
+/// Keeps the value alive.
+/// </summary>
+/// <param name="value">The value.</param>
+/// <returns></returns>
+void LongUI::Bench::Sink(uint64_t value) noexcept {
+    s_uSink = s_uSink + value;
+}
+
+// Entry, argv[1] to filter benchmarks by name
+int main(int argc, char* argv[]) {
+    using namespace LongUI::Bench;
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+#ifdef _DEBUG
+    std::printf("WARNING: debug build, numbers are meaningless\n");
+#endif
+    for (uint32_t i = 0; i != s_uCount; ++i) {
+        if (filter && !std::strstr(s_aBenches[i].name, filter)) continue;
+        std::printf("[%s]\n", s_aBenches[i].name);
+        s_aBenches[i].func();
+    }
+    return 0;
+}
@@ -0,0 +1,23 @@
+﻿#pragma once
+
+// minimal headless test helper, no UIManager or GPU required
+#include <cstdint>
+
+// longui::test namespace
+namespace LongUI { namespace Test {
+    // test function
+    using TestFunc = void(*)() noexcept;
+    // register test, return index of test
+    auto Register(const char* name, TestFunc func) noexcept -> uint32_t;
+    // report a failed check
+    void Fail(const char* file, int line, const char* expr) noexcept;
+}}
+
+// define a test
+#define LUI_TEST(name) \
+    static void lui_test_##name() noexcept;\
+    static const auto lui_test_index_##name = LongUI::Test::Register(#name, lui_test_##name);\
+    static void lui_test_##name() noexcept
+
+// check a expression
+#define LUI_CHECK(expr) ((expr) ? (void)0 : LongUI::Test::Fail(__FILE__, __LINE__, #expr))
@@ -0,0 +1,58 @@
+﻿#include "lui_test.h"
+#include <cstdio>
+
+// longui::test namespace
+namespace LongUI { namespace Test {
+    // test unit
+    struct Unit { const char* name; TestFunc func; };
+    // max count of tests
+    enum : uint32_t { TEST_MAX = 256 };
+    // tests
+    static Unit s_aTests[TEST_MAX];
+    // count of tests
+    static uint32_t s_uCount = 0;
+    // count of failed checks
+    static uint32_t s_uFailed = 0;
+}}
+
+/// <summary>
+/// Registers the test.
+/// </summary>
+/// <param name="name">The name.</param>
+/// <param name="func">The function.</param>
+/// <returns>index of test</returns>
+auto LongUI::Test::Register(const char* name, TestFunc func) noexcept -> uint32_t {
+    if (s_uCount == TEST_MAX) {
+        std::printf("too many tests, '%s' ignored\n", name);
+        return TEST_MAX;
+    }
+    s_aTests[s_uCount] = { name, func };
+    return s_uCount++;
+}
+
+/// <summary>
+/// Reports a failed check.
+/// </summary>
+/// <param name="file">The file.</param>
+/// <param name="line">The line.</param>
+/// <param name="expr">The expression.</param>
+/// <returns></returns>
+void LongUI::Test::Fail(const char* file, int line, const char* expr) noexcept {
+    std::printf("  %s(%d): check failed: %s\n", file, line, expr);
+    ++s_uFailed;
+}
+
+// Entry
+int main() {
+    using namespace LongUI::Test;
+    uint32_t failed_tests = 0;
+    for (uint32_t i = 0; i != s_uCount; ++i) {
+        const auto old = s_uFailed;
+        s_aTests[i].func();
+        const bool ok = old == s_uFailed;
+        if (!ok) ++failed_tests;
+        std::printf("[%s] %s\n", ok ? " OK " : "FAIL", s_aTests[i].name);
+    }
+    std::printf("%u/%u tests passed\n", s_uCount - failed_tests, s_uCount);
+    return failed_tests ? 1 : 0;
+}
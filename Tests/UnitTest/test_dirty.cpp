@@ -0,0 +1,112 @@
+﻿#include "lui_test.h"
+#include <luiconf.h>
+#include <Platless/luiPlDirty.h>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // make rect
+    static inline auto rect(float l, float t, float r, float b) noexcept {
+        RectLTRB_F rc; rc.left = l; rc.top = t; rc.right = r; rc.bottom = b; return rc;
+    }
+    // is region covering the rect?
+    static bool covered(const CUIDirtyRegion& region, const RectLTRB_F& rc) noexcept {
+        for (const auto& unit : region) {
+            if (CUIDirtyRegion::IsContain(unit.rect, rc)) return true;
+        }
+        return false;
+    }
+    // cover checker for test: lower address covers higher one
+    static bool lower_covers(void* outer, void* inner) noexcept { return outer < inner; }
+}}
+
+// overlapped rects with little waste merged into one
+LUI_TEST(dirty_merge_overlapped) {
+    using namespace LongUI;
+    CUIDirtyRegion region;
+    int a = 0;
+    region.AddRect(impl::rect(0.f, 0.f, 100.f, 100.f), &a);
+    region.AddRect(impl::rect(50.f, 0.f, 150.f, 100.f), &a);
+    LUI_CHECK(region.GetCount() == 1);
+    LUI_CHECK(region[0].rect.left == 0.f && region[0].rect.right == 150.f);
+    LUI_CHECK(region[0].data == nullptr);
+    LUI_CHECK(region.GetArea() == 150.f * 100.f);
+}
+
+// contained rect swallowed, data kept if same or covered
+LUI_TEST(dirty_merge_contained) {
+    using namespace LongUI;
+    CUIDirtyRegion region;
+    char data[2];
+    region.AddRect(impl::rect(0.f, 0.f, 100.f, 100.f), data + 0);
+    region.AddRect(impl::rect(10.f, 10.f, 20.f, 20.f), data + 0);
+    LUI_CHECK(region.GetCount() == 1 && region[0].data == data + 0);
+    // 没有检查器: 不同数据无法合并
+    region.AddRect(impl::rect(30.f, 30.f, 40.f, 40.f), data + 1);
+    LUI_CHECK(region.GetCount() == 1 && region[0].data == nullptr);
+    // 有检查器
+    region.Clear();
+    region.SetCoverChecker(impl::lower_covers);
+    region.AddRect(impl::rect(10.f, 10.f, 20.f, 20.f), data + 1);
+    region.AddRect(impl::rect(0.f, 0.f, 100.f, 100.f), data + 0);
+    LUI_CHECK(region.GetCount() == 1 && region[0].data == data + 0);
+}
+
+// far away rects kept separately
+LUI_TEST(dirty_keep_disjoint) {
+    using namespace LongUI;
+    CUIDirtyRegion region;
+    region.AddRect(impl::rect(0.f, 0.f, 10.f, 10.f), nullptr);
+    region.AddRect(impl::rect(500.f, 500.f, 510.f, 510.f), nullptr);
+    LUI_CHECK(region.GetCount() == 2);
+    LUI_CHECK(region.GetArea() == 200.f);
+}
+
+// more rects than units: merged with the cheapest, nothing lost
+LUI_TEST(dirty_overflow_merge) {
+    using namespace LongUI;
+    CUIDirtyRegion region;
+    constexpr uint32_t count = LongUIDirtyRegionSize * 3;
+    for (uint32_t i = 0; i != count; ++i) {
+        const auto x = float(i % 16) * 100.f;
+        const auto y = float(i / 16) * 100.f;
+        region.AddRect(impl::rect(x, y, x + 10.f, y + 10.f), nullptr);
+        LUI_CHECK(region.GetCount() <= LongUIDirtyRegionSize);
+    }
+    for (uint32_t i = 0; i != count; ++i) {
+        const auto x = float(i % 16) * 100.f;
+        const auto y = float(i / 16) * 100.f;
+        LUI_CHECK(impl::covered(region, impl::rect(x, y, x + 10.f, y + 10.f)));
+    }
+    float area = 0.f;
+    for (const auto& unit : region) area += CUIDirtyRegion::AreaOf(unit.rect);
+    LUI_CHECK(area == region.GetArea());
+}
+
+// region too large -> full rendering
+LUI_TEST(dirty_full_threshold) {
+    using namespace LongUI;
+    CUIDirtyRegion region;
+    constexpr float w = 100.f, h = 100.f;
+    const auto limit = w * h * LongUIDirtyRegionFullRatio;
+    // 刚好低于阈值
+    region.AddRect(impl::rect(0.f, 0.f, w, limit / w - 1.f), nullptr);
+    LUI_CHECK(!region.IsOverRatio(w, h));
+    // 超过阈值
+    region.AddRect(impl::rect(0.f, 0.f, w, limit / w + 1.f), nullptr);
+    LUI_CHECK(region.GetCount() == 1);
+    LUI_CHECK(region.IsOverRatio(w, h));
+    region.Clear();
+    LUI_CHECK(region.IsEmpty() && !region.IsOverRatio(w, h));
+}
+
+// zero-size rect grows to 1 pixel, inverted rect ignored
+LUI_TEST(dirty_zero_size) {
+    using namespace LongUI;
+    CUIDirtyRegion region;
+    region.AddRect(impl::rect(10.5f, 10.f, 10.5f, 20.f), nullptr);
+    LUI_CHECK(region.GetCount() == 1);
+    LUI_CHECK(region[0].rect.left == 10.f && region[0].rect.right == 11.f);
+    LUI_CHECK(region[0].rect.top == 10.f && region[0].rect.bottom == 20.f);
+    region.AddRect(impl::rect(50.f, 50.f, 40.f, 60.f), nullptr);
+    LUI_CHECK(region.GetCount() == 1);
+}
@@ -0,0 +1,120 @@
+﻿#include "lui_test.h"
+#include <luibase.h>
+#include <luiconf.h>
+#include <Platless/luiPlUtil.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cfloat>
+#include <random>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // float from bits
+    static auto make_float(uint32_t bits) noexcept -> float {
+        float value; std::memcpy(&value, &bits, sizeof(value)); return value;
+    }
+    // parse whole string, bit-exact to strtof
+    static bool same_as_strtof(const char* str) noexcept {
+        const auto end = str + std::strlen(str);
+        float value = -1.f;
+        if (LongUI::ParseFloat(str, end, value) != end) return false;
+        const auto expected = std::strtof(str, nullptr);
+        return !std::memcmp(&value, &expected, sizeof(value));
+    }
+    // random finite float bits, sign and exponent included
+    static auto random_bits(std::mt19937& rng) noexcept -> uint32_t {
+        uint32_t bits;
+        do { bits = uint32_t(rng()); } while ((bits & 0x7F800000) == 0x7F800000);
+        return bits;
+    }
+}}
+
+// shortest and long round-trip of random floats
+LUI_TEST(float_round_trip) {
+    std::mt19937 rng(25);
+    char buf[64];
+    for (uint32_t i = 0; i != 20000; ++i) {
+        const auto value = LongUI::impl::make_float(LongUI::impl::random_bits(rng));
+        std::snprintf(buf, sizeof(buf), "%.9g", value);
+        LUI_CHECK(LongUI::impl::same_as_strtof(buf));
+        std::snprintf(buf, sizeof(buf), "%.*e", int(1 + rng() % 12), value);
+        LUI_CHECK(LongUI::impl::same_as_strtof(buf));
+    }
+}
+
+// exact midpoints of adjacent floats, and just above them
+LUI_TEST(float_halfway) {
+    std::mt19937 rng(2);
+    char buf[256];
+    for (uint32_t i = 0; i != 5000; ++i) {
+        const auto bits = LongUI::impl::random_bits(rng) & 0x7FFFFFFF;
+        if (bits == 0x7F7FFFFF) continue;
+        // 相邻浮点的中点可以用double精确表示
+        const auto lo = double(LongUI::impl::make_float(bits));
+        const auto hi = double(LongUI::impl::make_float(bits + 1));
+        const auto len = std::snprintf(buf, sizeof(buf) - 2, "%.200e", (lo + hi) / 2);
+        LUI_CHECK(LongUI::impl::same_as_strtof(buf));
+        // 尾数末尾加一位非零数字
+        const auto e = std::strchr(buf, 'e');
+        std::memmove(e + 1, e, std::size_t(buf + len + 1 - e));
+        *e = '1';
+        LUI_CHECK(LongUI::impl::same_as_strtof(buf));
+    }
+}
+
+// more significant digits than a 64-bit mantissa holds
+LUI_TEST(float_long_mantissa) {
+    std::mt19937 rng(19);
+    char buf[128];
+    for (uint32_t i = 0; i != 20000; ++i) {
+        uint32_t len = 0;
+        const auto digits = 20 + rng() % 40;
+        const auto point = rng() % digits;
+        for (uint32_t j = 0; j != digits; ++j) {
+            if (j == point) buf[len++] = '.';
+            buf[len++] = char('0' + rng() % 10);
+        }
+        std::snprintf(buf + len, sizeof(buf) - len, "e%d", int(rng() % 90) - 60);
+        LUI_CHECK(LongUI::impl::same_as_strtof(buf));
+    }
+    LUI_CHECK(LongUI::impl::same_as_strtof("0.1000000000000000055511151231257827021181583404541015625"));
+    LUI_CHECK(LongUI::impl::same_as_strtof("16777217.000000000000000000001"));
+    LUI_CHECK(LongUI::impl::same_as_strtof("16777216.999999999999999999999"));
+}
+
+// denormal, underflow and overflow edges
+LUI_TEST(float_edge) {
+    std::mt19937 rng(126);
+    char buf[64];
+    for (uint32_t i = 0; i != 5000; ++i) {
+        const auto value = LongUI::impl::make_float(uint32_t(rng()) & 0x807FFFFF);
+        std::snprintf(buf, sizeof(buf), "%.9g", value);
+        LUI_CHECK(LongUI::impl::same_as_strtof(buf));
+    }
+    const char* const edges[] = {
+        "1e-45", "1.4e-45", "7e-46", "7.1e-46", "7.006492321624085e-46", "1e-50", "-1e-50",
+        "1.17549435e-38", "1.1754942e-38", "0e-999", "1e-9999",
+        "3.4028235e38", "3.40282356e38", "3.40282357e38", "3.4028236e38", "1e39", "-1e39", "1e9999",
+    };
+    for (const auto str : edges) LUI_CHECK(LongUI::impl::same_as_strtof(str));
+}
+
+// batch parse with svg separators, missing ones set to 0
+LUI_TEST(float_batch) {
+    float out[4] = { 9.f, 9.f, 9.f, 9.f };
+    const char list[] = "1-2.5.5";
+    const char* itr = list;
+    LUI_CHECK(LongUI::ParseFloats(itr, list + sizeof(list) - 1, out, 4) == 3);
+    LUI_CHECK(itr == list + sizeof(list) - 1);
+    LUI_CHECK(out[0] == 1.f && out[1] == -2.5f && out[2] == .5f && out[3] == 9.f);
+    // 未解析的保持原值
+    const char part[] = "3, 4 x 5";
+    itr = part;
+    LUI_CHECK(LongUI::ParseFloats(itr, part + sizeof(part) - 1, out, 4) == 2);
+    LUI_CHECK(itr == part + 4 && out[0] == 3.f && out[1] == 4.f && out[2] == .5f);
+    const char none[] = " ,x";
+    itr = none;
+    LUI_CHECK(LongUI::ParseFloats(itr, none + sizeof(none) - 1, out, 2) == 0);
+    LUI_CHECK(itr == none && out[0] == 3.f && out[1] == 4.f);
+}
@@ -0,0 +1,173 @@
+﻿#include "lui_test.h"
+#include <luibase.h>
+#include <luiconf.h>
+#include <Platless/luiPlUtil.h>
+#include <Platless/luiPlPiece.h>
+#include <Platless/luiPlLine.h>
+#include <algorithm>
+#include <vector>
+#include <random>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // naive text as reference
+    using RefText = std::vector<wchar_t>;
+    // naive line of text
+    struct RefLine { uint32_t start, end; };
+    // split text into lines naively: CR, LF, CRLF, NEL, LS, PS
+    static void ref_lines(const RefText& text, std::vector<RefLine>& lines) noexcept {
+        lines.clear();
+        const auto len = uint32_t(text.size());
+        uint32_t start = 0;
+        for (uint32_t i = 0; i < len; ++i) {
+            uint32_t nl = 0;
+            switch (text[i])
+            {
+            case L'\r': nl = i + 1 < len && text[i + 1] == L'\n' ? 2 : 1; break;
+            case L'\n': case 0x85: case 0x2028: case 0x2029: nl = 1; break;
+            }
+            if (!nl) continue;
+            lines.push_back(RefLine{ start, i });
+            i += nl - 1;
+            start = i + 1;
+        }
+        lines.push_back(RefLine{ start, len });
+    }
+    // check piece table against reference
+    static bool same_text(const CUIPieceTable& table, const RefText& text) noexcept {
+        if (table.GetLength() != text.size()) return false;
+        RefText copied(text.size() + 1);
+        if (table.Copy(0, uint32_t(text.size()), copied.data()) != text.size()) return false;
+        for (uint32_t i = 0; i != text.size(); ++i) {
+            if (copied[i] != text[i] || table[i] != text[i]) return false;
+        }
+        return true;
+    }
+    // check line index against reference
+    static bool same_lines(const CUILineIndex& index, const RefText& text) noexcept {
+        std::vector<RefLine> lines;
+        ref_lines(text, lines);
+        if (index.GetLength() != text.size()) return false;
+        if (index.GetLineCount() != lines.size()) return false;
+        for (uint32_t i = 0; i != lines.size(); ++i) {
+            if (index.GetLineStart(i) != lines[i].start) return false;
+            if (index.GetLineEnd(i) != lines[i].end) return false;
+            // 行内所有位置, 包括换行符
+            const auto next = i + 1 < lines.size() ? lines[i + 1].start : uint32_t(text.size()) + 1;
+            for (auto pos = lines[i].start; pos < next; ++pos) {
+                if (index.GetLineFromPosition(pos) != i) return false;
+            }
+        }
+        return true;
+    }
+    // random edit context
+    struct Editor {
+        // piece table
+        CUIPieceTable   table;
+        // line index
+        CUILineIndex    index;
+        // reference
+        RefText         text;
+        // replace [pos, pos + removed) with str
+        bool Replace(uint32_t pos, uint32_t removed, const wchar_t* str, uint32_t len) noexcept {
+            if (removed) table.Remove(pos, removed);
+            if (len && !table.Insert(pos, str, len)) return false;
+            text.erase(text.begin() + pos, text.begin() + pos + removed);
+            text.insert(text.begin() + pos, str, str + len);
+            return index.Update(table, pos, removed, len);
+        }
+    };
+}}
+
+// CRLF joined and split by single edits
+LUI_TEST(line_crlf_join_split) {
+    using namespace LongUI;
+    impl::Editor ed;
+    const wchar_t init[] = L"ab\rcd";
+    ed.table.Set(init, 5);
+    ed.text.assign(init, init + 5);
+    LUI_CHECK(ed.index.Build(ed.table));
+    LUI_CHECK(impl::same_lines(ed.index, ed.text));
+    // CR 后插入 LF: 合并为 CRLF
+    LUI_CHECK(ed.Replace(3, 0, L"\n", 1));
+    LUI_CHECK(ed.index.GetLineCount() == 2);
+    LUI_CHECK(impl::same_lines(ed.index, ed.text));
+    // CRLF 中间插入: 拆成两行
+    LUI_CHECK(ed.Replace(3, 0, L"x", 1));
+    LUI_CHECK(ed.index.GetLineCount() == 3);
+    LUI_CHECK(impl::same_lines(ed.index, ed.text));
+    // 删除中间字符: 重新合并
+    LUI_CHECK(ed.Replace(3, 1, nullptr, 0));
+    LUI_CHECK(ed.index.GetLineCount() == 2);
+    LUI_CHECK(impl::same_lines(ed.index, ed.text));
+    // 只删除 CR: 剩下 LF
+    LUI_CHECK(ed.Replace(2, 1, nullptr, 0));
+    LUI_CHECK(ed.index.GetLineCount() == 2);
+    LUI_CHECK(impl::same_lines(ed.index, ed.text));
+    // LS 替换 LF
+    LUI_CHECK(ed.Replace(2, 1, L"\x2028", 1));
+    LUI_CHECK(impl::same_lines(ed.index, ed.text));
+    LUI_CHECK(impl::same_text(ed.table, ed.text));
+}
+
+// random edits of CR, LF, CRLF and LS against naive reference
+LUI_TEST(line_random_edit) {
+    using namespace LongUI;
+    const wchar_t alphabet[] = { L'a', L'b', L' ', L'\r', L'\n', 0x2028 };
+    std::mt19937 rng(2016);
+    impl::Editor ed;
+    ed.table.Set(L"", 0);
+    LUI_CHECK(ed.index.Build(ed.table));
+    LUI_CHECK(ed.index.GetLineCount() == 1);
+    bool ok = true;
+    for (uint32_t step = 0; step != 3000 && ok; ++step) {
+        const auto length = uint32_t(ed.text.size());
+        const auto pos = length ? uint32_t(rng() % (length + 1)) : 0;
+        const auto removed = pos < length && (rng() & 1) ? uint32_t(rng() % std::min(length - pos, 6u)) + 1 : 0;
+        wchar_t buf[6];
+        const auto len = length > 200 ? uint32_t(rng() % 3) : uint32_t(rng() % 6);
+        for (uint32_t i = 0; i != len; ++i) buf[i] = alphabet[rng() % 6];
+        // CRLF 单独插入的比例加大
+        if (len >= 2 && !(rng() % 4)) { buf[0] = L'\r'; buf[1] = L'\n'; }
+        ok = ed.Replace(pos, removed, buf, len)
+            && impl::same_text(ed.table, ed.text)
+            && impl::same_lines(ed.index, ed.text);
+    }
+    LUI_CHECK(ok);
+    // 重建与增量结果相同
+    CUILineIndex rebuilt;
+    LUI_CHECK(rebuilt.Build(ed.table));
+    LUI_CHECK(impl::same_lines(rebuilt, ed.text));
+}
+
+// piece table under long delete-heavy editing, buffer compacted on the way
+LUI_TEST(piece_random_edit) {
+    using namespace LongUI;
+    std::mt19937 rng(42);
+    CUIPieceTable table;
+    impl::RefText text;
+    table.Set(L"", 0);
+    bool ok = true;
+    for (uint32_t step = 0; step != 200000 && ok; ++step) {
+        const auto length = uint32_t(text.size());
+        if (length < 512 || (rng() & 1)) {
+            const auto pos = length ? uint32_t(rng() % (length + 1)) : 0;
+            const wchar_t buf[] = { L'0', L'1', L'\r', L'\n' };
+            const auto len = uint32_t(rng() % 4) + 1;
+            ok = table.Insert(pos, buf, len);
+            text.insert(text.begin() + pos, buf, buf + len);
+        }
+        else {
+            const auto pos = uint32_t(rng() % length);
+            const auto len = std::min(uint32_t(rng() % 8) + 1, length - pos);
+            table.Remove(pos, len);
+            text.erase(text.begin() + pos, text.begin() + pos + len);
+        }
+        if (!(step % 10000)) ok = ok && impl::same_text(table, text);
+    }
+    LUI_CHECK(ok);
+    LUI_CHECK(impl::same_text(table, text));
+    // 整体删除
+    table.Remove(0, table.GetLength());
+    LUI_CHECK(table.GetLength() == 0 && table.GetPieceCount() == 0);
+}
@@ -0,0 +1,136 @@
+﻿#include "lui_test.h"
+#include <luibase.h>
+#include <luiconf.h>
+#include <Platless/luiPlUtil.h>
+#include <string>
+#include <random>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // utf-8 to utf-16 with length-based converter
+    static auto to_utf16(const std::string& str) noexcept -> std::u16string {
+        std::u16string out(str.size() + 1, u'\0');
+        const auto end = LongUI::UTF8toUTF16(str.data(), uint32_t(str.size()), &out[0]);
+        out.resize(std::size_t(end - out.data()));
+        return out;
+    }
+    // utf-16 to utf-8 with length-based converter
+    static auto to_utf8(const std::u16string& str) noexcept -> std::string {
+        std::string out(str.size() * 3 + 1, '\0');
+        const auto end = LongUI::UTF16toUTF8(str.data(), uint32_t(str.size()), &out[0]);
+        out.resize(std::size_t(end - out.data()));
+        return out;
+    }
+    // piece of text in both encodings
+    struct UtfPiece { const char* utf8; const char16_t* utf16; };
+    // U+FFFD in utf-8
+    static const char* const REPLACEMENT = "\xEF\xBF\xBD";
+}}
+
+// overlong, surrogate, truncated and out-of-range utf-8: one U+FFFD per maximal subpart
+LUI_TEST(utf8_malformed) {
+    using LongUI::impl::to_utf16;
+    const struct { const char* src; const char16_t* expected; bool valid; } cases[] = {
+        { "\xE4\xB8\xAD", u"\u4E2D", true },
+        { "\xF0\x9F\x98\x80", u"\U0001F600", true },
+        { "\xF4\x8F\xBF\xBF", u"\U0010FFFF", true },
+        // 超长编码
+        { "\xC0\xAF", u"\uFFFD\uFFFD", false },
+        { "\xC1\xBF", u"\uFFFD\uFFFD", false },
+        { "\xE0\x80\xAF", u"\uFFFD\uFFFD\uFFFD", false },
+        { "\xF0\x8F\xBF\xBF", u"\uFFFD\uFFFD\uFFFD\uFFFD", false },
+        // 代理项
+        { "\xED\xA0\x80", u"\uFFFD\uFFFD\uFFFD", false },
+        { "\xED\xBF\xBF", u"\uFFFD\uFFFD\uFFFD", false },
+        { "\xED\x9F\xBF", u"\uD7FF", true },
+        // 截断
+        { "\xE4\xB8", u"\uFFFD", false },
+        { "\xE4\xB8" "A", u"\uFFFD" u"A", false },
+        { "\xF0\x9F\x98", u"\uFFFD", false },
+        { "\xF0\x9F" "A\xC3", u"\uFFFD" u"A\uFFFD", false },
+        // 超出范围
+        { "\xF4\x90\x80\x80", u"\uFFFD\uFFFD\uFFFD\uFFFD", false },
+        { "\xF5\x80", u"\uFFFD\uFFFD", false },
+        { "\xFF", u"\uFFFD", false },
+        // 单独的后续字节
+        { "\x80" "A\xBF", u"\uFFFD" u"A\uFFFD", false },
+    };
+    for (const auto& c : cases) {
+        const std::string src = c.src;
+        LUI_CHECK(to_utf16(src) == c.expected);
+        LUI_CHECK(LongUI::IsValidUTF8(src.data(), uint32_t(src.size())) == c.valid);
+    }
+}
+
+// lone high and low surrogates become U+FFFD
+LUI_TEST(utf16_lone_surrogate) {
+    using LongUI::impl::to_utf8;
+    const std::string fffd = LongUI::impl::REPLACEMENT;
+    const struct { std::u16string src; std::string expected; bool valid; } cases[] = {
+        { u"\U0001F600", "\xF0\x9F\x98\x80", true },
+        { std::u16string(1, char16_t(0xD800)), fffd, false },
+        { std::u16string(1, char16_t(0xDFFF)), fffd, false },
+        { u"a" + std::u16string(1, char16_t(0xD83D)) + u"b", "a" + fffd + "b", false },
+        { u"a" + std::u16string(1, char16_t(0xDE00)) + u"b", "a" + fffd + "b", false },
+        // 顺序颠倒
+        { std::u16string{ char16_t(0xDE00), char16_t(0xD83D) }, fffd + fffd, false },
+        // 两个高代理
+        { std::u16string{ char16_t(0xD83D), char16_t(0xD83D), char16_t(0xDE00) }, fffd + "\xF0\x9F\x98\x80", false },
+        { u"\uFFFF", "\xEF\xBF\xBF", true },
+    };
+    for (const auto& c : cases) {
+        LUI_CHECK(to_utf8(c.src) == c.expected);
+        LUI_CHECK(LongUI::IsValidUTF16(c.src.data(), uint32_t(c.src.size())) == c.valid);
+    }
+}
+
+// *GetBufLen equals converted length plus null on random malformed input
+LUI_TEST(utf_buflen) {
+    std::mt19937 rng(24);
+    for (uint32_t i = 0; i != 2000; ++i) {
+        // 非零字节: ASCII, 后续字节与各种首字节
+        std::string u8(rng() % 200, '\0');
+        for (auto& ch : u8) {
+            const auto r = rng() % 4;
+            ch = char(r == 0 ? 1 + rng() % 0x7F : (r == 1 ? 0x80 + rng() % 0x40 : 0xC0 + rng() % 0x40));
+        }
+        const auto u16 = LongUI::impl::to_utf16(u8);
+        LUI_CHECK(LongUI::UTF8toUTF16GetBufLen(u8.c_str()) == u16.size() + 1);
+        // 非零单元: ASCII, 2字节, 3字节与代理项
+        std::u16string w(rng() % 200, u'\0');
+        for (auto& ch : w) {
+            const auto r = rng() % 4;
+            ch = char16_t(r == 0 ? 1 + rng() % 0x7F : (r == 1 ? 0x80 + rng() % 0x780 : (r == 2 ? 0xD800 + rng() % 0x800 : 0xE000 + rng() % 0x2000)));
+        }
+        const auto u8w = LongUI::impl::to_utf8(w);
+        LUI_CHECK(LongUI::UTF16toUTF8GetBufLen(w.c_str()) == u8w.size() + 1);
+    }
+}
+
+// SSE2 ASCII blocks and scalar tail agree around 8, 16 and 17 chars
+LUI_TEST(utf_block_boundary) {
+    const LongUI::impl::UtfPiece pieces[] = {
+        { "\xC3\xA9", u"\u00E9" },
+        { "\xE4\xB8\xAD", u"\u4E2D" },
+        { "\xF0\x9F\x98\x80", u"\U0001F600" },
+    };
+    for (const auto& piece : pieces) {
+        for (uint32_t total = 6; total != 36; ++total) {
+            // 非ASCII字符放在每个位置, 前后用ASCII填充
+            for (uint32_t at = 0; at <= total; ++at) {
+                std::string u8; std::u16string u16;
+                for (uint32_t i = 0; i != at; ++i) u8 += char('a' + i % 26), u16 += char16_t('a' + i % 26);
+                u8 += piece.utf8; u16 += piece.utf16;
+                for (uint32_t i = at; i != total; ++i) u8 += char('A' + i % 26), u16 += char16_t('A' + i % 26);
+                LUI_CHECK(LongUI::impl::to_utf16(u8) == u16);
+                LUI_CHECK(LongUI::impl::to_utf8(u16) == u8);
+                // 非法序列同样
+                const auto bad8 = u8.substr(0, at) + "\xC0" + u8.substr(at);
+                const auto bad16 = u16.substr(0, at) + u"\uFFFD" + u16.substr(at);
+                LUI_CHECK(LongUI::impl::to_utf16(bad8) == bad16);
+                const auto lone16 = u16.substr(0, at) + char16_t(0xDC00) + u16.substr(at);
+                LUI_CHECK(LongUI::impl::to_utf8(lone16) == u8.substr(0, at) + LongUI::impl::REPLACEMENT + u8.substr(at));
+            }
+        }
+    }
+}
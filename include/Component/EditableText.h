@@ -29,6 +29,12 @@
 #include "../Graphics/luiGrDwrt.h"
 #include "../Core/luiString.h"
 #include "../Platless/luiPlEzC.h"
+#include "../Platless/luiPlPiece.h"
+#include "../Platless/luiPlLine.h"
+#include "../Platless/luiPlUndo.h"
+#include "../Platless/luiPlFind.h"
+#include "../Platless/luiPlToken.h"
+#include "ParagraphLayout.h"
 #include "../LongUI/luiUiTxtRdr.h"
 #include "../Core/luiMenu.h"
 #include <cstdint>
@@ -42,6 +48,8 @@ namespace LongUI { namespace Component {
         // 缓冲区
         using MetricsBuffer = EzContainer::SmallBuffer<HitTestMetrics, 8>;
     public:
+        // progress call back of deferred layout: (laid out, total) in char
+        using ProgressCallBack = CUIFunction<void(uint32_t, uint32_t)>;
         // the mode of text selection zone 选择区模式
         enum SelectionMode : uint32_t {
             Mode_Left = 0,      // 左移
@@ -59,6 +67,8 @@ namespace LongUI { namespace Component {
             Mode_Leading,       // 鼠标点击位置
             Mode_Trailing,      // 选择后缘
             Mode_SelectAll,     // 全选
+            Mode_PageUp,        // 上移一页
+            Mode_PageDown,      // 下移一页
         };
         // the type of editable text, bit array
         // same as TXTBIT_XXXXXXX in TextServ.h
@@ -108,12 +118,18 @@ namespace LongUI { namespace Component {
         void AddReturnEventCall(UICallBack&& call) noexcept { m_evReturn += std::move(call); }
         // add return event call
         void AddChangedEventCall(UICallBack&& call) noexcept { m_evChanged += std::move(call); }
+        // add progress event call of deferred layout
+        void AddProgressEventCall(ProgressCallBack&& call) noexcept { m_evProgress += std::move(call); }
+        // is layout of some text deferred?
+        bool IsLayoutPending() const noexcept { return !!m_layout.GetPending(); }
         // get hittest
         auto GetHitTestMetrics() noexcept { return m_bufMetrice.GetData(); }
         // get hittest's length 
         auto GetHitTestLength() noexcept { return m_bufMetrice.GetCount(); }
-        // c-style string
-        auto c_str() const noexcept { return m_string.c_str(); }
+        // c-style string, contiguous view of text buffer
+        auto c_str() const noexcept { return m_buffer.c_str(); }
+        // get length of text
+        auto GetLength() const noexcept { return m_buffer.GetLength(); }
         // Resizes the layout, use this after resize
         void Resize(float w, float h) noexcept;
         /// <summary>
@@ -121,8 +137,40 @@ namespace LongUI { namespace Component {
         /// </summary>
         /// <returns></returns>
         void RecreateLayout() noexcept { this->recreate_layout(); }
-        // get string
-        auto&GetString() noexcept { return m_string; }
+        // get text buffer
+        const auto&GetBuffer() const noexcept { return m_buffer; }
+        // get count of lines
+        auto GetLineCount() const noexcept { return m_lines.GetLineCount(); }
+        // get line of text position, O(log n)
+        auto GetLineOfPosition(uint32_t pos) const noexcept { return m_lines.GetLineFromPosition(pos); }
+        // get text position of line start, O(log n)
+        auto GetPositionOfLine(uint32_t line) const noexcept { return m_lines.GetLineStart(line); }
+        // get line of caret, O(log n)
+        auto GetCaretLine() const noexcept { return m_lines.GetLineFromPosition(m_u32CaretPos + m_u32CaretPosOffset); }
+        // go to start of line, O(log n)
+        void GoToLine(uint32_t line, bool exsel = false) noexcept;
+        // undo last edit
+        bool Undo() noexcept;
+        // redo last undone edit
+        bool Redo() noexcept;
+        // can undo?
+        bool CanUndo() const noexcept { return m_undo.CanUndo(); }
+        // can redo?
+        bool CanRedo() const noexcept { return m_undo.CanRedo(); }
+        // set byte budget of undo history
+        void SetUndoBudget(uint32_t bytes) noexcept { m_undo.SetBudget(bytes); }
+        // find text from position, CUITextFinder::NPOS if not found, icase folds with LongUI::FoldCase
+        auto Find(const wchar_t* str, uint32_t len, uint32_t from = 0, bool icase = false) const noexcept ->uint32_t;
+        // find all non-overlapped matches, return count
+        auto FindAll(const wchar_t* str, uint32_t len, EzContainer::EzVector<uint32_t>& out, bool icase = false) const noexcept ->uint32_t;
+        // select next match after selection, wrap around
+        bool FindNext(const wchar_t* str, uint32_t len, bool icase = false) noexcept;
+        // replace all matches back to front, undone as one group, layout deferred, return count
+        auto ReplaceAll(const wchar_t* str, uint32_t len, const wchar_t* rep, uint32_t rlen, bool icase = false) noexcept ->uint32_t;
+        // set tokenizer for syntax highlighting, not owned, null to disable
+        void SetTokenizer(XUITokenizer* tokenizer, const D2D1_COLOR_F* colors, uint32_t count) noexcept;
+        // get style runs of syntax highlighting
+        auto&RefStyleRuns() const noexcept { return m_highlighter.RefRuns(); }
     private:
         // delete selection and recreate layout
         void delete_selandrelay() noexcept;
@@ -134,12 +182,40 @@ namespace LongUI { namespace Component {
         void recreate_layout(IDWriteTextFormat* fmt) noexcept;
         // recreate layout without format
         void recreate_layout() noexcept;
-        // insert text
-        auto insert(uint32_t pos, const wchar_t* str, /*in out*/uint32_t& length) noexcept ->HRESULT;
+        // relayout paragraphs touched by [pos, pos + removed) replaced with inserted chars
+        void relayout(uint32_t pos, uint32_t removed, uint32_t inserted) noexcept;
+        // insert text, typing will be coalesced in undo history
+        auto insert(uint32_t pos, const wchar_t* str, /*in out*/uint32_t& length, bool typing = false) noexcept ->HRESULT;
+        // insert large text in chunks, layout deferred to later frames
+        auto insert_stream(uint32_t pos, const wchar_t* str, /*in out*/uint32_t& length) noexcept ->HRESULT;
+        // filter input for number/password, return length of output
+        auto filter(const wchar_t* str, uint32_t length, wchar_t* out) const noexcept ->uint32_t;
+        // search text window by window, first match if out is null, or count of all matches
+        auto find_text(const wchar_t* str, uint32_t len, uint32_t from, bool icase, EzContainer::EzVector<uint32_t>* out) const noexcept ->uint32_t;
+        // lay out next slice of deferred text
+        void continue_layout() noexcept;
+        // record removing text to undo history
+        void record_remove(uint32_t pos, uint32_t len, bool typing) noexcept;
+        // record inserted text to undo history
+        void record_insert(uint32_t pos, uint32_t len, bool typing) noexcept;
+        // record [pos, pos + len) replaced with str to undo history
+        void record_replace(uint32_t pos, uint32_t len, const wchar_t* str, uint32_t length) noexcept;
+        // replace [pos, pos + removed) with str for undo/redo, caller selects restored text
+        void apply_delta(uint32_t pos, uint32_t removed, const wchar_t* str, uint32_t length) noexcept;
+        // move caret as part of edit, undo history not sealed
+        auto edit_selection(SelectionMode mode, uint32_t advance, bool update = true) noexcept ->HRESULT;
+        // draw text layout
+        void draw_text(ID2D1DeviceContext* target, float x, float y) const noexcept;
+        // is cached text bitmap same as text layout?
+        bool is_cache_valid() const noexcept;
+        // record text into cached bitmap if changed
+        void record_cache() noexcept;
+        // render old and new selection only if selection changed
+        void invalidate_selection() noexcept;
     public: // 一般内部设置区
         // get selection range
         auto GetSelectionRange()const noexcept ->DWRITE_TEXT_RANGE;
-        // set selection zone
+        // set selection zone, undo history sealed if caret moved
         auto SetSelection(SelectionMode, uint32_t, bool, bool = true) noexcept ->HRESULT;
         // delete the selection text
         auto DeleteSelection() noexcept ->HRESULT;
@@ -191,7 +267,7 @@ namespace LongUI { namespace Component {
         void GetTextBox(RectLTWH_F& rect) const noexcept;
         // update this
         void Update() noexcept;
-        // render this: absolute postion
+        // render this: absolute postion, selection under cached text bitmap if valid
         void Render(ID2D1DeviceContext* target, D2D1_POINT_2F) const noexcept;
         // refresh the selection HitTestMetrics
         void RefreshSelectionMetrics(DWRITE_TEXT_RANGE) noexcept;
@@ -215,10 +291,12 @@ namespace LongUI { namespace Component {
     private:
         // ensure string
         void ensure_string(CUIString& str) noexcept;
-        // remove text
-        auto remove_text(uint32_t off, uint32_t len) noexcept {
-            this->IsReadOnly() ? LongUI::BeepError() : m_string.Remove(off, len);
-            return !this->IsReadOnly();
+        // remove text, typing will be coalesced in undo history
+        auto remove_text(uint32_t off, uint32_t len, bool typing = false) noexcept {
+            if (this->IsReadOnly()) { LongUI::BeepError(); return false; }
+            this->record_remove(off, len, typing);
+            m_buffer.Remove(off, len); this->relayout(off, len, 0);
+            return true;
         }
     public:
         // set color
@@ -232,12 +310,10 @@ namespace LongUI { namespace Component {
         // initizlize without xml-node
         void Init() noexcept;
         // get layout
-        auto RefLayout() const noexcept { return m_pLayout; }
-        // get layout
-        auto GetLayout() const noexcept { return LongUI::SafeAcquire(m_pLayout); }
+        auto&RefLayout() const noexcept { return m_layout; }
     private:
-        // type of text
-        IDWriteTextLayout*      m_pLayout = nullptr;
+        // layout of text
+        ParagraphLayout         m_layout;
     public:
         // text render offset
         D2D1_POINT_2F           offset = D2D1_POINT_2F{0.f};
@@ -256,6 +332,8 @@ namespace LongUI { namespace Component {
         UICallBack              m_evReturn;
         // changed event
         UICallBack              m_evChanged;
+        // progress event of deferred layout
+        ProgressCallBack        m_evProgress;
         // context menu
         CUIMenu                 m_menuCtx;
         // render target
@@ -288,20 +366,48 @@ namespace LongUI { namespace Component {
         bool                    m_bDragFormatOK = false;
         // drag data from this
         bool                    m_bDragFromThis = false;
+        // applying undo/redo, not recorded
+        bool                    m_bUndoing = false;
+        // moving caret as part of edit
+        bool                    m_bEditSelection = false;
         // stg medium
         STGMEDIUM               m_recentMedium;
         // hit test metrics
         MetricsBuffer           m_bufMetrice;
+        // bounds of selection rendered
+        D2D1_RECT_F             m_rcSelection = D2D1_RECT_F{ 0.f };
+        // cached bitmap of text
+        ID2D1Bitmap1*           m_pTextCache = nullptr;
+        // offset of cached text
+        D2D1_POINT_2F           m_ptCache = D2D1_POINT_2F{ 0.f };
+        // size of cached text
+        D2D1_SIZE_F             m_szCache = D2D1_SIZE_F{ 0.f };
+        // world scale of cached text
+        D2D1_SIZE_F             m_szCacheScale = D2D1_SIZE_F{ 0.f };
+        // color of cached text
+        D2D1_COLOR_F            m_colorCache = D2D1_COLOR_F{ 0.f };
         // the anchor of caret 光标锚位 -- 当前位置
         uint32_t                m_u32CaretAnchor = 0;
         // the position of caret 光标位置 -- 起始位置
         uint32_t                m_u32CaretPos = 0;
         // the pos offset of caret 光标偏移 -- 选择区大小
         uint32_t                m_u32CaretPosOffset = 0;
-        // unused
-        uint32_t                m_unused_u32;
-        // string of text
-        CUIString               m_string;
+        // total length of deferred layout for progress
+        uint32_t                m_uPendingTotal = 0;
+        // version of text layout, changed when drawing of text changed
+        uint32_t                m_uLayoutVersion = 1;
+        // version of text layout cached
+        uint32_t                m_uCacheVersion = 0;
+        // text buffer
+        CUIPieceTable           m_buffer;
+        // line-start index of text buffer
+        CUILineIndex            m_lines;
+        // undo/redo history
+        CUIUndoStack            m_undo;
+        // syntax highlighting
+        CUIHighlighter          m_highlighter;
+        // drawing effect of highlighting styles
+        EzContainer::EzVector<IUnknown*> m_vStyleEffects;
     public:
         // basic color
         D2D1_COLOR_F            color[STATE_COUNT];
@@ -0,0 +1,176 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include "../Graphics/luiGrDwrt.h"
+#include "../Platless/luiPlEzC.h"
+#include "../Platless/luiPlPiece.h"
+#include "../Platless/luiPlToken.h"
+#include <cstdint>
+
+// longui::component namespace
+namespace LongUI { namespace Component {
+    // text layout split into paragraph chunks, only chunks touched by edit are re-laid out
+    class ParagraphLayout {
+        // null index
+        enum : uint32_t { NIL = uint32_t(-1) };
+    public:
+        // paragraph chunk
+        struct Chunk {
+            // layout of paragraph, null if deferred
+            IDWriteTextLayout*  layout;
+            // first char position in text
+            uint32_t            position;
+            // length of text, newline included
+            uint32_t            length;
+            // line count, without empty line after newline
+            uint32_t            lines;
+            // top of chunk in block
+            float               top;
+            // height of chunk
+            float               height;
+            // left of chunk
+            float               left;
+            // width of chunk, trailing whitespace included
+            float               width;
+        };
+    private:
+        // chunk vector
+        using ChunkVector = EzContainer::EzVector<Chunk>;
+    public:
+        // ctor
+        ParagraphLayout() noexcept = default;
+        // dtor
+        ~ParagraphLayout() noexcept { this->Release(); }
+        // no copy
+        ParagraphLayout(const ParagraphLayout&) = delete;
+        // release all chunks
+        void Release() noexcept;
+        // set format, call Build() after this
+        void SetFormat(IDWriteTextFormat* fmt) noexcept;
+        // set single chunk mode for whole document layout(rich text)
+        void SetSingleChunk(bool single) noexcept { m_bSingle = single; }
+        // set password char, 0 for none
+        void SetPasswordChar(wchar_t ch) noexcept { m_chPwd = ch; }
+        // set style runs and drawing effect of each style, not owned, null runs for none
+        void SetStyles(const CUIStyleRuns* runs, IUnknown* const* effects, uint32_t count) noexcept {
+            m_pRuns = runs; m_ppEffects = effects; m_cEffects = count;
+        }
+        // re-apply styles to chunks touching text range [begin, end)
+        void Restyle(uint32_t begin, uint32_t end) noexcept;
+        // build all chunks from text
+        auto Build(const CUIPieceTable& text) noexcept ->HRESULT;
+        // update chunks after [pos, pos + removed) was replaced with inserted chars
+        auto Update(const CUIPieceTable& text, uint32_t pos, uint32_t removed, uint32_t inserted) noexcept ->HRESULT {
+            return this->update(text, pos, removed, inserted, false);
+        }
+        // same as Update, but layout of touched paragraphs is deferred to Continue()
+        auto Defer(const CUIPieceTable& text, uint32_t pos, uint32_t removed, uint32_t inserted) noexcept ->HRESULT {
+            return this->update(text, pos, removed, inserted, true);
+        }
+        // lay out deferred paragraphs, at least budget chars if any
+        auto Continue(const CUIPieceTable& text, uint32_t budget) noexcept ->HRESULT;
+        // get count of chars whose layout is deferred
+        auto GetPending() const noexcept ->uint32_t { return m_ixPending == NIL ? 0 : m_vChunks[m_ixPending].length; }
+        // resize
+        void Resize(float width, float height) noexcept;
+        // is ok?
+        bool IsOk() const noexcept { return !m_vChunks.empty(); }
+        // get chunk count
+        auto GetChunkCount() const noexcept { return m_vChunks.size(); }
+        // get chunk
+        auto&GetChunk(uint32_t index) const noexcept { return m_vChunks[index]; }
+        // get layout of single chunk mode
+        auto RefSingleLayout() const noexcept { return m_bSingle && this->IsOk() ? m_vChunks[0].layout : nullptr; }
+        // find chunk containing text position, O(log n)
+        auto FindChunk(uint32_t pos) const noexcept ->uint32_t;
+        // find chunk at y in block, O(log n)
+        auto FindChunkAt(float y) const noexcept ->uint32_t;
+        // get visual line containing text position, return start of line, O(log n + lines of paragraph)
+        auto GetLineAt(uint32_t pos, DWRITE_LINE_METRICS& metrics) const noexcept ->uint32_t;
+        // get start of word before text position, O(log n + clusters of paragraph)
+        auto GetWordLeft(uint32_t pos) const noexcept ->uint32_t;
+        // get last cluster of word at or after text position, return start of cluster, O(log n + clusters of paragraph)
+        auto GetWordRight(uint32_t pos, uint32_t& length) const noexcept ->uint32_t;
+    public: // same as IDWriteTextLayout, deferred chunk as one line or clusters without width
+        // get metrics of whole text
+        auto GetMetrics(DWRITE_TEXT_METRICS* metrics) const noexcept ->HRESULT { *metrics = m_metrics; return S_OK; }
+        // get line metrics of all chunks
+        auto GetLineMetrics(DWRITE_LINE_METRICS* metrics, uint32_t max_count, uint32_t* actual) const noexcept ->HRESULT;
+        // get cluster metrics of all chunks
+        auto GetClusterMetrics(DWRITE_CLUSTER_METRICS* metrics, uint32_t max_count, uint32_t* actual) const noexcept ->HRESULT;
+        // hit test text position
+        auto HitTestTextPosition(uint32_t pos, BOOL trailing, float* x, float* y, DWRITE_HIT_TEST_METRICS* metrics) const noexcept ->HRESULT;
+        // hit test point
+        auto HitTestPoint(float x, float y, BOOL* trailing, BOOL* inside, DWRITE_HIT_TEST_METRICS* metrics) const noexcept ->HRESULT;
+        // hit test text range
+        auto HitTestTextRange(uint32_t pos, uint32_t length, float x, float y,
+            DWRITE_HIT_TEST_METRICS* metrics, uint32_t max_count, uint32_t* actual) const noexcept ->HRESULT;
+        // draw chunks in [top, bottom) of block
+        void Draw(void* context, IDWriteTextRenderer* renderer, float x, float y, float top, float bottom) const noexcept;
+    private:
+        // update chunks touched by edit, lay out them or defer
+        auto update(const CUIPieceTable& text, uint32_t pos, uint32_t removed, uint32_t inserted, bool defer) noexcept ->HRESULT;
+        // replace count chunks from index with new chunks in one pass
+        bool splice_chunks(uint32_t index, uint32_t count, const ChunkVector& chunks) noexcept;
+        // create layouts for paragraphs in text range [begin, end), append to chunks
+        auto create_chunks(const CUIPieceTable& text, uint32_t begin, uint32_t end, ChunkVector& chunks) noexcept ->HRESULT;
+        // create layout for a paragraph, append to chunks
+        auto create_chunk(wchar_t* str, uint32_t position, uint32_t length, ChunkVector& chunks) noexcept ->HRESULT;
+        // apply styles in text range [begin, end) to chunk
+        void apply_styles(const Chunk& chunk, uint32_t begin, uint32_t end) noexcept;
+        // measure chunk
+        void measure_chunk(Chunk& chunk) noexcept;
+        // get cluster metrics of chunk, return count needed, filled if max_count is enough
+        auto chunk_clusters(const Chunk& chunk, DWRITE_CLUSTER_METRICS* metrics, uint32_t max_count) const noexcept ->uint32_t;
+        // refresh top of chunks from index and whole metrics
+        void refresh_metrics(uint32_t index) noexcept;
+    private:
+        // chunks
+        ChunkVector                 m_vChunks;
+        // text format
+        IDWriteTextFormat*          m_pFormat = nullptr;
+        // style runs
+        const CUIStyleRuns*         m_pRuns = nullptr;
+        // drawing effect of styles
+        IUnknown* const*            m_ppEffects = nullptr;
+        // count of effects
+        uint32_t                    m_cEffects = 0;
+        // metrics of whole text
+        DWRITE_TEXT_METRICS         m_metrics = DWRITE_TEXT_METRICS{ 0.f };
+        // size of layout
+        D2D1_SIZE_F                 m_size = D2D1_SIZE_F{ 96.f, 96.f };
+        // offset of block for paragraph alignment
+        float                       m_fOffsetY = 0.f;
+        // index of deferred chunk
+        uint32_t                    m_ixPending = NIL;
+        // password char
+        wchar_t                     m_chPwd = 0;
+        // single chunk mode
+        bool                        m_bSingle = false;
+    };
+}}
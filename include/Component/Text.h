@@ -70,6 +70,8 @@ namespace LongUI { namespace Component {
         void Resize(float w, float h) noexcept;
         // render it
         void Render(ID2D1DeviceContext* target, D2D1_POINT_2F) const noexcept;
+        // render layout with color, snapshotted for render thread
+        void Render(ID2D1DeviceContext* target, D2D1_POINT_2F, IDWriteTextLayout*, const D2D1_COLOR_F&) const noexcept;
         // get text box
         void GetTextBox(RectLTWH_F& rect) const noexcept;
     public:
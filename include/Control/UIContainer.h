@@ -25,6 +25,7 @@
 */
 
 #include "UIMarginalable.h"
+#include "../LongUI/luiUiProf.h"
 
 // LongUI namespace
 namespace LongUI {
@@ -50,18 +51,15 @@ namespace LongUI {
         virtual bool DoMouseEvent(const LongUI::MouseEventArgument& arg) noexcept override;
         // recreate this
         virtual auto Recreate() noexcept ->HRESULT override;
-    public:
-#ifdef _DEBUG
     private:
-        // debug for_each
-        virtual void debug_for_each(const CUIFunction<void(UIControl*)>& call) noexcept = 0;
+        // for_each child
+        virtual void for_each_child(const CUIFunction<void(UIControl*)>& call) noexcept = 0;
     public:
-        // debug for_each helper
-        template<typename T> void DebugForEach(T call) noexcept {
+        // for_each child helper
+        template<typename T> void ForEachChild(T call) noexcept {
             CUIFunction<void(UIControl*)> func(call);
-            this->debug_for_each(func);
+            this->for_each_child(func);
         }
-#endif
         // find child control by mouse point
         virtual auto FindChild(const D2D1_POINT_2F& pt) noexcept ->UIControl* ;
         // refresh layout
@@ -154,7 +152,7 @@ namespace LongUI {
         auto GetPopularChild() const noexcept { return m_pPopularChild; }
         // set popular child(like radio button)
         void SetPopularChild(UIControl* ctrl) noexcept;
-    private:
+    protected:
         // refresh marginal controls
         void refresh_marginal_controls() noexcept;
         // auto template size
@@ -172,6 +170,7 @@ namespace LongUI {
         void release_child(UIControl* ctrl) noexcept { 
             assert(ctrl && (ctrl->parent == this || !ctrl->parent)); 
             force_cast(ctrl->parent) = nullptr;
+            this->InvalidateTreeOrder();
             ctrl->Release(); 
         }
         // after insert
@@ -212,12 +211,12 @@ namespace LongUI {
         // zoom size
         D2D1_SIZE_F             m_2fZoom = D2D1_SIZE_F{1.f,1.f};
     public:
-        // helper for update
+        // helper for update, return true if world or size of any child changed
         template<typename TSuperClass, typename TIterator>
-        void UpdateHelper(TIterator itrbegin, TIterator itrend) noexcept;
-        // helper for render
-        template<typename TIterator, typename RT>
-        void RenderHelper(RT render_target,TIterator itrbegin, TIterator itrend) const noexcept;
+        bool UpdateHelper(TIterator itrbegin, TIterator itrend) noexcept;
+        // helper for render, render children in front frame
+        template<typename RT>
+        void RenderHelper(RT render_target) const noexcept;
 #ifdef LongUIDebugEvent
     protected:
         // debug infomation
@@ -231,7 +230,7 @@ namespace LongUI {
     // ------------------------------ INLINE IMPLEMENT -------------------------------
     // helper for update
     template<typename TSuperClass, typename TIterator>
-    inline void UIContainer::UpdateHelper(TIterator itrbegin, TIterator itrend) noexcept {
+    inline bool UIContainer::UpdateHelper(TIterator itrbegin, TIterator itrend) noexcept {
         // update for super
         TSuperClass::Update();
         // change if need refresh
@@ -264,28 +263,40 @@ namespace LongUI {
         // update marginal control
         for (auto itr = this->MCBegin(); itr != MCEnd(); ++itr) {
             auto ctrl = (*itr);
+#ifdef LONGUI_WITH_CONTROL_PROFILER
+            CUIControlProfiler::Scope scope(ctrl, CUIControlProfiler::Kind_Update);
+#endif
             ctrl->Update();
             ctrl->AfterUpdate();
         }
         // update children
+        bool changed = false;
         for (auto itr = itrbegin; itr != itrend; ++itr) {
             auto ctrl = (*itr);
+#ifdef LONGUI_WITH_CONTROL_PROFILER
+            CUIControlProfiler::Scope scope(ctrl, CUIControlProfiler::Kind_Update);
+#endif
             ctrl->Update();
+            // AfterUpdate会清除标记, 之前检查
+            changed |= ctrl->IsNeedRefreshWorld();
             ctrl->AfterUpdate();
         }
+        return changed;
     }
     // helper for render
-    template<typename TIterator, typename RT>
-    inline void UIContainer::RenderHelper(RT target, TIterator itrbegin, TIterator itrend) const noexcept {
+    template<typename RT>
+    inline void UIContainer::RenderHelper(RT target) const noexcept {
+        const auto& state = this->RefRenderState();
         // push clip for children
         {
-            D2D1_RECT_F clip_rect; this->GetViewRect(clip_rect);
+            D2D1_RECT_F clip_rect = { 0.f, 0.f, state.view_size.width, state.view_size.height };
             target->PushAxisAlignedClip(
                 &clip_rect, D2D1_ANTIALIAS_MODE_ALIASED
             );
         }
-        // render children
-        for (auto itr = itrbegin; itr != itrend; ++itr) {
+        // render children snapshotted, not live children
+        auto itr = this->GetRenderChildren() + state.marginal_count;
+        for (const auto end = itr + state.child_count; itr != end; ++itr) {
             this->child_do_render(*itr);
         }
         // pop
@@ -25,6 +25,7 @@
 */
 
 #include "UIContainer.h"
+#include "../Platless/luiPlGrid.h"
 
 // LongUI namespace
 namespace LongUI {
@@ -42,7 +43,7 @@ namespace LongUI {
         // init without xml-node
         void initialize() noexcept { return Super::initialize(); }
         // dtor
-        ~UIContainerBuiltIn() noexcept {}
+        ~UIContainerBuiltIn() noexcept { delete m_pGrid; }
     public:
         // itr 迭代器
         class Iterator {
@@ -117,6 +118,10 @@ namespace LongUI {
     protected:
         // insert only
         void insert_only(Iterator itr, UIControl* ctrl) noexcept;
+        // invalidate spatial index, rebuild in next FindChild
+        void invalidate_grid() noexcept { if (m_pGrid) m_pGrid->Clear(); }
+        // rebuild spatial index
+        void rebuild_grid() noexcept;
         // render chain -> background
         void render_chain_background() const noexcept { return Super::render_chain_background(); }
         // render chain -> mainground
@@ -128,18 +133,18 @@ namespace LongUI {
         auto begin() const noexcept { return Iterator(m_pHead); };
         // end
         auto end() const noexcept { return Iterator(nullptr); };
-#ifdef _DEBUG
     private:
-        // debug for_each
-        virtual void debug_for_each(const CUIFunction<void(UIControl*)>& call) noexcept override {
+        // for_each child
+        virtual void for_each_child(const CUIFunction<void(UIControl*)>& call) noexcept override {
             for (auto ctrl : (*this)) { call(ctrl); }
         }
-#endif
     protected:
         // head of list
         UIControl*              m_pHead = nullptr;
         // tail of list
         UIControl*              m_pTail = nullptr;
+        // spatial index for hit-testing, created when too many children
+        CUISpatialGrid*         m_pGrid = nullptr;
 #ifdef LongUIDebugEvent
     protected:
         // debug infomation
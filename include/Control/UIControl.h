@@ -28,6 +28,7 @@
 #include "../luiconf.h"
 #include "../Platless/luiPlUtil.h"
 #include "../Platless/luiPlHlper.h"
+#include "../Platless/luiPlEzC.h"
 #include "../Core/luiString.h"
 #include <d2d1_3.h>
 #ifdef LongUIDebugEvent
@@ -102,6 +103,29 @@ namespace LongUI {
             arg.stf.value = value; this->DoEvent(arg);
         }
     public:
+        // render-relevant state copied in update, render thread reads it only
+        struct RenderState {
+            // transform for world
+            D2D1_MATRIX_3X2_F       world = DX::Matrix3x2F::Identity();
+            // visible rect in window
+            D2D1_RECT_F             visible_rect = D2D1_RECT_F{0.f};
+            // size of viewport
+            D2D1_SIZE_F             view_size = D2D1_SIZE_F{0.f};
+            // color of border
+            D2D1_COLOR_F            border_color = D2D1_COLOR_F{0.f};
+            // color of text
+            D2D1_COLOR_F            text_color = D2D1_COLOR_F{0.f};
+            // text layout, AddRef-ed
+            IDWriteTextLayout*      layout = nullptr;
+            // first renderable child in children of frame, marginal controls first
+            uint32_t                child_begin = 0;
+            // count of renderable marginal controls
+            uint32_t                marginal_count = 0;
+            // count of renderable children, marginal controls excluded
+            uint32_t                child_count = 0;
+            // serial of frame snapshot written
+            uint32_t                serial = 0;
+        };
 #ifdef _DEBUG
         // debug checker
         enum : uint32_t {
@@ -132,6 +156,8 @@ namespace LongUI {
     protected:
         // [uniform interface]ui call
         virtual bool uniface_addevent(SubEvent, UICallBack&&) noexcept { return false; };
+        // copy control-specific state to render state
+        virtual void snapshot_render(RenderState& /*state*/) noexcept { }
         // render chain -> background
         void render_chain_background() const noexcept;
         // render chain -> background
@@ -204,6 +230,20 @@ namespace LongUI {
         bool IsPosterityForSelf(const UIControl*) const noexcept;
         // is successor for self?  
         bool IsSuccessorForSelf(const UIControl* test) const noexcept { return this->IsPosterityForSelf(test); }
+        // refresh tree order(pre/post-order index) for this subtree
+        void RefreshTreeOrder(uint32_t& index) noexcept;
+        // is tree order valid?
+        bool IsTreeOrderValid() const noexcept;
+        // invalidate tree order of controls in same window, call it after tree changed
+        void InvalidateTreeOrder() noexcept;
+        // snapshot render state of this subtree into back frame, call it in update
+        void SnapshotRender(ControlVector& children, uint32_t back, uint32_t serial) noexcept;
+        // get render state in front frame, call it in render
+        auto RefRenderState() const noexcept ->const RenderState&;
+        // get renderable children in front frame, call it in render
+        auto GetRenderChildren() const noexcept ->UIControl*const*;
+        // get rect for cliping in front frame, call it in render
+        void GetRenderClipRect(D2D1_RECT_F& rect) const noexcept;
         // get taking up width of control
         auto GetTakingUpWidth() const noexcept ->float;
         // get taking up height of control
@@ -280,6 +320,10 @@ namespace LongUI {
 #endif
         // control name
         CUIWrappedCCP   const   name;
+#ifdef LONGUI_WITH_CONTROL_PROFILER
+        // class name registered for creating(xml element name), "" if created without xml
+        const char*             class_name = "";
+#endif
         // user ptr
         void*                   user_ptr = nullptr;
         // user data
@@ -293,6 +337,14 @@ namespace LongUI {
         float                   m_fRenderTime = 0.f;
         // render time, unused
         float                   m_fRenderTime_unused = 0.f;
+        // pre-order index in tree
+        uint32_t                m_uTreePre = 0;
+        // post-order index in tree, end of subtree
+        uint32_t                m_uTreePost = 0;
+        // version of tree order, compared with tree version of window
+        uint32_t                m_uTreeVersion = 0;
+        // render state: index of back frame for updating, front for rendering
+        RenderState             m_aRender[2];
     public:
         // parent control
         UIContainer*    const   parent = nullptr;
@@ -27,13 +27,15 @@
 #include "UILinearLayout.h"
 #include "../LongUI/luiUiHlper.h"
 #include "../Platless/luiPlEzC.h"
+#include "../Platless/luiPlFenwick.h"
+#include "../Platless/luiPlRange.h"
+#include "../Platless/luiPlSort.h"
 #include "../Platonly/luiPoHlper.h"
 
 
 // LongUI namespace
 namespace LongUI {
     // ui list line, the width child must be fixed
-    // State_Self1 : Selected
     class UIListLine : public UIHorizontalLayout {
         // super class
         using Super = UIHorizontalLayout;
@@ -61,10 +63,10 @@ namespace LongUI {
         auto GetToBeSorted() const noexcept { return m_pToBeSorted; }
         // set to be sorted control
         auto SetToBeSorted(uint32_t index) noexcept { m_pToBeSorted = this->GetAt(index); }
-        // selected!
-        auto SetSelected(bool b) noexcept { m_state.SetTo<State_Self1>(b); }
-        // selected?
-        auto IsSelected() const noexcept { return m_state.Test<State_Self1>(); }
+        // set row height, <= 0 for line height of list
+        auto SetRowHeight(float h) noexcept { m_fRowHeight = h; }
+        // get row height, <= 0 for line height of list
+        auto GetRowHeight() const noexcept { return m_fRowHeight; }
         // get sorted child text
         auto GeToBeSortedText() const noexcept { return m_pToBeSorted ? m_pToBeSorted->GetText() : L""; }
         // get first child text
@@ -81,6 +83,8 @@ namespace LongUI {
     protected:
         // to be sorted control
         UIControl*          m_pToBeSorted = nullptr;
+        // row height, <= 0 for line height of list
+        float               m_fRowHeight = 0.f;
 #ifdef LongUIDebugEvent
     protected:
         // debug infomation
@@ -154,6 +158,29 @@ namespace LongUI {
             // default flag
             Flag_Default = 0,
         };
+        // type of selection change
+        enum SelectionChangeType : uint32_t {
+            // selection cleared, then [begin, end) selected
+            Selection_Set = 0,
+            // [begin, end) added
+            Selection_Add,
+            // [begin, end) toggled
+            Selection_Toggle,
+            // selection cleared
+            Selection_Clear,
+        };
+        // selection change, reported by Event_ValueChanged
+        struct SelectionChange {
+            // first row
+            uint32_t                begin;
+            // last row + 1
+            uint32_t                end;
+            // type of change
+            SelectionChangeType     type;
+        };
+    private:
+        // type-ahead buffer length and timeout(ms) to restart
+        enum : uint32_t { TYPE_AHEAD_LENGTH = 32, TYPE_AHEAD_TIMEOUT = 1000, };
     public:
         // render this
         virtual void Render() const noexcept override;
@@ -176,15 +203,16 @@ namespace LongUI {
         void render_chain_main() const noexcept;
         // render chain -> foreground
         void render_chain_foreground() const noexcept { return Super::render_chain_foreground(); }
-    public:
-#ifdef _DEBUG
+        // copy backgrounds of visible rows for render
+        virtual void snapshot_render(RenderState& state) noexcept override;
     private:
-        // debug for_each
-        virtual void debug_for_each(const CUIFunction<void(UIControl*)>& call) noexcept override {
+        // background of visible row, copied for render
+        struct RowBackground { D2D1_RECT_F rect; D2D1_COLOR_F color; };
+        // for_each child
+        virtual void for_each_child(const CUIFunction<void(UIControl*)>& call) noexcept override {
             for (auto ctrl : (m_vLines)) { call(ctrl); }
         }
     public:
-#endif
         // push back
         virtual void Push(UIControl* child) noexcept;
         // remove child 
@@ -197,6 +225,27 @@ namespace LongUI {
         auto GetAt(uint32_t index) const noexcept { return m_vLines[index]; }
         // clear list
         void ClearList() noexcept;
+    public:
+        // set data source, switch to virtual mode if not null
+        void SetDataSource(IUIListDataSource* source) noexcept;
+        // data source changed, rebind all lines
+        void NotifyDataChanged() noexcept;
+        // get data source
+        auto GetDataSource() const noexcept { return m_pDataSource; }
+        // is virtual mode?
+        auto IsVirtual() const noexcept { return !!m_pDataSource; }
+        // get row count, lines count in normal mode
+        auto GetRowCount() const noexcept ->uint32_t { return m_pDataSource ? m_cVirtualRow : m_cChildrenCount; }
+        // get line of row, null if not bound in virtual mode
+        auto GetLineOfRow(uint32_t row) const noexcept ->UIListLine*;
+        // set height of row, <= 0 for line height
+        void SetRowHeight(uint32_t row, float height) noexcept;
+        // get height of row
+        auto GetRowHeight(uint32_t row) const noexcept ->float;
+        // get top of row in content
+        auto GetRowTop(uint32_t row) const noexcept ->float { return m_oRowOffset.PrefixSum(row); }
+        // get row at top of content, row count if out of range
+        auto GetRowFromOffset(float top) const noexcept ->uint32_t { return m_oRowOffset.Find(top); }
     public:
         // get line-element count
         auto GetLineElementCount() const noexcept { return m_vLineTemplate.size(); }
@@ -214,17 +263,44 @@ namespace LongUI {
         template<typename ...Args> bool PushLineElement(Args... args) noexcept { return this->InsertLineElement(m_cChildrenCount, args...); }
         // insert line-elemnet
         template<typename ...Args> bool InsertLineElement(uint32_t index, Args...) noexcept;
+        // insert lines with line-template in batch, call fill(UIListLine*, uint32_t index) for each, return inserted count
+        template<typename Lambda> auto InsertLines(uint32_t index, uint32_t count, Lambda fill) noexcept ->uint32_t;
+        // push lines with line-template in batch
+        template<typename Lambda> auto PushLines(uint32_t count, Lambda fill) noexcept { return this->InsertLines(m_cChildrenCount, count, fill); }
+        // insert lines keeping order of sort column, index in fill is position before sorting
+        template<typename Lambda> auto InsertLinesSorted(uint32_t count, Lambda fill) noexcept ->uint32_t;
+        // move changed line to keep order of sort column, return new index
+        auto UpdateLineSorted(uint32_t index) noexcept ->uint32_t;
+        // get sort column, uint32_t(-1) if lines not in order
+        auto GetSortColumn() const noexcept { return m_ixSortColumn; }
+        // is sort descending?
+        auto IsSortDescending() const noexcept { return m_bSortDescending; }
+    public:
+        // set column for type-ahead search and prefix index, uint32_t(-1) to disable
+        void SetSearchColumn(uint32_t col) noexcept;
+        // get search column
+        auto GetSearchColumn() const noexcept { return m_ixSearchColumn; }
+        // find first row starting with prefix(case-insensitive) from row 'from' with wrapping, row count if not found
+        auto FindPrefix(const wchar_t* prefix, uint32_t from = 0) noexcept ->uint32_t;
+        // filter rows starting with prefix(case-insensitive), return count of matched rows
+        auto FilterPrefix(const wchar_t* prefix, CUIIntervalSet& rows) noexcept ->uint32_t;
+        // refresh key of row in prefix index, call after text of search column changed(e.g. line from InsertLineTemplateToList)
+        void RefreshSearchKey(uint32_t row) noexcept;
     public:
         // get conttrols
         const auto&GetContainer() const noexcept { return m_vLines; }
-        // get selected lines index
-        const auto&GetSelectedIndices() const noexcept { return m_vSelectedIndex; }
+        // get selected rows
+        const auto&GetSelection() const noexcept { return m_oSelection; }
+        // is row selected? O(log n)
+        bool IsRowSelected(uint32_t row) const noexcept { return m_oSelection.Contains(row); }
+        // get last selection change, valid during Event_ValueChanged
+        auto&GetLastSelectionChange() const noexcept { return m_lastSelection; }
         // get height in line
         auto GetLineHeight() const noexcept { return m_fLineHeight; }
         // get last clicked line index
         auto GetLastClickedLineIndex() const noexcept { return m_ixLastClickedLine; }
         // get last clicked line
-        auto GetLastClickedLine() const noexcept ->UIListLine* { return m_ixLastClickedLine < m_cChildrenCount ? m_vLines[m_ixLastClickedLine] : nullptr; }
+        auto GetLastClickedLine() const noexcept ->UIListLine* { return this->GetLineOfRow(m_ixLastClickedLine); }
         // get ToBeSortedHeaderChild, used during (AddBeforSortCallBack)
         auto GetToBeSortedHeaderChild() const noexcept { return m_pToBeSortedHeaderChild; }
         // set header
@@ -235,6 +311,10 @@ namespace LongUI {
         void SelectChild(uint32_t index, bool new_select = true) noexcept;
         // select to
         void SelectTo(uint32_t index1, uint32_t index2) noexcept;
+        // select all rows
+        void SelectAll() noexcept;
+        // clear selection
+        void ClearSelection() noexcept;
         // set all lines content width to 0
         void ZeroAllLinesContentWidth() noexcept;
     private:
@@ -244,18 +324,58 @@ namespace LongUI {
         void select_child(uint32_t index, bool new_select) noexcept;
         // select child
         void select_to(uint32_t index1, uint32_t index2) noexcept;
+        // selection changed
+        void selection_changed(uint32_t begin, uint32_t end, SelectionChangeType type) noexcept;
         // sort line
         void sort_line(bool(*cmp)(UIControl* a, UIControl* b)) noexcept;
+        // sort line with extracted keys, false if OOM
+        bool sort_line_by_key(bool string) noexcept;
         // init
         void init_layout() noexcept;
         // set new elements count
         void set_element_count(uint32_t length) noexcept;
+        // align line-elements to referent line
+        void align_line(UIListLine* line) noexcept;
+        // create line with line-template
+        auto create_template_line() noexcept ->UIListLine*;
+        // visible rows in [first, last)
+        void get_visible_rows(uint32_t& first, uint32_t& last) const noexcept;
+        // refresh layout in virtual mode
+        void refresh_virtual_layout() noexcept;
+        // relayout one row, shift rows after it
+        void relayout_row(uint32_t row, float height) noexcept;
+        // bind row to line in virtual mode
+        void bind_line(UIListLine* line, uint32_t row) noexcept;
         // referent ctrl
         auto get_referent_control() const noexcept ->UIListLine*;
         // find line via mouse point
         auto find_line(const D2D1_POINT_2F& pt) const noexcept ->UIListLine*;
         // find line via mouse point
         auto find_line_index(const D2D1_POINT_2F& pt) const noexcept ->uint32_t;
+        // fill line callback for batch inserting
+        using FillLineCall = void(*)(void* ctx, UIListLine* line, uint32_t index);
+        // insert lines in batch
+        auto insert_lines(uint32_t index, uint32_t count, FillLineCall call, void* ctx) noexcept ->uint32_t;
+        // insert lines in batch keeping order
+        auto insert_lines_sorted(uint32_t count, FillLineCall call, void* ctx) noexcept ->uint32_t;
+        // compare key of sort column in ascending, < 0 if a < b
+        auto compare_line_key(const UIListLine* a, const UIListLine* b) const noexcept ->int;
+        // less in current order of sort column
+        bool less_line_sorted(const UIListLine* a, const UIListLine* b) const noexcept;
+        // get text of cell, user_ptr first like sorting
+        auto get_cell_text(uint32_t row, uint32_t col) noexcept ->const wchar_t*;
+        // build prefix index if whole list changed, false if no search column
+        bool sync_prefix_index() noexcept;
+        // is prefix index built and maintained incrementally?
+        bool is_prefix_synced() const noexcept { return !m_bPrefixDirty && m_ixSearchColumn != uint32_t(-1); }
+        // get case-folded prefix key of row in search column
+        auto get_search_key(uint32_t row) noexcept ->uint64_t;
+        // match prefix of row, case-insensitive
+        bool match_prefix(uint32_t row, const wchar_t* prefix) noexcept;
+        // type-ahead with char
+        void type_ahead(char32_t ch) noexcept;
+        // scroll to make row visible
+        void ensure_row_visible(uint32_t row) noexcept;
         // push line-elemnet
         template<typename Itr> void push_back_le_helper(Itr) noexcept {}
         // push line-elemnet
@@ -289,8 +409,22 @@ namespace LongUI {
         // flag for list
         UIListFlag              list_flag = Flag_Default;
     protected:
-        // threshold for fast-sort
+        // threshold for fast-sort, sort with extracted keys if over this
         uint32_t                m_cFastSortThreshold = 32;
+        // sort column, uint32_t(-1) if lines not in order
+        uint32_t                m_ixSortColumn = uint32_t(-1);
+        // sort descending
+        bool                    m_bSortDescending = false;
+        // prefix index need full rebuilding: whole list sorted, replaced or column changed
+        bool                    m_bPrefixDirty = true;
+        // search column for type-ahead, uint32_t(-1) if disabled
+        uint32_t                m_ixSearchColumn = uint32_t(-1);
+        // length of type-ahead buffer
+        uint32_t                m_cTypeAhead = 0;
+        // time of last type-ahead char
+        uint32_t                m_dwTypeAheadTime = 0;
+        // type-ahead buffer
+        wchar_t                 m_szTypeAhead[TYPE_AHEAD_LENGTH];
         // double-click helper
         Helper::DoubleClick     m_hlpDbClick;
         // line back-color normal1
@@ -311,18 +445,34 @@ namespace LongUI {
         UICallBack              m_callLineClicked;
         // line db-clicked
         UICallBack              m_callLineDBClicked;
+        // selection changed
+        UICallBack              m_callSelectionChanged;
         // hovered line
         UIListLine*             m_pHoveredLine = nullptr;
+        // data source for virtual mode
+        IUIListDataSource*      m_pDataSource = nullptr;
+        // row count in virtual mode
+        uint32_t                m_cVirtualRow = 0;
+        // first row bound to line-pool in virtual mode
+        uint32_t                m_ixFirstBound = uint32_t(-1);
         // last clicked line index
         uint32_t                m_ixLastClickedLine = uint32_t(-1);
         // line height
         float                   m_fLineHeight = 32.f;
+        // row offset index
+        CUIFenwickTree          m_oRowOffset;
         // line template
         LineTemplateVector      m_vLineTemplate;
         // list lines vector
         LinesVector             m_vLines;
-        // selected line index vector
-        IndexVector             m_vSelectedIndex;
+        // selected rows
+        CUIIntervalSet          m_oSelection;
+        // prefix index of search column
+        CUIPrefixIndex          m_oPrefix;
+        // last selection change
+        SelectionChange         m_lastSelection = { 0, 0, Selection_Clear };
+        // row backgrounds: index of back frame for updating, front for rendering
+        EzContainer::EzVector<RowBackground> m_aRowBack[2];
 #ifdef LongUIDebugEvent
     protected:
         // debug infomation
@@ -345,8 +495,19 @@ namespace LongUI {
         auto line = this->InsertLineTemplateToList(index);
         if (line) this->push_back_le_helper(line->begin(), args...);
         else return false;
+        this->RefreshSearchKey(index);
         return true;
     }
+    // template for inserting lines in batch
+    template<typename Lambda> auto UIList::InsertLines(uint32_t index, uint32_t count, Lambda fill) noexcept ->uint32_t {
+        auto call = [](void* ctx, UIListLine* line, uint32_t i) noexcept { (*static_cast<Lambda*>(ctx))(line, i); };
+        return this->insert_lines(index, count, call, &fill);
+    }
+    // template for inserting lines in batch keeping order
+    template<typename Lambda> auto UIList::InsertLinesSorted(uint32_t count, Lambda fill) noexcept ->uint32_t {
+        auto call = [](void* ctx, UIListLine* line, uint32_t i) noexcept { (*static_cast<Lambda*>(ctx))(line, i); };
+        return this->insert_lines_sorted(count, call, &fill);
+    }
     // helper for push-back line-element
     template<typename Itr, typename ...Args> void UIList::push_back_le_helper(Itr itr, const wchar_t* p, Args... args) noexcept {
         auto ctrl = *itr; ctrl->SetText(p); ++itr;
@@ -99,13 +99,11 @@ namespace LongUI {
         auto begin() const noexcept { return m_vChildren.begin(); }
         // const end itr
         auto end() const noexcept { return m_vChildren.end(); }
-#ifdef _DEBUG
     private:
-        // debug for_each
-        virtual void debug_for_each(const CUIFunction<void(UIControl*)>& call) noexcept override {
+        // for_each child
+        virtual void for_each_child(const CUIFunction<void(UIControl*)>& call) noexcept override {
             for (auto ctrl : m_vChildren) call(ctrl);
         }
-#endif
     protected:
         // now display
         UIControl*                  m_pNowDisplay = nullptr;
@@ -80,13 +80,11 @@ namespace LongUI {
         auto begin() const noexcept { return &m_pChild; };
         // end
         auto end() const noexcept { return &m_pChild + 1; };
-#ifdef _DEBUG
     private:
-        // debug for_each
-        virtual void debug_for_each(const CUIFunction<void(UIControl*)>& call) noexcept override {
+        // for_each child
+        virtual void for_each_child(const CUIFunction<void(UIControl*)>& call) noexcept override {
             if (m_pChild) call(m_pChild);
         }
-#endif
     protected:
         // single one
         UIControl*              m_pChild = UIControl::GetPlaceholder();
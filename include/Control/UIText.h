@@ -55,6 +55,10 @@ namespace LongUI {
         void render_chain_main() const noexcept { return Super::render_chain_main(); }
         // render chain -> foreground
         void render_chain_foreground() const noexcept;
+        // render text in front frame
+        void render_text(D2D1_POINT_2F pt) const noexcept;
+        // copy text layout and color to render state
+        virtual void snapshot_render(RenderState& state) noexcept override;
     public:
         // create 创建
         static auto CreateControl(CreateEventType, pugi::xml_node) noexcept ->UIControl*;
@@ -123,6 +123,11 @@ namespace LongUI {
             Flag_RenderInAnytime = 1 << 2,
             // only one system window, like game(all child window will be logic window)
             Flag_OnlyOneSystemWindow = 1 << 3,
+            // pipelined rendering, render last frame snapshot on another thread while updating;
+            // dxgi lock is held only while publishing, control-specific values may still be read live
+            Flag_PipelinedRendering = 1 << 4,
+            // idle when nothing changed, sleep until invalidation/input/time-capsule wakes it
+            Flag_IdleWhenNoChange = 1 << 5,
             // -------------------------------------------------------------
             // [debug flag in _DEBUG] output font family infomation
             Flag_DbgOutputFontFamily = 1 << 10,
@@ -213,6 +218,16 @@ namespace LongUI {
         // redo
         virtual void Redo() noexcept = 0;
     };
+    // UI List Data Source, for UIList in virtual mode
+    class LONGUI_NOVTABLE IUIListDataSource : public IUIInterface {
+    public:
+        // get row count
+        virtual auto GetRowCount() noexcept ->uint32_t = 0;
+        // get text of cell, pointer must be valid until next call
+        virtual auto GetCellText(uint32_t row, uint32_t col) noexcept ->const wchar_t* = 0;
+        // get value of cell, for numeric column
+        virtual auto GetCellValue(uint32_t row, uint32_t col) noexcept ->double = 0;
+    };
     // operator for UIViewport::WindowFlag
     LONGUI_DEFINE_ENUM_FLAG_OPERATORS(IUIConfigure::ConfigureFlag, uint32_t);
 }
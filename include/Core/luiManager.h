@@ -32,6 +32,8 @@
 #include "luiInterface.h"
 #include "luiWindow.h"
 #include "../Platonly/luiPoUtil.h"
+#include "../Platonly/luiPoHlper.h"
+#include "../Platless/luiPlStat.h"
 #include "../Core/luiString.h"
 #include "../Control/UIViewport.h"
 #include <atomic>
@@ -65,6 +67,22 @@ namespace LongUI {
         using callback_create_viewport = auto(*)(
             pugi::xml_node node, XUIBaseWindow* container
             ) ->UIViewport*;
+    public:
+        // phase of frame
+        enum FramePhase : uint32_t {
+            // update time capsules
+            Phase_TimeCapsule = 0,
+            // update each window
+            Phase_WindowUpdate,
+            // input AfterUpdate
+            Phase_InputUpdate,
+            // render all windows
+            Phase_Render,
+            // cleanup delay-cleanup chain
+            Phase_DelayCleanup,
+            // count of phase
+            PHASE_COUNT,
+        };
     public:
         // initialize 初始化
         LongUIAPI auto Initialize(IUIConfigure* config = nullptr) noexcept ->HRESULT;
@@ -144,7 +162,7 @@ namespace LongUI {
         void RemoveTimeCapsule(void* id) noexcept { this->remove_time_capsule(id);  }
     private:
         // exit
-        inline void exit() noexcept { m_exitFlag = true; ::PostQuitMessage(0); }
+        inline void exit() noexcept { m_exitFlag = true; this->WakeUp(); ::PostQuitMessage(0); }
     public:
         // custom text rich format
         auto CustomRichType(const DX::FormatTextConfig& c, const wchar_t* f) noexcept {
@@ -184,6 +202,16 @@ namespace LongUI {
         //auto GetDropTargetHelper() noexcept { return LongUI::SafeAcquire(m_pDropTargetHelper); }
         // get display frequency
         auto GetDisplayFrequency() const noexcept { return m_dDisplayFrequency; };
+        // set target frame rate, 0 for display frequency(wait vblank if possible)
+        void SetTargetFrameRate(uint16_t hz) noexcept { m_uTargetFrameRate = hz; }
+        // get frame pacer for statistics
+        auto GetFramePacer() const noexcept ->const Helper::FramePacer& { return m_oPacer; }
+        // get histogram of frame phase in micro sec.
+        auto GetPhaseHistogram(FramePhase p) const noexcept ->const CUIHistogram& { assert(p < PHASE_COUNT && "out of range"); return m_aPhaseTime[p]; }
+        // get time in ms of frame phase at percentile(0-100), e.g. 50/95/99
+        auto GetPhaseTime(FramePhase p, float percentile) const noexcept { return float(this->GetPhaseHistogram(p).GetPercentile(percentile)) * 0.001f; }
+        // clear histograms of frame phase
+        void ClearPhaseTime() noexcept { for (auto& h : m_aPhaseTime) h.Clear(); }
         // lock data
         auto DataLock() noexcept { return m_uiDataLocker.Lock(); }
         // unlock data
@@ -193,7 +221,15 @@ namespace LongUI {
         // unlock dxgi
         auto DxgiUnlock() noexcept { return m_uiDxgiLocker.Unlock(); }
         // push delay cleanup
-        //auto PushDelayCleanup(UIControl* c) noexcept { m_vDelayCleanup.push_back(c); }
+        auto PushDelayCleanup(UIControl* c) noexcept { m_vDelayCleanup.push_back(c); }
+        // is render thread rendering the published frame?
+        bool IsRenderInFlight() const noexcept { return m_bRenderInFlight; }
+        // wake up the frame thread if it is sleeping for idle
+        void WakeUp() noexcept { if (m_bIdleSleeping.exchange(false)) ::SetEvent(m_hWakeUp); }
+        // get count of idle-sleep that frame thread entered
+        auto GetSleepCount() const noexcept { return m_cSleepCount.load(); }
+        // get count of idle-sleep that broken by WakeUp()
+        auto GetWakeCount() const noexcept { return m_cWakeCount.load(); }
         // push delay cleanup
         auto PushDelayCleanup(XUIBaseWindow* w) noexcept { m_vDelayDispose.push_back(w); }
         // ShowError with string
@@ -336,6 +372,8 @@ namespace LongUI {
         WindowVector                    m_vDelayDispose;
         // windows
         SystemWindowVector              m_vWindows;
+        // windows published to render, copied in publish
+        SystemWindowVector              m_vRenderWindows;
         // feature level
         D3D_FEATURE_LEVEL               m_featureLevel;
         // input
@@ -346,6 +384,10 @@ namespace LongUI {
         CUILocker                       m_uiDxgiLocker;
         // time-meter
         CUITimeMeterH                   m_uiTimeMeter;
+        // histograms of frame phase
+        CUIHistogram                    m_aPhaseTime[PHASE_COUNT];
+        // qpc frequency for frame phase
+        int64_t                         m_i64PhaseFreq = 1;
         // text renderer
         XUIBasicTextRenderer*           m_apTextRenderer[LongUITextRendererCountMax];
 #ifdef _DEBUG
@@ -380,18 +422,32 @@ namespace LongUI {
         uint16_t                        m_cCountMt = 0;
         // length of template node
         uint16_t                        m_cCountCtrlTemplate = 0;
-        // length of window*
-        uint16_t                        m_unused_u16 = 0;
+        // target frame rate, 0 for display frequency
+        uint16_t                        m_uTargetFrameRate = 0;
+        // event: frame published for rendering
+        HANDLE                          m_hRenderReady = nullptr;
+        // event: rendering finished
+        HANDLE                          m_hRenderDone = nullptr;
+        // event: wake up frame thread from idle
+        HANDLE                          m_hWakeUp = nullptr;
+        // count of idle-sleep
+        std::atomic<uint32_t>           m_cSleepCount = 0;
+        // count of idle-sleep broken by WakeUp()
+        std::atomic<uint32_t>           m_cWakeCount = 0;
+        // timeout of next idle-sleep in ms
+        uint32_t                        m_dwIdleTimeout = 0;
         // singal/flag for exiting
         std::atomic_bool                m_exitFlag = false;
+        // frame thread is(or will be) sleeping for idle
+        std::atomic_bool                m_bIdleSleeping = false;
+        // render thread is rendering the published frame
+        std::atomic_bool                m_bRenderInFlight = false;
         // count for text renderer
         uint8_t                         m_uTextRenderCount = 0;
         // ununsed
         uint16_t                        m_dDisplayFrequency = 0;
-        // vsync count
-        uint32_t                        m_dwWaitVSCount = 0;
-        // vsync start time
-        uint32_t                        m_dwWaitVSStartTime = 0;
+        // frame pacer for waiting without dxgi output
+        Helper::FramePacer              m_oPacer;
         // textrender: normal
         CUINormalTextRender             m_normalTRenderer;
         // textrender: outline
@@ -443,6 +499,20 @@ namespace LongUI {
         auto do_creating_event(CreateEventType type) noexcept ->HRESULT;
         // wait for VBlank
         void wait_for_vblank() noexcept;
+        // update all windows in one frame
+        void update_frame() noexcept;
+        // publish the frame to render
+        void publish_frame() noexcept;
+        // render all windows
+        void render_frame() noexcept;
+        // check if all windows are idle
+        void check_idle() noexcept;
+        // begin timing frame phase
+        static auto phase_begin() noexcept ->int64_t { LARGE_INTEGER t; ::QueryPerformanceCounter(&t); return t.QuadPart; }
+        // end timing frame phase
+        void phase_end(FramePhase p, int64_t begin) noexcept;
+        // sleep until woken up or timeout
+        void idle_sleep() noexcept;
         // refresh display frequency
         void refresh_display_frequency() noexcept;
         // update time capsules
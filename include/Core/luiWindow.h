@@ -28,6 +28,7 @@
 #include "../Platless/luiPlEzC.h"
 #include "../Platonly/luiPoHlper.h"
 #include "../Platless/luiPlHlper.h"
+#include "../Platless/luiPlDirty.h"
 
 #include <cstdint>
 #include <../3rdParty/pugixml/pugixml.hpp>
@@ -106,6 +107,25 @@ namespace LongUI {
             UIControl* child
         ) noexcept ->XUIBaseWindow*;
     public:
+        // snapshot of render-relevant data for one frame
+        struct FrameSnapshot {
+            // dirty region
+            CUIDirtyRegion      dirty;
+            // world transform for control of dirty unit
+            D2D1_MATRIX_3X2_F   world[LongUIDirtyRegionSize];
+            // world transform for viewport
+            D2D1_MATRIX_3X2_F   viewport;
+            // caret rect
+            D2D1_RECT_F         caret = D2D1_RECT_F{0.f};
+            // renderable children of each container, see UIControl::RenderState
+            ControlVector       children;
+            // serial of frame, render state of control is valid while same
+            uint32_t            serial = 0;
+            // do full-render this frame?
+            bool                full = true;
+            // caret in?
+            bool                caret_in = false;
+        };
         // index of BitArray
         enum BitArrayIndex : uint32_t {
             // [UN]
@@ -129,8 +149,6 @@ namespace LongUI {
             Index_CaretIn,
             // [RW] do caret
             //Index_DoCaret,
-            // [RW] do full-render this frame in render?
-            Index_FullRenderThisFrameRender,
             // [XX] count of this
             INDEX_COUNT,
         };
@@ -141,8 +159,14 @@ namespace LongUI {
         virtual auto Recreate() noexcept ->HRESULT;
         // render: call UIControl::Render
         virtual void Render() const noexcept;
-        // update: call UIControl::AfterUpdate
+        // wait until ready to render next frame, e.g. swap chain latency
+        virtual void WaitForRender() const noexcept {}
+        // update: call UIControl::AfterUpdate, build frame snapshot
         virtual void Update() noexcept;
+        // publish the frame snapshot built in last update to render
+        void PublishFrame() noexcept;
+        // get idle time in ms after last update, 0 for busy, INFINITE for no timer
+        virtual auto GetIdleTime() const noexcept ->uint32_t;
         // move window relative to parent
         virtual void MoveWindow(int32_t x, int32_t y) noexcept = 0;
         // close window
@@ -200,7 +224,15 @@ namespace LongUI {
         // copystring for control in this winddow in safe way
         auto CopyStringSafe(const char* str) noexcept { auto s = this->CopyString(str); return s ? s : ""; }
         // render window in next frame
-        void InvalidateWindow() noexcept { this->set_full_render_this_frame(); }
+        void InvalidateWindow() noexcept;
+        // get version of control tree
+        auto GetTreeVersion() const noexcept { return m_uTreeVersion; }
+        // invalidate tree order of controls, call it after control tree changed
+        void InvalidateTreeOrder() noexcept { ++m_uTreeVersion; }
+        // get index of front frame, for render state of controls
+        auto GetFrontIndex() const noexcept { return m_uFrameBack ^ 1; }
+        // get front frame snapshot, call it in render
+        auto RefFrontFrame() const noexcept ->const FrameSnapshot& { return this->front_frame(); }
     public:
         // add tabstop control
         void AddTabstop(UIControl* ctrl) noexcept;
@@ -218,6 +250,8 @@ namespace LongUI {
         bool DoEvent(const EventArgument& arg) noexcept;
         // render control in next frame
         void Invalidate(UIControl* ctrl) noexcept;
+        // render part of control in next frame, rect in window space
+        void InvalidateRect(UIControl* ctrl, const RectLTRB_F& rect) noexcept;
         // set focus control, set null to kill focused-control's focus
         void SetFocus(UIControl* ctrl) noexcept;
         // set hover track control
@@ -250,8 +284,6 @@ namespace LongUI {
         bool is_close_on_focus_killed() const noexcept { return m_baBoolWindow.Test<Index_CloseOnFocusKilled>(); }
         // is FullRenderingThisFrame
         bool is_full_render_this_frame() const noexcept { return m_baBoolWindow.Test<Index_FullRenderThisFrame>(); }
-        // is FullRenderingThisFrameRender
-        bool is_full_render_this_frame_render() const noexcept { return m_baBoolWindow.Test<Index_FullRenderThisFrameRender>(); }
     protected:
         // set PopupWindow to true
         void set_popup_window(bool p) noexcept { m_baBoolWindow.SetTo<Index_PopupWindow>(p); }
@@ -287,6 +319,14 @@ namespace LongUI {
     protected:
         // resized, called from child-class
         void resized() noexcept;
+        // add final visible rects of invalidated controls
+        void resolve_dirty_controls() noexcept;
+        // release invalidated controls
+        void release_dirty_controls() noexcept;
+        // frame snapshot for updating
+        auto back_frame() noexcept ->FrameSnapshot& { return m_aFrame[m_uFrameBack]; }
+        // frame snapshot for rendering
+        auto front_frame() const noexcept ->const FrameSnapshot& { return m_aFrame[m_uFrameBack ^ 1]; }
     protected:
         // longui viewport
         UIViewport*             m_pViewport = nullptr;
@@ -318,16 +358,18 @@ namespace LongUI {
         Helper::BitArray16      m_baBoolWindow;
         // mode for text anti-alias
         uint16_t                m_textAntiMode = D2D1_TEXT_ANTIALIAS_MODE_DEFAULT;
-        // data length of m_apUnits
-        uint16_t                m_uUnitLength = 0;
-        // data length of m_apUnits, in render
-        uint16_t                m_uUnitLengthRender = 0;
-        // data for unit
-        UIControl*              m_apUnit[LongUIDirtyControlSize];
-        // data for unit, in render
-        UIControl*              m_apUnitRender[LongUIDirtyControlSize];
-        // dirty rects
-        //RECT                    m_dirtyRects[LongUIDirtyControlSize];
+        // index of back frame snapshot
+        uint32_t                m_uFrameBack = 0;
+        // version of control tree, changed while tree changed
+        uint32_t                m_uTreeVersion = 1;
+        // serial of last frame snapshot built
+        uint32_t                m_uFrameSerial = 0;
+        // dirty region
+        CUIDirtyRegion          m_oDirty;
+        // invalidated controls, final visible rects resolved in update
+        ControlVector           m_vDirtyControls;
+        // frame snapshots: back for updating, front for rendering
+        FrameSnapshot           m_aFrame[2];
         // current STGMEDIUM: begin with DWORD
         STGMEDIUM               m_curMedium;
         // control name ->map-> control pointer
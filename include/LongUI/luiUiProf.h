@@ -0,0 +1,114 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include <cstdint>
+#include <atomic>
+
+#ifdef LONGUI_WITH_CONTROL_PROFILER
+// longui namespace
+namespace LongUI {
+    // control
+    class UIControl;
+    // profiler for update/render cost of control, one writer thread for each kind
+    class CUIControlProfiler {
+    public:
+        // kind of sample
+        enum Kind : uint32_t {
+            // UIControl::Update + UIControl::AfterUpdate
+            Kind_Update = 0,
+            // UIControl::Render
+            Kind_Render,
+            // count of kind
+            KIND_COUNT,
+        };
+        // limits
+        enum : uint32_t {
+            // max count of control recorded for each kind
+            MAX_CONTROL = 4096,
+            // max length of name
+            NAME_LENGTH = 48,
+        };
+        // stat of control
+        struct Stat {
+            // control, null after released
+            const UIControl*    ctrl;
+            // index of parent stat, UINT32_MAX for none
+            uint32_t            parent;
+            // inclusive time in tick
+            int64_t             inclusive;
+            // exclusive time in tick
+            int64_t             exclusive;
+            // count of call
+            uint32_t            calls;
+            // name of control
+            char                name[NAME_LENGTH];
+            // class name of control
+            char                klass[NAME_LENGTH];
+        };
+        // sample scope
+        class Scope {
+        public:
+            // ctor
+            Scope(const UIControl* ctrl, Kind kind) noexcept : m_kind(kind), m_uSession(CUIControlProfiler::GetSession()) {
+                if (m_uSession) CUIControlProfiler::Begin(ctrl, kind);
+            }
+            // dtor
+            ~Scope() noexcept { if (m_uSession) CUIControlProfiler::End(m_kind, m_uSession); }
+        private:
+            // kind
+            Kind        m_kind;
+            // session when begin, 0 for not sampling
+            uint32_t    m_uSession;
+        };
+    public:
+        // enable or disable, keep last `trace` events for each kind
+        static void Enable(bool enable, uint32_t trace = 0) noexcept;
+        // is enabled?
+        static bool IsEnabled() noexcept { return !!GetSession(); }
+        // get session, changed by each Enable(), 0 if disabled
+        static auto GetSession() noexcept ->uint32_t { return s_uSession.load(std::memory_order_relaxed); }
+        // clear samples
+        static void Clear() noexcept;
+        // begin sampling control
+        static void Begin(const UIControl* ctrl, Kind kind) noexcept;
+        // end sampling control, ignored if session changed after Begin()
+        static void End(Kind kind, uint32_t session) noexcept;
+        // forget the control, called when control destroyed
+        static void Forget(const UIControl* ctrl) noexcept;
+        // dump text report to file
+        static bool DumpReport(const wchar_t* file) noexcept;
+        // dump chrome trace-event json to file
+        static bool DumpTrace(const wchar_t* file) noexcept;
+    private:
+        // session, 0 for disabled
+        static std::atomic<uint32_t>    s_uSession;
+        // last session
+        static uint32_t                 s_uLastSession;
+    };
+}
+#endif
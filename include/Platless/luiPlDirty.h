@@ -0,0 +1,113 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include <cstdint>
+#include <cassert>
+
+// longui namespace
+namespace LongUI {
+    // dirty region, merge dirty rects for one frame
+    class CUIDirtyRegion {
+    public:
+        // check whether outer's rendering covers inner's
+        using CoverChecker = bool(*)(void* outer, void* inner);
+        // unit of region
+        struct Unit {
+            // rect of unit
+            RectLTRB_F      rect;
+            // user data, null if merged from different data
+            void*           data;
+        };
+    public:
+        // ctor
+        CUIDirtyRegion() noexcept = default;
+        // dtor
+        ~CUIDirtyRegion() noexcept = default;
+        // copy ctor
+        CUIDirtyRegion(const CUIDirtyRegion&) noexcept = default;
+        // operator =
+        auto operator=(const CUIDirtyRegion&) noexcept ->CUIDirtyRegion& = default;
+    public:
+        // add a rect with user data, zero-size rect grows to 1 pixel, inverted rect ignored
+        void AddRect(const RectLTRB_F& rect, void* data) noexcept;
+        // is the region too large for dirty-rendering?
+        bool IsOverRatio(float width, float height) const noexcept;
+        // clear region
+        void Clear() noexcept { m_uCount = 0; m_fArea = 0.f; }
+        // set cover checker
+        void SetCoverChecker(CoverChecker call) noexcept { m_pCoverChecker = call; }
+        // is empty?
+        bool IsEmpty() const noexcept { return !m_uCount; }
+        // get count of unit
+        auto GetCount() const noexcept { return m_uCount; }
+        // get total area of units, overlapped area maybe counted more than once
+        auto GetArea() const noexcept { return m_fArea; }
+        // begin
+        auto begin() const noexcept { return m_aUnits + 0; }
+        // end
+        auto end() const noexcept { return m_aUnits + m_uCount; }
+        // operator[]
+        auto&operator[](uint32_t i) const noexcept { assert(i < m_uCount && "out of range"); return m_aUnits[i]; }
+    public:
+        // get area of rect
+        static inline auto AreaOf(const RectLTRB_F& rc) noexcept { return (rc.right - rc.left) * (rc.bottom - rc.top); }
+        // union of 2 rects
+        static inline auto UnionOf(const RectLTRB_F& a, const RectLTRB_F& b) noexcept {
+            RectLTRB_F rc;
+            rc.left = a.left < b.left ? a.left : b.left;
+            rc.top = a.top < b.top ? a.top : b.top;
+            rc.right = a.right > b.right ? a.right : b.right;
+            rc.bottom = a.bottom > b.bottom ? a.bottom : b.bottom;
+            return rc;
+        }
+        // is rect a contain rect b?
+        static inline bool IsContain(const RectLTRB_F& a, const RectLTRB_F& b) noexcept {
+            return a.left <= b.left && a.top <= b.top && a.right >= b.right && a.bottom >= b.bottom;
+        }
+        // get area of intersection
+        static auto IntersectionArea(const RectLTRB_F& a, const RectLTRB_F& b) noexcept ->float;
+    private:
+        // remove unit at index
+        void remove_unit(uint32_t i) noexcept;
+        // try to merge into exist units, return true if swallowed
+        bool try_merge(Unit& unit) noexcept;
+        // merge data
+        auto merge_data(void* a, void* b) const noexcept ->void*;
+        // find the best unit to merge with when full
+        auto find_cheapest(const RectLTRB_F& rect) const noexcept ->uint32_t;
+    private:
+        // cover checker
+        CoverChecker        m_pCoverChecker = nullptr;
+        // total area
+        float               m_fArea = 0.f;
+        // count of units
+        uint32_t            m_uCount = 0;
+        // units
+        Unit                m_aUnits[LongUIDirtyRegionSize];
+    };
+}
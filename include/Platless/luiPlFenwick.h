@@ -0,0 +1,66 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include "luiPlEzC.h"
+#include <cstdint>
+#include <cassert>
+
+// longui namespace
+namespace LongUI {
+    // fenwick tree(binary indexed tree) for prefix sum of float values
+    class CUIFenwickTree {
+    public:
+        // ctor
+        CUIFenwickTree() noexcept = default;
+        // no copy
+        CUIFenwickTree(const CUIFenwickTree&) = delete;
+        // reset with count, all values set to value, O(n)
+        void Reset(uint32_t count, float value) noexcept;
+        // get value buffer to fill, call Build() after filled
+        auto Prepare(uint32_t count) noexcept ->float*;
+        // build tree from values, O(n)
+        void Build() noexcept;
+        // set value at index, O(log n)
+        void Set(uint32_t index, float value) noexcept;
+        // get value at index
+        auto Get(uint32_t index) const noexcept { assert(index < m_vValue.size()); return m_vValue[index]; }
+        // sum of [0, index), O(log n)
+        auto PrefixSum(uint32_t index) const noexcept ->float;
+        // sum of all values
+        auto GetTotal() const noexcept { return this->PrefixSum(this->GetCount()); }
+        // find index that offset in [sum(0, index), sum(0, index+1)), count if out of range, O(log n)
+        auto Find(float offset) const noexcept ->uint32_t;
+        // get count of values
+        auto GetCount() const noexcept { return uint32_t(m_vValue.size()); }
+    private:
+        // values
+        EzContainer::EzVector<float>    m_vValue;
+        // tree, 1-based, length = count + 1
+        EzContainer::EzVector<float>    m_vTree;
+    };
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include "luiPlEzC.h"
+#include <cstdint>
+#include <cassert>
+
+// longui namespace
+namespace LongUI {
+    // utf-16 substring finder, SSE2 scan of first/last char for short pattern, Horspool for long one,
+    // case-sensitive: fold pattern and text with LongUI::FoldCase first to ignore case
+    class CUITextFinder {
+        // pattern longer than this will use Horspool only, skip is longer than 8-char vector
+        enum : uint32_t { HORSPOOL_LENGTH = 16 };
+    public:
+        // not found
+        enum : uint32_t { NPOS = uint32_t(-1) };
+    public:
+        // ctor
+        CUITextFinder() noexcept = default;
+        // dtor
+        ~CUITextFinder() noexcept;
+        // no copy
+        CUITextFinder(const CUITextFinder&) = delete;
+        // set pattern, false if OOM or empty
+        bool Set(const wchar_t* pattern, uint32_t len) noexcept;
+        // get length of pattern
+        auto GetLength() const noexcept { return m_cPattern; }
+        // find first match in text[from, len), NPOS if not found
+        auto Find(const wchar_t* text, uint32_t len, uint32_t from = 0) const noexcept ->uint32_t;
+        // find all non-overlapped matches, return count
+        auto FindAll(const wchar_t* text, uint32_t len, EzContainer::EzVector<uint32_t>& out) const noexcept ->uint32_t;
+    private:
+        // verify match at text
+        bool verify(const wchar_t* text) const noexcept;
+        // Horspool search
+        auto find_horspool(const wchar_t* text, uint32_t len, uint32_t from) const noexcept ->uint32_t;
+#ifdef LONGUI_WITH_SSE2
+        // SSE2 search
+        auto find_sse2(const wchar_t* text, uint32_t len, uint32_t from) const noexcept ->uint32_t;
+#endif
+    private:
+        // pattern
+        wchar_t*            m_pPattern = nullptr;
+        // length of pattern
+        uint32_t            m_cPattern = 0;
+        // Horspool skip table, indexed by low byte of char
+        uint32_t            m_aSkip[256];
+        // first char
+        wchar_t             m_chFirst;
+        // last char
+        wchar_t             m_chLast;
+    };
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include "luiPlUtil.h"
+#include "luiPlEzC.h"
+#include <cstdint>
+#include <cassert>
+
+// longui namespace
+namespace LongUI {
+    // uniform grid for hit-testing rects, item added later is upper
+    class CUISpatialGrid : public CUISingleNormalObject {
+    public:
+        // item of grid
+        struct Item {
+            // rect of item
+            RectLTRB_F      rect;
+            // user data
+            void*           data;
+        };
+        // max cells in one axis
+        enum : uint32_t { MAX_CELL_AXIS = 64, };
+    public:
+        // ctor
+        CUISpatialGrid() noexcept = default;
+        // no copy
+        CUISpatialGrid(const CUISpatialGrid&) = delete;
+        // clear items, mark as invalid
+        void Clear() noexcept { m_vItems.clear(); m_bValid = false; }
+        // add item, call Build() after all items added
+        void Add(const RectLTRB_F& rect, void* data) noexcept { m_vItems.push_back(Item{ rect, data }); }
+        // build grid, grid keeps invalid if failed to allocate
+        auto Build() noexcept ->bool;
+        // find the top-most(last added) item containing point
+        auto FindTopmost(float x, float y) const noexcept ->void*;
+        // is grid built after last Clear()?
+        bool IsValid() const noexcept { return m_bValid; }
+        // get count of item
+        auto GetCount() const noexcept { return m_vItems.size(); }
+    private:
+        // items
+        EzContainer::EzVector<Item>     m_vItems;
+        // start index of cell in m_vCellItems, length = cells + 1
+        EzContainer::EzVector<uint32_t> m_vCellStart;
+        // index of items in each cell, ascending
+        EzContainer::EzVector<uint32_t> m_vCellItems;
+        // bounds of all items
+        RectLTRB_F                      m_rcBounds;
+        // reciprocal of cell width
+        float                           m_fInvCellW = 0.f;
+        // reciprocal of cell height
+        float                           m_fInvCellH = 0.f;
+        // count of column
+        uint32_t                        m_uCols = 0;
+        // count of row
+        uint32_t                        m_uRows = 0;
+        // valid
+        bool                            m_bValid = false;
+    };
+}
@@ -0,0 +1,116 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include "luiPlPiece.h"
+#include <cstdint>
+#include <cassert>
+
+// longui namespace
+namespace LongUI {
+    // line-start index of text, lines in treap with O(log n) line/position conversion
+    class CUILineIndex {
+        // null node
+        enum : uint32_t { NIL = uint32_t(-1) };
+        // line node
+        struct Node {
+            // length of line, newline included
+            uint32_t        length;
+            // length of newline
+            uint32_t        newline;
+            // length of subtree
+            uint32_t        sum;
+            // line count of subtree
+            uint32_t        count;
+            // priority of treap
+            uint32_t        priority;
+            // left child
+            uint32_t        left;
+            // right child
+            uint32_t        right;
+        };
+    public:
+        // ctor
+        CUILineIndex() noexcept = default;
+        // dtor
+        ~CUILineIndex() noexcept;
+        // no copy
+        CUILineIndex(const CUILineIndex&) = delete;
+        // get length of line break at str[i], 0 for none: CR, LF, CRLF, NEL, LS, PS
+        static auto BreakLength(const wchar_t* str, uint32_t i, uint32_t len) noexcept ->uint32_t;
+        // build index of whole text, false if OOM
+        bool Build(const CUIPieceTable& text) noexcept;
+        // update index after [pos, pos + removed) was replaced with inserted chars, false if OOM
+        bool Update(const CUIPieceTable& text, uint32_t pos, uint32_t removed, uint32_t inserted) noexcept;
+        // clear index
+        void Clear() noexcept;
+        // get line containing text position, O(log n)
+        auto GetLineFromPosition(uint32_t pos) const noexcept ->uint32_t;
+        // get text position of line start, O(log n)
+        auto GetLineStart(uint32_t line) const noexcept ->uint32_t;
+        // get text position of line end, newline excluded, O(log n)
+        auto GetLineEnd(uint32_t line) const noexcept ->uint32_t;
+        // get count of lines, at least 1 after built
+        auto GetLineCount() const noexcept { return m_ixRoot == NIL ? 0 : m_pNodes[m_ixRoot].count; }
+        // get length of text
+        auto GetLength() const noexcept { return m_ixRoot == NIL ? 0 : m_pNodes[m_ixRoot].sum; }
+    private:
+        // length of subtree
+        auto sum(uint32_t t) const noexcept { return t == NIL ? 0 : m_pNodes[t].sum; }
+        // line count of subtree
+        auto count(uint32_t t) const noexcept { return t == NIL ? 0 : m_pNodes[t].count; }
+        // update sum and count of node
+        void update(uint32_t t) noexcept;
+        // find node of line
+        auto find(uint32_t line, uint32_t& start) const noexcept ->uint32_t;
+        // new node, node pool must be reserved
+        auto new_node(uint32_t length, uint32_t newline) noexcept ->uint32_t;
+        // free nodes of subtree
+        void free_tree(uint32_t t) noexcept;
+        // reserve nodes for later new_node
+        bool reserve_node(uint32_t count) noexcept;
+        // make tree of lines in text range [begin, end)
+        bool make_lines(const CUIPieceTable& text, uint32_t begin, uint32_t end, uint32_t& tree) noexcept;
+        // split tree into lines [0, line) and [line, end)
+        void split(uint32_t t, uint32_t line, uint32_t& l, uint32_t& r) noexcept;
+        // merge 2 trees
+        auto merge(uint32_t a, uint32_t b) noexcept ->uint32_t;
+    private:
+        // node pool
+        Node*                   m_pNodes = nullptr;
+        // count of nodes used in pool
+        uint32_t                m_cNodes = 0;
+        // capacity of node pool
+        uint32_t                m_cNodeCap = 0;
+        // root of treap
+        uint32_t                m_ixRoot = NIL;
+        // free node list, linked by left
+        uint32_t                m_ixFree = NIL;
+        // random seed for priority
+        uint32_t                m_uSeed = 0x2545F491;
+    };
+}
@@ -0,0 +1,131 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include <cstdint>
+#include <cassert>
+
+// longui namespace
+namespace LongUI {
+    // piece table for text, pieces in treap with O(log n) position index
+    class CUIPieceTable {
+        // null node
+        enum : uint32_t { NIL = uint32_t(-1) };
+        // piece node
+        struct Node {
+            // offset in buffer
+            uint32_t        offset;
+            // length of piece
+            uint32_t        length;
+            // length of subtree
+            uint32_t        sum;
+            // priority of treap
+            uint32_t        priority;
+            // left child
+            uint32_t        left;
+            // right child
+            uint32_t        right;
+        };
+    public:
+        // ctor
+        CUIPieceTable() noexcept = default;
+        // dtor
+        ~CUIPieceTable() noexcept;
+        // no copy
+        CUIPieceTable(const CUIPieceTable&) = delete;
+        // set whole text, false if OOM
+        bool Set(const wchar_t* str, uint32_t len) noexcept;
+        // clear text
+        void Clear() noexcept;
+        // insert text, O(log n), false if OOM
+        bool Insert(uint32_t pos, const wchar_t* str, uint32_t len) noexcept;
+        // remove text, O(log n)
+        void Remove(uint32_t pos, uint32_t len) noexcept;
+        // get char at pos, O(log n)
+        auto GetChar(uint32_t pos) const noexcept ->wchar_t;
+        // copy text in [pos, pos + len) to buffer, return count copied
+        auto Copy(uint32_t pos, uint32_t len, wchar_t* out) const noexcept ->uint32_t;
+        // contiguous view, null-terminated, rebuilt after text changed
+        auto c_str() const noexcept ->const wchar_t*;
+        // get length of text
+        auto GetLength() const noexcept { return m_ixRoot == NIL ? 0 : m_pNodes[m_ixRoot].sum; }
+        // get count of pieces
+        auto GetPieceCount() const noexcept { return m_cPiece; }
+        // get char at pos
+        auto operator[](uint32_t pos) const noexcept { return this->GetChar(pos); }
+    private:
+        // length of subtree
+        auto sum(uint32_t t) const noexcept { return t == NIL ? 0 : m_pNodes[t].sum; }
+        // update sum of node
+        void update(uint32_t t) noexcept;
+        // new node, node pool must be reserved
+        auto new_node(uint32_t offset, uint32_t length) noexcept ->uint32_t;
+        // free nodes of subtree
+        void free_tree(uint32_t t) noexcept;
+        // reserve nodes for later new_node
+        bool reserve_node(uint32_t count) noexcept;
+        // append text to buffer
+        bool append(const wchar_t* str, uint32_t len) noexcept;
+        // compact buffer into one piece if most of it is unreferenced
+        void compact() noexcept;
+        // cut piece to make pos a boundary of pieces
+        void cut(uint32_t pos) noexcept;
+        // split tree into [0, pos) and [pos, end), pos must be a boundary
+        void split(uint32_t t, uint32_t pos, uint32_t& l, uint32_t& r) noexcept;
+        // merge 2 trees
+        auto merge(uint32_t a, uint32_t b) noexcept ->uint32_t;
+        // copy subtree range
+        auto copy(uint32_t t, uint32_t pos, uint32_t len, wchar_t* out) const noexcept ->uint32_t;
+    private:
+        // text buffer, append only until compacted
+        wchar_t*                m_pBuffer = nullptr;
+        // node pool
+        Node*                   m_pNodes = nullptr;
+        // contiguous view
+        mutable wchar_t*        m_pView = nullptr;
+        // length of buffer
+        uint32_t                m_cBuffer = 0;
+        // capacity of buffer
+        uint32_t                m_cBufferCap = 0;
+        // count of nodes used in pool
+        uint32_t                m_cNodes = 0;
+        // capacity of node pool
+        uint32_t                m_cNodeCap = 0;
+        // capacity of view
+        mutable uint32_t        m_cViewCap = 0;
+        // count of pieces
+        uint32_t                m_cPiece = 0;
+        // root of treap
+        uint32_t                m_ixRoot = NIL;
+        // free node list, linked by left
+        uint32_t                m_ixFree = NIL;
+        // random seed for priority
+        uint32_t                m_uSeed = 0x9E3779B9;
+        // view need rebuilding
+        mutable bool            m_bViewDirty = true;
+    };
+}
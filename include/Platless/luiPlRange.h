@@ -0,0 +1,87 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include "luiPlEzC.h"
+#include <cstdint>
+#include <cassert>
+
+// longui namespace
+namespace LongUI {
+    // set of uint32 stored as sorted, disjoint and non-adjacent intervals
+    class CUIIntervalSet {
+    public:
+        // interval in [begin, end)
+        struct Interval {
+            // first one
+            uint32_t    begin;
+            // last one + 1
+            uint32_t    end;
+        };
+    public:
+        // ctor
+        CUIIntervalSet() noexcept = default;
+        // no copy
+        CUIIntervalSet(const CUIIntervalSet&) = delete;
+        // clear
+        void Clear() noexcept { m_vIntervals.clear(); }
+        // add [begin, end)
+        void Add(uint32_t begin, uint32_t end) noexcept;
+        // remove [begin, end)
+        void Remove(uint32_t begin, uint32_t end) noexcept;
+        // toggle [begin, end)
+        void Toggle(uint32_t begin, uint32_t end) noexcept;
+        // insert a value slot at pos, values >= pos move up by 1
+        void InsertAt(uint32_t pos, bool set) noexcept;
+        // erase value slot at pos, values > pos move down by 1
+        void EraseAt(uint32_t pos) noexcept;
+        // contains value? O(log n)
+        bool Contains(uint32_t value) const noexcept;
+        // count of values in set
+        auto GetSize() const noexcept ->uint32_t;
+        // count of intervals
+        auto GetCount() const noexcept { return m_vIntervals.size(); }
+        // empty?
+        bool IsEmpty() const noexcept { return m_vIntervals.empty(); }
+        // first value, uint32_t(-1) if empty
+        auto GetFirst() const noexcept { return m_vIntervals.empty() ? uint32_t(-1) : m_vIntervals.front().begin; }
+        // get interval
+        auto&operator[](uint32_t i) const noexcept { return m_vIntervals[i]; }
+        // begin itr
+        auto begin() const noexcept { return m_vIntervals.begin(); }
+        // end itr
+        auto end() const noexcept { return m_vIntervals.end(); }
+    private:
+        // index of first interval whose end > value
+        auto lower_end(uint32_t value) const noexcept ->uint32_t;
+        // index of first interval whose begin > value
+        auto upper_begin(uint32_t value) const noexcept ->uint32_t;
+    private:
+        // intervals
+        EzContainer::EzVector<Interval>     m_vIntervals;
+    };
+}
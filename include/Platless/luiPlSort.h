@@ -0,0 +1,105 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include "luiPlEzC.h"
+#include <cstdint>
+#include <cassert>
+
+// longui namespace
+namespace LongUI {
+    // string sort key, first 4 chars packed for fast comparison
+    struct StringSortKey {
+        // first 4 chars in big-endian, zero-padded
+        uint64_t            prefix;
+        // full null-terminated string
+        const wchar_t*      string;
+    };
+    // make string sort key
+    auto MakeStringSortKey(const wchar_t* str) noexcept ->StringSortKey;
+    // compare 2 sort keys, same order as std::wcscmp
+    auto CompareSortKey(const StringSortKey& a, const StringSortKey& b) noexcept ->int;
+    // stable LSD radix sort index array with 32-bit keys, length of tmp must >= count
+    void RadixSortIndex(const uint32_t keys[], uint32_t index[], uint32_t tmp[], uint32_t count) noexcept;
+    // stable merge sort index array with string keys, length of tmp must >= count
+    void MergeSortIndex(const StringSortKey keys[], uint32_t index[], uint32_t tmp[], uint32_t count) noexcept;
+    // merge 2 sorted index runs into out, stable(run a first)
+    void MergeIndex(const StringSortKey keys[], const uint32_t a[], uint32_t na, const uint32_t b[], uint32_t nb, uint32_t out[]) noexcept;
+    // simple case fold in place: Latin, Greek, Cyrillic and fullwidth Latin, length unchanged
+    void FoldCase(wchar_t str[], uint32_t len) noexcept;
+    // make case-folded prefix key, first 4 chars packed like StringSortKey::prefix
+    auto MakeFoldedPrefixKey(const wchar_t* str) noexcept ->uint64_t;
+    // prefix index of rows for type-ahead, sorted by case-folded prefix key,
+    // maintained incrementally on row insert/erase/move in O(n) without re-sorting
+    class CUIPrefixIndex {
+    public:
+        // entry of index
+        struct Entry {
+            // case-folded prefix key
+            uint64_t        key;
+            // row index
+            uint32_t        row;
+        };
+    public:
+        // ctor
+        CUIPrefixIndex() noexcept = default;
+        // no copy
+        CUIPrefixIndex(const CUIPrefixIndex&) = delete;
+        // clear
+        void Clear() noexcept { m_vEntries.clear(); m_vKeys.clear(); }
+        // get key buffer of rows to fill, call Build() after filled, null if OOM
+        auto Prepare(uint32_t count) noexcept ->uint64_t*;
+        // sort entries of all rows, O(n log n), only for whole list replaced or reordered
+        bool Build() noexcept;
+        // insert rows [row, row + count) with keys, O(n + k log k)
+        bool Insert(uint32_t row, const uint64_t keys[], uint32_t count) noexcept;
+        // erase row, O(n)
+        void Erase(uint32_t row) noexcept;
+        // move row 'from' to 'to' with new key, rows between shift by 1, O(n)
+        void Move(uint32_t from, uint32_t to, uint64_t key) noexcept;
+        // update key of row, O(n)
+        void Update(uint32_t row, uint64_t key) noexcept { this->Move(row, row, key); }
+        // reorder rows: new row i was row source[i], O(n)
+        bool Permute(const uint32_t source[]) noexcept;
+        // find entries [first, last) whose key matches first 4 chars of prefix, O(log n)
+        void EqualRange(const wchar_t* prefix, uint32_t& first, uint32_t& last) const noexcept;
+        // get entry
+        auto&operator[](uint32_t i) const noexcept { return m_vEntries[i]; }
+        // get count of rows
+        auto GetCount() const noexcept { return m_vKeys.size(); }
+    private:
+        // index of first entry whose key >= key
+        auto lower_bound(uint64_t key) const noexcept ->uint32_t;
+        // index of entry of row
+        auto find(uint32_t row) const noexcept ->uint32_t;
+    private:
+        // entries sorted by key
+        EzContainer::EzVector<Entry>    m_vEntries;
+        // key of each row
+        EzContainer::EzVector<uint64_t> m_vKeys;
+    };
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstdint>
+#include <atomic>
+
+// longui namespace
+namespace LongUI {
+    // histogram of time in micro sec., lock-free for one writer and any readers, clearing done by writer
+    class CUIHistogram {
+    public:
+        // linear buckets for small value
+        enum : uint32_t { LINEAR_COUNT = 16, };
+        // sub-buckets(log2) for each power of 2
+        enum : uint32_t { SUB_BITS = 3, SUB_COUNT = 1 << SUB_BITS, };
+        // count of bucket, up to 2^26 mcs(about 67 sec.)
+        enum : uint32_t { BUCKET_COUNT = LINEAR_COUNT + (26 - 4) * SUB_COUNT, };
+    public:
+        // ctor
+        CUIHistogram() noexcept : m_bClear(false) { this->reset(); }
+        // no copy
+        CUIHistogram(const CUIHistogram&) = delete;
+        // record a value in micro sec.
+        void Record(uint32_t mcs) noexcept;
+        // clear all, done by writer in next Record, safe in any thread
+        void Clear() noexcept { m_bClear.store(true, std::memory_order_release); }
+        // get value in micro sec. at percentile(0-100)
+        auto GetPercentile(float percentile) const noexcept ->uint32_t;
+        // get count of recorded value
+        auto GetCount() const noexcept { return this->is_clearing() ? 0 : m_cCount.load(std::memory_order_relaxed); }
+        // get max recorded value in micro sec.
+        auto GetMax() const noexcept { return this->is_clearing() ? 0 : m_uMax.load(std::memory_order_relaxed); }
+        // get average value in micro sec.
+        auto GetAverage() const noexcept ->float;
+    public:
+        // index of bucket for value
+        static auto IndexOf(uint32_t mcs) noexcept ->uint32_t;
+        // upper bound value of bucket
+        static auto UpperOf(uint32_t index) noexcept ->uint32_t;
+    private:
+        // reset all, only for writer
+        void reset() noexcept;
+        // clear requested but not done yet?
+        bool is_clearing() const noexcept { return m_bClear.load(std::memory_order_acquire); }
+    private:
+        // sum of value
+        std::atomic<uint64_t>       m_uSum;
+        // count of value
+        std::atomic<uint32_t>       m_cCount;
+        // max value
+        std::atomic<uint32_t>       m_uMax;
+        // buckets
+        std::atomic<uint32_t>       m_aBuckets[BUCKET_COUNT];
+        // clear requested
+        std::atomic<bool>           m_bClear;
+    };
+}
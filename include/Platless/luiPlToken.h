@@ -0,0 +1,154 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include "luiPlEzC.h"
+#include "luiPlPiece.h"
+#include "luiPlLine.h"
+#include <cstdint>
+#include <cassert>
+
+// longui namespace
+namespace LongUI {
+    // style runs of text, run-length encoded by start position, style 0 before first run
+    class CUIStyleRuns {
+    public:
+        // style run in [position, position of next run)
+        struct Run {
+            // first char position
+            uint32_t    position;
+            // style index, 0 for default
+            uint32_t    style;
+        };
+    public:
+        // ctor
+        CUIStyleRuns() noexcept = default;
+        // no copy
+        CUIStyleRuns(const CUIStyleRuns&) = delete;
+        // clear
+        void Clear() noexcept { m_vRuns.clear(); }
+        // append run, position must not be less than last one, same style merged
+        void Append(uint32_t position, uint32_t style) noexcept;
+        // replace runs in old [begin, old_end) with runs in new [begin, new_end), later runs shifted
+        bool Splice(uint32_t begin, uint32_t old_end, uint32_t new_end, const CUIStyleRuns& runs) noexcept;
+        // index of run containing position, O(log n), count of runs if before first run
+        auto FindRun(uint32_t position) const noexcept ->uint32_t;
+        // get style at position, O(log n)
+        auto GetStyle(uint32_t position) const noexcept ->uint32_t;
+        // count of runs
+        auto GetCount() const noexcept { return m_vRuns.size(); }
+        // isok
+        bool IsOk() const noexcept { return m_vRuns.isok(); }
+        // get run
+        auto&operator[](uint32_t i) const noexcept { return m_vRuns[i]; }
+        // begin itr
+        auto begin() const noexcept { return m_vRuns.begin(); }
+        // end itr
+        auto end() const noexcept { return m_vRuns.end(); }
+    private:
+        // index of first run after position
+        auto upper(uint32_t position) const noexcept ->uint32_t;
+    private:
+        // runs
+        EzContainer::EzVector<Run>  m_vRuns;
+    };
+    // tokenizer for syntax highlighting, tokenize line by line with state
+    class XUITokenizer {
+    public:
+        // dtor
+        virtual ~XUITokenizer() noexcept = default;
+        // tokenize a line without newline from state, append runs at base + offset, return state at line end
+        virtual auto Tokenize(const wchar_t* str, uint32_t length, uint32_t state, 
+            uint32_t base, CUIStyleRuns& runs) noexcept ->uint32_t = 0;
+    };
+    // incremental tokenizing, re-tokenize from damaged line until state converges
+    class CUIHighlighter {
+    public:
+        // ctor
+        CUIHighlighter() noexcept = default;
+        // no copy
+        CUIHighlighter(const CUIHighlighter&) = delete;
+        // set tokenizer, not owned, null to disable, call Build() after this
+        void SetTokenizer(XUITokenizer* tokenizer) noexcept { m_pTokenizer = tokenizer; this->Clear(); }
+        // get tokenizer
+        auto GetTokenizer() const noexcept { return m_pTokenizer; }
+        // get style runs
+        auto&RefRuns() const noexcept { return m_runs; }
+        // clear
+        void Clear() noexcept { m_runs.Clear(); m_vStates.clear(); }
+        // tokenize whole text, false if OOM
+        bool Build(const CUIPieceTable& text, const CUILineIndex& lines) noexcept;
+        // update after [pos, pos + removed) replaced with inserted chars and lines updated, get restyled range
+        bool Update(const CUIPieceTable& text, const CUILineIndex& lines, 
+            uint32_t pos, uint32_t removed, uint32_t inserted, uint32_t& begin, uint32_t& end) noexcept;
+    private:
+        // tokenize a line starting at text position base, return state at line end
+        auto tokenize(const wchar_t* str, uint32_t length, uint32_t base, 
+            uint32_t state, CUIStyleRuns& runs) noexcept ->uint32_t;
+    private:
+        // tokenizer
+        XUITokenizer*                       m_pTokenizer = nullptr;
+        // style runs
+        CUIStyleRuns                        m_runs;
+        // state at start of each line
+        EzContainer::EzVector<uint32_t>     m_vStates;
+    };
+    // built-in xml tokenizer
+    class CUIXmlTokenizer final : public XUITokenizer {
+    public:
+        // style of xml
+        enum Style : uint32_t {
+            Style_Text = 0,     // 文本
+            Style_Delimiter,    // 分隔符 < > / =
+            Style_Element,      // 元素名
+            Style_Attribute,    // 属性名
+            Style_Value,        // 属性值
+            Style_Comment,      // 注释
+            Style_CData,        // CDATA
+            Style_Entity,       // 实体引用
+            Style_Instruction,  // 处理指令
+            Style_Declaration,  // 声明
+            STYLE_COUNT,
+        };
+        // state at line start
+        enum State : uint32_t {
+            State_Text = 0,     // 文本
+            State_Tag,          // 标签内
+            State_ValueDQ,      // 双引号属性值
+            State_ValueSQ,      // 单引号属性值
+            State_Comment,      // 注释
+            State_CData,        // CDATA
+            State_Instruction,  // 处理指令
+            State_Declaration,  // 声明
+        };
+    public:
+        // tokenize a line
+        auto Tokenize(const wchar_t* str, uint32_t length, uint32_t state, 
+            uint32_t base, CUIStyleRuns& runs) noexcept ->uint32_t override;
+    };
+}
@@ -0,0 +1,147 @@
+﻿#pragma once
+/**
+* Copyright (c) 2014-2016 dustpg   mailto:dustpg@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person
+* obtaining a copy of this software and associated documentation
+* files (the "Software"), to deal in the Software without
+* restriction, including without limitation the rights to use,
+* copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the
+* Software is furnished to do so, subject to the following
+* conditions:
+*
+* The above copyright notice and this permission notice shall be
+* included in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+* OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+* HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+* WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+* FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+* OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "../luibase.h"
+#include "../luiconf.h"
+#include "luiPlEzC.h"
+#include <cstdint>
+#include <cassert>
+
+// longui namespace
+namespace LongUI {
+    // undo/redo stack of text edit deltas, memory bounded by byte budget
+    class CUIUndoStack {
+        // record of edit, payload follows: removed text, inserted text
+        struct Record {
+            // position of edit
+            uint32_t        position;
+            // length of removed text
+            uint32_t        removed;
+            // length of inserted text
+            uint32_t        inserted;
+            // capacity of payload in byte
+            uint32_t        capacity;
+            // size of lz4 compressed payload in byte, 0 for raw
+            uint32_t        packed;
+            // typing record, can be coalesced
+            bool            typing;
+            // removed selection to be replaced by typing
+            bool            replace;
+            // undone and redone together with previous record
+            bool            grouped;
+        };
+    public:
+        // delta of edit: [position, position + removed_length) replaced with inserted
+        struct Delta {
+            // position of edit
+            uint32_t        position;
+            // length of removed text
+            uint32_t        removed_length;
+            // length of inserted text
+            uint32_t        inserted_length;
+            // removed text
+            const wchar_t*  removed;
+            // inserted text
+            const wchar_t*  inserted;
+            // more deltas of same group follow, call Undo/Redo again
+            bool            chained;
+        };
+    public:
+        // ctor
+        CUIUndoStack() noexcept = default;
+        // dtor
+        ~CUIUndoStack() noexcept;
+        // no copy
+        CUIUndoStack(const CUIUndoStack&) = delete;
+        // set budget in byte, oldest records are dropped while over budget
+        void SetBudget(uint32_t bytes) noexcept;
+        // get budget in byte
+        auto GetBudget() const noexcept { return m_cBudget; }
+        // get memory used by records in byte
+        auto GetUsage() const noexcept { return m_cUsage; }
+        // record an edit, typing edits are coalesced, false if history dropped
+        bool Push(uint32_t pos, const wchar_t* removed, uint32_t rlen, 
+            const wchar_t* inserted, uint32_t ilen, bool typing) noexcept;
+        // stop coalescing with next edit
+        void Seal() noexcept { m_bSealed = true; m_bReplace = false; }
+        // next removal is selection replaced by typing, typed text will be coalesced with it
+        void MarkReplace() noexcept { m_bReplace = true; }
+        // begin group, edits pushed until EndGroup are undone and redone together
+        void BeginGroup() noexcept { this->Seal(); m_bGrouping = true; m_bGroupOpen = false; m_bGroupBroken = false; }
+        // end group
+        void EndGroup() noexcept { m_bGrouping = m_bGroupOpen = m_bGroupBroken = false; this->Seal(); }
+        // clear all records
+        void Clear() noexcept;
+        // can undo?
+        bool CanUndo() const noexcept { return m_uTop > 0; }
+        // can redo?
+        bool CanRedo() const noexcept { return m_uTop < m_vRecords.size(); }
+        // get edit to undo, delta is valid until next call, delta.chained if group continues
+        bool Undo(Delta& delta) noexcept;
+        // get edit to redo, delta is valid until next call, delta.chained if group continues
+        bool Redo(Delta& delta) noexcept;
+    private:
+        // payload of record
+        static auto payload(Record* record) noexcept { return reinterpret_cast<char*>(record + 1); }
+        // raw size of payload in byte
+        static auto raw_size(const Record* record) noexcept { return uint32_t((record->removed + record->inserted) * sizeof(wchar_t)); }
+        // ensure capacity of record
+        bool reserve(uint32_t index, uint32_t capacity) noexcept;
+        // ensure scratch buffer
+        auto scratch(uint32_t bytes) noexcept ->char*;
+        // compress record with lz4 if enabled
+        void pack(uint32_t index) noexcept;
+        // get delta of record
+        bool unpack(uint32_t index, Delta& delta) noexcept;
+        // drop records to redo
+        void drop_redo() noexcept;
+        // drop oldest groups while over budget
+        bool trim() noexcept;
+    private:
+        // records, [0, top) to undo, [top, end) to redo
+        EzContainer::EzVector<Record*>  m_vRecords;
+        // scratch buffer for lz4
+        char*                   m_pScratch = nullptr;
+        // size of scratch buffer
+        uint32_t                m_cScratch = 0;
+        // budget in byte
+        uint32_t                m_cBudget = LongUIDefaultUndoBudget;
+        // memory used by records in byte
+        uint32_t                m_cUsage = 0;
+        // top of undo
+        uint32_t                m_uTop = 0;
+        // sealed, next edit won't be coalesced
+        bool                    m_bSealed = true;
+        // next removal is selection replaced by typing
+        bool                    m_bReplace = false;
+        // in group
+        bool                    m_bGrouping = false;
+        // record of current group pushed
+        bool                    m_bGroupOpen = false;
+        // history of current group cleared, rest of group is not recorded
+        bool                    m_bGroupBroken = false;
+    };
+}
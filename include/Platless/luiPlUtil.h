@@ -28,6 +28,8 @@
 #include "../luiconf.h"
 #include <cstdint>
 #include <cassert>
+#include <cstring>
+#include <cwchar>
 #include <new>
 
 // longui namespace
@@ -83,6 +85,10 @@ namespace LongUI {
     auto AtoF(const char* __restrict) noexcept -> float;
     // std::atof diy version(float ver) overload for wchar_t
     auto AtoF(const wchar_t* __restrict) noexcept -> float;
+    // parse float in [begin, end), correctly rounded: return end of number, begin if none
+    auto ParseFloat(const char* begin, const char* end, float& out) noexcept -> const char*;
+    // parse floats in [itr, end) separated by space, comma or sign, itr moved to end of last number: return parsed count
+    auto ParseFloats(const char*& itr, const char* end, float out[], uint32_t count) noexcept -> uint32_t;
     // UTF-32 to UTF-16 char
     auto Char32toChar16(char32_t ch, char16_t* str) -> char16_t*;
     // UTF-32 to UTF-32 char
@@ -91,6 +97,14 @@ namespace LongUI {
     auto UTF16toUTF8(const char16_t* __restrict src, char* __restrict des, uint32_t buflen) noexcept -> char*;
     // UTF-8 to UTF-16: Return end of utf16 string
     auto UTF8toUTF16(const char* __restrict src, char16_t* __restrict des, uint32_t buflen) noexcept -> char16_t*;
+    // UTF-16 to UTF-8 in one pass, unpaired surrogate to U+FFFD, des needs len*3 bytes at most
+    auto UTF16toUTF8(const char16_t* __restrict src, uint32_t len, char* __restrict des) noexcept -> char*;
+    // UTF-8 to UTF-16 in one pass, malformed sequence to U+FFFD, des needs len units at most
+    auto UTF8toUTF16(const char* __restrict src, uint32_t len, char16_t* __restrict des) noexcept -> char16_t*;
+    // is well-formed UTF-8 string
+    bool IsValidUTF8(const char* src, uint32_t len) noexcept;
+    // is well-formed UTF-16 string
+    bool IsValidUTF16(const char16_t* src, uint32_t len) noexcept;
     // get buffer length for UTF-16 to UTF-8(include NULL-END char)
     auto UTF16toUTF8GetBufLen(const char16_t* src) noexcept -> uint32_t;
     // get buffer length for UTF-8 to UTF-16(include NULL-END char)
@@ -105,13 +119,16 @@ namespace LongUI {
         static_assert(sizeof(wchar_t) == sizeof(char16_t), "change UTF-16 to UTF-32");
         return LongUI::UTF8toUTF16GetBufLen(src);
     }
-    // safe wchar to UTF-8
+    // safe wchar to UTF-8, converted in one pass, counted first if worst case exceeds BUFFER
     template<size_t BUFFER, typename Lambda> 
     inline void SafeWideChartoUTF8(const wchar_t* src, Lambda lam) noexcept {
-        auto len = LongUI::WideChartoUTF8GetBufLen(src);
-        LongUI::SafeBuffer<char, BUFFER>(len, [len, src, lam](char* buf) noexcept {
+        const auto len = static_cast<uint32_t>(std::wcslen(src));
+        // 每个UTF-16单元至多3字节, 栈缓冲不够时计算实际长度
+        auto buflen = size_t(len) * 3 + 1;
+        if (buflen > BUFFER) buflen = LongUI::WideChartoUTF8GetBufLen(src);
+        LongUI::SafeBuffer<char, BUFFER>(buflen, [len, src, lam](char* buf) noexcept {
             static_assert(sizeof(wchar_t) == sizeof(char16_t), "change UTF-16 to UTF-32");
-            auto end = LongUI::UTF16toUTF8(reinterpret_cast<const char16_t*>(src), buf, len);
+            auto end = LongUI::UTF16toUTF8(reinterpret_cast<const char16_t*>(src), len, buf);
             0[end] = 0;
             lam(buf, end);
         });
@@ -121,13 +138,14 @@ namespace LongUI {
     inline void SafeWideChartoUTF8(const wchar_t* src, Lambda lam) noexcept {
         return LongUI::SafeWideChartoUTF8<LongUIStringBufferLength>(src, lam);
     }
-    // safe  UTF-8 to wchar
+    // safe  UTF-8 to wchar, converted in one pass
     template<size_t BUFFER, typename Lambda> 
     inline void SafeUTF8toWideChar(const char* src, Lambda lam) noexcept {
-        auto len = LongUI::UTF8toWideCharGetBufLen(src);
-        LongUI::SafeBuffer<wchar_t, BUFFER>(len, [len, src, lam](wchar_t* buf) noexcept {
+        const auto len = static_cast<uint32_t>(std::strlen(src));
+        // 每个UTF-8字节至多1个UTF-16单元
+        LongUI::SafeBuffer<wchar_t, BUFFER>(len + 1, [len, src, lam](wchar_t* buf) noexcept {
             static_assert(sizeof(wchar_t) == sizeof(char16_t), "change UTF-16 to UTF-32");
-            auto end = LongUI::UTF8toUTF16(src, reinterpret_cast<char16_t*>(buf), len);
+            auto end = LongUI::UTF8toUTF16(src, len, reinterpret_cast<char16_t*>(buf));
             0[end] = 0;
             lam(buf, reinterpret_cast<wchar_t*>(end));
         });
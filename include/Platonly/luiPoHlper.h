@@ -79,11 +79,101 @@ namespace LongUI { namespace Helper {
         void Reset() noexcept { m_dwLastCount = ::timeGetTime(); }
         // reset
         void Reset(uint32_t elapse) noexcept { m_dwTime = elapse; this->Reset(); }
+        // get remain time in ms before Update() return true
+        auto GetRemain() const noexcept ->uint32_t;
     private:
         // time for elapse
         uint32_t        m_dwTime;
         // last tick-count
         uint32_t        m_dwLastCount = ::timeGetTime();
     };
+    // frame pacer: absolute deadline on QPC, wait on timer then yielding spin
+    /*
+        Helper::FramePacer pacer;
+        pacer.SetTargetRate(60);
+        pacer.Start();
+        while (run) { do_frame(); pacer.Wait(); }
+        pacer.Stop();
+    */
+    class FramePacer {
+    public:
+        // max divider when degrading, rate halved per step
+        enum : uint32_t { MAX_DIVIDER = 4, };
+        // ctor
+        FramePacer() noexcept;
+        // dtor
+        ~FramePacer() noexcept { this->Stop(); }
+        // no copy
+        FramePacer(const FramePacer&) = delete;
+        // start pacing, raise the system timer resolution
+        void Start() noexcept;
+        // stop pacing, restore the system timer resolution
+        void Stop() noexcept;
+        // reset deadline to one period later, keep statistics
+        void Reset() noexcept;
+        // set target rate in Hz, return false and keep the old one for 0
+        bool SetTargetRate(uint32_t hz) noexcept;
+        // wait for next deadline, return false if missed
+        bool Wait() noexcept;
+        // clear statistics
+        void ClearStatistics() noexcept;
+    public:
+        // get target rate in Hz
+        auto GetTargetRate() const noexcept { return m_uTargetRate; }
+        // get paced rate in Hz after degrading
+        auto GetPacedRate() const noexcept { return m_uTargetRate / m_uDivider; }
+        // get count of frame paced
+        auto GetFrameCount() const noexcept { return m_uFrameCount; }
+        // get count of missed deadline
+        auto GetMissedCount() const noexcept { return m_uMissedCount; }
+        // get max lateness in ms of missed deadline
+        auto GetMaxLateness() const noexcept { return this->to_ms(m_i64MaxLate); }
+        // get average lateness in ms of missed deadline
+        auto GetAverageLateness() const noexcept { return m_uMissedCount ? this->to_ms(m_i64SumLate) / float(m_uMissedCount) : 0.f; }
+    private:
+        // now tick
+        static auto now() noexcept ->int64_t { LARGE_INTEGER t; ::QueryPerformanceCounter(&t); return t.QuadPart; }
+        // tick to ms
+        auto to_ms(int64_t tick) const noexcept ->float { return float(double(tick) * 1e3 / double(m_i64Freq)); }
+        // degrade or recover the rate
+        void adapt(bool missed, int64_t slack) noexcept;
+        // sleep for ticks, on waitable timer if created
+        void sleep_for(int64_t tick) noexcept;
+        // refresh period
+        void refresh_period() noexcept;
+    private:
+        // waitable timer, high resolution if supported
+        HANDLE          m_hTimer = nullptr;
+        // qpc frequency
+        int64_t         m_i64Freq = 1;
+        // period of paced rate in tick
+        int64_t         m_i64Period = 1;
+        // next deadline in tick
+        int64_t         m_i64Deadline = 0;
+        // spin margin before deadline in tick
+        int64_t         m_i64Spin = 0;
+        // sum of lateness in tick
+        int64_t         m_i64SumLate = 0;
+        // max lateness in tick
+        int64_t         m_i64MaxLate = 0;
+        // min slack in on-time streak
+        int64_t         m_i64MinSlack = 0;
+        // target rate
+        uint32_t        m_uTargetRate = 60;
+        // rate divider
+        uint32_t        m_uDivider = 1;
+        // frame count
+        uint32_t        m_uFrameCount = 0;
+        // missed count
+        uint32_t        m_uMissedCount = 0;
+        // missed count in recent window
+        uint32_t        m_uRecentMissed = 0;
+        // frame count in recent window
+        uint32_t        m_uRecentFrame = 0;
+        // on-time streak
+        uint32_t        m_uOnTimeStreak = 0;
+        // started
+        bool            m_bStarted = false;
+    };
 }}
 
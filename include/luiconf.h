@@ -72,6 +72,17 @@ namespace LongUI {
 // using Media Foundation to play video file?
 #define LONGUI_WITH_MMFVIDEO
 
+// compress old un-redo records with lz4, need 3rdParty/lz4 linked
+//#define LONGUI_WITH_LZ4_UNDO
+
+// SSE2 for text finding, on x64 or x86 with /arch:SSE2
+#if !defined(LONGUI_NO_SSE2) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define LONGUI_WITH_SSE2
+#endif
+
+// per-control update/render profiler, sampling started by CUIControlProfiler::Enable
+//#define LONGUI_WITH_CONTROL_PROFILER
+
 
 #ifndef LongUIInline
 #define LongUIInline __forceinline
@@ -145,6 +156,10 @@ namespace LongUI {
     static constexpr uint32_t       LongUIDefaultTextVAlign = 2; // DWRITE_PARAGRAPH_ALIGNMENT_CENTER;
     // LongUI Default Text H-Align
     static constexpr uint32_t       LongUIDefaultTextHAlign = 2; // DWRITE_TEXT_ALIGNMENT_CENTER;
+    // LongUI Dirty Region Merge Ratio: merge 2 rects if wasted area of union less than this
+    static constexpr float          LongUIDirtyRegionMergeRatio = 0.25f;
+    // LongUI Dirty Region Full Ratio: full-rendering if dirty area larger than this
+    static constexpr float          LongUIDirtyRegionFullRatio = 0.6f;
     // LongUI 常量
     enum EnumUIConstant : uint32_t {
         // LongUI CUIString Fixed Buffer Length [fixed buffer length]
@@ -155,18 +170,34 @@ namespace LongUI {
         LongUIStringBufferLength = 256,
         // max count of control in window while in init [fixed buffer length]
         LongUIMaxControlInited = (512 - 1),
-        // default un-redo stack size [fixed buffer length]
-        LongUIDefaultUnRedoCommandSize = 13,
+        // default byte budget of un-redo stack for each editable text
+        LongUIDefaultUndoBudget = 256 * 1024,
+        // un-redo record larger than this in byte will be compressed if LONGUI_WITH_LZ4_UNDO
+        LongUIUndoPackThreshold = 256,
+        // pasting text longer than this in char will be inserted in chunks with deferred layout
+        LongUIStreamPasteThreshold = 64 * 1024,
+        // length in char of chunk filtered and appended to text buffer once [fixed buffer length]
+        LongUIStreamPasteChunk = 16 * 1024,
+        // length in char of deferred text laid out in one frame at least
+        LongUILayoutSliceLength = 16 * 1024,
+        // piece table compacts buffer when unreferenced chars exceed both this and length of text
+        LongUIPieceCompactMin = 64 * 1024,
+        // length in char of text window searched once, windows overlap by length of pattern - 1
+        LongUIFindWindowLength = 64 * 1024,
         // max count of longui text renderer [fixed buffer length]
         LongUITextRendererCountMax = 10,
         // max length of longui text renderer length [fixed buffer length]
         LongUITextRendererNameMaxLength = 32,
         // max count of gradient stop [fixed buffer length]
         LongUIMaxGradientStop = 128,
-        // dirty control size [fixed buffer length]
-        // if dirty control number bigger than this in one frame,
-        // will do the full-rendering, not dirty-rendering
-        LongUIDirtyControlSize = 15,
+        // max count of rect in dirty region [fixed buffer length]
+        // if more rects added in one frame, the cheapest
+        // two rects will be merged into one
+        LongUIDirtyRegionSize = 32,
+        // container with children over this will build spatial index for hit-testing
+        LongUISpatialIndexThreshold = 64,
+        // sorting over this count will use helper threads
+        LongUIParallelSortThreshold = 16 * 1024,
         // PlanToRender total time in sec. [fixed buffer length]
         LongUIPlanRenderingTotalTime = 5,
         // LongUI Default Window Width 
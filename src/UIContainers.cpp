@@ -45,7 +45,7 @@ bool LongUI::UIContainerBuiltIn::DoEvent(const LongUI::EventArgument& arg) noexc
 // UIContainerBuiltIn: 主景渲染
 inline void LongUI::UIContainerBuiltIn::render_chain_main() const noexcept {
     // 渲染帮助器
-    Super::RenderHelper(UIManager_RenderTarget, this->begin(), this->end());
+    Super::RenderHelper(UIManager_RenderTarget);
     // 父类主景
     Super::render_chain_main();
 }
@@ -62,8 +62,10 @@ void LongUI::UIContainerBuiltIn::Render() const noexcept {
 
 // LongUI内建容器: 刷新
 void LongUI::UIContainerBuiltIn::Update() noexcept {
-    // 帮助器
-    Super::UpdateHelper<Super>(this->begin(), this->end());
+    // 帮助器, 子控件世界转换或者大小修改时网格失效
+    if (Super::UpdateHelper<Super>(this->begin(), this->end())) {
+        this->invalidate_grid();
+    }
 }
 
 
@@ -88,16 +90,15 @@ auto LongUI::UIContainerBuiltIn::FindChild(const D2D1_POINT_2F& pt) noexcept ->U
     // 父类(边缘控件)
     auto mctrl = Super::FindChild(pt);
     if (mctrl) return mctrl;
-    // 性能警告
-#ifdef _DEBUG
-    if (this->GetChildrenCount() > 100) {
-        UIManager << DL_Warning
-            << "Performance Warning: O(n) algorithm"
-            << " is not fine for container that over 100 children"
-            << LongUI::endl;
+    // 子控件太多则使用空间索引
+    if (this->GetChildrenCount() >= LongUISpatialIndexThreshold) {
+        if (!m_pGrid || !m_pGrid->IsValid()) this->rebuild_grid();
+        if (m_pGrid && m_pGrid->IsValid()) {
+            return static_cast<UIControl*>(m_pGrid->FindTopmost(pt.x, pt.y));
+        }
     }
-#endif
-    for (auto ctrl : (*this)) {
+    // 倒序: 后渲染的在上面
+    for (auto ctrl = m_pTail; ctrl; ctrl = ctrl->prev) {
         // 区域内判断
         if (IsPointInRect(ctrl->visible_rect, pt)) {
             return ctrl;
@@ -106,6 +107,27 @@ auto LongUI::UIContainerBuiltIn::FindChild(const D2D1_POINT_2F& pt) noexcept ->U
     return nullptr;
 }
 
+/// <summary>
+/// Rebuilds the spatial index.
+/// </summary>
+/// <returns></returns>
+void LongUI::UIContainerBuiltIn::rebuild_grid() noexcept {
+    if (!m_pGrid) m_pGrid = new(std::nothrow) CUISpatialGrid;
+    if (!m_pGrid) return;
+    m_pGrid->Clear();
+    for (auto ctrl : (*this)) {
+        RectLTRB_F rect;
+        rect.left = ctrl->visible_rect.left;
+        rect.top = ctrl->visible_rect.top;
+        rect.right = ctrl->visible_rect.right;
+        rect.bottom = ctrl->visible_rect.bottom;
+        m_pGrid->Add(rect, ctrl);
+    }
+    // 内存不足时回退到线性查找
+    if (m_pGrid->GetCount() != this->GetChildrenCount()) return m_pGrid->Clear();
+    m_pGrid->Build();
+}
+
 
 // UIContainerBuiltIn: 推入♂最后
 void LongUI::UIContainerBuiltIn::Push(UIControl* child) noexcept {
@@ -158,6 +180,7 @@ void LongUI::UIContainerBuiltIn::insert_only(Iterator itr, UIControl* ctrl) noex
         force_cast(itr->prev) = ctrl;
     }
     ++m_cChildrenCount;
+    this->invalidate_grid();
 }
 
 
@@ -195,6 +218,7 @@ void LongUI::UIContainerBuiltIn::Remove(UIControl* ctrl) noexcept {
         --m_cChildrenCount;
         // 修改
         this->SetControlLayoutChanged();
+        this->invalidate_grid();
     }
     // 父类处理
     Super::Remove(ctrl);
@@ -364,6 +388,7 @@ void LongUI::UIContainerBuiltIn::SwapChild(Iterator itr1, Iterator itr2) noexcep
         // 刷新
         this->SetControlLayoutChanged();
         this->InvalidateThis();
+        this->invalidate_grid();
     }
     // 给予警告
     else {
@@ -609,7 +634,7 @@ auto LongUI::UISingle::Recreate() noexcept -> HRESULT {
 // UISingle: 主景渲染
 void LongUI::UISingle::render_chain_main() const noexcept {
     // 渲染帮助器
-    Super::RenderHelper(UIManager_RenderTarget, this->begin(), this->end());
+    Super::RenderHelper(UIManager_RenderTarget);
     // 父类主景
     Super::render_chain_main();
 }
@@ -831,7 +856,7 @@ void LongUI::UIPage::render_chain_main() const noexcept {
         float xoffset = (m_animation.value * direction + off) * view_size.width;
         UIManager_RenderTarget->SetTransform(
             DX::Matrix3x2F::Translation(xoffset, 0.f)
-            * m_pNextDisplay->world
+            * m_pNextDisplay->RefRenderState().world
         );
         m_pNextDisplay->Render();
         // 有效
@@ -839,13 +864,13 @@ void LongUI::UIPage::render_chain_main() const noexcept {
             xoffset = (m_animation.value * direction) * view_size.width;
             UIManager_RenderTarget->SetTransform(
                 DX::Matrix3x2F::Translation(xoffset, 0.f)
-                * m_pNowDisplay->world
+                * m_pNowDisplay->RefRenderState().world
             );
             m_pNowDisplay->Render();
         }
     }
     // 回归
-    UIManager_RenderTarget->SetTransform(&this->world);
+    UIManager_RenderTarget->SetTransform(&this->RefRenderState().world);
     // 父类主景
     Super::render_chain_main();
 }
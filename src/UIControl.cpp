@@ -61,6 +61,8 @@ Win8/8.1/10.0.10158之前
 // longui::impl namespace
 namespace LongUI { namespace impl { static float const floatx2[] = { 0.f, 0.f }; } }
 
+// version of tree order, begin with 1 to make new control invalid
+
 /// <summary>
 /// Invalidates the this.
 /// </summary>
@@ -125,6 +127,8 @@ void LongUI::UIControl::StartRender(float time) noexcept {
     const auto tt = time + 0.025f;
     // 不足再刷新
     if (m_fRenderTime < tt) m_fRenderTime = tt;
+    // 唤醒帧线程
+    UIManager.WakeUp();
     // 刷新再说
     //this->InvalidateThis();
 }
@@ -136,7 +140,16 @@ void LongUI::UIControl::StartRender(float time) noexcept {
 /// <returns></returns>
 LongUINoinline void LongUI::UIControl::Release() noexcept {
     uint32_t count = --m_u8RefCount;
-    if (!m_u8RefCount) this->cleanup();
+    if (!m_u8RefCount) {
+        // 正在渲染: 延迟清理
+        if (UIManager.IsRenderInFlight()) {
+            ++m_u8RefCount;
+            UIManager.PushDelayCleanup(this);
+        }
+        else {
+            this->cleanup();
+        }
+    }
 }
 
 #ifdef _DEBUG
@@ -179,6 +192,8 @@ void LongUI::UIControl::NewParentSetted() noexcept {
     assert(this->name == "" && "control grafting cannot used for named control");
     // 修改等级
     force_cast(this->level) = this->parent->level + 1;
+    // 树结构修改: 旧窗口与新窗口
+    this->InvalidateTreeOrder();
     // 修改窗口
     auto new_window = this->parent->GetWindow();
     // TODO: 去除旧窗口
@@ -186,6 +201,7 @@ void LongUI::UIControl::NewParentSetted() noexcept {
 
     }
     m_pWindow = new_window;
+    this->InvalidateTreeOrder();
 }
 
 /// <summary>
@@ -196,6 +212,7 @@ void LongUI::UIControl::NewParentSetted() noexcept {
 void LongUI::UIControl::LinkNewParent(UIContainer* cp) noexcept {
     force_cast(this->parent) = cp;
     m_pWindow = cp->GetWindow();
+    this->InvalidateTreeOrder();
     this->DoLongUIEvent(Event::Event_SetNewParent);
 }
 
@@ -278,6 +295,10 @@ void LongUI::UIControl::initialize(pugi::xml_node node) noexcept {
                 auto namestr = m_pWindow->CopyStringSafe(basestr);
                 force_cast(this->name) = namestr;
             }
+#ifdef LONGUI_WITH_CONTROL_PROFILER
+            // 分析器使用注册的类名
+            this->class_name = m_pWindow->CopyStringSafe(node.name());
+#endif
         }
         // 检查外边距
         Helper::MakeFloats(
@@ -410,11 +431,16 @@ void LongUI::UIControl::initialize() noexcept {
 LongUI::UIControl::~UIControl() noexcept {
     LongUI::SafeRelease(m_pBrush_SetBeforeUse);
     LongUI::SafeRelease(m_pBackgroudBrush);
+    for (auto& state : m_aRender) LongUI::SafeRelease(state.layout);
     // 释放脚本占用空间
     if (m_script.script) {
         assert(UIManager.script && "no script interface but data");
         UIManager.script->FreeScript(m_script);
     }
+#ifdef LONGUI_WITH_CONTROL_PROFILER
+    // 统计数据不再指向本控件
+    CUIControlProfiler::Forget(this);
+#endif
 }
 
 // UIControl:: 渲染调用链: 背景
@@ -432,7 +458,8 @@ void LongUI::UIControl::render_chain_background() const noexcept {
 #endif
 #if 1
     if (m_pBackgroudBrush) {
-        D2D1_RECT_F rect; this->GetViewRect(rect);
+        const auto& size = this->RefRenderState().view_size;
+        D2D1_RECT_F rect = { 0.f, 0.f, size.width, size.height };
         LongUI::FillRectWithCommonBrush(UIManager_RenderTarget, m_pBackgroudBrush, rect);
     }
 #else
@@ -459,10 +486,15 @@ void LongUI::UIControl::render_chain_foreground() const noexcept {
     }
     force_cast(this->debug_checker).SetTrue<DEBUG_CHECK_FORE>();
 #endif
+    const auto& state = this->RefRenderState();
     // 渲染边框
     if (m_fBorderWidth > 0.f) {
-        D2D1_ROUNDED_RECT brect; this->GetBorderRect(brect.rect);
-        m_pBrush_SetBeforeUse->SetColor(&m_colorBorderNow);
+        D2D1_ROUNDED_RECT brect;
+        brect.rect.left = -m_fBorderWidth * 0.5f;
+        brect.rect.top = -m_fBorderWidth * 0.5f;
+        brect.rect.right = state.view_size.width + m_fBorderWidth * 0.5f;
+        brect.rect.bottom = state.view_size.height + m_fBorderWidth * 0.5f;
+        m_pBrush_SetBeforeUse->SetColor(&state.border_color);
         brect.radiusX = m_2fBorderRdius.width;
         brect.radiusY = m_2fBorderRdius.height;
         UIManager_RenderTarget->DrawRoundedRectangle(&brect, m_pBrush_SetBeforeUse, m_fBorderWidth);
@@ -470,8 +502,12 @@ void LongUI::UIControl::render_chain_foreground() const noexcept {
     // 默认聚焦效果行为
     if (!(this->flags & Flag_NoDefaultFocusedRendering) && 
         m_pWindow->IsControlFocused(this)) {
-        D2D1_RECT_F rect; this->GetFocusRect(rect);
-        UIManager.RefFocusedBrush()->SetTransform(this->world);
+        D2D1_RECT_F rect;
+        rect.left = 1.f + m_fBorderWidth;
+        rect.top = 1.f + m_fBorderWidth;
+        rect.right = state.view_size.width - m_fBorderWidth - 1.f;
+        rect.bottom = state.view_size.height - m_fBorderWidth - 1.f;
+        UIManager.RefFocusedBrush()->SetTransform(state.world);
         UIManager_RenderTarget->DrawRectangle(
             &rect, UIManager.RefFocusedBrush(), 2.f
         );
@@ -544,11 +580,137 @@ auto LongUI::UIControl::Recreate() noexcept ->HRESULT {
 
 // 测试是否为子孙结点
 bool LongUI::UIControl::IsPosterityForSelf(const UIControl* test) const noexcept {
+    // 树序有效: O(1)
+    if (this->IsTreeOrderValid() && test->IsTreeOrderValid() && m_pWindow == test->m_pWindow) {
+        const bool result = m_uTreePre <= test->m_uTreePre && test->m_uTreePost <= m_uTreePost;
+#ifdef _DEBUG
+        auto check = test;
+        while (check->level > this->level) check = check->parent;
+        assert(result == (this == check) && "bad tree order");
+#endif
+        return result;
+    }
+    // 沿父结点查找: O(depth)
     const auto target = this->level;
     while (test->level > target) test = test->parent;
     return this == test;
 }
 
+/// <summary>
+/// Refreshes the tree order(pre/post-order index) for this subtree.
+/// </summary>
+/// <param name="index">The next pre-order index.</param>
+/// <returns></returns>
+void LongUI::UIControl::RefreshTreeOrder(uint32_t& index) noexcept {
+    m_uTreePre = index++;
+    // 容器
+    if (this->flags & Flag_UIContainer) {
+        const auto container = static_cast<UIContainer*>(this);
+        // 边缘控件
+        for (auto itr = container->MCBegin(); itr != container->MCEnd(); ++itr) {
+            (*itr)->RefreshTreeOrder(index);
+        }
+        // 子控件, 跳过占位控件
+        container->ForEachChild([container, &index](UIControl* ctrl) noexcept {
+            if (ctrl->parent == container) ctrl->RefreshTreeOrder(index);
+        });
+    }
+    m_uTreePost = index;
+    m_uTreeVersion = m_pWindow ? m_pWindow->GetTreeVersion() : 0;
+}
+
+/// <summary>
+/// Determines whether tree order is valid, same version as window.
+/// </summary>
+/// <returns></returns>
+bool LongUI::UIControl::IsTreeOrderValid() const noexcept {
+    return m_pWindow && m_uTreeVersion == m_pWindow->GetTreeVersion();
+}
+
+/// <summary>
+/// Invalidates the tree order of controls in same window.
+/// </summary>
+/// <returns></returns>
+void LongUI::UIControl::InvalidateTreeOrder() noexcept {
+    if (m_pWindow) m_pWindow->InvalidateTreeOrder();
+}
+
+/// <summary>
+/// Snapshots the render state of this subtree into back frame.
+/// </summary>
+/// <param name="children">The renderable children of frame.</param>
+/// <param name="back">The index of back frame.</param>
+/// <param name="serial">The serial of frame.</param>
+/// <returns></returns>
+void LongUI::UIControl::SnapshotRender(ControlVector& children, uint32_t back, uint32_t serial) noexcept {
+    auto& state = m_aRender[back];
+    state.world = this->world;
+    state.visible_rect = this->visible_rect;
+    state.view_size = this->view_size;
+    state.border_color = m_colorBorderNow;
+    LongUI::SafeRelease(state.layout);
+    state.serial = serial;
+    state.child_begin = children.size();
+    state.marginal_count = 0;
+    state.child_count = 0;
+    this->snapshot_render(state);
+    // 容器
+    if (this->flags & Flag_UIContainer) {
+        const auto container = static_cast<UIContainer*>(this);
+        // 可渲染的直接子控件连续存放, 边缘控件在前
+        const auto renderable = [&children](UIControl* ctrl) noexcept {
+            const auto& vrc = ctrl->visible_rect;
+            if (ctrl->GetVisible() && vrc.right > vrc.left && vrc.bottom > vrc.top) {
+                children.push_back(ctrl);
+            }
+        };
+        for (auto itr = container->MCBegin(); itr != container->MCEnd(); ++itr) {
+            renderable(*itr);
+        }
+        state.marginal_count = children.size() - state.child_begin;
+        container->ForEachChild(renderable);
+        state.child_count = children.size() - state.child_begin - state.marginal_count;
+        // 子树追加在之后, 不可渲染的子控件也可能被直接渲染(UIPage)
+        const auto snapshot = [&children, back, serial](UIControl* ctrl) noexcept {
+            ctrl->SnapshotRender(children, back, serial);
+        };
+        for (auto itr = container->MCBegin(); itr != container->MCEnd(); ++itr) {
+            snapshot(*itr);
+        }
+        container->ForEachChild(snapshot);
+    }
+}
+
+/// <summary>
+/// Refs the render state in front frame.
+/// </summary>
+/// <returns></returns>
+auto LongUI::UIControl::RefRenderState() const noexcept -> const RenderState& {
+    assert(m_pWindow && "render control without window");
+    return m_aRender[m_pWindow->GetFrontIndex()];
+}
+
+/// <summary>
+/// Gets the renderable children in front frame.
+/// </summary>
+/// <returns>marginal controls first</returns>
+auto LongUI::UIControl::GetRenderChildren() const noexcept -> UIControl*const* {
+    return m_pWindow->RefFrontFrame().children.data() + this->RefRenderState().child_begin;
+}
+
+/// <summary>
+/// Gets the clip rect in front frame, call it in render.
+/// </summary>
+/// <param name="rect">The rect.</param>
+/// <returns></returns>
+void LongUI::UIControl::GetRenderClipRect(D2D1_RECT_F& rect) const noexcept {
+    const auto& size = this->RefRenderState().view_size;
+    rect.left = -(this->margin_rect.left + m_fBorderWidth);
+    rect.top = -(this->margin_rect.top + m_fBorderWidth);
+    rect.right = size.width + this->margin_rect.right + m_fBorderWidth;
+    rect.bottom = size.height + this->margin_rect.bottom + m_fBorderWidth;
+}
+
 // 获取占用宽度
 auto LongUI::UIControl::GetTakingUpWidth() const noexcept -> float {
     return this->view_size.width
@@ -1065,6 +1227,8 @@ void LongUI::UIContainer::after_insert(UIControl* child) noexcept {
     }
     // 增加引用计数
     child->AddRef();
+    // 树结构修改
+    this->InvalidateTreeOrder();
     // 设置父结点
     assert(child->parent == this);
     // 设置窗口结点
@@ -1190,37 +1354,43 @@ bool LongUI::UIContainer::DoMouseEvent(const LongUI::MouseEventArgument& arg) no
 
 // 渲染子控件
 void LongUI::UIContainer::child_do_render(const UIControl* ctrl) noexcept {
-    auto& vrc = ctrl->visible_rect;  bool v = ctrl->GetVisible();
-    bool w = vrc.right > vrc.left;   bool h = vrc.bottom > vrc.top;
-    // 可渲染?
-    if (v && w && h) {
-        // 修改世界转换矩阵
-        UIManager_RenderTarget->SetTransform(&ctrl->world);
-        // 检查剪切规则
-        if (ctrl->flags & Flag_ClipStrictly) {
-            D2D1_RECT_F clip_rect; ctrl->GetClipRect(clip_rect);
-            UIManager_RenderTarget->PushAxisAlignedClip(
-                &clip_rect, D2D1_ANTIALIAS_MODE_ALIASED
-            );
-        }
-        // 渲染
+    // 帧快照里的子控件都是可渲染的
+    const auto& state = ctrl->RefRenderState();
+    const auto& vrc = state.visible_rect;
+    assert(vrc.right > vrc.left && vrc.bottom > vrc.top && "unrenderable");
+    UNREFERENCED_PARAMETER(vrc);
+    // 修改世界转换矩阵
+    UIManager_RenderTarget->SetTransform(&state.world);
+    // 检查剪切规则
+    if (ctrl->flags & Flag_ClipStrictly) {
+        D2D1_RECT_F clip_rect; ctrl->GetRenderClipRect(clip_rect);
+        UIManager_RenderTarget->PushAxisAlignedClip(
+            &clip_rect, D2D1_ANTIALIAS_MODE_ALIASED
+        );
+    }
+    // 渲染
+    {
+#ifdef LONGUI_WITH_CONTROL_PROFILER
+        CUIControlProfiler::Scope scope(ctrl, CUIControlProfiler::Kind_Render);
+#endif
         ctrl->Render();
-        // 检查剪切规则
-        if (ctrl->flags & Flag_ClipStrictly) {
-            UIManager_RenderTarget->PopAxisAlignedClip();
-        }
+    }
+    // 检查剪切规则
+    if (ctrl->flags & Flag_ClipStrictly) {
+        UIManager_RenderTarget->PopAxisAlignedClip();
     }
 }
 
 // UIContainer: 主景渲染
 void LongUI::UIContainer::render_chain_main() const noexcept {
     // 渲染边缘控件
-    for (auto itr = this->MCBegin(); itr != this->MCEnd(); ++itr) {
-        auto ctrl = *itr;
-        this->child_do_render(ctrl);
+    const auto children = this->GetRenderChildren();
+    const auto count = this->RefRenderState().marginal_count;
+    for (uint32_t i = 0; i != count; ++i) {
+        this->child_do_render(children[i]);
     }
     // 回退转变
-    UIManager_RenderTarget->SetTransform(&this->world);
+    UIManager_RenderTarget->SetTransform(&this->RefRenderState().world);
     // 父类
     Super::render_chain_main();
 }
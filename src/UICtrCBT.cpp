@@ -287,12 +287,24 @@ auto LongUI::UIRamBitmap::CreateControl(
 // 前景渲染
 void LongUI::UIText::render_chain_foreground() const noexcept {
     // 文本算前景
-    m_text.Render(UIManager_RenderTarget, D2D1_POINT_2F{});
+    this->render_text(D2D1_POINT_2F{});
     // 父类
     Super::render_chain_foreground();
 }
 
 
+// UI文本: 渲染帧快照的文本
+void LongUI::UIText::render_text(D2D1_POINT_2F pt) const noexcept {
+    const auto& state = this->RefRenderState();
+    m_text.Render(UIManager_RenderTarget, pt, state.layout, state.text_color);
+}
+
+// UI文本: 复制文本布局与颜色
+void LongUI::UIText::snapshot_render(RenderState& state) noexcept {
+    state.layout = m_text.GetLayout();
+    state.text_color = *m_text.GetColor();
+}
+
 // UI文本: 渲染
 void LongUI::UIText::Render() const noexcept {
     // 背景渲染
@@ -725,11 +737,11 @@ void LongUI::UIComboBox::initialize(pugi::xml_node node) noexcept {
         auto list = m_pItemList;
         m_pItemList->AddEventCall([list, this](UIControl* unused) noexcept {
             UNREFERENCED_PARAMETER(unused);
-            auto& selected = list->GetSelectedIndices();
+            auto& selected = list->GetSelection();
             // 检查选项
-            if (selected.size() && m_vItems.isok()) {
+            if (!selected.IsEmpty() && m_vItems.isok()) {
                 // 选择
-                uint32_t index = uint32_t(selected.front());
+                uint32_t index = selected.GetFirst();
                 auto old = this->GetSelectedIndex();
                 this->SetSelectedIndex(index);
                 // 是否选择
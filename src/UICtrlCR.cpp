@@ -14,10 +14,8 @@ void LongUI::UICheckBox::render_chain_main() const noexcept {
 
 // 背景渲染
 void LongUI::UICheckBox::render_chain_foreground() const noexcept {
-    // 文本算前景
-    if (m_text.GetString().length()) {
-        m_text.Render(UIManager_RenderTarget, D2D1_POINT_2F{ BOX_SIZE, 0.f });
-    }
+    // 文本算前景, 空文本的布局不会绘制
+    this->render_text(D2D1_POINT_2F{ BOX_SIZE, 0.f });
     // 父类-父类
     UIControl::render_chain_foreground();
 }
@@ -234,10 +232,8 @@ void LongUI::UIRadioButton::render_chain_main() const noexcept {
 
 // 背景渲染
 void LongUI::UIRadioButton::render_chain_foreground() const noexcept {
-    // 文本算前景
-    if (m_text.GetString().length()) {
-        m_text.Render(UIManager_RenderTarget, D2D1_POINT_2F{ RADIO_SIZE, 0.f });
-    }
+    // 文本算前景, 空文本的布局不会绘制
+    this->render_text(D2D1_POINT_2F{ RADIO_SIZE, 0.f });
     // 父类-父类
     UIControl::render_chain_foreground();
 }
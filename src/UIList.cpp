@@ -1,7 +1,73 @@
 ﻿#include "Control/UIList.h"
 #include "Core/luiManager.h"
 #include "Control/UIText.h"
+#include "Platless/luiPlSort.h"
 #include <algorithm>
+#include <process.h>
+
+// longui::impl namespace
+namespace LongUI { namespace impl {
+    // task for parallel sort
+    struct sort_task {
+        // keys
+        const StringSortKey*    keys;
+        // index array
+        uint32_t*               index;
+        // temp buffer
+        uint32_t*               tmp;
+        // count
+        uint32_t                count;
+    };
+    // thread for sort task
+    unsigned __stdcall sort_task_thread(void* arg) noexcept {
+        auto task = static_cast<sort_task*>(arg);
+        LongUI::MergeSortIndex(task->keys, task->index, task->tmp, task->count);
+        return 0;
+    }
+    // parallel stable merge sort: sort chunks in threads, then merge
+    void parallel_merge_sort(const StringSortKey keys[], uint32_t index[], uint32_t tmp[], uint32_t count) noexcept {
+        enum : uint32_t { MAX_TASK = 4 };
+        SYSTEM_INFO info; ::GetSystemInfo(&info);
+        const auto task_count = std::min(uint32_t(info.dwNumberOfProcessors), uint32_t(MAX_TASK));
+        // 数量不够
+        if (count < LongUIParallelSortThreshold || task_count < 2) {
+            return LongUI::MergeSortIndex(keys, index, tmp, count);
+        }
+        sort_task tasks[MAX_TASK];
+        HANDLE threads[MAX_TASK] = { nullptr };
+        const auto chunk = (count + task_count - 1) / task_count;
+        for (uint32_t i = 0; i < task_count; ++i) {
+            const auto start = i * chunk;
+            tasks[i] = { keys, index + start, tmp + start, std::min(chunk, count - start) };
+        }
+        // 第一段由当前线程处理
+        for (uint32_t i = 1; i < task_count; ++i) {
+            threads[i] = reinterpret_cast<HANDLE>(
+                ::_beginthreadex(nullptr, 0, sort_task_thread, tasks + i, 0, nullptr)
+                );
+            // 创建失败就自己来
+            if (!threads[i]) sort_task_thread(tasks + i);
+        }
+        sort_task_thread(tasks + 0);
+        for (uint32_t i = 1; i < task_count; ++i) {
+            if (threads[i]) {
+                ::WaitForSingleObject(threads[i], INFINITE);
+                ::CloseHandle(threads[i]);
+            }
+        }
+        // 逐层归并各段
+        auto src = index, des = tmp;
+        for (auto width = chunk; width < count; width *= 2) {
+            for (uint32_t bn = 0; bn < count; bn += width * 2) {
+                const auto mid = std::min(bn + width, count);
+                const auto ed = std::min(bn + width * 2, count);
+                LongUI::MergeIndex(keys, src + bn, mid - bn, src + mid, ed - mid, des + bn);
+            }
+            std::swap(src, des);
+        }
+        if (src != index) std::memcpy(index, src, sizeof(uint32_t) * count);
+    }
+}}
 
 // ----------------------------------------------------------------------------
 // -------------------------------- UIList ------------------------------------
@@ -14,7 +80,6 @@ void LongUI::UIList::initialize(pugi::xml_node node) noexcept {
     Super::initialize(node);
     // 初始
     m_vLines.reserve(50);
-    m_vSelectedIndex.reserve(16);
     m_vLineTemplate.reserve(16);
     // OOM or BAD ACTION
     if (!m_vLines.isok() && !m_vLineTemplate.isok()) {
@@ -59,6 +124,10 @@ void LongUI::UIList::initialize(pugi::xml_node node) noexcept {
         if (node.attribute("sort").as_bool(false)) {
             listflag |= this->Flag_SortableLineWithUserDataPtr;
         }
+        // 键入查找列
+        if ((str = node.attribute("searchcolumn").value())) {
+            this->SetSearchColumn(uint32_t(LongUI::AtoI(str)));
+        }
         // 普通背景颜色
         Helper::MakeColor(node.attribute("linebkcolor").value(), m_colorLineNormal1);
         // 普通背景颜色2 - step 1
@@ -91,7 +160,8 @@ bool LongUI::UIList::uniface_addevent(SubEvent sb, UICallBack&& call) noexcept {
     case LongUI::SubEvent::Event_EditReturned:
         break;
     case LongUI::SubEvent::Event_ValueChanged:
-        break;
+        m_callSelectionChanged += std::move(call);
+        return true;
     case LongUI::SubEvent::Event_Custom:
         break;
     default:
@@ -114,28 +184,43 @@ auto LongUI::UIList::get_referent_control() const noexcept -> UIListLine* {
 
 // 依靠鼠标位置获取列表行索引
 auto LongUI::UIList::find_line_index(const D2D1_POINT_2F& pt) const noexcept ->uint32_t {
+    const auto rows = this->GetRowCount();
+    // 行偏移索引有效: O(log n)
+    if (m_oRowOffset.GetCount() == rows) {
+        const auto local = LongUI::TransformPointInverse(this->world, pt);
+        if (local.x < 0.f || local.x >= this->view_size.width) return rows;
+        if (local.y < 0.f || local.y >= this->view_size.height) return rows;
+        return m_oRowOffset.Find(local.y / this->GetZoomY() - this->GetOffsetYZoomed());
+    }
     uint32_t index = 0;
     // XXX: 利用list特性优化
     for (auto ctrl : m_vLines) {
         // 区域内判断
-        if (IsPointInRect(ctrl->visible_rect, pt)) {
-            break;
+        if (ctrl->GetVisible() && IsPointInRect(ctrl->visible_rect, pt)) {
+            // 虚拟模式: 行池索引 -> 行索引
+            return m_pDataSource ? m_ixFirstBound + index : index;
         }
         ++index;
     }
-    return index;
+    return rows;
 }
 
 // 依靠鼠标位置获取列表行
 auto LongUI::UIList::find_line(const D2D1_POINT_2F& pt) const noexcept ->UIListLine* {
-    // XXX: 利用list特性优化
-    for (auto ctrl : m_vLines) {
-        // 区域内判断
-        if (IsPointInRect(ctrl->visible_rect, pt)) {
-            return ctrl;
+    return this->GetLineOfRow(this->find_line_index(pt));
+}
+
+// 获取行对应的列表行
+auto LongUI::UIList::GetLineOfRow(uint32_t row) const noexcept ->UIListLine* {
+    // 虚拟模式: 只有绑定在行池中的行才有控件
+    if (m_pDataSource) {
+        const auto index = row - m_ixFirstBound;
+        if (row < m_cVirtualRow && index < m_vLines.size()) {
+            return m_vLines[index];
         }
+        return nullptr;
     }
-    return nullptr;
+    return row < m_vLines.size() ? m_vLines[row] : nullptr;
 }
 
 
@@ -164,6 +249,8 @@ void LongUI::UIList::ClearList() noexcept {
     }
     m_vLines.clear();
     m_cChildrenCount = 0;
+    m_oPrefix.Clear();
+    m_bPrefixDirty = true;
 }
 
 
@@ -179,26 +266,41 @@ void LongUI::UIList::Push(UIControl* child) noexcept {
     }
 }
 
+// 对齐列表行
+void LongUI::UIList::align_line(UIListLine* child) noexcept {
+    assert(child && "bad argument");
+    auto line = this->get_referent_control();
+    if (line && line != child) {
+        auto itr1 = child->begin();
+        for (auto itr2 = line->begin(); itr2 != line->end(); ++itr1, ++itr2) {
+            auto ctrl_new = *itr1, ctrl_ref = *itr2;
+            force_cast(ctrl_new->flags) = ctrl_ref->flags;
+            force_cast(ctrl_new->weight) = ctrl_ref->weight;
+            ctrl_new->SetWidth(ctrl_ref->GetWidth());
+        }
+    }
+}
+
 // 插入
 LongUINoinline void LongUI::UIList::Insert(uint32_t index, UIListLine* child) noexcept {
     assert(child && "bad argument");
-    if (child) {
+    assert(!m_pDataSource && "cannot insert line in virtual mode");
+    if (child && !m_pDataSource) {
+        // 不再有序
+        m_ixSortColumn = uint32_t(-1);
         // 对齐操作
-        auto line = this->get_referent_control();
-        if (line) {
-            auto itr1 = child->begin();
-            for (auto itr2 = line->begin(); itr2 != line->end(); ++itr1, ++itr2) {
-                auto ctrl_new = *itr1, ctrl_ref = *itr2;
-                force_cast(ctrl_new->flags) = ctrl_ref->flags;
-                force_cast(ctrl_new->weight) = ctrl_ref->weight;
-                ctrl_new->SetWidth(ctrl_ref->GetWidth());
-            }
-        }
+        this->align_line(child);
         m_vLines.insert(index, child);
         this->after_insert(child);
         ++m_cChildrenCount;
-        this->reset_select();
+        // 选择后移一行, 逐行插入时不再每行重置选择
+        m_oSelection.InsertAt(index, false);
         assert(m_vLines.isok());
+        // 前缀索引增量插入
+        if (this->is_prefix_synced()) {
+            const auto key = this->get_search_key(index);
+            if (!m_oPrefix.Insert(index, &key, 1)) m_bPrefixDirty = true;
+        }
     }
 }
 
@@ -206,8 +308,13 @@ LongUINoinline void LongUI::UIList::Insert(uint32_t index, UIListLine* child) no
 void LongUI::UIList::Sort(uint32_t index, UIControl* child) noexcept {
     // 修改
     m_pToBeSortedHeaderChild = child;
+    // 虚拟模式: 数据源负责排序
+    if (m_pDataSource) {
+        m_callBeforSort(this);
+        this->NotifyDataChanged();
+    }
     // 有必要再说
-    if ((this->list_flag & Flag_SortableLineWithUserDataPtr) 
+    else if ((this->list_flag & Flag_SortableLineWithUserDataPtr) 
         && m_vLines.size() > 1 
         && index < m_vLines.front()->GetChildrenCount()) {
         assert(child && "bad argument");
@@ -218,33 +325,46 @@ void LongUI::UIList::Sort(uint32_t index, UIControl* child) noexcept {
         }
         // 排序前
         m_callBeforSort(this);
-        // 普通排序
-        auto cmp_user_data = [](UIControl* a, UIControl* b) noexcept {
-            assert(a && b && "bad arguments");
-            auto ctrla = longui_cast<UIListLine*>(a)->GetToBeSorted();
-            auto ctrlb = longui_cast<UIListLine*>(b)->GetToBeSorted();
-            assert(ctrla && ctrlb && "bad action");
-            return ctrla->user_data < ctrlb->user_data;
-        };
-        // 字符串排序
-        auto cmp_user_ptr = [](UIControl* a, UIControl* b) noexcept {
-            assert(a && b && "bad arguments");
-            auto ctrla = longui_cast<UIListLine*>(a)->GetToBeSorted();
-            auto ctrlb = longui_cast<UIListLine*>(b)->GetToBeSorted();
-            assert(ctrla && ctrlb && "bad action");
-            auto stra = static_cast<const wchar_t*>(ctrla->user_ptr);
-            auto strb = static_cast<const wchar_t*>(ctrlb->user_ptr);
-            assert(stra && strb && "bad action");
-            return std::wcscmp(stra, strb) < 0;
-        };
-        // 普通排序
-        bool(*cmp_alg)(UIControl*, UIControl*) = cmp_user_data;
         // 字符串排序?
-        if (m_vLines.front()->GetToBeSorted()->user_ptr) {
-            cmp_alg = cmp_user_ptr;
+        const bool string = !!m_vLines.front()->GetToBeSorted()->user_ptr;
+        // 数量较多: 提取键值排序
+        const bool by_key = m_vLines.size() >= m_cFastSortThreshold
+            && this->sort_line_by_key(string);
+        // 比较器排序
+        if (!by_key) {
+            // 普通排序
+            auto cmp_user_data = [](UIControl* a, UIControl* b) noexcept {
+                assert(a && b && "bad arguments");
+                auto ctrla = longui_cast<UIListLine*>(a)->GetToBeSorted();
+                auto ctrlb = longui_cast<UIListLine*>(b)->GetToBeSorted();
+                assert(ctrla && ctrlb && "bad action");
+                return ctrla->user_data < ctrlb->user_data;
+            };
+            // 字符串排序
+            auto cmp_user_ptr = [](UIControl* a, UIControl* b) noexcept {
+                assert(a && b && "bad arguments");
+                auto ctrla = longui_cast<UIListLine*>(a)->GetToBeSorted();
+                auto ctrlb = longui_cast<UIListLine*>(b)->GetToBeSorted();
+                assert(ctrla && ctrlb && "bad action");
+                auto stra = static_cast<const wchar_t*>(ctrla->user_ptr);
+                auto strb = static_cast<const wchar_t*>(ctrlb->user_ptr);
+                assert(stra && strb && "bad action");
+                return std::wcscmp(stra, strb) < 0;
+            };
+            // 普通排序
+            bool(*cmp_alg)(UIControl*, UIControl*) = cmp_user_data;
+            // 字符串排序?
+            if (string) {
+                cmp_alg = cmp_user_ptr;
+            }
+            // 进行排序
+            this->sort_line(cmp_alg);
         }
-        // 进行排序
-        this->sort_line(cmp_alg);
+        // 行已整体重排, 前缀索引在下次查找时重建
+        m_bPrefixDirty = true;
+        // 记录排序列以维护有序插入
+        m_ixSortColumn = index;
+        m_bSortDescending = this->compare_line_key(m_vLines.back(), m_vLines.front()) < 0;
         // 刷新
         this->InvalidateThis();
     }
@@ -259,6 +379,8 @@ void LongUI::UIList::Sort(uint32_t index, UIControl* child) noexcept {
 void LongUI::UIList::before_deleted() noexcept {
     // 清理子控件
     this->ClearList();
+    // 释放数据源
+    LongUI::SafeRelease(m_pDataSource);
     // 链式清理
     Super::before_deleted();
 }
@@ -276,13 +398,15 @@ void LongUI::UIList::Remove(UIControl* child) noexcept {
         return;
     }
     this->reset_select();
+    // 前缀索引增量删除
+    if (this->is_prefix_synced()) m_oPrefix.Erase(uint32_t(itr - m_vLines.cbegin()));
     m_vLines.erase(itr);
     --m_cChildrenCount;
     Super::Remove(child);
 }
 
-// 对列表插入一个行模板至指定位置
-auto LongUI::UIList::InsertLineTemplateToList(uint32_t index) noexcept ->UIListLine* {
+// 利用行模板创建列表行
+auto LongUI::UIList::create_template_line() noexcept ->UIListLine* {
     // 创建列表行
     auto ctrl = UIListLine::CreateControl(this);
     if (!ctrl) return ctrl;
@@ -292,6 +416,16 @@ auto LongUI::UIList::InsertLineTemplateToList(uint32_t index) noexcept ->UIListL
         ctrl->Insert(ctrl->end(), tmp);;
         tmp->Release();
     }
+    return ctrl;
+}
+
+// 对列表插入一个行模板至指定位置
+auto LongUI::UIList::InsertLineTemplateToList(uint32_t index) noexcept ->UIListLine* {
+    assert(!m_pDataSource && "cannot insert line in virtual mode");
+    if (m_pDataSource) return nullptr;
+    // 创建列表行
+    auto ctrl = this->create_template_line();
+    if (!ctrl) return ctrl;
     // 插入
     this->Insert(index, ctrl);
     // 释放计数
@@ -300,10 +434,218 @@ auto LongUI::UIList::InsertLineTemplateToList(uint32_t index) noexcept ->UIListL
     return this->GetAt(index);
 }
 
+/// <summary>
+/// Inserts lines with line-template in batch: reserve once, create in a
+/// tight loop, then shift selection and invalidate once at the end.
+/// </summary>
+/// <param name="index">The index to insert.</param>
+/// <param name="count">The count of lines.</param>
+/// <param name="call">The fill callback.</param>
+/// <param name="ctx">The context for callback.</param>
+/// <returns>count of inserted lines</returns>
+auto LongUI::UIList::insert_lines(uint32_t index, uint32_t count, FillLineCall call, void* ctx) noexcept -> uint32_t {
+    assert(!m_pDataSource && "cannot insert line in virtual mode");
+    assert(index <= m_vLines.size() && "out of range");
+    if (m_pDataSource || !count) return 0;
+    const auto old = uint32_t(m_vLines.size());
+    index = std::min(index, old);
+    // 一次性预留
+    m_vLines.reserve(old + count);
+    if (m_vLines.capacity() < old + count) {
+        UIManager << DL_Error << L"OOM for " << long(count) << L" lines" << LongUI::endl;
+        return 0;
+    }
+    // 不再有序
+    m_ixSortColumn = uint32_t(-1);
+    // 先创建至尾部
+    uint32_t created = 0;
+    for (; created < count; ++created) {
+        auto line = this->create_template_line();
+        if (!line) break;
+        this->align_line(line);
+        if (call) call(ctx, line, index + created);
+        m_vLines.push_back(line);
+        this->after_insert(line);
+        line->Release();
+    }
+    // 再旋转至插入位置
+    if (index < old) {
+        const auto bn = m_vLines.data();
+        std::rotate(bn + index, bn + old, bn + old + created);
+    }
+    m_cChildrenCount += created;
+    // 一次处理
+    if (m_cChildrenCount >= 10'000 && old < 10'000) {
+        UIManager << DL_Warning << "the count of children must be"
+            " less than 10k because of the precision of float" << LongUI::endl;
+    }
+    // 选择后移, 新行未选中
+    for (uint32_t i = 0; i != created; ++i) m_oSelection.InsertAt(index, false);
+    // 前缀索引增量插入, 键值在填充后计算
+    if (created && this->is_prefix_synced()) {
+        EzContainer::EzVector<uint64_t> keys;
+        keys.newsize(created);
+        bool ok = keys.isok();
+        if (ok) {
+            for (uint32_t i = 0; i != created; ++i) keys[i] = this->get_search_key(index + i);
+            ok = m_oPrefix.Insert(index, keys.data(), created);
+        }
+        if (!ok) m_bPrefixDirty = true;
+    }
+    this->SetControlLayoutChanged();
+    this->InvalidateThis();
+    return created;
+}
+
+/// <summary>
+/// Compares key of sort column in ascending.
+/// </summary>
+/// <param name="a">line a.</param>
+/// <param name="b">line b.</param>
+/// <returns>&lt; 0 if a &lt; b</returns>
+auto LongUI::UIList::compare_line_key(const UIListLine* a, const UIListLine* b) const noexcept -> int {
+    assert(a && b && "bad arguments");
+    assert(m_ixSortColumn < a->GetChildrenCount() && m_ixSortColumn < b->GetChildrenCount());
+    const auto ctrla = a->GetAt(m_ixSortColumn);
+    const auto ctrlb = b->GetAt(m_ixSortColumn);
+    // 字符串
+    if (ctrla->user_ptr && ctrlb->user_ptr) {
+        auto stra = static_cast<const wchar_t*>(ctrla->user_ptr);
+        auto strb = static_cast<const wchar_t*>(ctrlb->user_ptr);
+        return std::wcscmp(stra, strb);
+    }
+    // 整数
+    return ctrla->user_data < ctrlb->user_data ? -1 : (ctrlb->user_data < ctrla->user_data ? 1 : 0);
+}
+
+/// <summary>
+/// Less in current order of sort column.
+/// </summary>
+/// <param name="a">line a.</param>
+/// <param name="b">line b.</param>
+/// <returns></returns>
+bool LongUI::UIList::less_line_sorted(const UIListLine* a, const UIListLine* b) const noexcept {
+    const auto code = this->compare_line_key(a, b);
+    return m_bSortDescending ? code > 0 : code < 0;
+}
+
+/// <summary>
+/// Inserts lines in batch keeping order of sort column: one line is placed
+/// via binary search, more lines are sorted then merged in O(n + k log k)
+/// instead of k vector shifts.
+/// </summary>
+/// <param name="count">The count.</param>
+/// <param name="call">The fill callback.</param>
+/// <param name="ctx">The context for callback.</param>
+/// <returns>count of inserted lines</returns>
+auto LongUI::UIList::insert_lines_sorted(uint32_t count, FillLineCall call, void* ctx) noexcept -> uint32_t {
+    const auto column = m_ixSortColumn;
+    const auto old = uint32_t(m_vLines.size());
+    // 先添加至尾部
+    const auto created = this->insert_lines(old, count, call, ctx);
+    m_ixSortColumn = column;
+    // 无序
+    if (column == uint32_t(-1) || !created) return created;
+    const auto bn = m_vLines.data();
+    const auto mid = bn + old, ed = mid + created;
+    auto cmp = [this](const UIListLine* a, const UIListLine* b) noexcept {
+        return this->less_line_sorted(a, b);
+    };
+    // 单行: 二分查找后移动, 选择与前缀索引跟随
+    if (created == 1) {
+        const auto pos = std::upper_bound(bn, mid, *mid, cmp);
+        const auto to = uint32_t(pos - bn);
+        std::rotate(pos, mid, ed);
+        m_oSelection.EraseAt(old);
+        m_oSelection.InsertAt(to, false);
+        if (this->is_prefix_synced()) m_oPrefix.Move(old, to, this->get_search_key(to));
+        return created;
+    }
+    // 多行: 新行号排序后归并, 得到每行的来源
+    const auto total = old + created;
+    EzContainer::EzVector<uint32_t> source;
+    EzContainer::EzVector<UIListLine*> lines;
+    source.newsize(total);
+    lines.newsize(total);
+    if (!(source.isok() && lines.isok())) {
+        UIManager << DL_Error << L"OOM for sorting " << long(created) << L" lines" << LongUI::endl;
+        m_ixSortColumn = uint32_t(-1);
+        return created;
+    }
+    const auto src = source.data();
+    for (uint32_t i = 0; i != total; ++i) src[i] = i, lines[i] = bn[i];
+    auto cmp_row = [this, bn](uint32_t a, uint32_t b) noexcept {
+        return this->less_line_sorted(bn[a], bn[b]);
+    };
+    std::stable_sort(src + old, src + total, cmp_row);
+    std::inplace_merge(src, src + old, src + total, cmp_row);
+    for (uint32_t i = 0; i != total; ++i) bn[i] = lines[src[i]];
+    // 选择按来源重建
+    if (!m_oSelection.IsEmpty()) {
+        EzContainer::EzVector<uint32_t> selected;
+        for (uint32_t i = 0; i != total; ++i) {
+            if (m_oSelection.Contains(src[i])) selected.push_back(i);
+        }
+        m_oSelection.Clear();
+        for (const auto row : selected) m_oSelection.Add(row, row + 1);
+    }
+    // 前缀索引按来源重排
+    if (this->is_prefix_synced() && !m_oPrefix.Permute(src)) m_bPrefixDirty = true;
+    return created;
+}
+
+/// <summary>
+/// Moves changed line to keep order of sort column.
+/// </summary>
+/// <param name="index">The index of changed line.</param>
+/// <returns>new index</returns>
+auto LongUI::UIList::UpdateLineSorted(uint32_t index) noexcept -> uint32_t {
+    const auto count = uint32_t(m_vLines.size());
+    assert(index < count && "out of range");
+    if (m_ixSortColumn == uint32_t(-1) || index >= count || m_pDataSource) return index;
+    const auto bn = m_vLines.data();
+    const auto itr = bn + index;
+    const auto line = *itr;
+    auto cmp = [this](const UIListLine* a, const UIListLine* b) noexcept {
+        return this->less_line_sorted(a, b);
+    };
+    uint32_t new_index;
+    // 向前移动
+    if (index && cmp(line, itr[-1])) {
+        const auto pos = std::upper_bound(bn, itr, line, cmp);
+        std::rotate(pos, itr, itr + 1);
+        new_index = uint32_t(pos - bn);
+    }
+    // 向后移动
+    else if (index + 1 < count && cmp(itr[1], line)) {
+        const auto pos = std::upper_bound(itr + 1, bn + count, line, cmp);
+        std::rotate(itr, itr + 1, pos);
+        new_index = uint32_t(pos - bn) - 1;
+    }
+    // 不变: 只刷新文本
+    else {
+        this->RefreshSearchKey(index);
+        return index;
+    }
+    // 前缀索引跟随行移动
+    if (this->is_prefix_synced()) m_oPrefix.Move(index, new_index, this->get_search_key(new_index));
+    // 选择跟随行移动, 被选中的行不变, 不需要通知
+    const auto selected = m_oSelection.Contains(index);
+    m_oSelection.EraseAt(index);
+    m_oSelection.InsertAt(new_index, selected);
+    // 修改了
+    this->SetControlLayoutChanged();
+    this->InvalidateThis();
+    return new_index;
+}
+
 // [UNTESTED] 利用索引移除行模板中一个元素
 void LongUI::UIList::RemoveLineElementInEachLine(uint32_t index) noexcept {
     assert(index < m_vLineTemplate.size() && "out of range");
     if (index < m_vLineTemplate.size()) {
+        // 列已改变
+        m_ixSortColumn = uint32_t(-1);
+        m_bPrefixDirty = true;
         // 刷新
         this->InvalidateThis();
         // 交换列表
@@ -329,6 +671,9 @@ void LongUI::UIList::SwapLineElementsInEachLine(uint32_t index1, uint32_t index2
     assert(index1 != index2 && "bad arguments");
     if (!(index1 < m_vLineTemplate.size() && index2 < m_vLineTemplate.size())) return;
     if (index1 == index2) return;
+    // 列已改变
+    m_ixSortColumn = uint32_t(-1);
+    m_bPrefixDirty = true;
     // 刷新
     this->InvalidateThis();
     // 交换列表
@@ -347,6 +692,9 @@ void LongUI::UIList::InsertNewElementToEachLine(uint32_t index, CreateControlEve
     assert(func && "bad argument");
     // 有效
     if (index <= m_vLineTemplate.size() && func) {
+        // 列已改变
+        m_ixSortColumn = uint32_t(-1);
+        m_bPrefixDirty = true;
         // 刷新
         this->InvalidateThis();
         // 交换列表
@@ -417,6 +765,13 @@ bool LongUI::UIList::DoEvent(const LongUI::EventArgument& arg) noexcept {
             ctrl->DoEvent(arg);
         }
         return true;
+    case LongUI::Event::Event_Char:
+        // 键入查找
+        if (m_ixSearchColumn != uint32_t(-1)) {
+            this->type_ahead(arg.key.ch);
+            return true;
+        }
+        break;
     default:
         break;
     }
@@ -427,6 +782,8 @@ bool LongUI::UIList::DoEvent(const LongUI::EventArgument& arg) noexcept {
 bool LongUI::UIList::DoMouseEvent(const MouseEventArgument& arg) noexcept {
     // -------------------  L-Button Up  ---------------
     auto lbutton_up = [this, &arg]() noexcept {
+        // 键入查找需要焦点
+        if (this->flags & Flag_Focusable) m_pWindow->SetFocus(this);
         auto index = this->find_line_index(D2D1_POINT_2F{arg.ptx, arg.pty});
         // SHIFT优先
         if (UIInput.IsKbPressed(UIInput.KB_SHIFT)) {
@@ -565,9 +922,89 @@ void LongUI::UIList::sort_line(bool(*cmp)(UIControl* a, UIControl* b) ) noexcept
 }
 
 
+/// <summary>
+/// Sorts lines with keys extracted once: radix sort for user_data,
+/// parallel stable merge sort for user_ptr strings.
+/// </summary>
+/// <param name="string">if set to <c>true</c> [sort as string].</param>
+/// <returns>false if out of memory</returns>
+bool LongUI::UIList::sort_line_by_key(bool string) noexcept {
+    const auto count = uint32_t(m_vLines.size());
+    if (count <= 1) return true;
+#ifdef _DEBUG
+    auto timest = ::timeGetTime();
+#endif
+    // 键值 + 索引 + 临时缓存, 一次申请
+    const size_t key_size = string ? sizeof(StringSortKey) : sizeof(uint32_t);
+    auto buffer = reinterpret_cast<char*>(LongUI::NormalAlloc(
+        count * (key_size + sizeof(uint32_t) * 2)
+    ));
+    if (!buffer) return false;
+    // 选择索引在重排后失效
+    this->reset_select();
+    const auto index = reinterpret_cast<uint32_t*>(buffer + count * key_size);
+    const auto tmp = index + count;
+    const auto lines = &*m_vLines.begin();
+    // 提取键值并检查顺序
+    bool sorted = true;
+    if (string) {
+        const auto keys = reinterpret_cast<StringSortKey*>(buffer);
+        for (uint32_t i = 0; i < count; ++i) {
+            auto str = static_cast<const wchar_t*>(lines[i]->GetToBeSorted()->user_ptr);
+            assert(str && "bad action");
+            keys[i] = LongUI::MakeStringSortKey(str ? str : L"");
+            if (i && LongUI::CompareSortKey(keys[i], keys[i - 1]) < 0) sorted = false;
+            index[i] = i;
+        }
+        if (!sorted) impl::parallel_merge_sort(keys, index, tmp, count);
+    }
+    else {
+        const auto keys = reinterpret_cast<uint32_t*>(buffer);
+        for (uint32_t i = 0; i < count; ++i) {
+            keys[i] = lines[i]->GetToBeSorted()->user_data;
+            if (i && keys[i] < keys[i - 1]) sorted = false;
+            index[i] = i;
+        }
+        if (!sorted) LongUI::RadixSortIndex(keys, index, tmp, count);
+    }
+    // 已经有序: 直接逆序
+    if (sorted) {
+        std::reverse(lines, lines + count);
+    }
+    // 按置换环一次移动到位
+    else {
+        for (uint32_t i = 0; i < count; ++i) {
+            if (index[i] == i) continue;
+            auto save = lines[i];
+            auto j = i;
+            while (true) {
+                const auto k = index[j];
+                index[j] = j;
+                if (k == i) { lines[j] = save; break; }
+                lines[j] = lines[k];
+                j = k;
+            }
+        }
+    }
+    LongUI::NormalFree(buffer);
+#ifdef _DEBUG
+    timest = ::timeGetTime() - timest;
+    if (this->debug_this) {
+        UIManager << DL_Log
+            << "sort take time: "
+            << long(timest)
+            << " ms"
+            << LongUI::endl;
+    }
+#endif
+    // 修改了
+    this->SetControlLayoutChanged();
+    return true;
+}
+
 // 选择子控件(对外)
 void LongUI::UIList::SelectChild(uint32_t index, bool new_select) noexcept {
-    if (index < m_cChildrenCount) {
+    if (index < this->GetRowCount()) {
         this->select_child(index, new_select);
         this->InvalidateThis();
     }
@@ -578,7 +1015,7 @@ void LongUI::UIList::SelectTo(uint32_t index1, uint32_t index2) noexcept {
     // 交换
     if (index1 > index2) std::swap(index1, index2);
     // 限制
-    index2 = std::min(index2, m_cChildrenCount - 1);
+    index2 = std::min(index2, this->GetRowCount() - 1);
     // 有效
     if (index1 < index2) {
         this->select_to(index1, index2);
@@ -588,7 +1025,7 @@ void LongUI::UIList::SelectTo(uint32_t index1, uint32_t index2) noexcept {
 
 // 选择子控件
 LongUINoinline void LongUI::UIList::select_child(uint32_t index, bool new_select) noexcept {
-    assert(index < m_cChildrenCount && "out of range for selection");
+    assert(index < this->GetRowCount() && "out of range for selection");
     // 检查是否多选
     if (!new_select && !(this->list_flag & this->Flag_MultiSelect)) {
         UIManager << DL_Hint
@@ -596,53 +1033,63 @@ LongUINoinline void LongUI::UIList::select_child(uint32_t index, bool new_select
             << LongUI::endl;
         new_select = true;
     }
-    // 新的重置
+    // 新的选择: 静默清除, 只通知一次
     if (new_select) {
-        this->reset_select();
-    }
-    // 选择
-    auto line = m_vLines[index];
-    if (line->IsSelected()) {
-        line->SetSelected(false);
-        // 移除
-        auto itr = std::find(m_vSelectedIndex.cbegin(), m_vSelectedIndex.cend(), index);
-        if (itr == m_vSelectedIndex.cend()) {
-            assert(!"NOT FOUND");
-        }
-        else {
-            m_vSelectedIndex.erase(itr);
-        }
+        m_oSelection.Clear();
+        m_oSelection.Add(index, index + 1);
+        this->selection_changed(index, index + 1, Selection_Set);
     }
+    // 切换选择
     else {
-        line->SetSelected(true);
-        m_vSelectedIndex.push_back(index);
+        m_oSelection.Toggle(index, index + 1);
+        this->selection_changed(index, index + 1, Selection_Toggle);
     }
 }
 
 // 选择子控件到
 LongUINoinline void LongUI::UIList::select_to(uint32_t index1, uint32_t index2) noexcept {
-    assert(index1 < m_cChildrenCount && index2 < m_cChildrenCount && "out of range for selection");
+    assert(index1 < this->GetRowCount() && index2 < this->GetRowCount() && "out of range for selection");
     // 检查是否多选
     if (!(this->list_flag & this->Flag_MultiSelect)) {
         UIManager << DL_Hint
             << "cannot do multi-selection"
             << LongUI::endl;
-        index1 = index2;
+        m_oSelection.Clear();
+        m_oSelection.Add(index2, index2 + 1);
+        return this->selection_changed(index2, index2 + 1, Selection_Set);
     }
     // 交换
     if (index1 > index2) std::swap(index1, index2);
-    // 选择
-    auto itr_1st = m_vLines.data() + index1;
-    auto itr_lst = m_vLines.data() + index2;
-    auto i = index1;
-    for (auto itr = itr_1st; itr <= itr_lst; ++itr) {
-        auto line = *itr;
-        line->SetSelected(true);
-        m_vSelectedIndex.push_back(i);
-        ++i;
+    // 选择区间
+    m_oSelection.Add(index1, index2 + 1);
+    this->selection_changed(index1, index2 + 1, Selection_Add);
+}
+
+// 全选(对外)
+void LongUI::UIList::SelectAll() noexcept {
+    const auto rows = this->GetRowCount();
+    if (rows && (this->list_flag & this->Flag_MultiSelect)) {
+        m_oSelection.Clear();
+        m_oSelection.Add(0, rows);
+        this->selection_changed(0, rows, Selection_Set);
+        this->InvalidateThis();
     }
 }
 
+// 清除选择(对外)
+void LongUI::UIList::ClearSelection() noexcept {
+    if (!m_oSelection.IsEmpty()) {
+        this->reset_select();
+        this->InvalidateThis();
+    }
+}
+
+// 选择已修改
+void LongUI::UIList::selection_changed(uint32_t begin, uint32_t end, SelectionChangeType type) noexcept {
+    m_lastSelection = { begin, end, type };
+    this->CallUiEvent(m_callSelectionChanged, SubEvent::Event_ValueChanged);
+}
+
 /// <summary>
 /// Zeroes the width of all lines content.
 /// </summary>
@@ -656,10 +1103,10 @@ void LongUI::UIList::ZeroAllLinesContentWidth() noexcept {
 void LongUI::UIList::reset_select() noexcept {
     //m_pHoveredLine = nullptr;
     //m_ixLastClickedLine = uint32_t(-1);
-    for (auto i : m_vSelectedIndex) {
-        m_vLines[i]->SetSelected(false);
+    if (!m_oSelection.IsEmpty()) {
+        m_oSelection.Clear();
+        this->selection_changed(0, 0, Selection_Clear);
     }
-    m_vSelectedIndex.clear();
 }
 
 // UIList: 初始化布局
@@ -704,50 +1151,56 @@ void LongUI::UIList::set_element_count(uint32_t length) noexcept {
     }
 }
 
+// UIList: 复制可视行的背景
+void LongUI::UIList::snapshot_render(RenderState& state) noexcept {
+    Super::snapshot_render(state);
+    auto& rows = m_aRowBack[m_pWindow->GetFrontIndex() ^ 1];
+    rows.clear();
+    if (!this->GetRowCount()) return;
+    // 可视列表行
+    uint32_t first_visible, last_visible;
+    this->get_visible_rows(first_visible, last_visible);
+    // 背景索引
+    int bkindex1 = !(first_visible & 1);
+    // 循环
+    for (auto row = first_visible; row < last_visible; ++row) {
+        // 虚拟模式下行池可能还未绑定
+        auto line = this->GetLineOfRow(row);
+        if (!line) { bkindex1 = !bkindex1; continue; }
+        const D2D1_COLOR_F* color;
+        // 选择色优先
+        if (m_oSelection.Contains(row)) {
+            color = &m_colorLineSelected;
+        }
+        // 悬浮色其次
+        else if (line == m_pHoveredLine) {
+            color = &m_colorLineHover;
+        }
+        // 背景色最后
+        else {
+            color = &m_colorLineNormal1 + bkindex1;
+        }
+        // 添加
+        if (color->a > 0.f) {
+            rows.push_back(RowBackground{ line->visible_rect, *color });
+        }
+        bkindex1 = !bkindex1;
+    }
+}
+
 // UIList: 前景渲染
 void LongUI::UIList::render_chain_background() const noexcept {
     // 独立背景- - 可视优化
-    if (this->GetChildrenCount()) {
+    const auto& rows = m_aRowBack[m_pWindow->GetFrontIndex()];
+    if (rows.size()) {
         // 保留转变
         D2D1_MATRIX_3X2_F matrix;
         UIManager_RenderTarget->GetTransform(&matrix);
         UIManager_RenderTarget->SetTransform(DX::Matrix3x2F::Identity());
-        // 第一个可视列表行 = (-Y偏移) / 行高
-        int first_visible = static_cast<int>((-m_2fOffset.y) / m_fLineHeight);
-        first_visible = std::max(first_visible, int(0));
-        // 最后一个可视列表行 = 第一个可视列表行 + 1 + 可视区域高度 / 行高
-        int last_visible = static_cast<int>(this->view_size.height / m_fLineHeight);
-        last_visible = last_visible + first_visible + 1;
-        last_visible = std::min(last_visible, int(this->GetChildrenCount()));
-        // 背景索引
-        int bkindex1 = !(first_visible & 1);
         // 循环
-        const auto first_itr = m_vLines.data() + first_visible;
-        const auto last_itr = m_vLines.data() + last_visible;
-        for (auto itr = first_itr; itr < last_itr; ++itr) {
-            auto line = *itr;
-            // REMOVE THIS LINE?
-            const D2D1_COLOR_F* color;
-            // 选择色优先
-            if (line->IsSelected()) {
-                color = &m_colorLineSelected;
-            }
-            // 悬浮色其次
-            else if (line == m_pHoveredLine) {
-                color = &m_colorLineHover;
-            }
-            // 背景色最后
-            else {
-                color = &m_colorLineNormal1 + bkindex1;
-            }
-            // 设置
-            if (color->a > 0.f) {
-                m_pBrush_SetBeforeUse->SetColor(color);
-                UIManager_RenderTarget->FillRectangle(
-                    &line->visible_rect, m_pBrush_SetBeforeUse
-                    );
-            }
-            bkindex1 = !bkindex1;
+        for (const auto& bk : rows) {
+            m_pBrush_SetBeforeUse->SetColor(&bk.color);
+            UIManager_RenderTarget->FillRectangle(&bk.rect, m_pBrush_SetBeforeUse);
         }
         // 还原
         UIManager_RenderTarget->SetTransform(&matrix);
@@ -759,7 +1212,7 @@ void LongUI::UIList::render_chain_background() const noexcept {
 // UIList: 主景渲染
 void LongUI::UIList::render_chain_main() const noexcept {
     // 渲染帮助器
-    Super::RenderHelper(UIManager_RenderTarget, this->begin(), this->end());
+    Super::RenderHelper(UIManager_RenderTarget);
     // 父类主景
     Super::render_chain_main();
 }
@@ -776,6 +1229,14 @@ void LongUI::UIList::Render() const noexcept {
 
 // UIList: 刷新
 void LongUI::UIList::Update() noexcept {
+    // 虚拟模式: 滚动到新的行时重新绑定行池
+    if (m_pDataSource && this->IsNeedRefreshWorld()) {
+        uint32_t first, last;
+        this->get_visible_rows(first, last);
+        if (first != m_ixFirstBound || last > m_ixFirstBound + m_vLines.size()) {
+            this->SetControlLayoutChanged();
+        }
+    }
     // 帮助器
     Super::UpdateHelper<Super>(m_vLines.begin(), m_vLines.end());
 #ifdef _DEBUG
@@ -792,9 +1253,13 @@ void LongUI::UIList::Update() noexcept {
 
 // 更新子控件布局
 void LongUI::UIList::RefreshLayout() noexcept {
+    // 虚拟模式
+    if (m_pDataSource) return this->refresh_virtual_layout();
     if (m_vLines.empty()) return;
     // 第二次
-    float index = 0.f;
+    float top = 0.f;
+    uint32_t index = 0;
+    auto heights = m_oRowOffset.Prepare(uint32_t(m_vLines.size()));
     float widthtt = m_vLines.front()->GetContentWidthZoomed();
 #ifdef _DEBUG
     if (this->debug_this && widthtt > 0.f) {
@@ -806,20 +1271,462 @@ void LongUI::UIList::RefreshLayout() noexcept {
 #endif
     if (widthtt == 0.f) widthtt = this->GetViewWidthZoomed();
     for (auto ctrl : m_vLines) {
+        // 行高
+        const auto height = ctrl->GetRowHeight() > 0.f ? ctrl->GetRowHeight() : m_fLineHeight;
+        if (heights) heights[index] = height;
         // 设置控件高度
         ctrl->SetWidth(widthtt);
-        ctrl->SetHeight(m_fLineHeight);
+        ctrl->SetHeight(height);
         // 不管如何, 修改!
         ctrl->SetControlLayoutChanged();
         ctrl->SetLeft(0.f);
-        ctrl->SetTop(m_fLineHeight * index);
-        ctrl->visible_rect;
-        ctrl->world;
+        ctrl->SetTop(top);
+        top += height;
         ++index;
     }
+    // 重建行偏移索引
+    m_oRowOffset.Build();
     // 设置
     m_2fContentSize.width = widthtt;
-    m_2fContentSize.height = m_fLineHeight * this->GetChildrenCount();
+    m_2fContentSize.height = top;
+}
+
+/// <summary>
+/// Gets the visible rows in [first, last).
+/// </summary>
+/// <param name="first">The first.</param>
+/// <param name="last">The last.</param>
+/// <returns></returns>
+void LongUI::UIList::get_visible_rows(uint32_t& first, uint32_t& last) const noexcept {
+    const auto rows = this->GetRowCount();
+    const auto top = -this->GetOffsetYZoomed();
+    const auto bottom = top + this->GetViewHeightZoomed();
+    // 行偏移索引未同步: 按行高估算
+    if (m_oRowOffset.GetCount() != rows) {
+        first = static_cast<uint32_t>(std::max(static_cast<int>(top / m_fLineHeight), int(0)));
+        last = static_cast<uint32_t>(std::max(static_cast<int>(bottom / m_fLineHeight), int(0))) + 1;
+    }
+    // O(log n) 查找
+    else {
+        first = m_oRowOffset.Find(top);
+        last = m_oRowOffset.Find(bottom) + 1;
+    }
+    first = std::min(first, rows);
+    last = std::min(last, rows);
+}
+
+/// <summary>
+/// Sets the height of row, O(log n) for offset index.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <param name="height">The height, &lt;= 0 for line height.</param>
+/// <returns></returns>
+void LongUI::UIList::SetRowHeight(uint32_t row, float height) noexcept {
+    assert(row < this->GetRowCount() && "out of range");
+    if (row >= this->GetRowCount()) return;
+    // 普通模式: 行高保存在列表行中
+    if (!m_pDataSource) {
+        m_vLines[row]->SetRowHeight(height);
+        // 索引同步且没有等待中的布局: 只移动之后的行
+        if (m_oRowOffset.GetCount() == m_vLines.size() && !this->IsControlLayoutChanged()) {
+            return this->relayout_row(row, height > 0.f ? height : m_fLineHeight);
+        }
+    }
+    // 更新索引
+    if (row < m_oRowOffset.GetCount()) {
+        m_oRowOffset.Set(row, height > 0.f ? height : m_fLineHeight);
+    }
+    this->SetControlLayoutChanged();
+    this->InvalidateThis();
+}
+
+/// <summary>
+/// Relayouts one row and shifts rows after it, normal mode only.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <param name="height">The real height.</param>
+/// <returns></returns>
+void LongUI::UIList::relayout_row(uint32_t row, float height) noexcept {
+    assert(!m_pDataSource && "normal mode only");
+    const auto delta = height - m_oRowOffset.Get(row);
+    if (delta == 0.f) return;
+    m_oRowOffset.Set(row, height);
+    // 本行重新布局
+    const auto line = m_vLines[row];
+    line->SetHeight(height);
+    line->SetControlLayoutChanged();
+    // 之后的行整体移动
+    for (auto i = row + 1; i < m_vLines.size(); ++i) {
+        const auto ctrl = m_vLines[i];
+        ctrl->SetTop(ctrl->GetTop() + delta);
+    }
+    // 内容高度改变, 刷新滚动条
+    m_2fContentSize.height = m_oRowOffset.GetTotal();
+    if (this->MCBegin() != this->MCEnd()) this->refresh_marginal_controls();
+    // 刷新子控件世界矩阵
+    this->SetControlWorldChanged();
+    this->InvalidateThis();
+}
+
+/// <summary>
+/// Gets the height of row.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <returns></returns>
+auto LongUI::UIList::GetRowHeight(uint32_t row) const noexcept -> float {
+    if (row < m_oRowOffset.GetCount()) return m_oRowOffset.Get(row);
+    // 索引未同步
+    auto line = m_pDataSource ? nullptr : this->GetLineOfRow(row);
+    return line && line->GetRowHeight() > 0.f ? line->GetRowHeight() : m_fLineHeight;
+}
+
+/// <summary>
+/// Sets the data source, switch to virtual mode if not null
+/// </summary>
+/// <param name="source">The data source.</param>
+/// <returns></returns>
+void LongUI::UIList::SetDataSource(IUIListDataSource* source) noexcept {
+    if (source == m_pDataSource) return;
+    // 清理旧的行
+    this->reset_select();
+    this->ClearList();
+    // 替换数据源
+    if (source) source->AddRef();
+    LongUI::SafeRelease(m_pDataSource);
+    m_pDataSource = source;
+    m_pHoveredLine = nullptr;
+    m_ixLastClickedLine = uint32_t(-1);
+    // 重新绑定
+    m_cVirtualRow = source ? source->GetRowCount() : 0;
+    m_ixFirstBound = uint32_t(-1);
+    m_bPrefixDirty = true;
+    m_oRowOffset.Reset(m_cVirtualRow, m_fLineHeight);
+    this->SetControlLayoutChanged();
+    this->InvalidateThis();
+}
+
+/// <summary>
+/// Notifies the data changed, row count and cells will be re-fetched.
+/// </summary>
+/// <returns></returns>
+void LongUI::UIList::NotifyDataChanged() noexcept {
+    if (!m_pDataSource) return;
+    this->reset_select();
+    m_cVirtualRow = m_pDataSource->GetRowCount();
+    m_ixFirstBound = uint32_t(-1);
+    m_bPrefixDirty = true;
+    // 行高重置
+    m_oRowOffset.Reset(m_cVirtualRow, m_fLineHeight);
+    this->SetControlLayoutChanged();
+    this->InvalidateThis();
+}
+
+/// <summary>
+/// Binds the row to line in virtual mode.
+/// </summary>
+/// <param name="line">The line.</param>
+/// <param name="row">The row.</param>
+/// <returns></returns>
+void LongUI::UIList::bind_line(UIListLine* line, uint32_t row) noexcept {
+    assert(m_pDataSource && row < m_cVirtualRow && "bad action");
+    uint32_t col = 0;
+    for (auto ctrl : (*line)) {
+        ctrl->SetText(m_pDataSource->GetCellText(row, col));
+        ++col;
+    }
+    line->user_data = row;
+}
+
+/// <summary>
+/// Refreshes the layout in virtual mode: only lines in visible range exist,
+/// the line-pool will be rebound when scrolled.
+/// </summary>
+/// <returns></returns>
+void LongUI::UIList::refresh_virtual_layout() noexcept {
+    assert(m_pDataSource && "virtual mode only");
+    // 可视行
+    uint32_t first, last;
+    this->get_visible_rows(first, last);
+    // 行池大小 = 可视行数 + 1
+    const auto pool = std::min(last - first + 1, m_cVirtualRow);
+    // 行池不够就扩充
+    while (m_vLines.size() < pool) {
+        auto line = this->create_template_line();
+        if (!line) {
+            UIManager << DL_Error << L"OOM for line-pool" << LongUI::endl;
+            break;
+        }
+        this->align_line(line);
+        m_vLines.push_back(line);
+        this->after_insert(line);
+        ++m_cChildrenCount;
+        line->Release();
+        if (!m_vLines.isok()) break;
+    }
+    // 第一个绑定行, 超出部分隐藏
+    m_ixFirstBound = first;
+    m_pHoveredLine = nullptr;
+    // 宽度
+    float widthtt = m_vLines.empty() ? 0.f : m_vLines.front()->GetContentWidthZoomed();
+    if (widthtt == 0.f) widthtt = this->GetViewWidthZoomed();
+    // 重新绑定
+    auto row = first;
+    auto top = m_oRowOffset.PrefixSum(first);
+    for (auto line : m_vLines) {
+        const bool valid = row < m_cVirtualRow;
+        line->SetVisible(valid);
+        if (valid) {
+            const auto height = this->GetRowHeight(row);
+            this->bind_line(line, row);
+            line->SetWidth(widthtt);
+            line->SetHeight(height);
+            line->SetControlLayoutChanged();
+            line->SetLeft(0.f);
+            line->SetTop(top);
+            top += height;
+        }
+        ++row;
+    }
+    // 设置
+    m_2fContentSize.width = widthtt;
+    m_2fContentSize.height = m_oRowOffset.GetTotal();
+}
+
+/// <summary>
+/// Sets the column for type-ahead search and prefix index.
+/// </summary>
+/// <param name="col">The column, uint32_t(-1) to disable.</param>
+/// <returns></returns>
+void LongUI::UIList::SetSearchColumn(uint32_t col) noexcept {
+    m_ixSearchColumn = col;
+    m_cTypeAhead = 0;
+    m_oPrefix.Clear();
+    m_bPrefixDirty = true;
+    // 键入查找需要键盘焦点
+    if (col != uint32_t(-1)) {
+        force_cast(this->flags) |= Flag_Focusable | Flag_NoDefaultFocusedRendering;
+    }
+}
+
+/// <summary>
+/// Gets the text of cell, user_ptr first like sorting.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <param name="col">The column.</param>
+/// <returns>text, never null</returns>
+auto LongUI::UIList::get_cell_text(uint32_t row, uint32_t col) noexcept -> const wchar_t* {
+    assert(row < this->GetRowCount() && "out of range");
+    const wchar_t* text = nullptr;
+    // 虚拟模式
+    if (m_pDataSource) {
+        text = m_pDataSource->GetCellText(row, col);
+    }
+    // 普通模式: 与排序相同的键值
+    else if (col < m_vLines[row]->GetChildrenCount()) {
+        auto ctrl = m_vLines[row]->GetAt(col);
+        text = ctrl->user_ptr ? static_cast<const wchar_t*>(ctrl->user_ptr) : ctrl->GetText();
+    }
+    return text ? text : L"";
+}
+
+/// <summary>
+/// Gets the case-folded prefix key of row in search column.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <returns></returns>
+auto LongUI::UIList::get_search_key(uint32_t row) noexcept -> uint64_t {
+    assert(m_ixSearchColumn != uint32_t(-1) && "no search column");
+    return LongUI::MakeFoldedPrefixKey(this->get_cell_text(row, m_ixSearchColumn));
+}
+
+/// <summary>
+/// Builds the prefix index if whole list changed, O(n log n), rows
+/// inserted, removed or moved later are applied incrementally.
+/// </summary>
+/// <returns>false if no search column or OOM</returns>
+bool LongUI::UIList::sync_prefix_index() noexcept {
+    if (m_ixSearchColumn == uint32_t(-1)) return false;
+    const auto rows = this->GetRowCount();
+    if (!m_bPrefixDirty) {
+        assert(m_oPrefix.GetCount() == rows && "prefix index out of sync");
+        return true;
+    }
+    auto keys = m_oPrefix.Prepare(rows);
+    if (rows && !keys) {
+        UIManager << DL_Error << L"OOM for prefix index" << LongUI::endl;
+        return false;
+    }
+    for (uint32_t row = 0; row < rows; ++row) keys[row] = this->get_search_key(row);
+    if (!m_oPrefix.Build()) {
+        UIManager << DL_Error << L"OOM for prefix index" << LongUI::endl;
+        return false;
+    }
+    m_bPrefixDirty = false;
+    return true;
+}
+
+/// <summary>
+/// Refreshes the key of row in prefix index.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <returns></returns>
+void LongUI::UIList::RefreshSearchKey(uint32_t row) noexcept {
+    if (!this->is_prefix_synced()) return;
+    if (row < m_oPrefix.GetCount()) {
+        m_oPrefix.Update(row, this->get_search_key(row));
+    }
+}
+
+/// <summary>
+/// Matches the prefix of row, case-insensitive.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <param name="prefix">The prefix.</param>
+/// <returns></returns>
+bool LongUI::UIList::match_prefix(uint32_t row, const wchar_t* prefix) noexcept {
+    auto text = this->get_cell_text(row, m_ixSearchColumn);
+    // 与前缀索引相同的折叠方式, 分段比较
+    enum : uint32_t { SEGMENT = 32 };
+    wchar_t a[SEGMENT], b[SEGMENT];
+    while (*prefix) {
+        uint32_t len = 0;
+        for (; len < SEGMENT && prefix[len]; ++len) {
+            if (!text[len]) return false;
+            a[len] = prefix[len]; b[len] = text[len];
+        }
+        LongUI::FoldCase(a, len);
+        LongUI::FoldCase(b, len);
+        if (std::wmemcmp(a, b, len)) return false;
+        prefix += len; text += len;
+    }
+    return true;
+}
+
+/// <summary>
+/// Finds the first row starting with prefix from row 'from' with wrapping.
+/// </summary>
+/// <param name="prefix">The prefix.</param>
+/// <param name="from">The row to start.</param>
+/// <returns>row count if not found</returns>
+auto LongUI::UIList::FindPrefix(const wchar_t* prefix, uint32_t from) noexcept -> uint32_t {
+    assert(prefix && "bad argument");
+    const auto rows = this->GetRowCount();
+    if (!prefix || !this->sync_prefix_index()) return rows;
+    // 前4个字符由索引保证
+    const bool longer = std::wcslen(prefix) > 4;
+    uint32_t first, last;
+    m_oPrefix.EqualRange(prefix, first, last);
+    // 在匹配项中找 from 之后最近的行
+    uint32_t after = rows, before = rows;
+    for (auto i = first; i < last; ++i) {
+        const auto row = m_oPrefix[i].row;
+        if (longer && !this->match_prefix(row, prefix)) continue;
+        if (row >= from) after = std::min(after, row);
+        else before = std::min(before, row);
+    }
+    return after < rows ? after : before;
+}
+
+/// <summary>
+/// Filters the rows starting with prefix.
+/// </summary>
+/// <param name="prefix">The prefix.</param>
+/// <param name="rows">The matched rows.</param>
+/// <returns>count of matched rows</returns>
+auto LongUI::UIList::FilterPrefix(const wchar_t* prefix, CUIIntervalSet& rows) noexcept -> uint32_t {
+    assert(prefix && "bad argument");
+    rows.Clear();
+    if (!prefix || !this->sync_prefix_index()) return 0;
+    const bool longer = std::wcslen(prefix) > 4;
+    uint32_t first, last;
+    m_oPrefix.EqualRange(prefix, first, last);
+    // 收集后按行号排序
+    EzContainer::EzVector<uint32_t> matched;
+    matched.reserve(last - first);
+    for (auto i = first; i < last; ++i) {
+        const auto row = m_oPrefix[i].row;
+        if (longer && !this->match_prefix(row, prefix)) continue;
+        matched.push_back(row);
+    }
+    if (!matched.isok()) {
+        UIManager << DL_Error << L"OOM for filter" << LongUI::endl;
+        return 0;
+    }
+    std::sort(matched.begin(), matched.end());
+    // 连续行合并为区间
+    for (uint32_t i = 0; i < matched.size(); ) {
+        auto j = i + 1;
+        while (j < matched.size() && matched[j] == matched[j - 1] + 1) ++j;
+        rows.Add(matched[i], matched[j - 1] + 1);
+        i = j;
+    }
+    return matched.size();
+}
+
+/// <summary>
+/// Type-ahead with char: chars typed within timeout form the prefix,
+/// repeating the same char cycles through rows starting with it.
+/// </summary>
+/// <param name="ch">The char.</param>
+/// <returns></returns>
+void LongUI::UIList::type_ahead(char32_t ch) noexcept {
+    // 控制字符
+    if (ch < 0x20) return;
+    // 超时重新开始
+    const auto now = uint32_t(::timeGetTime());
+    if (now - m_dwTypeAheadTime > TYPE_AHEAD_TIMEOUT) m_cTypeAhead = 0;
+    m_dwTypeAheadTime = now;
+    // 添加至缓存
+    if (m_cTypeAhead + 3 > TYPE_AHEAD_LENGTH) return;
+    if (ch > 0xFFFF) {
+        ch -= 0x10000;
+        m_szTypeAhead[m_cTypeAhead++] = wchar_t(0xD800 | (ch >> 10));
+        m_szTypeAhead[m_cTypeAhead++] = wchar_t(0xDC00 | (ch & 0x3FF));
+    }
+    else m_szTypeAhead[m_cTypeAhead++] = wchar_t(ch);
+    m_szTypeAhead[m_cTypeAhead] = 0;
+    const auto rows = this->GetRowCount();
+    if (!rows) return;
+    // 相同字符重复: 用单个字符从下一行开始
+    bool repeat = true;
+    for (uint32_t i = 1; i < m_cTypeAhead; ++i) {
+        if (m_szTypeAhead[i] != m_szTypeAhead[0]) { repeat = false; break; }
+    }
+    const wchar_t single[] = { m_szTypeAhead[0], 0 };
+    const auto prefix = repeat && ch <= 0xFFFF ? single : m_szTypeAhead;
+    auto from = m_ixLastClickedLine < rows ? m_ixLastClickedLine : 0;
+    if (prefix == single) ++from;
+    const auto row = this->FindPrefix(prefix, from);
+    if (row < rows) {
+        m_ixLastClickedLine = row;
+        this->SelectChild(row, true);
+        this->ensure_row_visible(row);
+    }
+}
+
+/// <summary>
+/// Scrolls to make the row visible.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <returns></returns>
+void LongUI::UIList::ensure_row_visible(uint32_t row) noexcept {
+    if (row >= this->GetRowCount()) return;
+    // 行偏移索引未同步: 按行高估算
+    const bool synced = m_oRowOffset.GetCount() == this->GetRowCount();
+    const auto top = synced ? this->GetRowTop(row) : float(row) * m_fLineHeight;
+    const auto height = this->GetRowHeight(row);
+    const auto view_top = -this->GetOffsetYZoomed();
+    const auto view_height = this->GetViewHeightZoomed();
+    // 上方
+    if (top < view_top) {
+        this->SetOffsetYZoomed(-top);
+    }
+    // 下方
+    else if (top + height > view_top + view_height) {
+        this->SetOffsetYZoomed(view_height - top - height);
+    }
+    else return;
+    this->InvalidateThis();
 }
 
 // 清理UI列表控件
@@ -5,6 +5,7 @@
 #include <Component/EditableText.h>
 #include <Component/Text.h>
 #include <Platless/luiPlUtil.h>
+#include <Platless/luiPlSort.h>
 #include <Core/luiMenu.h>
 #undef LONGUI_WITH_MMFVIDEO
 #ifdef LONGUI_WITH_MMFVIDEO
@@ -190,8 +191,11 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     /// <param name="h">The h.</param>
     /// <returns></returns>
     void ShortText::Resize(float w, float h) noexcept {
+        if (m_config.width == w && m_config.height == h) return;
         m_config.width = w; m_config.height = h;
         if (!m_pLayout) return;
+        // 布局可能被渲染中的帧快照引用
+        CUIDxgiAutoLocker locker;
         m_pLayout->SetMaxWidth(w); m_pLayout->SetMaxHeight(h);
     }
     /// <summary>
@@ -221,20 +225,32 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     /// <param name="pt">The pt.</param>
     /// <returns></returns>
     void ShortText::Render(ID2D1DeviceContext* target, D2D1_POINT_2F pt) const noexcept {
+        this->Render(target, pt, m_pLayout, *m_pColor);
+    }
+    /// <summary>
+    /// Renders the specified layout, snapshotted for render thread.
+    /// </summary>
+    /// <param name="target">The target.</param>
+    /// <param name="pt">The pt.</param>
+    /// <param name="layout">The layout.</param>
+    /// <param name="color">The color.</param>
+    /// <returns></returns>
+    void ShortText::Render(ID2D1DeviceContext* target, D2D1_POINT_2F pt,
+        IDWriteTextLayout* layout, const D2D1_COLOR_F& color) const noexcept {
         assert(target && "bad argument");
-        if (!m_pLayout) return;
+        if (!layout) return;
         m_pTextRenderer->target = target;
-        m_pTextRenderer->basic_color.color = *m_pColor;
+        m_pTextRenderer->basic_color.color = color;
         //m_pLayout->SetReadingDirection(DWRITE_READING_DIRECTION_TOP_TO_BOTTOM);
         //m_pLayout->SetFlowDirection(DWRITE_FLOW_DIRECTION_RIGHT_TO_LEFT);
 #if 0
         ID2D1SolidColorBrush* brush = nullptr;
         target->CreateSolidColorBrush(D2D1::ColorF(D2D1::ColorF::Black), &brush);
-        target->DrawTextLayout(pt, m_pLayout, brush);
+        target->DrawTextLayout(pt, layout, brush);
         brush->Release();
 #else
         IDWriteTextRenderer1* pTextRenderer = m_pTextRenderer;
-        auto hr = m_pLayout->Draw(
+        auto hr = layout->Draw(
             m_pTextContext,
             pTextRenderer,
             this->offset.x + pt.x,
@@ -245,7 +261,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     }
     // ShortText 重建布局
     void ShortText::RecreateLayout() noexcept {
-        CUIDxgiAutoLocker locker;
+        // 渲染线程只使用帧快照引用的布局, 无需渲染锁
         // 保留数据
         auto old_layout = m_pLayout;
         m_pLayout = nullptr;
@@ -291,6 +307,681 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                 << LongUI::endl;
         }
     }
+    // ------------------ LongUI::Component::ParagraphLayout ------------------
+    /// <summary>
+    /// Releases all chunks and the text format.
+    /// </summary>
+    /// <returns></returns>
+    void ParagraphLayout::Release() noexcept {
+        for (auto& chunk : m_vChunks) LongUI::SafeRelease(chunk.layout);
+        m_vChunks.clear();
+        m_ixPending = NIL;
+        LongUI::SafeRelease(m_pFormat);
+    }
+    /// <summary>
+    /// Sets the text format.
+    /// </summary>
+    /// <param name="fmt">The format.</param>
+    /// <returns></returns>
+    void ParagraphLayout::SetFormat(IDWriteTextFormat* fmt) noexcept {
+        assert(fmt && "bad argument");
+        LongUI::SafeRelease(m_pFormat);
+        m_pFormat = LongUI::SafeAcquire(fmt);
+    }
+    /// <summary>
+    /// Finds the chunk containing the text position.
+    /// </summary>
+    /// <param name="pos">The position.</param>
+    /// <returns>index of last chunk whose position &lt;= pos</returns>
+    auto ParagraphLayout::FindChunk(uint32_t pos) const noexcept -> uint32_t {
+        uint32_t lo = 0, hi = m_vChunks.size();
+        while (lo < hi) {
+            const auto mid = (lo + hi) / 2;
+            if (m_vChunks[mid].position > pos) hi = mid;
+            else lo = mid + 1;
+        }
+        return lo ? lo - 1 : 0;
+    }
+    /// <summary>
+    /// Finds the chunk at y in block.
+    /// </summary>
+    /// <param name="y">The y.</param>
+    /// <returns>index of last chunk whose top &lt;= y</returns>
+    auto ParagraphLayout::FindChunkAt(float y) const noexcept -> uint32_t {
+        uint32_t lo = 0, hi = m_vChunks.size();
+        while (lo < hi) {
+            const auto mid = (lo + hi) / 2;
+            if (m_vChunks[mid].top > y) hi = mid;
+            else lo = mid + 1;
+        }
+        return lo ? lo - 1 : 0;
+    }
+    /// <summary>
+    /// Gets the visual line containing the text position, 
+    /// only line metrics of the paragraph are fetched.
+    /// </summary>
+    /// <param name="pos">The position.</param>
+    /// <param name="metrics">The line metrics.</param>
+    /// <returns>text position of line start</returns>
+    auto ParagraphLayout::GetLineAt(uint32_t pos, DWRITE_LINE_METRICS& metrics) const noexcept -> uint32_t {
+        std::memset(&metrics, 0, sizeof(metrics));
+        if (m_vChunks.empty()) return 0;
+        const auto& chunk = m_vChunks[this->FindChunk(pos)];
+        // 延迟的块: 视为一行
+        if (!chunk.layout) {
+            metrics.length = chunk.length;
+            return chunk.position;
+        }
+        // 包括被排除的空行
+        EzContainer::SmallBuffer<DWRITE_LINE_METRICS, 32> lines;
+        lines.NewSize(chunk.lines + 1);
+        uint32_t count = 0;
+        chunk.layout->GetLineMetrics(lines.GetData(), lines.GetCount(), &count);
+        count = std::min(count, chunk.lines);
+        // 块内查找
+        auto start = chunk.position;
+        for (uint32_t i = 0; i < count; ++i) {
+            metrics = lines[i];
+            if (start + metrics.length > pos || i + 1 == count) break;
+            start += metrics.length;
+        }
+        return start;
+    }
+    /// <summary>
+    /// Gets the start of word before the text position, only clusters
+    /// of the paragraph(and the previous one at boundary) are fetched.
+    /// </summary>
+    /// <param name="pos">The position.</param>
+    /// <returns>text position of word start</returns>
+    auto ParagraphLayout::GetWordLeft(uint32_t pos) const noexcept -> uint32_t {
+        if (m_vChunks.empty()) return 0;
+        EzContainer::SmallBuffer<DWRITE_CLUSTER_METRICS, 64> clusters;
+        for (auto index = this->FindChunk(pos); ; --index) {
+            const auto& chunk = m_vChunks[index];
+            // 在块起始处: 查找上一块
+            if (chunk.position >= pos) {
+                if (!index) return 0;
+                continue;
+            }
+            const auto count = this->chunk_clusters(chunk, nullptr, 0);
+            clusters.NewSize(count);
+            this->chunk_clusters(chunk, clusters.GetData(), count);
+            // 块起始处在换行符之后, 也是单词边界
+            auto found = chunk.position, position = chunk.position;
+            for (uint32_t i = 0; i < count; ++i) {
+                position += clusters[i].length;
+                if (clusters[i].canWrapLineAfter) {
+                    if (position >= pos) break;
+                    found = position;
+                }
+            }
+            return found;
+        }
+    }
+    /// <summary>
+    /// Gets the last cluster of word at or after the text position, only
+    /// clusters of the paragraph(and the next one at boundary) are fetched.
+    /// </summary>
+    /// <param name="pos">The position.</param>
+    /// <param name="length">The length of cluster.</param>
+    /// <returns>text position of cluster</returns>
+    auto ParagraphLayout::GetWordRight(uint32_t pos, uint32_t& length) const noexcept -> uint32_t {
+        length = 0;
+        EzContainer::SmallBuffer<DWRITE_CLUSTER_METRICS, 64> clusters;
+        auto last = pos;
+        for (auto index = this->FindChunk(pos); index < m_vChunks.size(); ++index) {
+            const auto& chunk = m_vChunks[index];
+            const auto count = this->chunk_clusters(chunk, nullptr, 0);
+            clusters.NewSize(count);
+            this->chunk_clusters(chunk, clusters.GetData(), count);
+            auto position = chunk.position;
+            for (uint32_t i = 0; i < count; ++i) {
+                length = clusters[i].length;
+                last = position;
+                if (position >= pos && clusters[i].canWrapLineAfter) return position;
+                position += length;
+            }
+        }
+        // 没有单词边界: 最后一个簇
+        return last;
+    }
+    /// <summary>
+    /// Builds all chunks from text.
+    /// </summary>
+    /// <param name="text">The text.</param>
+    /// <returns></returns>
+    auto ParagraphLayout::Build(const CUIPieceTable& text) noexcept -> HRESULT {
+        assert(m_pFormat && "set format first");
+        for (auto& chunk : m_vChunks) LongUI::SafeRelease(chunk.layout);
+        m_vChunks.clear();
+        m_ixPending = NIL;
+        auto hr = this->create_chunks(text, 0, text.GetLength(), m_vChunks);
+        this->refresh_metrics(0);
+        return hr;
+    }
+    /// <summary>
+    /// Updates chunks after [pos, pos + removed) was replaced 
+    /// with inserted chars, only paragraphs touched are re-laid out.
+    /// If deferred, the paragraphs are merged into one deferred 
+    /// chunk, which will be laid out in <see cref="Continue"/>.
+    /// </summary>
+    /// <param name="text">The new text.</param>
+    /// <param name="pos">The position.</param>
+    /// <param name="removed">The removed length.</param>
+    /// <param name="inserted">The inserted length.</param>
+    /// <param name="defer">if set to <c>true</c> [defer].</param>
+    /// <returns></returns>
+    auto ParagraphLayout::update(const CUIPieceTable& text, 
+        uint32_t pos, uint32_t removed, uint32_t inserted, bool defer) noexcept -> HRESULT {
+        // 富文本或者没有块: 整体重建
+        if (m_bSingle || m_vChunks.empty()) return this->Build(text);
+        const auto count = m_vChunks.size();
+        const auto length = text.GetLength();
+        // 受影响的块(旧位置)
+        auto first = this->FindChunk(pos);
+        auto last = this->FindChunk(pos + removed);
+        // 前一段以CR结尾: 可能与插入的LF合并
+        if (first && pos == m_vChunks[first].position && text[pos - 1] == L'\r') --first;
+        auto begin = m_vChunks[first].position;
+        auto end = m_vChunks[last].position + m_vChunks[last].length + inserted - removed;
+        // 以CR结尾: 可能与下一段的LF合并
+        while (last + 1 < count && end < length && text[end - 1] == L'\r' && text[end] == L'\n') {
+            end += m_vChunks[++last].length;
+        }
+        // 到达末尾: 包括末尾空块
+        if (end == length) last = count - 1;
+        // 已有延迟的块: 保证最多只有一个
+        if (m_ixPending != NIL) {
+            // 修改了延迟的块: 一起延迟
+            if (m_ixPending >= first && m_ixPending <= last) defer = true;
+            // 再次延迟: 合并中间的块
+            else if (defer && m_ixPending < first) {
+                begin = m_vChunks[first = m_ixPending].position;
+            }
+            else if (defer) {
+                last = m_ixPending;
+                end = m_vChunks[last].position + m_vChunks[last].length + inserted - removed;
+            }
+        }
+        // 空段落无需延迟
+        if (begin == end) defer = false;
+        // 创建新的块
+        ChunkVector chunks;
+        HRESULT hr = S_OK;
+        if (defer) {
+            chunks.push_back(Chunk{ nullptr, begin, end - begin, 0, 0.f, 0.f, 0.f, 0.f });
+            if (!chunks.isok()) hr = E_OUTOFMEMORY;
+        }
+        else hr = this->create_chunks(text, begin, end, chunks);
+        if (FAILED(hr)) {
+            for (auto& chunk : chunks) LongUI::SafeRelease(chunk.layout);
+            return this->Build(text);
+        }
+        // 替换旧的块
+        for (auto i = first; i <= last; ++i) LongUI::SafeRelease(m_vChunks[i].layout);
+        if (!this->splice_chunks(first, last - first + 1, chunks)) return this->Build(text);
+        // 延迟的块的索引
+        if (defer) m_ixPending = first;
+        else if (m_ixPending != NIL && m_ixPending > last) m_ixPending += chunks.size() - (last - first + 1);
+        else if (m_ixPending != NIL && m_ixPending >= first) m_ixPending = NIL;
+        // 后续的块仅仅移动位置
+        for (auto index = first + chunks.size(); index < m_vChunks.size(); ++index) {
+            m_vChunks[index].position += inserted - removed;
+        }
+        this->refresh_metrics(first);
+        return hr;
+    }
+    /// <summary>
+    /// Lays out deferred paragraphs, at least budget chars 
+    /// if any, extended to the end of paragraph.
+    /// </summary>
+    /// <param name="text">The text.</param>
+    /// <param name="budget">The budget in chars.</param>
+    /// <returns>S_FALSE if nothing deferred</returns>
+    auto ParagraphLayout::Continue(const CUIPieceTable& text, uint32_t budget) noexcept -> HRESULT {
+        if (m_ixPending == NIL) return S_FALSE;
+        const auto index = m_ixPending;
+        const auto begin = m_vChunks[index].position;
+        const auto stop = begin + m_vChunks[index].length;
+        auto end = begin + std::min(std::max(budget, 1u), stop - begin);
+        // 扩展到段落结束: CR, LF, CRLF, NEL, LS, PS
+        while (end < stop) {
+            const auto ch = text[end - 1];
+            if (ch == L'\n' || ch == 0x85 || ch == 0x2028 || ch == 0x2029) break;
+            if (ch == L'\r' && text[end] != L'\n') break;
+            ++end;
+        }
+        // 创建新的块
+        ChunkVector chunks;
+        auto hr = this->create_chunks(text, begin, end, chunks);
+        if (FAILED(hr)) {
+            for (auto& chunk : chunks) LongUI::SafeRelease(chunk.layout);
+            return this->Build(text);
+        }
+        // 剩余部分继续延迟
+        const auto rest = stop - end;
+        // 之后已有末尾空块
+        if (!rest && index + 1 < m_vChunks.size() && !chunks.empty() && !chunks.back().length) {
+            LongUI::SafeRelease(chunks.back().layout);
+            chunks.pop_back();
+        }
+        if (rest) chunks.push_back(Chunk{ nullptr, end, rest, 0, 0.f, 0.f, 0.f, 0.f });
+        if (!chunks.isok() || !this->splice_chunks(index, 1, chunks)) return this->Build(text);
+        m_ixPending = rest ? index + chunks.size() - 1 : NIL;
+        this->refresh_metrics(index);
+        return hr;
+    }
+    /// <summary>
+    /// Replaces count chunks from index with new chunks in one pass.
+    /// </summary>
+    /// <param name="index">The index.</param>
+    /// <param name="count">The count of old chunks.</param>
+    /// <param name="chunks">The new chunks.</param>
+    /// <returns>false if OOM</returns>
+    bool ParagraphLayout::splice_chunks(uint32_t index, uint32_t count, const ChunkVector& chunks) noexcept {
+        const auto old = m_vChunks.size();
+        const auto size = old - count + chunks.size();
+        if (size > old) {
+            m_vChunks.resize(size);
+            if (!m_vChunks.isok()) return false;
+        }
+        const auto data = m_vChunks.data();
+        std::memmove(data + index + chunks.size(), data + index + count, (old - index - count) * sizeof(Chunk));
+        if (!chunks.empty()) std::memcpy(data + index, chunks.data(), chunks.size() * sizeof(Chunk));
+        if (size < old) m_vChunks.resize(size);
+        return true;
+    }
+    /// <summary>
+    /// Creates layouts for paragraphs in text range [begin, end).
+    /// </summary>
+    /// <param name="text">The text.</param>
+    /// <param name="begin">The begin.</param>
+    /// <param name="end">The end.</param>
+    /// <param name="chunks">The chunks.</param>
+    /// <returns></returns>
+    auto ParagraphLayout::create_chunks(const CUIPieceTable& text, 
+        uint32_t begin, uint32_t end, ChunkVector& chunks) noexcept -> HRESULT {
+        HRESULT hr = E_OUTOFMEMORY;
+        const auto len = end - begin;
+        const bool at_end = end == text.GetLength();
+        LongUI::SafeBuffer<wchar_t>(len + 1, [&](wchar_t* const buf) noexcept {
+            hr = S_OK;
+            text.Copy(begin, len, buf);
+            uint32_t start = 0;
+            // 单块模式不分段
+            for (uint32_t i = 0; i < len && !m_bSingle && SUCCEEDED(hr); ++i) {
+                const auto ch = buf[i];
+                // 段落分隔: CR, LF, CRLF, NEL, LS, PS
+                const bool sep = ch == L'\n' || ch == 0x85 || ch == 0x2028 || ch == 0x2029 
+                    || (ch == L'\r' && !(i + 1 < len && buf[i + 1] == L'\n'));
+                if (sep) {
+                    hr = this->create_chunk(buf + start, begin + start, i + 1 - start, chunks);
+                    start = i + 1;
+                }
+            }
+            // 剩余部分, 文档末尾总是保留(可能为空的)块
+            if (SUCCEEDED(hr) && (start < len || at_end)) {
+                hr = this->create_chunk(buf + start, begin + start, len - start, chunks);
+            }
+        });
+        return hr;
+    }
+    /// <summary>
+    /// Creates layout for a paragraph.
+    /// </summary>
+    /// <param name="str">The string, will be overwritten if password.</param>
+    /// <param name="position">The position.</param>
+    /// <param name="length">The length.</param>
+    /// <param name="chunks">The chunks.</param>
+    /// <returns></returns>
+    auto ParagraphLayout::create_chunk(wchar_t* str, 
+        uint32_t position, uint32_t length, ChunkVector& chunks) noexcept -> HRESULT {
+        // 密码
+        if (m_chPwd) for (auto itr = str; itr < str + length; ++itr) *itr = m_chPwd;
+        Chunk chunk = { nullptr, position, length, 0, 0.f, 0.f, 0.f, 0.f };
+        auto hr = UIManager_DWriteFactory->CreateTextLayout(
+            str, length, m_pFormat,
+            m_size.width, m_size.height,
+            &chunk.layout
+        );
+        if (SUCCEEDED(hr)) {
+            // 段落对齐由整体偏移模拟
+            chunk.layout->SetParagraphAlignment(DWRITE_PARAGRAPH_ALIGNMENT_NEAR);
+            this->apply_styles(chunk, position, position + length);
+            this->measure_chunk(chunk);
+            chunks.push_back(chunk);
+            if (!chunks.isok()) {
+                LongUI::SafeRelease(chunk.layout);
+                hr = E_OUTOFMEMORY;
+            }
+        }
+        return hr;
+    }
+    /// <summary>
+    /// Applies styles in text range [begin, end) to chunk,
+    /// drawing effect of each run set in one pass.
+    /// </summary>
+    /// <param name="chunk">The chunk.</param>
+    /// <param name="begin">The begin.</param>
+    /// <param name="end">The end.</param>
+    /// <returns></returns>
+    void ParagraphLayout::apply_styles(const Chunk& chunk, uint32_t begin, uint32_t end) noexcept {
+        if (!m_pRuns || !chunk.layout) return;
+        const auto& runs = *m_pRuns;
+        const auto count = runs.GetCount();
+        begin = std::max(begin, chunk.position);
+        end = std::min(end, chunk.position + chunk.length);
+        // 起始的块
+        auto index = runs.FindRun(begin);
+        auto style = index < count ? runs[index].style : 0u;
+        index = index < count ? index + 1 : 0;
+        for (auto start = begin; start < end; ) {
+            const auto stop = index < count ? std::min(runs[index].position, end) : end;
+            const auto effect = style < m_cEffects ? m_ppEffects[style] : nullptr;
+            chunk.layout->SetDrawingEffect(effect, DWRITE_TEXT_RANGE{ start - chunk.position, stop - start });
+            start = stop;
+            if (index < count) style = runs[index++].style;
+        }
+    }
+    /// <summary>
+    /// Re-applies styles to chunks touching text range [begin, end).
+    /// </summary>
+    /// <param name="begin">The begin.</param>
+    /// <param name="end">The end.</param>
+    /// <returns></returns>
+    void ParagraphLayout::Restyle(uint32_t begin, uint32_t end) noexcept {
+        if (!m_pRuns || begin >= end || m_vChunks.empty()) return;
+        for (auto index = this->FindChunk(begin); index < m_vChunks.size(); ++index) {
+            const auto& chunk = m_vChunks[index];
+            if (chunk.position >= end) break;
+            this->apply_styles(chunk, begin, end);
+        }
+    }
+    /// <summary>
+    /// Measures the chunk.
+    /// </summary>
+    /// <param name="chunk">The chunk.</param>
+    /// <returns></returns>
+    void ParagraphLayout::measure_chunk(Chunk& chunk) noexcept {
+        DWRITE_TEXT_METRICS tm;
+        chunk.layout->GetMetrics(&tm);
+        chunk.lines = tm.lineCount;
+        chunk.top = 0.f;
+        chunk.height = tm.height;
+        chunk.left = tm.left;
+        chunk.width = tm.widthIncludingTrailingWhitespace;
+        // 换行符后的空行属于下一块
+        if (!m_bSingle && tm.lineCount > 1) {
+            EzContainer::SmallBuffer<DWRITE_LINE_METRICS, 32> lines;
+            lines.NewSize(tm.lineCount);
+            uint32_t count = 0;
+            chunk.layout->GetLineMetrics(lines.GetData(), lines.GetCount(), &count);
+            if (count == tm.lineCount && !lines[count - 1].length) {
+                chunk.height -= lines[count - 1].height;
+                --chunk.lines;
+            }
+        }
+    }
+    /// <summary>
+    /// Refreshes top of chunks from index and metrics of whole text.
+    /// </summary>
+    /// <param name="index">The index.</param>
+    /// <returns></returns>
+    void ParagraphLayout::refresh_metrics(uint32_t index) noexcept {
+        std::memset(&m_metrics, 0, sizeof(m_metrics));
+        m_fOffsetY = 0.f;
+        if (m_vChunks.empty()) return;
+        // 更新位置
+        float top = index ? m_vChunks[index - 1].top + m_vChunks[index - 1].height : 0.f;
+        for (auto i = index; i < m_vChunks.size(); ++i) {
+            m_vChunks[i].top = top;
+            top += m_vChunks[i].height;
+        }
+        // 整体
+        m_metrics.left = m_vChunks[0].left;
+        for (const auto& chunk : m_vChunks) {
+            m_metrics.left = std::min(m_metrics.left, chunk.left);
+            m_metrics.widthIncludingTrailingWhitespace = std::max(
+                m_metrics.widthIncludingTrailingWhitespace, chunk.width
+            );
+            m_metrics.lineCount += chunk.lines;
+        }
+        m_metrics.width = m_metrics.widthIncludingTrailingWhitespace;
+        m_metrics.height = top;
+        m_metrics.layoutWidth = m_size.width;
+        m_metrics.layoutHeight = m_size.height;
+        // 段落对齐
+        switch (m_pFormat ? m_pFormat->GetParagraphAlignment() : DWRITE_PARAGRAPH_ALIGNMENT_NEAR)
+        {
+        case DWRITE_PARAGRAPH_ALIGNMENT_FAR:
+            m_fOffsetY = m_size.height - top;
+            break;
+        case DWRITE_PARAGRAPH_ALIGNMENT_CENTER:
+            m_fOffsetY = (m_size.height - top) * 0.5f;
+            break;
+        }
+        m_metrics.top = m_fOffsetY;
+    }
+    /// <summary>
+    /// Resizes the layout.
+    /// </summary>
+    /// <param name="width">The width.</param>
+    /// <param name="height">The height.</param>
+    /// <returns></returns>
+    void ParagraphLayout::Resize(float width, float height) noexcept {
+        const bool relayout = width != m_size.width;
+        m_size.width = width; m_size.height = height;
+        for (auto& chunk : m_vChunks) {
+            if (!chunk.layout) continue;
+            chunk.layout->SetMaxWidth(width);
+            chunk.layout->SetMaxHeight(height);
+            // 宽度变化需要重新测量
+            if (relayout) this->measure_chunk(chunk);
+        }
+        this->refresh_metrics(0);
+    }
+    /// <summary>
+    /// Gets the line metrics of all chunks.
+    /// </summary>
+    /// <param name="metrics">The metrics.</param>
+    /// <param name="max_count">The maximum count.</param>
+    /// <param name="actual">The actual count.</param>
+    /// <returns></returns>
+    auto ParagraphLayout::GetLineMetrics(DWRITE_LINE_METRICS* metrics, 
+        uint32_t max_count, uint32_t* actual) const noexcept -> HRESULT {
+        // 延迟的块视为一行, 保持后面的位置正确
+        const auto total = m_metrics.lineCount + (m_ixPending != NIL);
+        *actual = total;
+        if (!metrics || max_count < total) return E_NOT_SUFFICIENT_BUFFER;
+        EzContainer::SmallBuffer<DWRITE_LINE_METRICS, 32> lines;
+        for (const auto& chunk : m_vChunks) {
+            if (!chunk.layout) {
+                std::memset(metrics, 0, sizeof(*metrics));
+                metrics->length = chunk.length;
+                metrics->height = chunk.height;
+                ++metrics;
+                continue;
+            }
+            // 包括被排除的空行
+            lines.NewSize(chunk.lines + 1);
+            uint32_t count = 0;
+            auto hr = chunk.layout->GetLineMetrics(lines.GetData(), lines.GetCount(), &count);
+            if (FAILED(hr)) return hr;
+            count = std::min(count, chunk.lines);
+            std::memcpy(metrics, lines.GetData(), count * sizeof(*metrics));
+            metrics += count;
+        }
+        return S_OK;
+    }
+    /// <summary>
+    /// Gets the cluster metrics of all chunks.
+    /// </summary>
+    /// <param name="metrics">The metrics.</param>
+    /// <param name="max_count">The maximum count.</param>
+    /// <param name="actual">The actual count.</param>
+    /// <returns></returns>
+    auto ParagraphLayout::GetClusterMetrics(DWRITE_CLUSTER_METRICS* metrics, 
+        uint32_t max_count, uint32_t* actual) const noexcept -> HRESULT {
+        uint32_t total = 0;
+        for (const auto& chunk : m_vChunks) total += this->chunk_clusters(chunk, nullptr, 0);
+        *actual = total;
+        if (!metrics || max_count < total) return E_NOT_SUFFICIENT_BUFFER;
+        for (const auto& chunk : m_vChunks) {
+            const auto count = this->chunk_clusters(chunk, metrics, max_count);
+            metrics += count; max_count -= count;
+        }
+        return S_OK;
+    }
+    /// <summary>
+    /// Gets the cluster metrics of chunk, deferred chunk is reported as
+    /// clusters without width to keep text positions after it correct.
+    /// </summary>
+    /// <param name="chunk">The chunk.</param>
+    /// <param name="metrics">The metrics.</param>
+    /// <param name="max_count">The maximum count.</param>
+    /// <returns>count of clusters</returns>
+    auto ParagraphLayout::chunk_clusters(const Chunk& chunk,
+        DWRITE_CLUSTER_METRICS* metrics, uint32_t max_count) const noexcept -> uint32_t {
+        uint32_t count = 0;
+        if (chunk.layout) {
+            chunk.layout->GetClusterMetrics(metrics, metrics ? max_count : 0, &count);
+            return count;
+        }
+        // 簇长度只有16位
+        enum : uint32_t { MAX_LENGTH = 0xffff };
+        count = (chunk.length + MAX_LENGTH - 1) / MAX_LENGTH;
+        if (metrics && count && max_count >= count) {
+            std::memset(metrics, 0, sizeof(*metrics) * count);
+            auto rest = chunk.length;
+            for (uint32_t i = 0; i < count; ++i) {
+                metrics[i].length = UINT16(std::min(rest, uint32_t(MAX_LENGTH)));
+                rest -= metrics[i].length;
+            }
+            metrics[count - 1].canWrapLineAfter = true;
+        }
+        return count;
+    }
+    /// <summary>
+    /// Hit test with text position.
+    /// </summary>
+    /// <param name="pos">The position.</param>
+    /// <param name="trailing">The trailing.</param>
+    /// <param name="x">The x.</param>
+    /// <param name="y">The y.</param>
+    /// <param name="metrics">The metrics.</param>
+    /// <returns></returns>
+    auto ParagraphLayout::HitTestTextPosition(uint32_t pos, BOOL trailing, 
+        float* x, float* y, DWRITE_HIT_TEST_METRICS* metrics) const noexcept -> HRESULT {
+        if (m_vChunks.empty()) return E_NOT_VALID_STATE;
+        const auto& chunk = m_vChunks[this->FindChunk(pos)];
+        // 延迟的块: 视为块起始处
+        if (!chunk.layout) {
+            std::memset(metrics, 0, sizeof(*metrics));
+            metrics->textPosition = pos;
+            *x = 0.f; *y = metrics->top = chunk.top + m_fOffsetY;
+            return S_OK;
+        }
+        auto hr = chunk.layout->HitTestTextPosition(pos - chunk.position, trailing, x, y, metrics);
+        // 转换到整体坐标
+        if (SUCCEEDED(hr)) {
+            *y += chunk.top + m_fOffsetY;
+            metrics->top += chunk.top + m_fOffsetY;
+            metrics->textPosition += chunk.position;
+        }
+        return hr;
+    }
+    /// <summary>
+    /// Hit test with point.
+    /// </summary>
+    /// <param name="x">The x.</param>
+    /// <param name="y">The y.</param>
+    /// <param name="trailing">The trailing.</param>
+    /// <param name="inside">The inside.</param>
+    /// <param name="metrics">The metrics.</param>
+    /// <returns></returns>
+    auto ParagraphLayout::HitTestPoint(float x, float y, 
+        BOOL* trailing, BOOL* inside, DWRITE_HIT_TEST_METRICS* metrics) const noexcept -> HRESULT {
+        if (m_vChunks.empty()) return E_NOT_VALID_STATE;
+        const auto block_y = y - m_fOffsetY;
+        const auto& chunk = m_vChunks[this->FindChunkAt(block_y)];
+        // 延迟的块: 视为块起始处
+        if (!chunk.layout) {
+            std::memset(metrics, 0, sizeof(*metrics));
+            metrics->textPosition = chunk.position;
+            metrics->top = chunk.top + m_fOffsetY;
+            *trailing = FALSE; *inside = FALSE;
+            return S_OK;
+        }
+        auto hr = chunk.layout->HitTestPoint(x, block_y - chunk.top, trailing, inside, metrics);
+        // 转换到整体坐标
+        if (SUCCEEDED(hr)) {
+            metrics->top += chunk.top + m_fOffsetY;
+            metrics->textPosition += chunk.position;
+        }
+        return hr;
+    }
+    /// <summary>
+    /// Hit test with text range.
+    /// </summary>
+    /// <param name="pos">The position.</param>
+    /// <param name="length">The length.</param>
+    /// <param name="x">The origin x.</param>
+    /// <param name="y">The origin y.</param>
+    /// <param name="metrics">The metrics.</param>
+    /// <param name="max_count">The maximum count.</param>
+    /// <param name="actual">The actual count.</param>
+    /// <returns></returns>
+    auto ParagraphLayout::HitTestTextRange(uint32_t pos, uint32_t length, float x, float y,
+        DWRITE_HIT_TEST_METRICS* metrics, uint32_t max_count, uint32_t* actual) const noexcept -> HRESULT {
+        *actual = 0;
+        if (m_vChunks.empty()) return E_NOT_VALID_STATE;
+        const auto end = pos + length;
+        uint32_t total = 0;
+        bool overflow = false;
+        for (auto i = this->FindChunk(pos); i < m_vChunks.size(); ++i) {
+            const auto& chunk = m_vChunks[i];
+            if (length && chunk.position >= end) break;
+            if (!chunk.layout) { if (length) continue; break; }
+            // 块内范围
+            const auto begin = std::max(pos, chunk.position) - chunk.position;
+            const auto len = length ? std::min(end, chunk.position + chunk.length) - chunk.position - begin : 0;
+            const auto buf = total < max_count ? metrics + total : nullptr;
+            uint32_t count = 0;
+            auto hr = chunk.layout->HitTestTextRange(
+                begin, len, x, y + chunk.top + m_fOffsetY,
+                buf, buf ? max_count - total : 0, &count
+            );
+            if (SUCCEEDED(hr)) {
+                for (auto itr = buf; itr < buf + count; ++itr) itr->textPosition += chunk.position;
+            }
+            else if (hr == E_NOT_SUFFICIENT_BUFFER) overflow = true;
+            else return hr;
+            total += count;
+            // 零长度仅测试一个块
+            if (!length) break;
+        }
+        *actual = total;
+        return overflow ? E_NOT_SUFFICIENT_BUFFER : S_OK;
+    }
+    /// <summary>
+    /// Draws chunks in [top, bottom) of block.
+    /// </summary>
+    /// <param name="context">The context.</param>
+    /// <param name="renderer">The renderer.</param>
+    /// <param name="x">The origin x.</param>
+    /// <param name="y">The origin y.</param>
+    /// <param name="top">The top relative to origin.</param>
+    /// <param name="bottom">The bottom relative to origin.</param>
+    /// <returns></returns>
+    void ParagraphLayout::Draw(void* context, IDWriteTextRenderer* renderer, 
+        float x, float y, float top, float bottom) const noexcept {
+        if (m_vChunks.empty()) return;
+        for (auto i = this->FindChunkAt(top - m_fOffsetY); i < m_vChunks.size(); ++i) {
+            const auto& chunk = m_vChunks[i];
+            if (chunk.top + m_fOffsetY >= bottom) break;
+            if (chunk.layout) chunk.layout->Draw(context, renderer, x, y + chunk.top + m_fOffsetY);
+        }
+    }
     // -------------------- LongUI::Component::EditableText --------------------
     // DWrite部分代码参考: 
     // http://msdn.microsoft.com/zh-cn/library/windows/desktop/dd941792(v=vs.85).aspx
@@ -305,7 +996,8 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         if (window->IsControlFocused(m_pHost)) {
             RectLTWH_F rect; this->GetCaretRect(rect);
             window->SetCaret(m_pHost, &rect);
-            if (update) {
+            // 文本未变: 插入符号与选择区仅刷新自身区域
+            if (update && !this->is_cache_valid()) {
                 m_pHost->InvalidateThis();
             }
         }
@@ -319,50 +1011,54 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     void EditableText::Resize(float w, float h) noexcept {
         CUIDxgiAutoLocker locker;
         m_size.width = w; m_size.height = h; 
-        m_pLayout->SetMaxWidth(w); 
-        m_pLayout->SetMaxHeight(h);
+        m_layout.Resize(w, h);
+        ++m_uLayoutVersion;
     }
     // 直接重建布局
     void EditableText::recreate_layout() noexcept { 
         CUIDxgiAutoLocker locker;
-        auto fmt = m_pLayout; 
-        m_pLayout = nullptr; 
-        this->recreate_layout(fmt); 
-        LongUI::SafeRelease(fmt); 
+        // 修改文本
+        m_bTxtChanged = true;
+        ++m_uLayoutVersion;
+        // 富文本属性作用于整个文档: 不分段
+        m_layout.SetSingleChunk(this->IsRiched());
+        m_layout.SetPasswordChar(this->IsPassword() ? m_chPwd : L'\0');
+        // 行索引
+        HRESULT hr = m_lines.Build(m_buffer) ? S_OK : E_OUTOFMEMORY;
+        // 语法高亮, 样式在创建布局时应用
+        if (!m_highlighter.Build(m_buffer, m_lines)) hr = E_OUTOFMEMORY;
+        const auto hr2 = m_layout.Build(m_buffer);
+        if (SUCCEEDED(hr)) hr = hr2;
+#ifdef _DEBUG
+        if (m_pHost->debug_this) {
+            UIManager << DL_Hint << L"CODE: " << long(hr) << LongUI::endl;
+            assert(hr == S_OK);
+        }
+#endif
+        // 断言
+        assert(SUCCEEDED(hr));
     }
     // 重新创建布局
     void EditableText::recreate_layout(IDWriteTextFormat* fmt) noexcept {
         assert(fmt && "bad argument");
-        assert(m_pLayout == nullptr && "bad action");
+        m_layout.SetFormat(fmt);
+        m_layout.Resize(m_size.width, m_size.height);
+        this->recreate_layout();
+    }
+    // 重新布局受影响的段落
+    void EditableText::relayout(uint32_t pos, uint32_t removed, uint32_t inserted) noexcept {
+        CUIDxgiAutoLocker locker;
         // 修改文本
         m_bTxtChanged = true;
-        // 数据
-        HRESULT hr = S_OK;
-        // 密码?
-        if (this->IsPassword()) {
-            // 双字密码字符
-            uint32_t len = m_string.length();
-            // 申请缓存
-            LongUI::SafeBuffer<wchar_t>(len, [len, this, fmt, &hr](wchar_t* const buf) {
-                // 复制字符串
-                for (auto itr = buf; itr < buf + len; ++itr) *itr = char16_t(m_chPwd);
-                // 创建文本布局
-                hr = UIManager_DWriteFactory->CreateTextLayout(
-                    buf, len, fmt,
-                    m_size.width, m_size.height,
-                    &m_pLayout
-                );
-            });
-        }
-        // 创建一般布局 
-        else {
-            hr = UIManager_DWriteFactory->CreateTextLayout(
-                m_string.c_str(), static_cast<uint32_t>(m_string.length()),
-                fmt,
-                m_size.width, m_size.height,
-                &m_pLayout
-            );
-        }
+        ++m_uLayoutVersion;
+        // 行索引
+        HRESULT hr = m_lines.Update(m_buffer, pos, removed, inserted) ? S_OK : E_OUTOFMEMORY;
+        // 语法高亮: 样式可能在编辑之后的段落变化
+        uint32_t begin, end;
+        if (!m_highlighter.Update(m_buffer, m_lines, pos, removed, inserted, begin, end)) hr = E_OUTOFMEMORY;
+        const auto hr2 = m_layout.Update(m_buffer, pos, removed, inserted);
+        if (SUCCEEDED(hr)) hr = hr2;
+        m_layout.Restyle(begin, end);
 #ifdef _DEBUG
         if (m_pHost->debug_this) {
             UIManager << DL_Hint << L"CODE: " << long(hr) << LongUI::endl;
@@ -373,7 +1069,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         assert(SUCCEEDED(hr));
     }
     // 插入字符(串)
-    auto EditableText::insert(uint32_t pos, const wchar_t * str, uint32_t& length) noexcept -> HRESULT {
+    auto EditableText::insert(uint32_t pos, const wchar_t * str, uint32_t& length, bool typing) noexcept -> HRESULT {
         // 第一次查错
         {
             // 只读
@@ -381,8 +1077,8 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                 length = 0;
             }
             // 限制大小
-            else if ((m_string.length() + length) > m_uMaxLength) {
-                auto l = m_string.length();
+            else if ((m_buffer.GetLength() + length) > m_uMaxLength) {
+                auto l = m_buffer.GetLength();
                 // 太长
                 length = (l < m_uMaxLength) ? (m_uMaxLength - l) : 0;
             }
@@ -394,47 +1090,19 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         }
         // 第二次查错
         {
-            // 输入数字
-            if (this->IsNumber()) {
-                auto& data = m_string;
-                LongUI::SafeBuffer<wchar_t>(length + 1,
-                    [pos, str, &data, &length](wchar_t* const buf) {
-                    auto wrt = buf;
-                    for (auto itr = str; itr != str + length; ++itr) {
-                        if (valid_digit(*itr)) {
-                            *wrt = *itr;
-                            ++wrt;
-                        }
-                    }
-                    length = uint32_t(wrt - buf);
+            // 输入数字或者密码: 需要过滤
+            if (this->IsNumber() || this->IsPassword()) {
+                LongUI::SafeBuffer<wchar_t>(length + 1, [&](wchar_t* const buf) noexcept {
+                    length = this->filter(str, length, buf);
 #ifdef _DEBUG
-                    *wrt = 0;
+                    buf[length] = 0;
 #endif
-                    data.insert(pos, buf, length);
-                });
-            }
-            // 输入密码: 不能有大于0xFFFF的字符
-            else if (this->IsPassword()) {
-                auto& data = m_string;
-                LongUI::SafeBuffer<wchar_t>(length + 1,
-                    [pos, str, &data, &length](wchar_t* const buf) {
-                    auto wrt = buf;
-                    for (auto itr = str; itr != str + length; ++itr) {
-                        if (!LongUI::IsSurrogate(*itr)) {
-                            *wrt = *itr;
-                            ++wrt;
-                        }
-                    }
-                    length = uint32_t(wrt - buf);
-#ifdef _DEBUG
-                    *wrt = 0;
-#endif
-                    data.insert(pos, buf, length);
+                    if (!m_buffer.Insert(pos, buf, length)) length = 0;
                 });
             }
             // 插入字符
             else {
-                m_string.insert(pos, str, length);
+                if (!m_buffer.Insert(pos, str, length)) length = 0;
             }
         }
         // 没有输入
@@ -442,38 +1110,41 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             LongUI::BeepError();
             return S_FALSE;
         }
+        // 记录撤销
+        this->record_insert(pos, length, typing);
         HRESULT hr = S_OK;
-        auto old_length = static_cast<uint32_t>(m_string.length());
+        auto old_length = m_buffer.GetLength();
         // 保留旧布局
-        auto old_layout = LongUI::SafeAcquire(m_pLayout);
-        // 重新创建布局
-        this->recreate_layout();
+        auto old_layout = LongUI::SafeAcquire(m_layout.RefSingleLayout());
+        // 重新布局受影响的段落
+        this->relayout(pos, 0, length);
         // 富文本情况下?
-        if (old_layout && this->IsRiched() && SUCCEEDED(hr)) {
+        auto new_layout = m_layout.RefSingleLayout();
+        if (old_layout && new_layout && this->IsRiched() && SUCCEEDED(hr)) {
             // 复制全局属性
-            Component::EditableText::CopyGlobalProperties(old_layout, m_pLayout);
+            Component::EditableText::CopyGlobalProperties(old_layout, new_layout);
             // 对于每种属性, 获取并应用到新布局
             // 在首位?
             if (pos) {
                 // 第一块
-                Component::EditableText::CopyRangedProperties(old_layout, m_pLayout, 0, pos, 0);
+                Component::EditableText::CopyRangedProperties(old_layout, new_layout, 0, pos, 0);
                 // 插入块
-                Component::EditableText::CopySinglePropertyRange(old_layout, pos - 1, m_pLayout, pos, length);
+                Component::EditableText::CopySinglePropertyRange(old_layout, pos - 1, new_layout, pos, length);
                 // 结束块
-                Component::EditableText::CopyRangedProperties(old_layout, m_pLayout, pos, old_length, length);
+                Component::EditableText::CopyRangedProperties(old_layout, new_layout, pos, old_length, length);
             }
             else {
                 // 插入块
-                Component::EditableText::CopySinglePropertyRange(old_layout, 0, m_pLayout, 0, length);
+                Component::EditableText::CopySinglePropertyRange(old_layout, 0, new_layout, 0, length);
                 // 结束块
-                Component::EditableText::CopyRangedProperties(old_layout, m_pLayout, 0, old_length, length);
+                Component::EditableText::CopyRangedProperties(old_layout, new_layout, 0, old_length, length);
             }
             // 末尾
             Component::EditableText::CopySinglePropertyRange(
                 old_layout, 
                 old_length, 
-                m_pLayout, 
-                static_cast<uint32_t>(m_string.length()), 
+                new_layout, 
+                m_buffer.GetLength(), 
                 UINT32_MAX
             );
         }
@@ -481,19 +1152,125 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         return hr;
     }
     /// <summary>
+    /// Filters the input for number or password.
+    /// </summary>
+    /// <param name="str">The string.</param>
+    /// <param name="length">The length.</param>
+    /// <param name="out">The output, length chars at most.</param>
+    /// <returns>length of output</returns>
+    auto EditableText::filter(const wchar_t* str, uint32_t length, wchar_t* out) const noexcept -> uint32_t {
+        auto wrt = out;
+        // 输入数字
+        if (this->IsNumber()) {
+            for (auto itr = str; itr != str + length; ++itr) {
+                if (valid_digit(*itr)) *wrt++ = *itr;
+            }
+        }
+        // 输入密码: 不能有大于0xFFFF的字符
+        else if (this->IsPassword()) {
+            for (auto itr = str; itr != str + length; ++itr) {
+                if (!LongUI::IsSurrogate(*itr)) *wrt++ = *itr;
+            }
+        }
+        else {
+            std::memcpy(out, str, length * sizeof(wchar_t));
+            wrt += length;
+        }
+        return uint32_t(wrt - out);
+    }
+    /// <summary>
+    /// Inserts large text in chunks, no temporary copy of whole 
+    /// text, layout of inserted text is deferred to later frames.
+    /// </summary>
+    /// <param name="pos">The position.</param>
+    /// <param name="str">The string.</param>
+    /// <param name="length">The length, length inserted in fact returned.</param>
+    /// <returns></returns>
+    auto EditableText::insert_stream(uint32_t pos, const wchar_t* str, uint32_t& length) noexcept -> HRESULT {
+        // 只读
+        if (this->IsReadOnly()) length = 0;
+        // 限制大小
+        else if ((m_buffer.GetLength() + length) > m_uMaxLength) {
+            auto l = m_buffer.GetLength();
+            length = (l < m_uMaxLength) ? (m_uMaxLength - l) : 0;
+        }
+        if (!length) {
+            LongUI::BeepError();
+            return S_FALSE;
+        }
+        HRESULT hr = S_OK;
+        uint32_t inserted = 0;
+        const bool filtered = this->IsNumber() || this->IsPassword();
+        // 逐块过滤并追加, 行索引仅扫描每块
+        LongUI::SafeBuffer<wchar_t>(LongUIStreamPasteChunk, [&](wchar_t* const buf) noexcept {
+            for (uint32_t done = 0; done < length && SUCCEEDED(hr); ) {
+                auto count = std::min(length - done, uint32_t(LongUIStreamPasteChunk));
+                // 不拆分代理对
+                if (count > 1 && done + count < length && LongUI::IsHighSurrogate(str[done + count - 1])) --count;
+                const wchar_t* data = str + done;
+                done += count;
+                if (filtered) {
+                    count = this->filter(data, count, buf);
+                    data = buf;
+                }
+                if (!count) continue;
+                if (!m_buffer.Insert(pos + inserted, data, count)) { hr = E_OUTOFMEMORY; break; }
+                if (!m_lines.Update(m_buffer, pos + inserted, 0, count)) hr = E_OUTOFMEMORY;
+                inserted += count;
+            }
+        });
+        length = inserted;
+        // 没有输入
+        if (!length) {
+            LongUI::BeepError();
+            return FAILED(hr) ? hr : S_FALSE;
+        }
+        // 记录撤销
+        this->record_insert(pos, length, false);
+        m_bTxtChanged = true;
+        ++m_uLayoutVersion;
+        // 语法高亮一次更新
+        uint32_t begin, end;
+        if (!m_highlighter.Update(m_buffer, m_lines, pos, 0, length, begin, end)) hr = E_OUTOFMEMORY;
+        // 延迟布局, 之后每帧布局一部分
+        const auto hr2 = m_layout.Defer(m_buffer, pos, 0, length);
+        if (SUCCEEDED(hr)) hr = hr2;
+        m_layout.Restyle(begin, end);
+        m_uPendingTotal = std::max(m_uPendingTotal, m_layout.GetPending());
+        m_pHost->StartRender(0.f);
+        return hr;
+    }
+    /// <summary>
+    /// Lays out next slice of deferred text.
+    /// </summary>
+    /// <returns></returns>
+    void EditableText::continue_layout() noexcept {
+        auto hr = m_layout.Continue(m_buffer, LongUILayoutSliceLength);
+        assert(SUCCEEDED(hr)); UNREFERENCED_PARAMETER(hr);
+        ++m_uLayoutVersion;
+        const auto pending = m_layout.GetPending();
+        m_uPendingTotal = std::max(m_uPendingTotal, pending);
+        // 进度
+        if (m_evProgress.IsOK()) m_evProgress(m_uPendingTotal - pending, m_uPendingTotal);
+        // 继续下一帧
+        if (pending) m_pHost->StartRender(0.f);
+        else m_uPendingTotal = 0;
+        m_pHost->InvalidateThis();
+    }
+    /// <summary>
     /// Copy_removes this instance.
     /// </summary>
     /// <param name="oldLayout">The old layout.</param>
     /// <param name="r">The r.</param>
     /// <returns></returns>
     auto EditableText::copy_remove(IDWriteTextLayout* oldLayout, DWRITE_TEXT_RANGE r) noexcept {
-        auto newLayout = m_pLayout;
+        auto newLayout = m_layout.RefSingleLayout();
         if (!(newLayout && oldLayout)) return;
         if (newLayout == oldLayout) return;
         if (!this->IsRiched()) return;
         auto position = r.startPosition;
         auto lengthToRemove = r.length;
-        uint32_t oldTextLength = m_string.length() + lengthToRemove;
+        uint32_t oldTextLength = m_buffer.GetLength() + lengthToRemove;
         Component::EditableText::CopyGlobalProperties(oldLayout, newLayout);
 
         if (position == 0) {
@@ -508,7 +1285,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             );
         }
         Component::EditableText::CopySinglePropertyRange(
-            oldLayout, oldTextLength, newLayout, static_cast<UINT32>(m_string.length()), UINT32_MAX
+            oldLayout, oldTextLength, newLayout, m_buffer.GetLength(), UINT32_MAX
         );
     }
     // 返回当前选择区域
@@ -521,7 +1298,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             std::swap(caretBegin, caretEnd);
         }
         // 限制范围在文本长度之内
-        auto textLength = static_cast<uint32_t>(m_string.size());
+        auto textLength = m_buffer.GetLength();
         caretBegin = std::min(caretBegin, textLength);
         caretEnd = std::min(caretEnd, textLength);
         // 返回范围
@@ -530,12 +1307,10 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     // 设置选择区
     auto EditableText::SetSelection(
         SelectionMode mode, uint32_t advance, bool exsel, bool update) noexcept -> HRESULT {
-        using LineMetricsBuffer = EzContainer::SmallBuffer<DWRITE_LINE_METRICS, 32>;
         //uint32_t line = uint32_t(-1);
         uint32_t absolute_position = m_u32CaretPos + m_u32CaretPosOffset;
         uint32_t oldabsolute_position = absolute_position;
         uint32_t old_caret_anchor = m_u32CaretAnchor;
-        DWRITE_TEXT_METRICS textMetrics;
         // CASE
         switch (mode)
         {
@@ -548,9 +1323,9 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                 // 检查换行符
                 absolute_position = m_u32CaretPos + m_u32CaretPosOffset;
                 if (absolute_position >= 1
-                    && absolute_position < m_string.size()
-                    && m_string[absolute_position - 1] == L'\r'
-                    &&  m_string[absolute_position] == L'\n')
+                    && absolute_position < m_buffer.GetLength()
+                    && m_buffer[absolute_position - 1] == L'\r'
+                    &&  m_buffer[absolute_position] == L'\n')
                 {
                     m_u32CaretPos = absolute_position - 1;
                     this->AlignCaretToNearestCluster(false, true);
@@ -563,9 +1338,9 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             this->AlignCaretToNearestCluster(true, true);
             absolute_position = m_u32CaretPos + m_u32CaretPosOffset;
             if (absolute_position >= 1
-                && absolute_position < m_string.size()
-                && m_string[absolute_position - 1] == '\r'
-                &&  m_string[absolute_position] == '\n')
+                && absolute_position < m_buffer.GetLength()
+                && m_buffer[absolute_position - 1] == '\r'
+                &&  m_buffer[absolute_position] == '\n')
             {
                 m_u32CaretPos = absolute_position + 1;
                 this->AlignCaretToNearestCluster(false, true);
@@ -583,7 +1358,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                 // Use hit-testing to limit text position.
                 DWRITE_HIT_TEST_METRICS hitTestMetrics;
                 float caretX, caretY;
-                m_pLayout->HitTestTextPosition(
+                m_layout.HitTestTextPosition(
                     m_u32CaretPos,
                     false,
                     &caretX,
@@ -596,39 +1371,24 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         case SelectionMode::Mode_Up:
         case SelectionMode::Mode_Down:
         {
-            LineMetricsBuffer metrice_buffer;
-            // 获取行指标
-            m_pLayout->GetMetrics(&textMetrics);
-            metrice_buffer.NewSize(textMetrics.lineCount);
-            m_pLayout->GetLineMetrics(
-                metrice_buffer.GetData(),
-                textMetrics.lineCount,
-                &textMetrics.lineCount
-                );
-            // 获取行
-            uint32_t line, linePosition;
-            Component::EditableText::GetLineFromPosition(
-                metrice_buffer.GetData(),
-                metrice_buffer.GetCount(),
-                m_u32CaretPos,
-                &line,
-                &linePosition
-                );
+            // 获取行: 仅涉及所在段落
+            DWRITE_LINE_METRICS line;
+            uint32_t linePosition = m_layout.GetLineAt(m_u32CaretPos, line);
             // 下移或上移
             if (mode == SelectionMode::Mode_Up) {
-                if (line <= 0) break;
-                line--;
-                linePosition -= metrice_buffer[line].length;
+                if (!linePosition) break;
+                linePosition = m_layout.GetLineAt(linePosition - 1, line);
             }
             else {
-                linePosition += metrice_buffer[line].length;
-                line++;
-                if (line >= metrice_buffer.GetCount())  break;
+                linePosition += line.length;
+                // 最后一行: 换行符后才有空行
+                const auto length = m_buffer.GetLength();
+                if (linePosition > length || (linePosition == length && !line.newlineLength)) break;
             }
             DWRITE_HIT_TEST_METRICS hitTestMetrics;
             float caretX, caretY, dummyX;
             // 获取当前文本X位置
-            m_pLayout->HitTestTextPosition(
+            m_layout.HitTestTextPosition(
                 m_u32CaretPos,
                 m_u32CaretPosOffset > 0, // trailing if nonzero, else leading edge
                 &caretX,
@@ -636,7 +1396,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                 &hitTestMetrics
                 );
             // 获取新位置Y坐标
-            m_pLayout->HitTestTextPosition(
+            m_layout.HitTestTextPosition(
                 linePosition,
                 false, // leading edge
                 &dummyX,
@@ -645,7 +1405,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                 );
             // 获取新x, y 的文本位置
             BOOL isInside, isTrailingHit;
-            m_pLayout->HitTestPoint(
+            m_layout.HitTestPoint(
                 caretX, caretY,
                 &isTrailingHit,
                 &isInside,
@@ -658,79 +1418,63 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         case SelectionMode::Mode_LeftWord:
         case SelectionMode::Mode_RightWord:
         {
-            // 计算所需字符串集
-            EzContainer::SmallBuffer<DWRITE_CLUSTER_METRICS, 64> metrice_buffer;
-            UINT32 clusterCount;
-            m_pLayout->GetClusterMetrics(nullptr, 0, &clusterCount);
-            if (clusterCount == 0) break;
-            // 重置大小
-            metrice_buffer.NewSize(clusterCount);
-            m_pLayout->GetClusterMetrics(metrice_buffer.GetData(), clusterCount, &clusterCount);
-            m_u32CaretPos = absolute_position;
-            UINT32 clusterPosition = 0;
-            UINT32 oldCaretPosition = m_u32CaretPos;
+            // 仅查询插入符所在段落, 在边界时加上相邻段落
+            if (!m_layout.IsOk()) break;
             // 左移
             if (mode == SelectionMode::Mode_LeftWord) {
-                m_u32CaretPos = 0;
+                m_u32CaretPos = m_layout.GetWordLeft(absolute_position);
                 m_u32CaretPosOffset = 0; // leading edge
-                for (UINT32 cluster = 0; cluster < clusterCount; ++cluster) {
-                    clusterPosition += metrice_buffer[cluster].length;
-                    if (metrice_buffer[cluster].canWrapLineAfter) {
-                        if (clusterPosition >= oldCaretPosition)
-                            break;
-                        // 刷新.
-                        m_u32CaretPos = clusterPosition;
-                    }
-                }
             }
             else {
-                // 之后
-                for (UINT32 cluster = 0; cluster < clusterCount; ++cluster) {
-                    UINT32 clusterLength = metrice_buffer[cluster].length;
-                    m_u32CaretPos = clusterPosition;
-                    m_u32CaretPosOffset = clusterLength; // trailing edge
-                    if (clusterPosition >= oldCaretPosition &&
-                        metrice_buffer[cluster].canWrapLineAfter) {
-                        break;
-                    }
-                    clusterPosition += clusterLength;
-                }
+                uint32_t length;
+                m_u32CaretPos = m_layout.GetWordRight(absolute_position, length);
+                m_u32CaretPosOffset = length; // trailing edge
             }
-            //int a = 0;
         }
         break;
         case SelectionMode::Mode_Home:
         case SelectionMode::Mode_End:
         {
-            // 获取预知的首位置或者末位置
-            LineMetricsBuffer metrice_buffer;
-            // 获取行指标
-            m_pLayout->GetMetrics(&textMetrics);
-            metrice_buffer.NewSize(textMetrics.lineCount);
-            m_pLayout->GetLineMetrics(
-                metrice_buffer.GetData(),
-                textMetrics.lineCount,
-                &textMetrics.lineCount
-                );
-            uint32_t line;
-            Component::EditableText::GetLineFromPosition(
-                metrice_buffer.GetData(),
-                metrice_buffer.GetCount(),
-                m_u32CaretPos,
-                &line,
-                &m_u32CaretPos
-                );
+            // 获取预知的首位置或者末位置: 仅涉及所在段落
+            DWRITE_LINE_METRICS line;
+            m_u32CaretPos = m_layout.GetLineAt(m_u32CaretPos, line);
             m_u32CaretPosOffset = 0;
             if (mode == SelectionMode::Mode_End) {
                 // 放置插入符号
-                UINT32 lineLength = metrice_buffer[line].length -
-                    metrice_buffer[line].newlineLength;
+                UINT32 lineLength = line.length - line.newlineLength;
                 m_u32CaretPosOffset = std::min(lineLength, 1u);
                 m_u32CaretPos += lineLength - m_u32CaretPosOffset;
                 this->AlignCaretToNearestCluster(true);
             }
         }
         break;
+        case SelectionMode::Mode_PageUp:
+        case SelectionMode::Mode_PageDown:
+        {
+            DWRITE_HIT_TEST_METRICS hitTestMetrics;
+            float caretX, caretY;
+            // 获取当前文本位置
+            m_layout.HitTestTextPosition(
+                m_u32CaretPos,
+                m_u32CaretPosOffset > 0,
+                &caretX,
+                &caretY,
+                &hitTestMetrics
+                );
+            // 移动一页, 超出文本的点击测试会落在首末行
+            caretY += hitTestMetrics.height * 0.5f;
+            caretY += mode == SelectionMode::Mode_PageUp ? -m_size.height : m_size.height;
+            BOOL isInside, isTrailingHit;
+            m_layout.HitTestPoint(
+                caretX, caretY,
+                &isTrailingHit,
+                &isInside,
+                &hitTestMetrics
+                );
+            m_u32CaretPos = hitTestMetrics.textPosition;
+            m_u32CaretPosOffset = isTrailingHit ? (hitTestMetrics.length > 0) : 0;
+        }
+        break;
         case SelectionMode::Mode_First:
             m_u32CaretPos = 0;
             m_u32CaretPosOffset = 0;
@@ -764,6 +1508,8 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             || (m_u32CaretAnchor != old_caret_anchor);
         // 移动了?
         if (caretMoved) {
+            // 不是编辑引起的移动: 之后的输入不再合并
+            if (!m_bEditSelection) m_undo.Seal();
             // 更新格式
             if (update) {
 
@@ -776,13 +1522,251 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         //return S_OK;
     }
 
+    // 编辑时移动插入符
+    auto EditableText::edit_selection(SelectionMode mode, uint32_t advance, bool update) noexcept -> HRESULT {
+        m_bEditSelection = true;
+        const auto hr = this->SetSelection(mode, advance, false, update);
+        m_bEditSelection = false;
+        return hr;
+    }
+    // 记录删除的文本
+    void EditableText::record_remove(uint32_t pos, uint32_t len, bool typing) noexcept {
+        // 密码不记录
+        if (m_bUndoing || this->IsPassword() || !len) return;
+        // 超出预算: 无需复制, 更早的记录已经无效
+        if (len * sizeof(wchar_t) > m_undo.GetBudget()) return m_undo.Clear();
+        bool recorded = false;
+        LongUI::SafeBuffer<wchar_t>(len, [&](wchar_t* const buf) noexcept {
+            m_buffer.Copy(pos, len, buf);
+            recorded = m_undo.Push(pos, buf, len, nullptr, 0, typing);
+        });
+        // 无法记录: 更早的记录已经无效
+        if (!recorded) m_undo.Clear();
+    }
+    // 记录插入的文本
+    void EditableText::record_insert(uint32_t pos, uint32_t len, bool typing) noexcept {
+        // 密码不记录
+        if (m_bUndoing || this->IsPassword() || !len) return;
+        // 超出预算: 无需复制, 更早的记录已经无效
+        if (len * sizeof(wchar_t) > m_undo.GetBudget()) return m_undo.Clear();
+        bool recorded = false;
+        LongUI::SafeBuffer<wchar_t>(len, [&](wchar_t* const buf) noexcept {
+            m_buffer.Copy(pos, len, buf);
+            recorded = m_undo.Push(pos, nullptr, 0, buf, len, typing);
+        });
+        // 无法记录: 更早的记录已经无效
+        if (!recorded) m_undo.Clear();
+    }
+    // 记录替换的文本
+    void EditableText::record_replace(uint32_t pos, uint32_t len, const wchar_t* str, uint32_t length) noexcept {
+        // 密码不记录
+        if (m_bUndoing || this->IsPassword()) return;
+        // 超出预算: 无需复制, 更早的记录已经无效
+        if ((len + length) * sizeof(wchar_t) > m_undo.GetBudget()) return m_undo.Clear();
+        bool recorded = false;
+        LongUI::SafeBuffer<wchar_t>(len + 1, [&](wchar_t* const buf) noexcept {
+            m_buffer.Copy(pos, len, buf);
+            recorded = m_undo.Push(pos, buf, len, str, length, false);
+        });
+        // 无法记录: 更早的记录已经无效
+        if (!recorded) m_undo.Clear();
+    }
+    // 应用撤销/重做
+    void EditableText::apply_delta(uint32_t pos, uint32_t removed, const wchar_t* str, uint32_t length) noexcept {
+        m_bUndoing = true;
+        if (removed) {
+            auto old = LongUI::SafeAcquire(m_layout.RefSingleLayout());
+            if (this->remove_text(pos, removed)) {
+                this->copy_remove(old, DWRITE_TEXT_RANGE{ pos, removed });
+            }
+            LongUI::SafeRelease(old);
+        }
+        if (length) this->insert(pos, str, length);
+        m_bUndoing = false;
+    }
+    // 撤销
+    bool EditableText::Undo() noexcept {
+        CUIUndoStack::Delta delta;
+        if (this->IsReadOnly() || !m_undo.Undo(delta)) return false;
+        // 同一组的修改一起撤销
+        uint32_t pos, length;
+        do {
+            pos = delta.position; length = delta.removed_length;
+            this->apply_delta(pos, delta.inserted_length, delta.removed, length);
+        } while (delta.chained && m_undo.Undo(delta));
+        // 选中恢复的文本
+        this->SetSelection(SelectionMode::Mode_Leading, pos, false);
+        if (length) this->SetSelection(SelectionMode::Mode_Leading, pos + length, true);
+        this->refresh();
+        return true;
+    }
+    // 重做
+    bool EditableText::Redo() noexcept {
+        CUIUndoStack::Delta delta;
+        if (this->IsReadOnly() || !m_undo.Redo(delta)) return false;
+        // 同一组的修改一起重做
+        uint32_t pos, length;
+        do {
+            pos = delta.position; length = delta.inserted_length;
+            this->apply_delta(pos, delta.removed_length, delta.inserted, length);
+        } while (delta.chained && m_undo.Redo(delta));
+        // 选中恢复的文本
+        this->SetSelection(SelectionMode::Mode_Leading, pos, false);
+        if (length) this->SetSelection(SelectionMode::Mode_Leading, pos + length, true);
+        this->refresh();
+        return true;
+    }
+    // 跳转到行首
+    void EditableText::GoToLine(uint32_t line, bool exsel) noexcept {
+        this->SetSelection(SelectionMode::Mode_Leading, m_lines.GetLineStart(line), exsel);
+    }
+    // 分段查找, 每次复制一个窗口, 相邻窗口重叠len-1个字符
+    auto EditableText::find_text(const wchar_t* str, uint32_t len, uint32_t from, 
+        bool icase, EzContainer::EzVector<uint32_t>* out) const noexcept -> uint32_t {
+        const uint32_t notfound = out ? 0 : CUITextFinder::NPOS;
+        const auto length = m_buffer.GetLength();
+        // 密码不能查找
+        if (this->IsPassword() || !len || from > length || length - from < len) return notfound;
+        constexpr uint32_t window = LongUIFindWindowLength;
+        const auto buf = LongUI::NormalAllocT<wchar_t>(window + len - 1);
+        if (!buf) return notfound;
+        // 忽略大小写: 模式与窗口都用FoldCase折叠, 再区分大小写查找
+        std::memcpy(buf, str, len * sizeof(wchar_t));
+        if (icase) LongUI::FoldCase(buf, len);
+        CUITextFinder finder;
+        auto result = notfound;
+        if (finder.Set(buf, len)) {
+            uint32_t count = 0;
+            // 下一个匹配的最小起点
+            auto next = from;
+            for (auto pos = from; pos + len <= length; pos += window) {
+                const auto chunk = m_buffer.Copy(pos, window + len - 1, buf);
+                if (icase) LongUI::FoldCase(buf, chunk);
+                // 窗口内的匹配起点必然小于window
+                auto i = finder.Find(buf, chunk, next > pos ? next - pos : 0);
+                if (!out) {
+                    if (i == CUITextFinder::NPOS) continue;
+                    result = pos + i;
+                    break;
+                }
+                for (; i != CUITextFinder::NPOS; i = finder.Find(buf, chunk, next - pos)) {
+                    out->push_back(pos + i);
+                    next = pos + i + len;
+                    ++count;
+                }
+            }
+            if (out) result = out->isok() ? count : 0;
+        }
+        LongUI::NormalFree(buf);
+        return result;
+    }
+    // 查找文本
+    auto EditableText::Find(const wchar_t* str, uint32_t len, uint32_t from, bool icase) const noexcept -> uint32_t {
+        return this->find_text(str, len, from, icase, nullptr);
+    }
+    // 查找全部文本
+    auto EditableText::FindAll(const wchar_t* str, uint32_t len, 
+        EzContainer::EzVector<uint32_t>& out, bool icase) const noexcept -> uint32_t {
+        return this->find_text(str, len, 0, icase, &out);
+    }
+    // 选择下一个匹配
+    bool EditableText::FindNext(const wchar_t* str, uint32_t len, bool icase) noexcept {
+        const auto range = this->GetSelectionRange();
+        auto pos = this->Find(str, len, range.startPosition + range.length, icase);
+        // 回绕
+        if (pos == CUITextFinder::NPOS) pos = this->Find(str, len, 0, icase);
+        if (pos == CUITextFinder::NPOS) {
+            LongUI::BeepError();
+            return false;
+        }
+        this->SetSelection(SelectionMode::Mode_Leading, pos, false);
+        this->SetSelection(SelectionMode::Mode_Leading, pos + len, true);
+        return true;
+    }
+    // 替换全部文本
+    auto EditableText::ReplaceAll(const wchar_t* str, uint32_t len, 
+        const wchar_t* rep, uint32_t rlen, bool icase) noexcept -> uint32_t {
+        if (this->IsReadOnly()) { LongUI::BeepError(); return 0; }
+        EzContainer::EzVector<uint32_t> matches;
+        const auto count = this->FindAll(str, len, matches, icase);
+        if (!count) return 0;
+        HRESULT hr = S_OK;
+        uint32_t replaced = 0, rcount = 0;
+        LongUI::SafeBuffer<wchar_t>(rlen + 1, [&](wchar_t* const rbuf) noexcept {
+            rcount = this->filter(rep, rlen, rbuf);
+            // 限制大小
+            const auto length = uint64_t(m_buffer.GetLength()) + uint64_t(count) * rcount - uint64_t(count) * len;
+            if (length > m_uMaxLength) return;
+            // 从后往前逐个替换, 前面的匹配位置不变, 撤销时作为一组
+            m_undo.BeginGroup();
+            for (auto i = count; i--; ) {
+                const auto pos = matches[i];
+                // 先插入再删除, 失败时文本不变
+                if (!m_buffer.Insert(pos + len, rbuf, rcount)) break;
+                this->record_replace(pos, len, rbuf, rcount);
+                m_buffer.Remove(pos, len);
+                // 行索引逐个更新
+                if (!m_lines.Update(m_buffer, pos, len, rcount)) hr = E_OUTOFMEMORY;
+                ++replaced;
+            }
+            m_undo.EndGroup();
+        });
+        if (!replaced) {
+            LongUI::BeepError();
+            return 0;
+        }
+        // 第一个到最后一个替换之间, 高亮与布局一次更新
+        const auto begin = matches[count - replaced];
+        const auto removed = matches.back() + len - begin;
+        const auto inserted = removed - replaced * len + replaced * rcount;
+        {
+            CUIDxgiAutoLocker locker;
+            m_bTxtChanged = true;
+            ++m_uLayoutVersion;
+            uint32_t hbegin, hend;
+            if (!m_highlighter.Update(m_buffer, m_lines, begin, removed, inserted, hbegin, hend)) hr = E_OUTOFMEMORY;
+            // 延迟布局, 之后每帧布局一部分
+            const auto hr2 = m_layout.Defer(m_buffer, begin, removed, inserted);
+            if (SUCCEEDED(hr)) hr = hr2;
+            m_layout.Restyle(hbegin, hend);
+            m_uPendingTotal = std::max(m_uPendingTotal, m_layout.GetPending());
+        }
+        assert(SUCCEEDED(hr)); UNREFERENCED_PARAMETER(hr);
+        m_pHost->StartRender(0.f);
+        this->SetSelection(SelectionMode::Mode_Leading, begin, false);
+        this->refresh();
+        return replaced;
+    }
+    // 设置语法高亮的分词器, 样式0使用文本颜色, 富文本与密码无效
+    void EditableText::SetTokenizer(XUITokenizer* tokenizer, const D2D1_COLOR_F* colors, uint32_t count) noexcept {
+        if (this->IsRiched() || this->IsPassword()) tokenizer = nullptr;
+        for (auto& effect : m_vStyleEffects) LongUI::SafeRelease(effect);
+        m_vStyleEffects.clear();
+        // 每种样式一个颜色效果
+        if (tokenizer && colors) {
+            m_vStyleEffects.resize(count);
+            for (uint32_t i = 1; i < m_vStyleEffects.size(); ++i) {
+                m_vStyleEffects[i] = CUIColorEffect::Create(colors[i]);
+            }
+        }
+        m_highlighter.SetTokenizer(tokenizer);
+        m_layout.SetStyles(
+            tokenizer ? &m_highlighter.RefRuns() : nullptr,
+            m_vStyleEffects.data(), m_vStyleEffects.size()
+        );
+        // 已经初始化
+        if (m_layout.IsOk()) {
+            this->recreate_layout();
+            this->refresh();
+        }
+    }
     // 删除选择区文字
     auto EditableText::DeleteSelection() noexcept -> HRESULT {
         DWRITE_TEXT_RANGE selection = this->GetSelectionRange();
         if (selection.length == 0 || this->IsReadOnly()) return S_FALSE;
         // 删除成功的话设置选择区
         if (this->remove_text(selection.startPosition, selection.length)) {
-            return this->SetSelection(Mode_Leading, selection.startPosition, false);
+            return this->edit_selection(Mode_Leading, selection.startPosition);
         }
         else {
             return S_FALSE;
@@ -790,11 +1774,13 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     }
     // 设置选择区
     bool EditableText::SetSelectionFromPoint(float x, float y, bool exsel) noexcept {
+        // 点击之后的输入不再合并
+        m_undo.Seal();
         BOOL isTrailingHit;
         BOOL isInside;
         DWRITE_HIT_TEST_METRICS caret_metrics;
         // 获取当前点击位置
-        m_pLayout->HitTestPoint(
+        m_layout.HitTestPoint(
             x, y,
             &isTrailingHit,
             &isInside,
@@ -837,7 +1823,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             BOOL trailin, inside;
             DWRITE_HIT_TEST_METRICS caret_metrics;
             // 获取当前点击位置
-            m_pLayout->HitTestPoint(x, y, &trailin, &inside, &caret_metrics);
+            m_layout.HitTestPoint(x, y, &trailin, &inside, &caret_metrics);
             bool inzone = caret_metrics.textPosition >= range.startPosition &&
                 caret_metrics.textPosition < range.startPosition + range.length;
             if (inzone) return false;
@@ -858,6 +1844,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     // 重建
     void EditableText::Recreate() noexcept {
         // 重新创建资源
+        LongUI::SafeRelease(m_pTextCache);
         LongUI::SafeRelease(m_pSelectionColor);
         UIManager_RenderTarget->CreateSolidColorBrush(
             D2D1::ColorF(D2D1::ColorF::LightSkyBlue),
@@ -879,7 +1866,8 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                 LongUI::BeepError();
                 return;
             }
-            // 删除选择区字符串
+            // 删除选择区字符串, 与输入合并为一次撤销
+            if (m_u32CaretPos + m_u32CaretPosOffset != m_u32CaretAnchor) m_undo.MarkReplace();
             this->delete_selandrelay();
             // 长度
             uint32_t length = 1;
@@ -898,9 +1886,9 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             }
     #endif
             // 插入
-            this->insert(m_u32CaretPos + m_u32CaretPosOffset, chars, length);
+            this->insert(m_u32CaretPos + m_u32CaretPosOffset, chars, length, true);
             // 设置选择区
-            this->SetSelection(SelectionMode::Mode_Right, length, false, false);
+            this->edit_selection(SelectionMode::Mode_Right, length, false);
             // 刷新
             this->refresh(true);
         }
@@ -912,11 +1900,9 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         // 有效删除范围
         if (!range.length) return;
         // 保留旧布局
-        auto old = LongUI::SafeAcquire(m_pLayout);
+        auto old = LongUI::SafeAcquire(m_layout.RefSingleLayout());
         // 删除选择区
         this->DeleteSelection();
-        // 重建布局
-        this->recreate_layout();
         // 复制内容
         this->copy_remove(old, range);
         // 释放
@@ -960,13 +1946,12 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             }
             else if (absolutePosition > 0) {
                 // 保留旧布局
-                auto old = LongUI::SafeAcquire(m_pLayout);
+                auto old = LongUI::SafeAcquire(m_layout.RefSingleLayout());
                 uint32_t count = 1;
                 // 双字特别处理
-                if (absolutePosition >= 2 && absolutePosition <= m_string.size()) {
-                    auto* base = m_string.data() + absolutePosition;
-                    auto ch1 = base[-2];
-                    auto ch2 = base[-1];
+                if (absolutePosition >= 2 && absolutePosition <= m_buffer.GetLength()) {
+                    auto ch1 = m_buffer[absolutePosition - 2];
+                    auto ch2 = m_buffer[absolutePosition - 1];
                     // 1.CR/LF
                     bool case1 = ch1 == L'\r' && ch2 == L'\n';
                     // 2.Surrogate
@@ -980,10 +1965,9 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                     count = (case1 || case2) ? 2 : 1;
                 }
                 // 左移
-                this->SetSelection(SelectionMode::Mode_LeftChar, count, false);
+                this->edit_selection(SelectionMode::Mode_LeftChar, count);
                 // 字符串: 删除count个字符
-                if (this->remove_text(m_u32CaretPos, count)) {
-                    this->recreate_layout();
+                if (this->remove_text(m_u32CaretPos, count, true)) {
                     this->copy_remove(old, DWRITE_TEXT_RANGE{ m_u32CaretPos, count });
                 }
                 LongUI::SafeRelease(old);
@@ -1000,11 +1984,11 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             // 删除下一个的字符
             else {
                 // 保留旧布局
-                auto old = LongUI::SafeAcquire(m_pLayout);
+                auto old = LongUI::SafeAcquire(m_layout.RefSingleLayout());
                 DWRITE_HIT_TEST_METRICS hitTestMetrics;
                 float caretX, caretY;
                 // 获取集群大小
-                m_pLayout->HitTestTextPosition(
+                m_layout.HitTestTextPosition(
                     absolutePosition,
                     false,
                     &caretX,
@@ -1012,20 +1996,18 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                     &hitTestMetrics
                     );
                 // CR-LF?
-                if (hitTestMetrics.textPosition + 2 < m_string.length()) {
-                    auto* base = m_string.data() + hitTestMetrics.textPosition;
-                    auto ch1 = base[0];
-                    auto ch2 = base[1];
+                if (hitTestMetrics.textPosition + 2 < m_buffer.GetLength()) {
+                    auto ch1 = m_buffer[hitTestMetrics.textPosition];
+                    auto ch2 = m_buffer[hitTestMetrics.textPosition + 1];
                     // 1.CR/LF
                     if (ch1 == L'\r' && ch2 == L'\n') {
                         ++hitTestMetrics.length;
                     }
                 }
                 // 修改
-                this->SetSelection(SelectionMode::Mode_Leading, hitTestMetrics.textPosition, false);
+                this->edit_selection(SelectionMode::Mode_Leading, hitTestMetrics.textPosition);
                 // 删除字符
-                if (this->remove_text(hitTestMetrics.textPosition, hitTestMetrics.length)) {
-                    this->recreate_layout();
+                if (this->remove_text(hitTestMetrics.textPosition, hitTestMetrics.length, true)) {
                     this->copy_remove(old, 
                         DWRITE_TEXT_RANGE{ hitTestMetrics.textPosition, hitTestMetrics.length }
                     );
@@ -1066,6 +2048,18 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                 this->SetNumber(this->GetNumber() - 1);
             }
             break;
+        case VK_PRIOR:
+            // 多行模式: 上移一页
+            if (this->IsMultiLine()) {
+                this->SetSelection(SelectionMode::Mode_PageUp, 1, heldShift);
+            }
+            break;
+        case VK_NEXT:
+            // 多行模式: 下移一页
+            if (this->IsMultiLine()) {
+                this->SetSelection(SelectionMode::Mode_PageDown, 1, heldShift);
+            }
+            break;
         case VK_HOME:
             // HOME键
             this->SetSelection(heldControl ? SelectionMode::Mode_First : SelectionMode::Mode_Home, 0, heldShift);
@@ -1101,10 +2095,15 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                 this->SetSelection(SelectionMode::Mode_SelectAll, 0, true);
             break;
         case 'Z':
-            // 撤销
+            // 'Z'键 Ctrl+Z 撤销, Ctrl+Shift+Z 重做
+            if (heldControl) {
+                if (heldShift) this->Redo();
+                else this->Undo();
+            }
             break;
         case 'Y':
-            // 重做
+            // 'Y'键 Ctrl+Y 重做
+            if (heldControl) this->Redo();
             break;
         default:
             break;
@@ -1125,12 +2124,14 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         }
         // 隐藏插入符号
         m_pHost->GetWindow()->HideCaret(m_pHost);
+        // 失去焦点后的输入不再合并
+        m_undo.Seal();
         // 文本修改事件
         if (m_bTxtChanged) {
 #ifdef _DEBUG
             UIManager << DL_Log
                 << L"Text Changed: "
-                << m_string
+                << m_buffer.c_str()
                 << LongUI::endl;
 #endif
             m_pHost->CallUiEvent(m_evChanged, SubEvent::Event_ValueChanged);
@@ -1164,7 +2165,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             BOOL trailin, inside;
             DWRITE_HIT_TEST_METRICS caret_metrics;
             // 获取当前点击位置
-            m_pLayout->HitTestPoint(x, y, &trailin, &inside, &caret_metrics);
+            m_layout.HitTestPoint(x, y, &trailin, &inside, &caret_metrics);
             m_bClickInSelection = caret_metrics.textPosition >= range.startPosition &&
                 caret_metrics.textPosition < range.startPosition + range.length;
         }
@@ -1273,7 +2274,6 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
                     }
                     // 删除
                     if (this->remove_text(m_dragRange.startPosition, m_dragRange.length)) {
-                        this->recreate_layout();
                         this->SetSelection(Mode_Left, 1, false);
                         this->SetSelection(Mode_Right, 1, false);
                     }
@@ -1292,9 +2292,9 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     void EditableText::AlignCaretToNearestCluster(bool hit, bool skip) noexcept {
         DWRITE_HIT_TEST_METRICS hitTestMetrics;
         float caretX, caretY;
-        assert(m_pLayout);
+        assert(m_layout.IsOk());
         // 对齐最近字符集
-        m_pLayout->HitTestTextPosition(
+        m_layout.HitTestTextPosition(
             m_u32CaretPos,
             false,
             &caretX,
@@ -1316,16 +2316,21 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     /// <param name="rect">The rect.</param>
     /// <returns></returns>
     void EditableText::GetTextBox(RectLTWH_F& rect) const noexcept {
-        impl::get_text_box(m_pLayout, rect);
+        DWRITE_TEXT_METRICS tm;
+        m_layout.GetMetrics(&tm);
+        rect.left = tm.left;
+        rect.top = tm.top;
+        rect.width = tm.widthIncludingTrailingWhitespace;
+        rect.height = tm.height;
     }
     // 获取插入符号矩形
     void EditableText::GetCaretRect(RectLTWH_F& rect) const noexcept {
         // 检查布局
-        if (m_pLayout) {
+        if (m_layout.IsOk()) {
             // 获取 f(文本偏移) -> 坐标
             DWRITE_HIT_TEST_METRICS caretMetrics;
             float caretX, caretY;
-            m_pLayout->HitTestTextPosition(
+            m_layout.HitTestTextPosition(
                 m_u32CaretPos,
                 m_u32CaretPosOffset > 0,
                 &caretX,
@@ -1336,7 +2341,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             DWRITE_TEXT_RANGE selectionRange = this->GetSelectionRange();
             if (selectionRange.length > 0) {
                 UINT32 actualHitTestCount = 1;
-                m_pLayout->HitTestTextRange(
+                m_layout.HitTestTextRange(
                     m_u32CaretPos,
                     0,      // length
                     0.f,    // x
@@ -1361,16 +2366,22 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     }
     // 刷新
     void EditableText::Update() noexcept {
+        // 延迟的布局
+        if (m_layout.GetPending()) this->continue_layout();
         this->refresh(false);
         // 检查选择区
         this->RefreshSelectionMetrics(this->GetSelectionRange());
+        this->invalidate_selection();
+        // 文本缓存
+        this->record_cache();
     }
     // 设置字符串
     void EditableText::SetString(const wchar_t* str) noexcept {
         if (this->IsReadOnly()) return;
         // 不同再修改
-        if (m_string != str) {
-            m_string = str;
+        if (std::wcscmp(m_buffer.c_str(), str)) {
+            m_buffer.Set(str, static_cast<uint32_t>(std::wcslen(str)));
+            m_undo.Clear();
             this->recreate_layout();
             m_u32CaretPos = 0;
             m_u32CaretAnchor = 0;
@@ -1383,19 +2394,22 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         if (this->IsReadOnly()) return;
         i = std::min(m_iMax, i);
         i = std::max(m_iMin, i);
-        m_string.Format(L"%d", int(i));
+        CUIString text;
+        text.Format(L"%d", int(i));
+        m_buffer.Set(text.c_str(), text.length());
+        m_undo.Clear();
         this->recreate_layout();
         this->SetSelection(SelectionMode::Mode_End, 0, false, false);
         this->refresh(true);
     }
     // 读取数值
     auto EditableText::GetNumber() const noexcept -> int32_t {
-        return LongUI::AtoI(m_string.c_str());
+        return LongUI::AtoI(m_buffer.c_str());
     }
     // 渲染
     void EditableText::Render(ID2D1DeviceContext* target, D2D1_POINT_2F pt) const noexcept {
         assert(target && "bad argument");
-        if (!m_pLayout) return;
+        if (!m_layout.IsOk()) return;
         float x = this->offset.x + pt.x;
         float y = this->offset.y + pt.y;
     #ifdef _DEBUG
@@ -1421,13 +2435,149 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             }
             UIManager_RenderTarget->SetAntialiasMode(D2D1_ANTIALIAS_MODE_PER_PRIMITIVE);
         }
+        // 文本未变: 复制缓存
+        if (this->is_cache_valid()) {
+            const auto size = m_pTextCache->GetSize();
+            const D2D1_RECT_F rect = { pt.x, pt.y, pt.x + size.width, pt.y + size.height };
+            target->DrawBitmap(m_pTextCache, &rect, 1.f, D2D1_BITMAP_INTERPOLATION_MODE_NEAREST_NEIGHBOR);
+            return;
+        }
         // 刻画文本
+        this->draw_text(target, x, y);
+    }
+    /// <summary>
+    /// Draws visible paragraphs of text layout.
+    /// </summary>
+    /// <param name="target">The target.</param>
+    /// <param name="x">The x.</param>
+    /// <param name="y">The y.</param>
+    /// <returns></returns>
+    void EditableText::draw_text(ID2D1DeviceContext* target, float x, float y) const noexcept {
         m_pTextRenderer->target = target;
         m_pTextRenderer->basic_color.color = *m_pColor;
         IDWriteTextRenderer1* pTextRenderer = m_pTextRenderer;
-        m_pLayout->Draw(m_pTextContext, pTextRenderer, x, y);
+        // 仅刻画可见的段落
+        m_layout.Draw(m_pTextContext, pTextRenderer, x, y, -this->offset.y, m_size.height - this->offset.y);
         m_pTextRenderer->target = nullptr;
     }
+    /// <summary>
+    /// Determines whether cached text bitmap is same as text layout.
+    /// </summary>
+    /// <returns></returns>
+    bool EditableText::is_cache_valid() const noexcept {
+        return m_pTextCache && m_uCacheVersion == m_uLayoutVersion
+            && m_ptCache.x == this->offset.x && m_ptCache.y == this->offset.y
+            && m_szCache.width == m_size.width && m_szCache.height == m_size.height
+            && m_szCacheScale.width == m_pHost->world._11 && m_szCacheScale.height == m_pHost->world._22
+            && !std::memcmp(&m_colorCache, m_pColor, sizeof(m_colorCache));
+    }
+    /// <summary>
+    /// Records text into cached bitmap if changed, so caret blink
+    /// and selection change only cost one bitmap copy. Riched text
+    /// is never cached for layout may be changed outside. ClearType
+    /// needs opaque background to blend with, so text is only cached
+    /// when window uses grayscale or aliased text antialiasing.
+    /// </summary>
+    /// <returns></returns>
+    void EditableText::record_cache() noexcept {
+        if (this->IsRiched() || !m_layout.IsOk() || !m_pTextRenderer) return;
+        // 默认模式一般为ClearType, 不能画在透明位图上
+        const auto mode = m_pHost->GetWindow()->GetTextAntimode();
+        if (mode != D2D1_TEXT_ANTIALIAS_MODE_GRAYSCALE && mode != D2D1_TEXT_ANTIALIAS_MODE_ALIASED) {
+            LongUI::SafeRelease(m_pTextCache);
+            return;
+        }
+        // 像素大小, 与世界变换缩放一致
+        const auto sx = m_pHost->world._11, sy = m_pHost->world._22;
+        const D2D1_SIZE_U pixel = {
+            static_cast<uint32_t>(std::ceil(m_size.width * sx)),
+            static_cast<uint32_t>(std::ceil(m_size.height * sy))
+        };
+        if (!pixel.width || !pixel.height || sx <= 0.f || sy <= 0.f) return;
+        if (this->is_cache_valid()) return;
+        CUIDxgiAutoLocker locker;
+        const auto target = UIManager_RenderTarget;
+        HRESULT hr = S_OK;
+        // 重建位图
+        if (m_pTextCache) {
+            const auto now = m_pTextCache->GetPixelSize();
+            if (now.width != pixel.width || now.height != pixel.height) LongUI::SafeRelease(m_pTextCache);
+        }
+        if (!m_pTextCache) {
+            const auto prop = D2D1::BitmapProperties1(
+                D2D1_BITMAP_OPTIONS_TARGET,
+                D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED),
+                LongUI::BASIC_DPI * sx, LongUI::BASIC_DPI * sy
+            );
+            hr = target->CreateBitmap(pixel, nullptr, 0, &prop, &m_pTextCache);
+        }
+        // 记录文本
+        if (SUCCEEDED(hr)) {
+            ID2D1Image* old = nullptr;
+            target->GetTarget(&old);
+            target->SetTarget(m_pTextCache);
+            target->BeginDraw();
+            target->SetTransform(DX::Matrix3x2F::Identity());
+            target->Clear(D2D1::ColorF(0x000000, 0.f));
+            // 与窗口相同的模式
+            target->SetTextAntialiasMode(mode);
+            this->draw_text(target, this->offset.x, this->offset.y);
+            hr = target->EndDraw();
+            target->SetTarget(old);
+            LongUI::SafeRelease(old);
+        }
+        // 记录状态
+        if (SUCCEEDED(hr)) {
+            m_ptCache = this->offset;
+            m_szCache = m_size;
+            m_szCacheScale = D2D1_SIZE_F{ sx, sy };
+            m_colorCache = *m_pColor;
+            m_uCacheVersion = m_uLayoutVersion;
+        }
+        else LongUI::SafeRelease(m_pTextCache);
+    }
+    /// <summary>
+    /// Renders old and new selection only if selection changed.
+    /// </summary>
+    /// <returns></returns>
+    void EditableText::invalidate_selection() noexcept {
+        // 选择区的包围盒
+        D2D1_RECT_F rect = { 0.f };
+        if (m_bufMetrice.GetCount()) {
+            const auto& first = m_bufMetrice[0];
+            rect.left = rect.right = first.left + this->offset.x;
+            rect.top = rect.bottom = first.top + this->offset.y;
+            for (const auto& htm : m_bufMetrice) {
+                rect.left = std::min(rect.left, htm.left + this->offset.x);
+                rect.top = std::min(rect.top, htm.top + this->offset.y);
+                rect.right = std::max(rect.right, htm.left + htm.width + this->offset.x);
+                rect.bottom = std::max(rect.bottom, htm.top + htm.height + this->offset.y);
+            }
+        }
+        if (!std::memcmp(&rect, &m_rcSelection, sizeof(rect))) return;
+        // 新旧选择区的并集
+        auto dirty = rect;
+        if (m_rcSelection.right > m_rcSelection.left) {
+            if (rect.right > rect.left) {
+                dirty.left = std::min(rect.left, m_rcSelection.left);
+                dirty.top = std::min(rect.top, m_rcSelection.top);
+                dirty.right = std::max(rect.right, m_rcSelection.right);
+                dirty.bottom = std::max(rect.bottom, m_rcSelection.bottom);
+            }
+            else dirty = m_rcSelection;
+        }
+        m_rcSelection = rect;
+        if (!(dirty.right > dirty.left)) return;
+        // 转换到窗口空间
+        const auto lt = LongUI::TransformPoint(m_pHost->world, D2D1_POINT_2F{ dirty.left, dirty.top });
+        const auto rb = LongUI::TransformPoint(m_pHost->world, D2D1_POINT_2F{ dirty.right, dirty.bottom });
+        RectLTRB_F window;
+        window.left = std::floor(std::min(lt.x, rb.x));
+        window.top = std::floor(std::min(lt.y, rb.y));
+        window.right = std::ceil(std::max(lt.x, rb.x));
+        window.bottom = std::ceil(std::max(lt.y, rb.y));
+        m_pHost->GetWindow()->InvalidateRect(m_pHost, window);
+    }
     // 复制到 目标全局句柄
     auto EditableText::CopyToGlobal() noexcept -> HGLOBAL {
         // 获取选择区
@@ -1435,16 +2585,19 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         // 有选择区域
         if (selection.length) {
             // 断言检查
-            assert(selection.startPosition < m_string.length() && "bad selection range");
-            assert((selection.startPosition + selection.length) <= m_string.length() && "bad selection range");
+            assert(selection.startPosition < m_buffer.GetLength() && "bad selection range");
+            assert((selection.startPosition + selection.length) <= m_buffer.GetLength() && "bad selection range");
             // 获取富文本数据
             if (this->IsRiched()) {
                 // TODO: 富文本
             }
-            // 全局申请
-            auto str = m_string.c_str() + selection.startPosition;
-            auto len = static_cast<size_t>(selection.length);
-            return Helper::GlobalAllocString(str, len);
+            // 全局申请: 只复制选择区文本
+            HGLOBAL global = nullptr;
+            LongUI::SafeBuffer<wchar_t>(selection.length, [&global, &selection, this](wchar_t* buf) noexcept {
+                auto len = m_buffer.Copy(selection.startPosition, selection.length, buf);
+                global = Helper::GlobalAllocString(buf, static_cast<size_t>(len));
+            });
+            return global;
         }
         // TODO: 复制选中行
         return nullptr;
@@ -1493,8 +2646,14 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
             const wchar_t* text = reinterpret_cast<const wchar_t*>(memory);
             // 计算长度
             auto characterCount = static_cast<UINT32>(std::min(std::wcslen(text), byteSize / sizeof(wchar_t)));
-            // 插入
-            hr = this->insert(m_u32CaretPos + m_u32CaretPosOffset, text, characterCount);
+            // 插入, 大量文本分块插入并延迟布局
+            const auto pos = m_u32CaretPos + m_u32CaretPosOffset;
+            if (characterCount > LongUIStreamPasteThreshold && !this->IsRiched()) {
+                hr = this->insert_stream(pos, text, characterCount);
+            }
+            else {
+                hr = this->insert(pos, text, characterCount);
+            }
             ::GlobalUnlock(global);
             // 移动
             this->SetSelection(SelectionMode::Mode_RightChar, characterCount, true);
@@ -1556,6 +2715,8 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     /// <returns></returns>
     void EditableText::RefreshSelectionMetrics(DWRITE_TEXT_RANGE selection) noexcept {
         //UIManager << DL_Hint << "selection.length: " << long(selection.length) << LongUI::endl;
+        // 渲染线程读取选择区块
+        CUIDxgiAutoLocker locker;
         // 有选择的情况下
         if (selection.length == 0) {
             m_bufMetrice.NewSize(0);
@@ -1563,7 +2724,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         };
         // 检查选择的区块数量
         uint32_t actualHitTestCount = 0;
-        m_pLayout->HitTestTextRange(
+        m_layout.HitTestTextRange(
             selection.startPosition,
             selection.length,
             0.f, // x
@@ -1576,7 +2737,7 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         m_bufMetrice.NewSize(actualHitTestCount);
         if (!actualHitTestCount) return;
         // 正式获取
-        m_pLayout->HitTestTextRange(
+        m_layout.HitTestTextRange(
             selection.startPosition,
             selection.length,
             0.f, // x
@@ -1593,7 +2754,9 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
     /// <returns></returns>
     EditableText::~EditableText() noexcept {
         ::ReleaseStgMedium(&m_recentMedium);
-        LongUI::SafeRelease(m_pLayout);
+        m_layout.Release();
+        for (auto& effect : m_vStyleEffects) LongUI::SafeRelease(effect);
+        LongUI::SafeRelease(m_pTextCache);
         LongUI::SafeRelease(m_pTextRenderer);
         LongUI::SafeRelease(m_pSelectionColor);
         //LongUI::SafeRelease(m_pDropSource);
@@ -1721,6 +2884,10 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         if ((str = attribute("offsety"))) {
             this->offset.y = LongUI::AtoF(str);
         }
+        // 撤销历史预算
+        if ((str = attribute("undobudget"))) {
+            m_undo.SetBudget(static_cast<uint32_t>(LongUI::AtoI(str)));
+        }
         // 最大输入长度
         if ((str = attribute("maxlength"))) {
             auto tmp = static_cast<uint32_t>(LongUI::AtoI(str));
@@ -1761,16 +2928,35 @@ LONGUI_NAMESPACE_BEGIN namespace Component {
         // 获取文本
         {
             str = node.attribute(prefix).value();
-            assert(m_string.length() == 0 && m_string.data()[0] == 0);
-            m_string.FromUtf8(str);
+            assert(m_buffer.GetLength() == 0);
+            CUIString text;
+            text.FromUtf8(str);
 #ifdef _DEBUG
             if (this->IsPassword()) {
-                for (auto ch : m_string) {
+                for (auto ch : text) {
                     assert(!LongUI::IsSurrogate(ch) && "text cannot over 0xFFFF if password");
                 }
             }
 #endif
-            this->ensure_string(m_string);
+            this->ensure_string(text);
+            m_buffer.Set(text.c_str(), text.length());
+        }
+        // 语法高亮
+        if ((str = attribute("syntax")) && !std::strcmp(str, "xml")) {
+            static CUIXmlTokenizer s_xml;
+            static const D2D1_COLOR_F s_colors[CUIXmlTokenizer::STYLE_COUNT] = {
+                D2D1::ColorF(0x000000),     // 文本(使用文本颜色)
+                D2D1::ColorF(0x0000FF),     // 分隔符
+                D2D1::ColorF(0xA31515),     // 元素名
+                D2D1::ColorF(0xFF0000),     // 属性名
+                D2D1::ColorF(0x0000FF),     // 属性值
+                D2D1::ColorF(0x008000),     // 注释
+                D2D1::ColorF(0x808080),     // CDATA
+                D2D1::ColorF(0x8B008B),     // 实体引用
+                D2D1::ColorF(0x2B91AF),     // 处理指令
+                D2D1::ColorF(0x2B91AF),     // 声明
+            };
+            this->SetTokenizer(&s_xml, s_colors, CUIXmlTokenizer::STYLE_COUNT);
         }
         // 创建布局
         this->recreate_layout(fmt);
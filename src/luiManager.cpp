@@ -70,11 +70,13 @@ auto LongUI::CUIManager::Initialize(IUIConfigure* config) noexcept ->HRESULT {
     m_vDelayCleanup.reserve(16);
     m_vDelayDispose.reserve(16);
     m_vWindows.reserve(16);
+    m_vRenderWindows.reserve(16);
     m_vTimeCapsules.reserve(32);
     // 内存不足
     if (!m_vDelayCleanup.isok() 
         || !m_vWindows.isok() 
         || !m_vDelayDispose.isok()
+        || !m_vRenderWindows.isok()
         || !m_vTimeCapsules.isok()
         ) {
         return E_OUTOFMEMORY;
@@ -83,6 +85,7 @@ auto LongUI::CUIManager::Initialize(IUIConfigure* config) noexcept ->HRESULT {
     m_szLocaleName[0] = L'\0';
     m_vDelayCleanup.clear();
     m_vWindows.clear();
+    m_vRenderWindows.clear();
     m_vDelayDispose.clear();
     // 开始计时
     m_uiTimeMeter.Start();
@@ -669,106 +672,257 @@ namespace LongUI { namespace impl { void dbg_cal_fps() { } }}
 #endif
 
 
+/// <summary>
+/// Updates all windows in one frame.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIManager::update_frame() noexcept {
+    // 数据锁
+    CUIDataAutoLocker locker;
+#ifdef _DEBUG
+    ++this->frame_id;
+#endif
+    // 更新计时器
+    m_fDeltaTime = m_uiTimeMeter.Delta_s<float>();
+    m_uiTimeMeter.MovStartEnd();
+    auto old = m_cNowTick;
+    auto now = ::timeGetTime(); m_cNowTick = now;
+    // 大概每隔2分钟, 刷新一次
+    constexpr uint32_t REFRESH_RATE = 1024 * 128 - 1;
+    constexpr uint32_t REFRESH_MASK = ~REFRESH_RATE;
+    if ((old & REFRESH_MASK) != (now & REFRESH_MASK) ) {
+        m_uiTimeMeter.RefreshFrequency();
+#ifdef _DEBUG
+        UIManager << DL_Log
+            << L"m_uiTimeMeter.RefreshFrequency"
+            << LongUI::endl;
+#endif
+    }
+    // 流水线渲染: 渲染线程只读取帧快照, 刷新与上一帧的渲染并行
+    // 更新时间胶囊
+    auto phase = this->phase_begin();
+    this->update_time_capsules(m_fDeltaTime);
+    this->phase_end(Phase_TimeCapsule, phase);
+    // 刷新窗口
+    for (auto window : m_vWindows) {
+        phase = this->phase_begin();
+        window->Update();
+        this->phase_end(Phase_WindowUpdate, phase);
+    }
+    // 更新输入
+    phase = this->phase_begin();
+    m_uiInput.AfterUpdate();
+    this->phase_end(Phase_InputUpdate, phase);
+    // 空闲检查
+    if (m_hWakeUp) this->check_idle();
+}
+
+/// <summary>
+/// Checks if all windows are idle, called in data lock.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIManager::check_idle() noexcept {
+    // 时间胶囊每帧都需要刷新
+    if (!m_vTimeCapsules.empty()) return;
+    // 取最近的定时时间
+    uint32_t timeout = INFINITE;
+    for (auto window : m_vWindows) {
+        timeout = std::min(timeout, window->GetIdleTime());
+        if (!timeout) return;
+    }
+    // 在数据锁内标记, 之后的刷新请求都会唤醒帧线程
+    m_dwIdleTimeout = timeout;
+    m_bIdleSleeping = true;
+}
+
+/// <summary>
+/// Sleeps until woken up or timeout.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIManager::idle_sleep() noexcept {
+    ++m_cSleepCount;
+    // 等待唤醒
+    if (::WaitForSingleObject(m_hWakeUp, m_dwIdleTimeout) == WAIT_OBJECT_0) {
+        ++m_cWakeCount;
+    }
+    // 超时唤醒
+    m_bIdleSleeping = false;
+    // 忽略睡眠时间, 防止动画跳变
+    m_uiTimeMeter.Start();
+    m_oPacer.Reset();
+}
+
+/// <summary>
+/// Publishes the frame built in last update to render.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIManager::publish_frame() noexcept {
+    // 数据锁
+    CUIDataAutoLocker locker;
+    // 没有正在渲染的帧
+    m_bRenderInFlight = false;
+    // 延迟清理
+    const auto phase = this->phase_begin();
+    this->cleanup_delay_cleanup_chain();
+    this->phase_end(Phase_DelayCleanup, phase);
+    // 提交帧快照, 只在交换时持有渲染锁
+    {
+        CUIDxgiAutoLocker dxgi;
+        for (auto window : m_vWindows) {
+            window->PublishFrame();
+        }
+        m_vRenderWindows.clear();
+        for (auto window : m_vWindows) {
+            m_vRenderWindows.push_back(window);
+        }
+    }
+    // 之后释放的控件需要延迟清理
+    m_bRenderInFlight = true;
+#ifdef _DEBUG
+    // 计算平均FPS
+    auto& fpsc = m_vFpsCalculator;
+    fpsc.push_back(m_fDeltaTime);
+    size_t frame = size_t(m_dDisplayFrequency / 2);
+    // 固定时间刷新一次
+    if (fpsc.size() >= size_t(frame)) {
+        float time = 0.f;
+        for (auto t : fpsc) time += t;
+        time /= float(frame);
+        wchar_t buffer[1024];
+        std::swprintf(
+            buffer, lengthof(buffer),
+            L"delta: %.2fms -- %2.2f fps",
+            time * 1000.f, 1.f / time
+        );
+        auto hwnd = m_hToolWnd;
+        this->DataUnlock();
+        ::SetWindowTextW(hwnd, buffer);
+        this->DataLock();
+        fpsc.clear();
+    }
+#endif
+}
+
+/// <summary>
+/// Renders all windows with published frame.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIManager::render_frame() noexcept {
+    // 渲染锁
+    CUIDxgiAutoLocker locker;
+    // 等待交换链, 不计入渲染时间
+    for (auto window : m_vRenderWindows) {
+        window->WaitForRender();
+    }
+    // 渲染窗口
+    const auto phase = this->phase_begin();
+    for (auto window : m_vRenderWindows) {
+        window->Render();
+    }
+    this->phase_end(Phase_Render, phase);
+}
+
+/// <summary>
+/// Ends timing the frame phase.
+/// </summary>
+/// <param name="p">The phase.</param>
+/// <param name="begin">The begin tick.</param>
+/// <returns></returns>
+void LongUI::CUIManager::phase_end(FramePhase p, int64_t begin) noexcept {
+    const auto tick = this->phase_begin() - begin;
+    const auto mcs = tick * 1000000 / m_i64PhaseFreq;
+    m_aPhaseTime[p].Record(mcs > 0 ? uint32_t(std::min(mcs, int64_t(UINT32_MAX))) : 0);
+}
+
 /// <summary>
 /// Runs this instance.
 /// </summary>
 /// <returns></returns>
 void LongUI::CUIManager::Run() noexcept {
     // 开始!
-    m_dwWaitVSStartTime = ::timeGetTime();
     UIManager.m_uiTimeMeter.RefreshFrequency();
-    // 渲染线程函数
-    auto render_thread_func = [](void*) noexcept ->unsigned {
+    {
+        LARGE_INTEGER freq; ::QueryPerformanceFrequency(&freq);
+        m_i64PhaseFreq = freq.QuadPart;
+    }
+    m_oPacer.SetTargetRate(m_uTargetFrameRate ? m_uTargetFrameRate : m_dDisplayFrequency);
+    m_oPacer.Start();
+    // 流水线渲染: 更新下一帧的同时渲染上一帧
+    const bool pipelined = !!(this->flag & IUIConfigure::Flag_PipelinedRendering);
+    if (pipelined) {
+        m_hRenderReady = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        m_hRenderDone = ::CreateEventW(nullptr, FALSE, TRUE, nullptr);
+        assert(m_hRenderReady && m_hRenderDone && "failed to create event");
+    }
+    // 空闲时休眠: 等待刷新请求唤醒
+    if (this->flag & IUIConfigure::Flag_IdleWhenNoChange) {
+        m_hWakeUp = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        assert(m_hWakeUp && "failed to create event");
+    }
+    // 帧线程函数
+    auto frame_thread_func = [](void*) noexcept ->unsigned {
         // 更新
         UIManager.m_cStartTick = UIManager.m_cNowTick = ::timeGetTime();
+        const bool pipelined = !!UIManager.m_hRenderReady;
         // 循环
         while (true) {
-            // 刷新
-            {
-                // 数据锁
-                CUIDataAutoLocker locker;
-#ifdef _DEBUG
-                ++UIManager.frame_id;
-#endif
-                // 更新计时器
-                UIManager.m_fDeltaTime = UIManager.m_uiTimeMeter.Delta_s<float>();
-                UIManager.m_uiTimeMeter.MovStartEnd();
-                auto old = UIManager.m_cNowTick;
-                auto now = ::timeGetTime(); UIManager.m_cNowTick = now;
-                // 大概每隔2分钟, 刷新一次
-                constexpr uint32_t REFRESH_RATE = 1024 * 128 - 1;
-                constexpr uint32_t REFRESH_MASK = ~REFRESH_RATE;
-                if ((old & REFRESH_MASK) != (now & REFRESH_MASK) ) {
-                    UIManager.m_uiTimeMeter.RefreshFrequency();
-#ifdef _DEBUG
-                    UIManager << DL_Log
-                        << L"m_uiTimeMeter.RefreshFrequency"
-                        << LongUI::endl;
-#endif
-                }
-                // 更新时间胶囊
-                UIManager.update_time_capsules(UIManager.m_fDeltaTime);
-                // 刷新窗口
-                for (auto window : UIManager.m_vWindows) {
-                    window->Update();
-                }
-                // 更新输入
-                UIManager.m_uiInput.AfterUpdate();
+            // 刷新: 流水线下与上一帧的渲染并行
+            UIManager.update_frame();
+            // 流水线渲染
+            if (pipelined) {
+                // 等待上一帧渲染完毕
+                ::WaitForSingleObject(UIManager.m_hRenderDone, INFINITE);
+                UIManager.publish_frame();
+                ::SetEvent(UIManager.m_hRenderReady);
             }
-            // 渲染
-            {
-                // 渲染锁
-                CUIDxgiAutoLocker locker;
-                // 渲染窗口
-                for (auto window : UIManager.m_vWindows) {
-                    window->Render();
-                }
-            }
-            // 帧尾处理
-            {
-                // 数据锁
+            // 顺序渲染
+            else {
+                UIManager.publish_frame();
+                UIManager.render_frame();
                 CUIDataAutoLocker locker;
-                // 延迟清理
-                UIManager.cleanup_delay_cleanup_chain();
-#ifdef _DEBUG
-                // 计算平均FPS
-                auto& fpsc = UIManager.m_vFpsCalculator;
-                fpsc.push_back(UIManager.m_fDeltaTime);
-                size_t frame = size_t(UIManager.m_dDisplayFrequency / 2);
-                // 固定时间刷新一次
-                if (fpsc.size() >= size_t(frame)) {
-                    float time = 0.f;
-                    for (auto t : fpsc) time += t;
-                    time /= float(frame);
-                    wchar_t buffer[1024];
-                    std::swprintf(
-                        buffer, lengthof(buffer),
-                        L"delta: %.2fms -- %2.2f fps",
-                        time * 1000.f, 1.f / time
-                    );
-                    auto hwnd = UIManager.m_hToolWnd;
-                    UIManager.DataUnlock();
-                    ::SetWindowTextW(hwnd, buffer);
-                    UIManager.DataLock();
-                    fpsc.clear();
-                }
-#endif
+                UIManager.m_bRenderInFlight = false;
             }
             // 退出检查
             if (UIManager.m_exitFlag) break;
+            // 空闲则休眠
+            if (UIManager.m_bIdleSleeping) UIManager.idle_sleep();
             // 等待垂直同步
-            UIManager.wait_for_vblank();
+            else UIManager.wait_for_vblank();
+        }
+        // 唤醒渲染线程以退出
+        if (pipelined) ::SetEvent(UIManager.m_hRenderReady);
+        return 0;
+    };
+    // 渲染线程函数
+    auto render_thread_func = [](void*) noexcept ->unsigned {
+        while (true) {
+            // 等待帧提交
+            ::WaitForSingleObject(UIManager.m_hRenderReady, INFINITE);
+            // 退出检查
+            if (UIManager.m_exitFlag) break;
+            // 渲染
+            UIManager.render_frame();
+            ::SetEvent(UIManager.m_hRenderDone);
         }
         return 0;
     };
     // 需要std::thread?
 #ifdef LONGUI_RENDER_IN_STD_THREAD
-    std::thread thread(render_thread_func, nullptr);
+    std::thread thread(frame_thread_func, nullptr);
+    std::thread render_thread;
+    if (pipelined) render_thread = std::thread(render_thread_func, nullptr);
 #else
     auto thread = reinterpret_cast<HANDLE>(
-        ::_beginthreadex(nullptr, 0, render_thread_func, nullptr, 0, nullptr)
+        ::_beginthreadex(nullptr, 0, frame_thread_func, nullptr, 0, nullptr)
         );
     assert(thread && "failed to create thread");
+    HANDLE render_thread = nullptr;
+    if (pipelined) {
+        render_thread = reinterpret_cast<HANDLE>(
+            ::_beginthreadex(nullptr, 0, render_thread_func, nullptr, 0, nullptr)
+            );
+        assert(render_thread && "failed to create thread");
+    }
 #endif
     // 消息响应
     MSG msg;
@@ -776,17 +930,43 @@ void LongUI::CUIManager::Run() noexcept {
         ::TranslateMessage(&msg);
         ::DispatchMessageW(&msg);
     }
+    // 唤醒帧线程以退出
+    if (m_hWakeUp) ::SetEvent(m_hWakeUp);
     // 等待线程
 #ifdef LONGUI_RENDER_IN_STD_THREAD
     try { if (thread.joinable()) { thread.join(); } }
     catch (...) {}
+    try { if (render_thread.joinable()) { render_thread.join(); } }
+    catch (...) {}
 #else
     if (thread) {
         ::WaitForSingleObject(thread, INFINITE);
         ::CloseHandle(thread);
         thread = nullptr;
     }
+    if (render_thread) {
+        ::WaitForSingleObject(render_thread, INFINITE);
+        ::CloseHandle(render_thread);
+        render_thread = nullptr;
+    }
 #endif
+    // 关闭事件
+    if (m_hRenderReady) {
+        ::CloseHandle(m_hRenderReady);
+        m_hRenderReady = nullptr;
+    }
+    if (m_hRenderDone) {
+        ::CloseHandle(m_hRenderDone);
+        m_hRenderDone = nullptr;
+    }
+    if (m_hWakeUp) {
+        ::CloseHandle(m_hWakeUp);
+        m_hWakeUp = nullptr;
+    }
+    m_bIdleSleeping = false;
+    m_bRenderInFlight = false;
+    m_vRenderWindows.clear();
+    m_oPacer.Stop();
     // 再次清理
     this->cleanup_delay_cleanup_chain();
     // 尝试强行关闭
@@ -813,14 +993,16 @@ void LongUI::CUIManager::Run() noexcept {
 void LongUI::CUIManager::wait_for_vblank() noexcept {
     // 自行等待垂直同步以方便游戏窗口不等待垂直同步的实现
     if (this->flag & IUIConfigure::Flag_RenderInAnytime) return;
-    // 存在DXGI输出?
-    if (m_pDxgiOutput) return void(m_pDxgiOutput->WaitForVBlank());
-    // 保留刷新时间点
-    auto f = static_cast<uint32_t>(m_dDisplayFrequency);
-    auto c = ((++m_dwWaitVSCount) * 1000ui32);
-    auto end_time_of_sleep = m_dwWaitVSStartTime + c / f;
-    // 保证等待
-    while (::timeGetTime() < end_time_of_sleep) ::Sleep(1);
+    // 目标帧率
+    const uint32_t rate = m_uTargetFrameRate ? m_uTargetFrameRate : m_dDisplayFrequency;
+    // 存在DXGI输出并且跟随屏幕刷新率?
+    if (m_pDxgiOutput && rate == m_dDisplayFrequency) {
+        return void(m_pDxgiOutput->WaitForVBlank());
+    }
+    // 目标帧率修改了
+    if (rate != m_oPacer.GetTargetRate()) m_oPacer.SetTargetRate(rate);
+    // 等待截止时间
+    m_oPacer.Wait();
 }
 
 
@@ -2275,6 +2457,8 @@ void LongUI::CUIManager::push_time_capsule(TimeCapsuleCall && call, void* id, fl
         else {
             m_vTimeCapsules.push_back(capsule);
         }
+        // 唤醒帧线程
+        this->WakeUp();
     }
 }
 
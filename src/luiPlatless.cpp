@@ -2,6 +2,32 @@
 #include "luiconf.h"
 #include "Platless/luiPlUtil.h"
 #include "Platless/luiPlHlper.h"
+#include "Platless/luiPlDirty.h"
+#include "Platless/luiPlStat.h"
+#include "Platless/luiPlGrid.h"
+#include "Platless/luiPlSort.h"
+#include "Platless/luiPlFenwick.h"
+#include "Platless/luiPlRange.h"
+#include "Platless/luiPlPiece.h"
+#include "Platless/luiPlLine.h"
+#include "Platless/luiPlUndo.h"
+#include "Platless/luiPlFind.h"
+#include "Platless/luiPlToken.h"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cwchar>
+#include <cwctype>
+#include <cstdlib>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#ifdef LONGUI_WITH_LZ4_UNDO
+#include "../3rdParty/lz4/lib/lz4.h"
+#endif
+#ifdef LONGUI_WITH_SSE2
+#include <emmintrin.h>
+#endif
 
 // longui::implnamespace
 namespace LongUI { namespace impl {
@@ -25,6 +51,122 @@ namespace LongUI { namespace impl {
         assert(IsLowSurrogate(trail) && "illegal utf-16 char");
         return char32_t((lead-0xD800) << 10 | (trail-0xDC00)) + (0x10000);
     };
+    // malformed utf sequence
+    enum : char32_t { BAD_UTF = char32_t(-1) };
+    // decode utf-8, malformed sequence consumes its maximal subpart
+    inline auto utf8_decode(const uint8_t* src, const uint8_t* end, char32_t& ch) noexcept -> const uint8_t* {
+        const uint32_t lead = *src++;
+        ch = lead;
+        if (lead < 0x80) return src;
+        ch = BAD_UTF;
+        uint32_t need, lo = 0x80, hi = 0xBF; char32_t cp;
+        // 2字节区域: 排除超长编码C0 C1
+        if (lead >= 0xC2 && lead <= 0xDF) { need = 1; cp = lead & 0x1F; }
+        // 3字节区域: 排除超长编码与代理项
+        else if (lead >= 0xE0 && lead <= 0xEF) {
+            need = 2; cp = lead & 0x0F;
+            if (lead == 0xE0) lo = 0xA0; else if (lead == 0xED) hi = 0x9F;
+        }
+        // 4字节区域: 排除超长编码与超过U+10FFFF
+        else if (lead >= 0xF0 && lead <= 0xF4) {
+            need = 3; cp = lead & 0x07;
+            if (lead == 0xF0) lo = 0x90; else if (lead == 0xF4) hi = 0x8F;
+        }
+        else return src;
+        for (; need; --need) {
+            if (src == end || *src < lo || *src > hi) return src;
+            cp = (cp << 6) | (*src++ & 0x3F);
+            lo = 0x80; hi = 0xBF;
+        }
+        ch = cp;
+        return src;
+    }
+    // decode utf-16, unpaired surrogate is malformed
+    inline auto utf16_decode(const char16_t* src, const char16_t* end, char32_t& ch) noexcept -> const char16_t* {
+        const auto lead = *src++;
+        ch = lead;
+        if (IsSurrogate(lead)) {
+            if (IsHighSurrogate(lead) && src != end && IsLowSurrogate(*src)) ch = char16x2_to_char32(lead, *src++);
+            else ch = BAD_UTF;
+        }
+        return src;
+    }
+    // char32 to utf-8
+    inline auto char32_to_char8(char32_t ch, char* str) noexcept -> char* {
+        if (ch < 0x80) {
+            *str++ = char(ch);
+        }
+        else if (ch < 0x800) {
+            *str++ = char(0xC0 | (ch >> 6));
+            *str++ = char(0x80 | (ch & 0x3F));
+        }
+        else if (ch < 0x10000) {
+            *str++ = char(0xE0 | (ch >> 12));
+            *str++ = char(0x80 | ((ch >> 6) & 0x3F));
+            *str++ = char(0x80 | (ch & 0x3F));
+        }
+        else {
+            *str++ = char(0xF0 | (ch >> 18));
+            *str++ = char(0x80 | ((ch >> 12) & 0x3F));
+            *str++ = char(0x80 | ((ch >> 6) & 0x3F));
+            *str++ = char(0x80 | (ch & 0x3F));
+        }
+        return str;
+    }
+    // skip ascii bytes
+    inline auto skip_ascii(const uint8_t* src, const uint8_t* end) noexcept -> const uint8_t* {
+#ifdef LONGUI_WITH_SSE2
+        for (; end - src >= 16; src += 16) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            if (_mm_movemask_epi8(v)) break;
+        }
+#endif
+        while (src != end && *src < 0x80) ++src;
+        return src;
+    }
+    // skip ascii units
+    inline auto skip_ascii(const char16_t* src, const char16_t* end) noexcept -> const char16_t* {
+#ifdef LONGUI_WITH_SSE2
+        const auto high = _mm_set1_epi16(short(0xFF80));
+        const auto zero = _mm_setzero_si128();
+        for (; end - src >= 8; src += 8) {
+            const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+            const auto ascii = _mm_cmpeq_epi16(_mm_and_si128(v, high), zero);
+            if (_mm_movemask_epi8(ascii) != 0xFFFF) break;
+        }
+#endif
+        while (src != end && *src < 0x80) ++src;
+        return src;
+    }
+    // utf-16 length of utf-8 string, same as UTF8toUTF16 output
+    inline auto utf8_to_utf16_length(const uint8_t* src, const uint8_t* end) noexcept -> uint32_t {
+        uint32_t length = 0;
+        while (src != end) {
+            const auto ascii = skip_ascii(src, end);
+            length += uint32_t(ascii - src);
+            src = ascii;
+            while (src != end && *src >= 0x80) {
+                char32_t ch; src = utf8_decode(src, end, ch);
+                length += (ch != BAD_UTF && ch > 0xFFFF) ? 2 : 1;
+            }
+        }
+        return length;
+    }
+    // utf-8 length of utf-16 string, same as UTF16toUTF8 output
+    inline auto utf16_to_utf8_length(const char16_t* src, const char16_t* end) noexcept -> uint32_t {
+        uint32_t length = 0;
+        while (src != end) {
+            const auto ascii = skip_ascii(src, end);
+            length += uint32_t(ascii - src);
+            src = ascii;
+            while (src != end && *src >= 0x80) {
+                char32_t ch; src = utf16_decode(src, end, ch);
+                if (ch == BAD_UTF) length += 3;
+                else length += ch < 0x800 ? 2 : (ch < 0x10000 ? 3 : 4);
+            }
+        }
+        return length;
+    }
     // 反弹渐出
     auto inline bounce_ease_out(float p) noexcept ->float {
         if (p < 4.f / 11.f) {
@@ -68,65 +210,235 @@ namespace LongUI { namespace impl {
         }
         return value;
     }
-    // 字符串转浮点
-    template<typename T> auto atof(const T* p) noexcept ->float {
+    // 10^q, q in [0, 10], exact in float
+    static const float EXACT_POWERS_OF_TEN[] = {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f,
+    };
+    // 5^q normalized and truncated to 128 bits, q in [-65, 38]
+    static const uint64_t POWERS_OF_FIVE[] = {
+        0x86CCBB52EA94BAEA, 0x98E947129FC2B4E9, 0xA87FEA27A539E9A5, 0x3F2398D747B36224,
+        0xD29FE4B18E88640E, 0x8EEC7F0D19A03AAD, 0x83A3EEEEF9153E89, 0x1953CF68300424AC,
+        0xA48CEAAAB75A8E2B, 0x5FA8C3423C052DD7, 0xCDB02555653131B6, 0x3792F412CB06794D,
+        0x808E17555F3EBF11, 0xE2BBD88BBEE40BD0, 0xA0B19D2AB70E6ED6, 0x5B6ACEAEAE9D0EC4,
+        0xC8DE047564D20A8B, 0xF245825A5A445275, 0xFB158592BE068D2E, 0xEED6E2F0F0D56712,
+        0x9CED737BB6C4183D, 0x55464DD69685606B, 0xC428D05AA4751E4C, 0xAA97E14C3C26B886,
+        0xF53304714D9265DF, 0xD53DD99F4B3066A8, 0x993FE2C6D07B7FAB, 0xE546A8038EFE4029,
+        0xBF8FDB78849A5F96, 0xDE98520472BDD033, 0xEF73D256A5C0F77C, 0x963E66858F6D4440,
+        0x95A8637627989AAD, 0xDDE7001379A44AA8, 0xBB127C53B17EC159, 0x5560C018580D5D52,
+        0xE9D71B689DDE71AF, 0xAAB8F01E6E10B4A6, 0x9226712162AB070D, 0xCAB3961304CA70E8,
+        0xB6B00D69BB55C8D1, 0x3D607B97C5FD0D22, 0xE45C10C42A2B3B05, 0x8CB89A7DB77C506A,
+        0x8EB98A7A9A5B04E3, 0x77F3608E92ADB242, 0xB267ED1940F1C61C, 0x55F038B237591ED3,
+        0xDF01E85F912E37A3, 0x6B6C46DEC52F6688, 0x8B61313BBABCE2C6, 0x2323AC4B3B3DA015,
+        0xAE397D8AA96C1B77, 0xABEC975E0A0D081A, 0xD9C7DCED53C72255, 0x96E7BD358C904A21,
+        0x881CEA14545C7575, 0x7E50D64177DA2E54, 0xAA242499697392D2, 0xDDE50BD1D5D0B9E9,
+        0xD4AD2DBFC3D07787, 0x955E4EC64B44E864, 0x84EC3C97DA624AB4, 0xBD5AF13BEF0B113E,
+        0xA6274BBDD0FADD61, 0xECB1AD8AEACDD58E, 0xCFB11EAD453994BA, 0x67DE18EDA5814AF2,
+        0x81CEB32C4B43FCF4, 0x80EACF948770CED7, 0xA2425FF75E14FC31, 0xA1258379A94D028D,
+        0xCAD2F7F5359A3B3E, 0x096EE45813A04330, 0xFD87B5F28300CA0D, 0x8BCA9D6E188853FC,
+        0x9E74D1B791E07E48, 0x775EA264CF55347E, 0xC612062576589DDA, 0x95364AFE032A819E,
+        0xF79687AED3EEC551, 0x3A83DDBD83F52205, 0x9ABE14CD44753B52, 0xC4926A9672793543,
+        0xC16D9A0095928A27, 0x75B7053C0F178294, 0xF1C90080BAF72CB1, 0x5324C68B12DD6339,
+        0x971DA05074DA7BEE, 0xD3F6FC16EBCA5E04, 0xBCE5086492111AEA, 0x88F4BB1CA6BCF585,
+        0xEC1E4A7DB69561A5, 0x2B31E9E3D06C32E6, 0x9392EE8E921D5D07, 0x3AFF322E62439FD0,
+        0xB877AA3236A4B449, 0x09BEFEB9FAD487C3, 0xE69594BEC44DE15B, 0x4C2EBE687989A9B4,
+        0x901D7CF73AB0ACD9, 0x0F9D37014BF60A11, 0xB424DC35095CD80F, 0x538484C19EF38C95,
+        0xE12E13424BB40E13, 0x2865A5F206B06FBA, 0x8CBCCC096F5088CB, 0xF93F87B7442E45D4,
+        0xAFEBFF0BCB24AAFE, 0xF78F69A51539D749, 0xDBE6FECEBDEDD5BE, 0xB573440E5A884D1C,
+        0x89705F4136B4A597, 0x31680A88F8953031, 0xABCC77118461CEFC, 0xFDC20D2B36BA7C3E,
+        0xD6BF94D5E57A42BC, 0x3D32907604691B4D, 0x8637BD05AF6C69B5, 0xA63F9A49C2C1B110,
+        0xA7C5AC471B478423, 0x0FCF80DC33721D54, 0xD1B71758E219652B, 0xD3C36113404EA4A9,
+        0x83126E978D4FDF3B, 0x645A1CAC083126EA, 0xA3D70A3D70A3D70A, 0x3D70A3D70A3D70A4,
+        0xCCCCCCCCCCCCCCCC, 0xCCCCCCCCCCCCCCCD, 0x8000000000000000, 0x0000000000000000,
+        0xA000000000000000, 0x0000000000000000, 0xC800000000000000, 0x0000000000000000,
+        0xFA00000000000000, 0x0000000000000000, 0x9C40000000000000, 0x0000000000000000,
+        0xC350000000000000, 0x0000000000000000, 0xF424000000000000, 0x0000000000000000,
+        0x9896800000000000, 0x0000000000000000, 0xBEBC200000000000, 0x0000000000000000,
+        0xEE6B280000000000, 0x0000000000000000, 0x9502F90000000000, 0x0000000000000000,
+        0xBA43B74000000000, 0x0000000000000000, 0xE8D4A51000000000, 0x0000000000000000,
+        0x9184E72A00000000, 0x0000000000000000, 0xB5E620F480000000, 0x0000000000000000,
+        0xE35FA931A0000000, 0x0000000000000000, 0x8E1BC9BF04000000, 0x0000000000000000,
+        0xB1A2BC2EC5000000, 0x0000000000000000, 0xDE0B6B3A76400000, 0x0000000000000000,
+        0x8AC7230489E80000, 0x0000000000000000, 0xAD78EBC5AC620000, 0x0000000000000000,
+        0xD8D726B7177A8000, 0x0000000000000000, 0x878678326EAC9000, 0x0000000000000000,
+        0xA968163F0A57B400, 0x0000000000000000, 0xD3C21BCECCEDA100, 0x0000000000000000,
+        0x84595161401484A0, 0x0000000000000000, 0xA56FA5B99019A5C8, 0x0000000000000000,
+        0xCECB8F27F4200F3A, 0x0000000000000000, 0x813F3978F8940984, 0x4000000000000000,
+        0xA18F07D736B90BE5, 0x5000000000000000, 0xC9F2C9CD04674EDE, 0xA400000000000000,
+        0xFC6F7C4045812296, 0x4D00000000000000, 0x9DC5ADA82B70B59D, 0xF020000000000000,
+        0xC5371912364CE305, 0x6C28000000000000, 0xF684DF56C3E01BC6, 0xC732000000000000,
+        0x9A130B963A6C115C, 0x3C7F400000000000, 0xC097CE7BC90715B3, 0x4B9F100000000000,
+        0xF0BDC21ABB48DB20, 0x1E86D40000000000, 0x96769950B50D88F4, 0x1314448000000000,
+    };
+    // 64x64 to 128 bits product, return low part
+    inline auto mul128(uint64_t a, uint64_t b, uint64_t& high) noexcept -> uint64_t {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return _umul128(a, b, &high);
+#elif defined(__SIZEOF_INT128__)
+        const auto r = static_cast<unsigned __int128>(a) * b;
+        high = static_cast<uint64_t>(r >> 64);
+        return static_cast<uint64_t>(r);
+#else
+        const uint64_t a0 = uint32_t(a), a1 = a >> 32, b0 = uint32_t(b), b1 = b >> 32;
+        const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+        const uint64_t mid = (p00 >> 32) + uint32_t(p01) + uint32_t(p10);
+        high = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+        return (mid << 32) | uint32_t(p00);
+#endif
+    }
+    // count leading zero bits, x != 0
+    inline auto clz64(uint64_t x) noexcept -> uint32_t {
+        assert(x && "bad argument");
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index; _BitScanReverse64(&index, x);
+        return 63 - index;
+#elif defined(__GNUC__)
+        return uint32_t(__builtin_clzll(x));
+#else
+        uint32_t n = 0;
+        if (!(x >> 32)) { n += 32; x <<= 32; }
+        if (!(x >> 48)) { n += 16; x <<= 16; }
+        if (!(x >> 56)) { n += 8; x <<= 8; }
+        if (!(x >> 60)) { n += 4; x <<= 4; }
+        if (!(x >> 62)) { n += 2; x <<= 2; }
+        if (!(x >> 63)) { n += 1; }
+        return n;
+#endif
+    }
+    // Eisel-Lemire: w * 10^q to float bits, false if can not decide
+    inline bool eisel_lemire(uint64_t w, int32_t q, uint32_t& bits) noexcept {
+        // 下溢或上溢
+        if (!w || q < -65) { bits = 0; return true; }
+        if (q > 38) { bits = 0x7F800000; return true; }
+        const auto lz = impl::clz64(w);
+        w <<= lz;
+        // 截断的5^q乘积, 精度不足时补上低位
+        const auto index = uint32_t(q + 65) * 2;
+        uint64_t high, low = impl::mul128(w, POWERS_OF_FIVE[index], high);
+        constexpr uint64_t mask = ~uint64_t(0) >> 26;
+        if ((high & mask) == mask) {
+            uint64_t high2; impl::mul128(w, POWERS_OF_FIVE[index + 1], high2);
+            low += high2;
+            if (high2 > low) ++high;
+        }
+        if (low == ~uint64_t(0) && (q < -27 || q > 55)) return false;
+        // 24+2位尾数
+        const auto upper = uint32_t(high >> 63);
+        uint64_t mantissa = high >> (upper + 38);
+        int32_t power2 = (((152170 + 65536) * q) >> 16) + 63 + int32_t(upper) - int32_t(lz) + 127;
+        // 非规格化数
+        if (power2 <= 0) {
+            if (1 - power2 >= 64) { bits = 0; return true; }
+            mantissa >>= 1 - power2;
+            mantissa += mantissa & 1;
+            mantissa >>= 1;
+            power2 = mantissa < (uint64_t(1) << 23) ? 0 : 1;
+            bits = uint32_t(mantissa) | (uint32_t(power2) << 23);
+            return true;
+        }
+        // 恰好位于中点: 向偶数舍入
+        if (low <= 1 && q >= -17 && q <= 10 && (mantissa & 3) == 1) {
+            if ((mantissa << (upper + 38)) == high) mantissa &= ~uint64_t(1);
+        }
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        if (mantissa >= (uint64_t(2) << 23)) {
+            mantissa = uint64_t(1) << 23;
+            ++power2;
+        }
+        mantissa &= ~(uint64_t(1) << 23);
+        if (power2 >= 0xFF) { bits = 0x7F800000; return true; }
+        bits = uint32_t(mantissa) | (uint32_t(power2) << 23);
+        return true;
+    }
+    // slow path for rare case, digits with integral mantissa to strtof
+    template<typename T> auto slow_float(const T* p, const T* last, int32_t exp10) noexcept -> float {
+        // 超过113位有效数字只影响舍入方向
+        constexpr uint32_t MAX_DIGITS = 200;
+        char buf[MAX_DIGITS + 16];
+        uint32_t len = 0;
+        bool frac = false, sticky = false;
+        for (; p != last; ++p) {
+            if (*p == '.') { frac = true; continue; }
+            const auto ch = char(*p);
+            if (frac) --exp10;
+            if (!len && ch == '0') continue;
+            if (len < MAX_DIGITS) buf[len++] = ch;
+            else { ++exp10; sticky |= ch != '0'; }
+        }
+        if (!len) return 0.f;
+        if (sticky) { buf[len++] = '1'; --exp10; }
+        // 整数尾数加指数: 与区域设置的小数点无关
+        buf[len++] = 'e';
+        if (exp10 < 0) { buf[len++] = '-'; exp10 = -exp10; }
+        char tmp[12]; uint32_t n = 0;
+        do { tmp[n++] = char('0' + exp10 % 10); exp10 /= 10; } while (exp10);
+        while (n) buf[len++] = tmp[--n];
+        buf[len] = 0;
+        return std::strtof(buf, nullptr);
+    }
+    // 字符串转浮点, 正确舍入
+    template<typename T> auto parse_float(const T* p, const T* end, float& out) noexcept -> const T* {
         assert(p && "bad argument");
-        bool negative = false;
-        float value, scale;
+        const auto begin = p;
         // 跳过空白
-        while (white_space(*p)) ++p;
+        while (p != end && white_space(*p)) ++p;
         // 检查符号
-        if (*p == '-') {
-            negative = true;
-            ++p;
-        }
-        else if (*p == '+') {
+        bool negative = false;
+        if (p != end && (*p == '-' || *p == '+')) {
+            negative = *p == '-';
             ++p;
         }
-        // 获取小数点或者指数之前的数字(有的话)
-        for (value = 0.0f; valid_digit(*p); ++p) {
-            value = value * 10.0f + static_cast<float>(*p - static_cast<T>('0'));
+        // 最多19位有效数字
+        const auto first = p;
+        uint64_t w = 0; int32_t exp10 = 0; uint32_t digits = 0;
+        bool truncated = false, any = false;
+        for (; p != end && valid_digit(*p); ++p) {
+            const auto d = uint32_t(*p - static_cast<T>('0'));
+            any = true;
+            if (digits < 19) { w = w * 10 + d; digits += w != 0; }
+            else { ++exp10; truncated |= d != 0; }
         }
-        // 获取小数点或者指数之后的数字(有的话)
-        if (*p == '.') {
-            float pow10 = 10.0f; ++p;
-            while (valid_digit(*p)) {
-                value += (*p - static_cast<T>('0')) / pow10;
-                pow10 *= 10.0f;
-                ++p;
+        if (p != end && *p == '.') {
+            for (++p; p != end && valid_digit(*p); ++p) {
+                const auto d = uint32_t(*p - static_cast<T>('0'));
+                any = true;
+                if (digits < 19) { w = w * 10 + d; digits += w != 0; --exp10; }
+                else truncated |= d != 0;
             }
         }
-        // 处理指数(有的话)
-        bool frac = false;
-        scale = 1.0f;
-        if ((*p == 'e') || (*p == 'E')) {
-            // 获取指数的符号(有的话)
-            ++p;
-            if (*p == '-') {
-                frac = true;
-                ++p;
-            }
-            else if (*p == '+') {
-                ++p;
-            }
-            unsigned int expon;
-            // 获取指数的数字(有的话)
-            for (expon = 0; valid_digit(*p); ++p) {
-                expon = expon * 10 + (*p - static_cast<T>('0'));
+        if (!any) return begin;
+        const auto last = p;
+        // 处理指数(有的话), 需要至少一个数字
+        int32_t expon = 0;
+        if (p != end && (*p == 'e' || *p == 'E')) {
+            auto q = p + 1;
+            bool frac = false;
+            if (q != end && (*q == '-' || *q == '+')) { frac = *q == '-'; ++q; }
+            if (q != end && valid_digit(*q)) {
+                for (; q != end && valid_digit(*q); ++q) {
+                    if (expon < 0x10000) expon = expon * 10 + int32_t(*q - static_cast<T>('0'));
+                }
+                if (frac) expon = -expon;
+                p = q;
             }
-            // float 最大38 double 最大308
-            if (expon > 38) expon = 38;
-            // 计算比例因数
-            while (expon >= 8) { scale *= 1E8f;  expon -= 8; }
-            while (expon) { scale *= 10.0f; --expon; }
         }
-        // 返回
-        float returncoude = (frac ? (value / scale) : (value * scale));
-        if (negative) {
-            // float
-            returncoude = -returncoude;
+        const auto q = exp10 + expon;
+        float value;
+        // Clinger: 尾数与10的幂都能精确表示
+        if (!truncated && w <= (uint64_t(1) << 24) && q >= -10 && q <= 10) {
+            value = static_cast<float>(w);
+            value = q < 0 ? value / EXACT_POWERS_OF_TEN[-q] : value * EXACT_POWERS_OF_TEN[q];
         }
-        return returncoude;
+        // Eisel-Lemire: 截断时w与w+1结果一致才可靠
+        else {
+            uint32_t bits, bits2;
+            bool ok = impl::eisel_lemire(w, q, bits);
+            if (ok && truncated) ok = impl::eisel_lemire(w + 1, q, bits2) && bits == bits2;
+            if (ok) std::memcpy(&value, &bits, sizeof(value));
+            else value = impl::slow_float(first, last, expon);
+        }
+        out = negative ? -value : value;
+        return p;
     }
 }}
 
@@ -170,10 +482,6 @@ namespace LongUI {
         0x00000000UL, 0x00003080UL, 0x000E2080UL, 
         0x03C82080UL, 0xFA082080UL, 0x82082080UL 
     };
-    // mark for first byte
-    static const char32_t FIRST_BYTE_MARK[7] = { 
-        0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC 
-    };
     // Base64 Encode 编码
     auto Base64Encode(
         const uint8_t*  __restrict  bindata,
@@ -273,45 +581,13 @@ namespace LongUI {
     // 获取u16转换u8后u8所占长度(含0结尾符)
     auto UTF16toUTF8GetBufLen(const char16_t * src) noexcept -> uint32_t {
         static_assert(sizeof(char16_t) == sizeof(wchar_t), "bad action");
-        const wchar_t* src2 = reinterpret_cast<const wchar_t*>(src);
-        uint32_t length = 1;
-        char16_t ch = 0;
-        // 遍历字符串
-        while ((ch = *src)) {
-            src += 1;
-            // 1字节区域 [0-7F]
-            if (ch < 0x0080) {
-                length += 1;
-            }
-            // 四字节区
-            else if (LongUI::IsHighSurrogate(ch)) {
-                assert(IsHighSurrogate(src[0]) && "illegal utf-8");
-                src += 1;
-                length += 4;
-            }
-            // 3字节区域 > 2^11
-            else if (ch > 0x07FFF){
-                length += 3;
-            }
-            // 2字节区域 [80-7FF]
-            else /*if (ch < 0x0800) */{
-                length += 2;
-            }
-        }
-        return length;
+        const auto len = std::wcslen(reinterpret_cast<const wchar_t*>(src));
+        return impl::utf16_to_utf8_length(src, src + len) + 1;
     }
     // 获取u8转换u16后u16所占长度(含0结尾符)
     auto UTF8toUTF16GetBufLen(const char* src) noexcept -> uint32_t {
-        uint32_t length = 1;
-        unsigned char ch = 0;
-        // 遍历字符串
-        while ((ch = *src)) {
-            auto blen = BYTES_FOR_UTF8[ch];
-            assert(blen > 0 && blen < 5 && "illegal utf-8");
-            src += blen;
-            length += 1 + (blen >> 2);
-        }
-        return length;
+        const auto itr = reinterpret_cast<const uint8_t*>(src);
+        return impl::utf8_to_utf16_length(itr, itr + std::strlen(src)) + 1;
     }
     // UTF16字符串 转 UTF8字符串
     auto UTF16toUTF8(
@@ -319,113 +595,146 @@ namespace LongUI {
         char * __restrict des,
         uint32_t buflen
     ) noexcept -> char* {
+        const auto len = std::wcslen(reinterpret_cast<const wchar_t*>(src));
 #ifdef _DEBUG
-        const auto olddes = des;
-        auto len = LongUI::UTF16toUTF8GetBufLen(src);
-        assert(buflen >= len && "buffer too small");
-#endif
-        // 遍历
-        while (*src) {
-            // 初始数据
-            char32_t ch = 0;
-            uint32_t move = 0;
-            // 辅助平面
-            if (((*src) & 0xD800) == 0xD800) {
-                ch = impl::char16x2_to_char32(src[0], src[1]);
-                assert(ch > 0xFFFF && ch <= 0x10FFFF && "bad utf32 char");
-                // UTF-16 x2 --- UTF-8  x4
-                src += 2;
-                move = 4;
-            }
-            // 基本多语言平面
-            else {
-                ch = char32_t(*src);
-                src += 1;
-                // 单字节
-                if (ch < char32_t(0x80)) {
-                    move = 1;
-                }
-                // 双字节
-                else if (ch < char32_t(0x0800)) {
-                    move = 2;
-                }
-                // 三字节
-                else {
-                    move = 3;
-                }
-            }
-            // 掩码
-            constexpr char32_t byteMask = 0xBF;
-            constexpr char32_t byteMark = 0x80;
-            des += move;
-            // 转换
-            switch (move) {
-            case 4: *--des = (char)((ch | byteMark) & byteMask); ch >>= 6;
-            case 3: *--des = (char)((ch | byteMark) & byteMask); ch >>= 6;
-            case 2: *--des = (char)((ch | byteMark) & byteMask); ch >>= 6;
-            case 1: *--des = (char)(ch | FIRST_BYTE_MARK[move]);
-            }
-            des += move;
-        }
-        // 收尾检查
-#ifdef _DEBUG
-        auto utf16len1 = size_t(len - 1);
-        auto utf16len2 = size_t(des - olddes);
-        assert((utf16len1 == utf16len2) && "bug!");
+        const auto need = LongUI::UTF16toUTF8GetBufLen(src);
+        assert(buflen >= need && "buffer too small");
+#else
+        buflen;
 #endif
-        return des;
+        return LongUI::UTF16toUTF8(src, uint32_t(len), des);
     }
     //  UTF8字符串 转 UTF16字符串
     auto UTF8toUTF16(
         const char * __restrict src, 
         char16_t * __restrict des, 
         uint32_t buflen) noexcept -> char16_t* {
+        const auto len = std::strlen(src);
 #ifdef _DEBUG
-        const auto olddes = des;
-        auto len = LongUI::UTF8toUTF16GetBufLen(src);
-        assert(buflen >= len && "buffer too small");
+        const auto need = LongUI::UTF8toUTF16GetBufLen(src);
+        assert(buflen >= need && "buffer too small");
 #else
         buflen;
 #endif
-        // 遍历字符串
-        while (*src) {
-            // 初始数据
-            char32_t ch = 0;
-            unsigned char read = BYTES_FOR_UTF8[(unsigned char)(*src)] - 1;
-            // 读取
-            switch (read)
-            {
-#ifdef _DEBUG
-            default:assert(!"bug"); break;
-            case 5: 
-            case 4: assert(!"illegal utf-8");
+        return LongUI::UTF8toUTF16(src, uint32_t(len), des);
+    }
+    /// <summary>
+    /// UTF-16 to UTF-8 in one pass, 8 ASCII units packed at once
+    /// with SSE2. Unpaired surrogate is written as U+FFFD.
+    /// </summary>
+    /// <param name="src">The source.</param>
+    /// <param name="len">The length of source.</param>
+    /// <param name="des">The destination, len*3 bytes at most.</param>
+    /// <returns>end of utf-8 string, not null-terminated</returns>
+    auto UTF16toUTF8(
+        const char16_t* __restrict src,
+        uint32_t len,
+        char* __restrict des
+    ) noexcept -> char* {
+        assert((src || !len) && "bad argument");
+        auto itr = src;
+        const auto end = src + len;
+        while (itr != end) {
+#ifdef LONGUI_WITH_SSE2
+            // ASCII: 8个单元一次压缩
+            const auto high = _mm_set1_epi16(short(0xFF80));
+            const auto zero = _mm_setzero_si128();
+            for (; end - itr >= 8; itr += 8, des += 8) {
+                const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(itr));
+                const auto ascii = _mm_cmpeq_epi16(_mm_and_si128(v, high), zero);
+                if (_mm_movemask_epi8(ascii) != 0xFFFF) break;
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(des), _mm_packus_epi16(v, v));
+            }
 #endif
-            case 3: ch += (unsigned char)(*src++); ch <<= 6;
-            case 2: ch += (unsigned char)(*src++); ch <<= 6;
-            case 1: ch += (unsigned char)(*src++); ch <<= 6;
-            case 0: ch += (unsigned char)(*src++);
+            // 逐字: ASCII部分
+            while (itr != end && *itr < 0x80) *des++ = char(*itr++);
+            // 逐字: 直到下一个ASCII
+            while (itr != end && *itr >= 0x80) {
+                char32_t ch; itr = impl::utf16_decode(itr, end, ch);
+                des = impl::char32_to_char8(ch == impl::BAD_UTF ? 0xFFFD : ch, des);
             }
-            // 减去偏移量
-            ch -= OFFSETS_FROM_UTF8[read];
-            // 写入
-            des = impl::char32_to_char16(ch, des);
         }
-        // 收尾检查
-#ifdef _DEBUG
-        auto utf16len1 = size_t(len - 1);
-        auto utf16len2 = size_t(des - olddes);
-        assert((utf16len1 == utf16len2) && "bug!");
+        return des;
+    }
+    /// <summary>
+    /// UTF-8 to UTF-16 in one pass, 16 ASCII bytes widened at once
+    /// with SSE2. Malformed sequence(overlong, surrogate, out of 
+    /// range or truncated) is written as one U+FFFD per maximal
+    /// subpart, so output never exceeds len units.
+    /// </summary>
+    /// <param name="src">The source.</param>
+    /// <param name="len">The length of source.</param>
+    /// <param name="des">The destination, len units at most.</param>
+    /// <returns>end of utf-16 string, not null-terminated</returns>
+    auto UTF8toUTF16(
+        const char* __restrict src,
+        uint32_t len,
+        char16_t* __restrict des
+    ) noexcept -> char16_t* {
+        assert((src || !len) && "bad argument");
+        auto itr = reinterpret_cast<const uint8_t*>(src);
+        const auto end = itr + len;
+        while (itr != end) {
+#ifdef LONGUI_WITH_SSE2
+            // ASCII: 16字节一次扩展
+            const auto zero = _mm_setzero_si128();
+            for (; end - itr >= 16; itr += 16, des += 16) {
+                const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(itr));
+                if (_mm_movemask_epi8(v)) break;
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(des), _mm_unpacklo_epi8(v, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(des + 8), _mm_unpackhi_epi8(v, zero));
+            }
 #endif
+            // 逐字: ASCII部分
+            while (itr != end && *itr < 0x80) *des++ = char16_t(*itr++);
+            // 逐字: 直到下一个ASCII
+            while (itr != end && *itr >= 0x80) {
+                char32_t ch; itr = impl::utf8_decode(itr, end, ch);
+                des = impl::char32_to_char16(ch == impl::BAD_UTF ? 0xFFFD : ch, des);
+            }
+        }
         return des;
     }
     /// <summary>
+    /// Determines whether string is well-formed UTF-8.
+    /// </summary>
+    /// <param name="src">The source.</param>
+    /// <param name="len">The length.</param>
+    /// <returns></returns>
+    bool IsValidUTF8(const char* src, uint32_t len) noexcept {
+        auto itr = reinterpret_cast<const uint8_t*>(src);
+        const auto end = itr + len;
+        while ((itr = impl::skip_ascii(itr, end)) != end) {
+            char32_t ch; itr = impl::utf8_decode(itr, end, ch);
+            if (ch == impl::BAD_UTF) return false;
+        }
+        return true;
+    }
+    /// <summary>
+    /// Determines whether string is well-formed UTF-16.
+    /// </summary>
+    /// <param name="src">The source.</param>
+    /// <param name="len">The length.</param>
+    /// <returns></returns>
+    bool IsValidUTF16(const char16_t* src, uint32_t len) noexcept {
+        auto itr = src;
+        const auto end = src + len;
+        while ((itr = impl::skip_ascii(itr, end)) != end) {
+            char32_t ch; itr = impl::utf16_decode(itr, end, ch);
+            if (ch == impl::BAD_UTF) return false;
+        }
+        return true;
+    }
+    /// <summary>
     /// string to float.字符串转浮点, std::atof自己实现版
     /// </summary>
     /// <param name="p">The string. in const char*</param>
     /// <returns></returns>
     auto AtoF(const char* __restrict p) noexcept -> float {
         if (!p) return 0.0f;
-        return impl::atof(p);
+        float value = 0.0f;
+        impl::parse_float(p, p + std::strlen(p), value);
+        return value;
     }
     /// <summary>
     /// string to float.字符串转浮点, std::atof自己实现版
@@ -434,7 +743,41 @@ namespace LongUI {
     /// <returns></returns>
     auto AtoF(const wchar_t* __restrict p) noexcept -> float {
         if (!p) return 0.0f;
-        return impl::atof(p);
+        float value = 0.0f;
+        impl::parse_float(p, p + std::wcslen(p), value);
+        return value;
+    }
+    /// <summary>
+    /// Parses a float in [begin, end) without copy, correctly
+    /// rounded(Clinger fast path, then Eisel-Lemire).
+    /// </summary>
+    /// <param name="begin">The begin.</param>
+    /// <param name="end">The end.</param>
+    /// <param name="out">The output.</param>
+    /// <returns>end of number, begin if no number found</returns>
+    auto ParseFloat(const char* begin, const char* end, float& out) noexcept -> const char* {
+        return impl::parse_float(begin, end, out);
+    }
+    /// <summary>
+    /// Parses floats in [begin, end), separated by white space,
+    /// comma or just sign like "1-2" in svg path.
+    /// </summary>
+    /// <param name="itr">The begin, moved to end of last number.</param>
+    /// <param name="end">The end.</param>
+    /// <param name="out">The output, unparsed ones untouched.</param>
+    /// <param name="count">The count.</param>
+    /// <returns>count of parsed numbers</returns>
+    auto ParseFloats(const char*& itr, const char* end, float out[], uint32_t count) noexcept -> uint32_t {
+        uint32_t i = 0;
+        for (; i < count; ++i) {
+            auto now = itr;
+            // 跳过分隔符
+            while (now != end && (white_space(*now) || *now == ',' || *now == '\r' || *now == '\n')) ++now;
+            const auto next = impl::parse_float(now, end, out[i]);
+            if (next == now) break;
+            itr = next;
+        }
+        return i;
     }
     /// <summary>
     /// string to int, 字符串转整型, std::atoi自己实现版
@@ -654,3 +997,2439 @@ namespace LongUI {
     }
 
 }
+
+
+/// <summary>
+/// Get the intersection area of 2 rects
+/// </summary>
+/// <param name="a">The rect a.</param>
+/// <param name="b">The rect b.</param>
+/// <returns></returns>
+auto LongUI::CUIDirtyRegion::IntersectionArea(const RectLTRB_F& a, const RectLTRB_F& b) noexcept -> float {
+    const auto left = a.left > b.left ? a.left : b.left;
+    const auto top = a.top > b.top ? a.top : b.top;
+    const auto right = a.right < b.right ? a.right : b.right;
+    const auto bottom = a.bottom < b.bottom ? a.bottom : b.bottom;
+    // 没有交集
+    if (right <= left || bottom <= top) return 0.f;
+    return (right - left) * (bottom - top);
+}
+
+/// <summary>
+/// Adds the rect with user data.
+/// </summary>
+/// <param name="rect">The rect.</param>
+/// <param name="data">The user data.</param>
+/// <returns></returns>
+void LongUI::CUIDirtyRegion::AddRect(const RectLTRB_F& rect, void* data) noexcept {
+    // 反向矩形(被完全裁剪)
+    if (!(rect.right >= rect.left && rect.bottom >= rect.top)) return;
+    Unit unit; unit.rect = rect; unit.data = data;
+    // 零面积矩形(例如细线)仍然会影响所在的像素
+    if (unit.rect.right == unit.rect.left) {
+        unit.rect.left = std::floor(rect.left);
+        unit.rect.right = unit.rect.left + 1.f;
+    }
+    if (unit.rect.bottom == unit.rect.top) {
+        unit.rect.top = std::floor(rect.top);
+        unit.rect.bottom = unit.rect.top + 1.f;
+    }
+    // 尝试合并
+    if (this->try_merge(unit)) return;
+    // 已满: 与代价最小的合并
+    while (m_uCount == LongUIDirtyRegionSize) {
+        const auto index = this->find_cheapest(unit.rect);
+        unit.rect = UnionOf(m_aUnits[index].rect, unit.rect);
+        unit.data = nullptr;
+        this->remove_unit(index);
+        // 合并后更大了, 再次尝试
+        if (this->try_merge(unit)) return;
+    }
+    // 添加到最后
+    m_aUnits[m_uCount++] = unit;
+    m_fArea += AreaOf(unit.rect);
+}
+
+/// <summary>
+/// Determines whether region is too large for dirty-rendering
+/// </summary>
+/// <param name="width">The width of target.</param>
+/// <param name="height">The height of target.</param>
+/// <returns></returns>
+bool LongUI::CUIDirtyRegion::IsOverRatio(float width, float height) const noexcept {
+    return m_fArea > width * height * LongUIDirtyRegionFullRatio;
+}
+
+/// <summary>
+/// Removes the unit at index.
+/// </summary>
+/// <param name="i">The index.</param>
+/// <returns></returns>
+void LongUI::CUIDirtyRegion::remove_unit(uint32_t i) noexcept {
+    assert(i < m_uCount && "out of range");
+    m_fArea -= AreaOf(m_aUnits[i].rect);
+    m_aUnits[i] = m_aUnits[--m_uCount];
+}
+
+/// <summary>
+/// Merges the data while outer rect contains inner rect
+/// </summary>
+/// <param name="outer">The outer data.</param>
+/// <param name="inner">The inner data.</param>
+/// <returns></returns>
+auto LongUI::CUIDirtyRegion::merge_data(void* outer, void* inner) const noexcept -> void* {
+    // 同一个
+    if (outer == inner) return outer;
+    // 外部渲染覆盖内部
+    if (outer && inner && m_pCoverChecker && m_pCoverChecker(outer, inner)) return outer;
+    // 无法覆盖
+    return nullptr;
+}
+
+/// <summary>
+/// Tries to merge the unit into exist units.
+/// </summary>
+/// <param name="unit">The unit.</param>
+/// <returns>true if swallowed by exist unit</returns>
+bool LongUI::CUIDirtyRegion::try_merge(Unit& unit) noexcept {
+    uint32_t i = 0;
+    while (i < m_uCount) {
+        auto& exist = m_aUnits[i];
+        // 已存在的包含新的 -> 吞掉
+        if (IsContain(exist.rect, unit.rect)) {
+            exist.data = this->merge_data(exist.data, unit.data);
+            return true;
+        }
+        // 新的包含已存在的 -> 移除已存在的
+        if (IsContain(unit.rect, exist.rect)) {
+            unit.data = this->merge_data(unit.data, exist.data);
+            this->remove_unit(i);
+            continue;
+        }
+        // 合并后浪费的面积较少 -> 合并
+        const auto covered = AreaOf(exist.rect) + AreaOf(unit.rect)
+            - IntersectionArea(exist.rect, unit.rect);
+        const auto merged = UnionOf(exist.rect, unit.rect);
+        if (AreaOf(merged) - covered <= covered * LongUIDirtyRegionMergeRatio) {
+            unit.rect = merged;
+            unit.data = nullptr;
+            this->remove_unit(i);
+            // 变大了, 从头检查
+            i = 0;
+            continue;
+        }
+        ++i;
+    }
+    return false;
+}
+
+/// <summary>
+/// Finds the cheapest unit to merge with.
+/// </summary>
+/// <param name="rect">The rect.</param>
+/// <returns>index of unit</returns>
+auto LongUI::CUIDirtyRegion::find_cheapest(const RectLTRB_F& rect) const noexcept -> uint32_t {
+    assert(m_uCount && "no unit");
+    uint32_t index = 0;
+    float cost = 0.f;
+    for (uint32_t i = 0; i < m_uCount; ++i) {
+        const auto& exist = m_aUnits[i].rect;
+        const auto now = AreaOf(UnionOf(exist, rect)) - AreaOf(exist);
+        if (!i || now < cost) {
+            index = i;
+            cost = now;
+        }
+    }
+    return index;
+}
+
+
+/// <summary>
+/// Gets the index of bucket for the value.
+/// </summary>
+/// <param name="mcs">The value in micro sec.</param>
+/// <returns></returns>
+auto LongUI::CUIHistogram::IndexOf(uint32_t mcs) noexcept -> uint32_t {
+    // 线性区间
+    if (mcs < LINEAR_COUNT) return mcs;
+    // 最高位
+    uint32_t exp = 31;
+    while (!(mcs >> exp)) --exp;
+    // 对数区间, 每个2的幂再细分
+    const auto sub = (mcs >> (exp - SUB_BITS)) & (SUB_COUNT - 1);
+    const auto index = LINEAR_COUNT + (exp - 4) * SUB_COUNT + sub;
+    return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+}
+
+/// <summary>
+/// Gets the upper bound value of the bucket.
+/// </summary>
+/// <param name="index">The index.</param>
+/// <returns></returns>
+auto LongUI::CUIHistogram::UpperOf(uint32_t index) noexcept -> uint32_t {
+    assert(index < BUCKET_COUNT && "out of range");
+    if (index < LINEAR_COUNT) return index;
+    const auto exp = (index - LINEAR_COUNT) / SUB_COUNT + 4;
+    const auto sub = (index - LINEAR_COUNT) % SUB_COUNT;
+    return ((SUB_COUNT + sub + 1) << (exp - SUB_BITS)) - 1;
+}
+
+/// <summary>
+/// Records the specified value.
+/// </summary>
+/// <param name="mcs">The value in micro sec.</param>
+/// <returns></returns>
+void LongUI::CUIHistogram::Record(uint32_t mcs) noexcept {
+    // 由写入者执行清理请求
+    if (m_bClear.load(std::memory_order_relaxed) && m_bClear.exchange(false, std::memory_order_acquire)) {
+        this->reset();
+    }
+    m_aBuckets[IndexOf(mcs)].fetch_add(1, std::memory_order_relaxed);
+    m_uSum.fetch_add(mcs, std::memory_order_relaxed);
+    m_cCount.fetch_add(1, std::memory_order_relaxed);
+    // 只有一个写入者, 无需CAS
+    if (mcs > m_uMax.load(std::memory_order_relaxed)) {
+        m_uMax.store(mcs, std::memory_order_relaxed);
+    }
+}
+
+/// <summary>
+/// Resets this instance, called by writer or ctor.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIHistogram::reset() noexcept {
+    for (auto& bucket : m_aBuckets) bucket.store(0, std::memory_order_relaxed);
+    m_uSum.store(0, std::memory_order_relaxed);
+    m_cCount.store(0, std::memory_order_relaxed);
+    m_uMax.store(0, std::memory_order_relaxed);
+}
+
+/// <summary>
+/// Gets the average value.
+/// </summary>
+/// <returns></returns>
+auto LongUI::CUIHistogram::GetAverage() const noexcept -> float {
+    if (this->is_clearing()) return 0.f;
+    const auto count = m_cCount.load(std::memory_order_relaxed);
+    if (!count) return 0.f;
+    return float(double(m_uSum.load(std::memory_order_relaxed)) / double(count));
+}
+
+/// <summary>
+/// Gets the value at percentile.
+/// </summary>
+/// <param name="percentile">The percentile(0-100).</param>
+/// <returns>upper bound of bucket, clamped to max</returns>
+auto LongUI::CUIHistogram::GetPercentile(float percentile) const noexcept -> uint32_t {
+    if (this->is_clearing()) return 0;
+    // 读取快照, 写入者可能同时在写
+    uint32_t buckets[BUCKET_COUNT]; uint64_t total = 0;
+    for (uint32_t i = 0; i < BUCKET_COUNT; ++i) {
+        buckets[i] = m_aBuckets[i].load(std::memory_order_relaxed);
+        total += buckets[i];
+    }
+    if (!total) return 0;
+    // 目标排名
+    if (percentile < 0.f) percentile = 0.f;
+    if (percentile > 100.f) percentile = 100.f;
+    auto rank = uint64_t(double(percentile) * 0.01 * double(total) + 0.5);
+    if (!rank) rank = 1;
+    // 累计
+    uint64_t sum = 0;
+    const auto max = m_uMax.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < BUCKET_COUNT; ++i) {
+        sum += buckets[i];
+        if (sum >= rank) {
+            const auto upper = UpperOf(i);
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+
+/// <summary>
+/// Builds the grid.
+/// </summary>
+/// <returns></returns>
+auto LongUI::CUISpatialGrid::Build() noexcept -> bool {
+    // 失败时保持无效, 调用者退回线性查找
+    m_bValid = false;
+    m_uCols = m_uRows = 0;
+    m_vCellStart.clear();
+    m_vCellItems.clear();
+    // 计算边界, 忽略空矩形
+    bool first = true;
+    for (const auto& item : m_vItems) {
+        const auto& rc = item.rect;
+        if (!(rc.right > rc.left && rc.bottom > rc.top)) continue;
+        if (first) m_rcBounds = rc, first = false;
+        else m_rcBounds = CUIDirtyRegion::UnionOf(m_rcBounds, rc);
+    }
+    if (first) return m_bValid = true;
+    // 每个格子大约两个项目
+    const auto count = m_vItems.size();
+    auto side = uint32_t(std::sqrt(float(count) * 0.5f)) + 1;
+    side = std::min(side, uint32_t(MAX_CELL_AXIS));
+    m_uCols = m_uRows = side;
+    m_fInvCellW = float(m_uCols) / (m_rcBounds.right - m_rcBounds.left);
+    m_fInvCellH = float(m_uRows) / (m_rcBounds.bottom - m_rcBounds.top);
+    const auto cells = m_uCols * m_uRows;
+    // 项目覆盖的格子范围
+    auto range_of = [this](const RectLTRB_F& rc, uint32_t range[4]) noexcept {
+        auto clamp = [](float v, uint32_t max) noexcept {
+            return v <= 0.f ? 0u : std::min(uint32_t(v), max - 1);
+        };
+        range[0] = clamp((rc.left - m_rcBounds.left) * m_fInvCellW, m_uCols);
+        range[1] = clamp((rc.top - m_rcBounds.top) * m_fInvCellH, m_uRows);
+        range[2] = clamp((rc.right - m_rcBounds.left) * m_fInvCellW, m_uCols);
+        range[3] = clamp((rc.bottom - m_rcBounds.top) * m_fInvCellH, m_uRows);
+    };
+    // 第一遍: 计数
+    m_vCellStart.newsize(cells + 1);
+    if (!m_vCellStart.isok()) { m_uCols = m_uRows = 0; return false; }
+    std::memset(m_vCellStart.data(), 0, sizeof(uint32_t) * (cells + 1));
+    uint32_t range[4];
+    for (const auto& item : m_vItems) {
+        const auto& rc = item.rect;
+        if (!(rc.right > rc.left && rc.bottom > rc.top)) continue;
+        range_of(rc, range);
+        for (auto y = range[1]; y <= range[3]; ++y) {
+            for (auto x = range[0]; x <= range[2]; ++x) {
+                ++m_vCellStart[y * m_uCols + x + 1];
+            }
+        }
+    }
+    // 前缀和
+    for (uint32_t i = 0; i < cells; ++i) m_vCellStart[i + 1] += m_vCellStart[i];
+    m_vCellItems.newsize(m_vCellStart[cells]);
+    if (!m_vCellItems.isok()) { m_uCols = m_uRows = 0; return false; }
+    // 第二遍: 填充, 保持项目顺序
+    auto cursor = LongUI::NormalAllocT<uint32_t>(cells);
+    if (!cursor) { m_uCols = m_uRows = 0; return false; }
+    std::memcpy(cursor, m_vCellStart.data(), sizeof(uint32_t) * cells);
+    for (uint32_t i = 0; i < count; ++i) {
+        const auto& rc = m_vItems[i].rect;
+        if (!(rc.right > rc.left && rc.bottom > rc.top)) continue;
+        range_of(rc, range);
+        for (auto y = range[1]; y <= range[3]; ++y) {
+            for (auto x = range[0]; x <= range[2]; ++x) {
+                m_vCellItems[cursor[y * m_uCols + x]++] = i;
+            }
+        }
+    }
+    LongUI::NormalFree(cursor);
+    return m_bValid = true;
+}
+
+/// <summary>
+/// Finds the top-most item containing point.
+/// </summary>
+/// <param name="x">The x.</param>
+/// <param name="y">The y.</param>
+/// <returns>user data, null if not found</returns>
+auto LongUI::CUISpatialGrid::FindTopmost(float x, float y) const noexcept -> void* {
+    assert(m_bValid && "call Build() first");
+    if (!m_uCols) return nullptr;
+    // 不在边界
+    if (x < m_rcBounds.left || y < m_rcBounds.top) return nullptr;
+    if (x >= m_rcBounds.right || y >= m_rcBounds.bottom) return nullptr;
+    const auto col = std::min(uint32_t((x - m_rcBounds.left) * m_fInvCellW), m_uCols - 1);
+    const auto row = std::min(uint32_t((y - m_rcBounds.top) * m_fInvCellH), m_uRows - 1);
+    const auto cell = row * m_uCols + col;
+    // 倒序: 后添加的在上面
+    for (auto i = m_vCellStart[cell + 1]; i > m_vCellStart[cell]; --i) {
+        const auto& item = m_vItems[m_vCellItems[i - 1]];
+        const auto& rc = item.rect;
+        if (x >= rc.left && y >= rc.top && x < rc.right && y < rc.bottom) {
+            return item.data;
+        }
+    }
+    return nullptr;
+}
+
+
+/// <summary>
+/// Makes the string sort key.
+/// </summary>
+/// <param name="str">The null-terminated string.</param>
+/// <returns></returns>
+auto LongUI::MakeStringSortKey(const wchar_t* str) noexcept -> StringSortKey {
+    assert(str && "bad argument");
+    static_assert(sizeof(wchar_t) == sizeof(char16_t), "change UTF-16 to UTF-32");
+    StringSortKey key = { 0, str };
+    // 前4字符大端打包, 遇到0后补0
+    for (int i = 0; i < 4; ++i) {
+        const auto ch = uint64_t(uint16_t(*str));
+        key.prefix |= ch << ((3 - i) * 16);
+        if (ch) ++str;
+    }
+    return key;
+}
+
+/// <summary>
+/// Compares the sort keys, same order as std::wcscmp.
+/// </summary>
+/// <param name="a">A.</param>
+/// <param name="b">The b.</param>
+/// <returns></returns>
+auto LongUI::CompareSortKey(const StringSortKey& a, const StringSortKey& b) noexcept -> int {
+    if (a.prefix != b.prefix) return a.prefix < b.prefix ? -1 : 1;
+    // 前缀含0: 字符串已经结束
+    if (!(a.prefix & 0xFFFF)) return 0;
+    return std::wcscmp(a.string + 4, b.string + 4);
+}
+
+/// <summary>
+/// Stable LSD radix sort for index array via 32-bit keys, 8-bit per pass.
+/// </summary>
+/// <param name="keys">The keys, indexed by value in index array.</param>
+/// <param name="index">The index array.</param>
+/// <param name="tmp">The temporary buffer.</param>
+/// <param name="count">The count.</param>
+/// <returns></returns>
+void LongUI::RadixSortIndex(const uint32_t keys[], uint32_t index[], uint32_t tmp[], uint32_t count) noexcept {
+    assert(keys && index && tmp && "bad arguments");
+    if (count < 2) return;
+    // 一次性统计4趟的直方图
+    uint32_t histogram[4][256];
+    std::memset(histogram, 0, sizeof(histogram));
+    for (uint32_t i = 0; i < count; ++i) {
+        const auto key = keys[index[i]];
+        ++histogram[0][key & 0xFF];
+        ++histogram[1][(key >> 8) & 0xFF];
+        ++histogram[2][(key >> 16) & 0xFF];
+        ++histogram[3][key >> 24];
+    }
+    auto src = index, des = tmp;
+    for (uint32_t pass = 0; pass < 4; ++pass) {
+        auto& hist = histogram[pass];
+        const auto shift = pass * 8;
+        // 所有键值该字节相同: 跳过
+        if (hist[(keys[src[0]] >> shift) & 0xFF] == count) continue;
+        // 前缀和
+        uint32_t sum = 0;
+        for (auto& h : hist) { const auto c = h; h = sum; sum += c; }
+        // 分配
+        for (uint32_t i = 0; i < count; ++i) {
+            const auto id = src[i];
+            des[hist[(keys[id] >> shift) & 0xFF]++] = id;
+        }
+        std::swap(src, des);
+    }
+    // 结果在临时缓存
+    if (src != index) std::memcpy(index, src, sizeof(uint32_t) * count);
+}
+
+/// <summary>
+/// Merges 2 sorted index runs, stable.
+/// </summary>
+/// <param name="keys">The keys.</param>
+/// <param name="a">Run a.</param>
+/// <param name="na">The length of a.</param>
+/// <param name="b">Run b.</param>
+/// <param name="nb">The length of b.</param>
+/// <param name="out">The output.</param>
+/// <returns></returns>
+void LongUI::MergeIndex(const StringSortKey keys[], const uint32_t a[], uint32_t na,
+    const uint32_t b[], uint32_t nb, uint32_t out[]) noexcept {
+    const auto ea = a + na, eb = b + nb;
+    while (a != ea && b != eb) {
+        // 相等时取a保证稳定
+        if (LongUI::CompareSortKey(keys[*b], keys[*a]) < 0) *out++ = *b++;
+        else *out++ = *a++;
+    }
+    while (a != ea) *out++ = *a++;
+    while (b != eb) *out++ = *b++;
+}
+
+/// <summary>
+/// Stable bottom-up merge sort for index array via string keys.
+/// </summary>
+/// <param name="keys">The keys, indexed by value in index array.</param>
+/// <param name="index">The index array.</param>
+/// <param name="tmp">The temporary buffer.</param>
+/// <param name="count">The count.</param>
+/// <returns></returns>
+void LongUI::MergeSortIndex(const StringSortKey keys[], uint32_t index[], uint32_t tmp[], uint32_t count) noexcept {
+    assert(keys && index && tmp && "bad arguments");
+    constexpr uint32_t RUN = 16;
+    // 小段插入排序
+    for (uint32_t bn = 0; bn < count; bn += RUN) {
+        const auto ed = std::min(bn + RUN, count);
+        for (auto i = bn + 1; i < ed; ++i) {
+            const auto id = index[i];
+            auto j = i;
+            for (; j > bn && LongUI::CompareSortKey(keys[id], keys[index[j - 1]]) < 0; --j) {
+                index[j] = index[j - 1];
+            }
+            index[j] = id;
+        }
+    }
+    // 逐层归并
+    auto src = index, des = tmp;
+    for (uint32_t width = RUN; width < count; width *= 2) {
+        for (uint32_t bn = 0; bn < count; bn += width * 2) {
+            const auto mid = std::min(bn + width, count);
+            const auto ed = std::min(bn + width * 2, count);
+            LongUI::MergeIndex(keys, src + bn, mid - bn, src + mid, ed - mid, des + bn);
+        }
+        std::swap(src, des);
+    }
+    // 结果在临时缓存
+    if (src != index) std::memcpy(index, src, sizeof(uint32_t) * count);
+}
+
+
+/// <summary>
+/// Resets with specified count, all values set to value.
+/// </summary>
+/// <param name="count">The count.</param>
+/// <param name="value">The value.</param>
+/// <returns></returns>
+void LongUI::CUIFenwickTree::Reset(uint32_t count, float value) noexcept {
+    auto values = this->Prepare(count);
+    if (!values) return;
+    for (uint32_t i = 0; i < count; ++i) values[i] = value;
+    this->Build();
+}
+
+/// <summary>
+/// Prepares the value buffer with specified count.
+/// </summary>
+/// <param name="count">The count.</param>
+/// <returns>value buffer, null if OOM</returns>
+auto LongUI::CUIFenwickTree::Prepare(uint32_t count) noexcept -> float* {
+    m_vValue.newsize(count);
+    m_vTree.newsize(count + 1);
+    // OOM
+    if (!m_vValue.isok() || !m_vTree.isok()) {
+        m_vValue.clear();
+        m_vTree.clear();
+        return nullptr;
+    }
+    return m_vValue.data();
+}
+
+/// <summary>
+/// Builds the tree from values in O(n).
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIFenwickTree::Build() noexcept {
+    const auto count = this->GetCount();
+    if (m_vTree.size() != count + 1) return;
+    auto tree = m_vTree.data();
+    tree[0] = 0.f;
+    std::memcpy(tree + 1, m_vValue.data(), sizeof(float) * count);
+    // 每个结点累加到父结点
+    for (uint32_t i = 1; i <= count; ++i) {
+        const auto parent = i + (i & (0 - i));
+        if (parent <= count) tree[parent] += tree[i];
+    }
+}
+
+/// <summary>
+/// Sets the value at index in O(log n).
+/// </summary>
+/// <param name="index">The index.</param>
+/// <param name="value">The value.</param>
+/// <returns></returns>
+void LongUI::CUIFenwickTree::Set(uint32_t index, float value) noexcept {
+    const auto count = this->GetCount();
+    assert(index < count && "out of range");
+    if (index >= count) return;
+    const auto delta = value - m_vValue[index];
+    m_vValue[index] = value;
+    auto tree = m_vTree.data();
+    for (auto i = index + 1; i <= count; i += i & (0 - i)) tree[i] += delta;
+}
+
+/// <summary>
+/// Sum of [0, index) in O(log n).
+/// </summary>
+/// <param name="index">The index.</param>
+/// <returns></returns>
+auto LongUI::CUIFenwickTree::PrefixSum(uint32_t index) const noexcept -> float {
+    index = std::min(index, this->GetCount());
+    if (!index) return 0.f;
+    float sum = 0.f;
+    auto tree = m_vTree.data();
+    for (auto i = index; i; i &= i - 1) sum += tree[i];
+    return sum;
+}
+
+/// <summary>
+/// Finds the index that offset in [sum(0, index), sum(0, index+1)).
+/// </summary>
+/// <param name="offset">The offset.</param>
+/// <returns>count if out of range</returns>
+auto LongUI::CUIFenwickTree::Find(float offset) const noexcept -> uint32_t {
+    const auto count = this->GetCount();
+    if (offset < 0.f || !count) return offset < 0.f ? 0 : count;
+    // 二进制提升
+    uint32_t step = 1;
+    while (step * 2 <= count) step *= 2;
+    uint32_t pos = 0;
+    auto tree = m_vTree.data();
+    for (; step; step >>= 1) {
+        const auto next = pos + step;
+        if (next <= count && tree[next] <= offset) {
+            pos = next;
+            offset -= tree[next];
+        }
+    }
+    return pos;
+}
+
+
+/// <summary>
+/// Index of first interval whose end &gt; value.
+/// </summary>
+/// <param name="value">The value.</param>
+/// <returns></returns>
+auto LongUI::CUIIntervalSet::lower_end(uint32_t value) const noexcept -> uint32_t {
+    uint32_t lo = 0, hi = m_vIntervals.size();
+    while (lo < hi) {
+        const auto mid = (lo + hi) / 2;
+        if (m_vIntervals[mid].end > value) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+/// <summary>
+/// Index of first interval whose begin &gt; value.
+/// </summary>
+/// <param name="value">The value.</param>
+/// <returns></returns>
+auto LongUI::CUIIntervalSet::upper_begin(uint32_t value) const noexcept -> uint32_t {
+    uint32_t lo = 0, hi = m_vIntervals.size();
+    while (lo < hi) {
+        const auto mid = (lo + hi) / 2;
+        if (m_vIntervals[mid].begin > value) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+/// <summary>
+/// Determines whether contains the specified value in O(log n).
+/// </summary>
+/// <param name="value">The value.</param>
+/// <returns></returns>
+bool LongUI::CUIIntervalSet::Contains(uint32_t value) const noexcept {
+    const auto i = this->lower_end(value);
+    return i < m_vIntervals.size() && m_vIntervals[i].begin <= value;
+}
+
+/// <summary>
+/// Gets the count of values in set.
+/// </summary>
+/// <returns></returns>
+auto LongUI::CUIIntervalSet::GetSize() const noexcept -> uint32_t {
+    uint32_t size = 0;
+    for (const auto& x : m_vIntervals) size += x.end - x.begin;
+    return size;
+}
+
+/// <summary>
+/// Adds [begin, end), merges overlapped or adjacent intervals.
+/// </summary>
+/// <param name="begin">The begin.</param>
+/// <param name="end">The end.</param>
+/// <returns></returns>
+void LongUI::CUIIntervalSet::Add(uint32_t begin, uint32_t end) noexcept {
+    if (begin >= end) return;
+    // [i, j) 与之重叠或相邻
+    const auto i = begin ? this->lower_end(begin - 1) : 0;
+    const auto j = this->upper_begin(end);
+    Interval x = { begin, end };
+    if (i < j) {
+        x.begin = std::min(begin, m_vIntervals[i].begin);
+        x.end = std::max(end, m_vIntervals[j - 1].end);
+        m_vIntervals.erase(i, j - i);
+    }
+    m_vIntervals.insert(i, x);
+}
+
+/// <summary>
+/// Removes [begin, end), splits interval if need.
+/// </summary>
+/// <param name="begin">The begin.</param>
+/// <param name="end">The end.</param>
+/// <returns></returns>
+void LongUI::CUIIntervalSet::Remove(uint32_t begin, uint32_t end) noexcept {
+    if (begin >= end) return;
+    // [i, j) 与之重叠
+    const auto i = this->lower_end(begin);
+    const auto j = this->upper_begin(end - 1);
+    if (i >= j) return;
+    // 两端剩余部分
+    const Interval left = { m_vIntervals[i].begin, begin };
+    const Interval right = { end, m_vIntervals[j - 1].end };
+    m_vIntervals.erase(i, j - i);
+    auto pos = i;
+    if (left.begin < left.end) m_vIntervals.insert(pos++, left);
+    if (right.begin < right.end) m_vIntervals.insert(pos, right);
+}
+
+/// <summary>
+/// Toggles [begin, end).
+/// </summary>
+/// <param name="begin">The begin.</param>
+/// <param name="end">The end.</param>
+/// <returns></returns>
+void LongUI::CUIIntervalSet::Toggle(uint32_t begin, uint32_t end) noexcept {
+    if (begin >= end) return;
+    const auto i = this->lower_end(begin);
+    const auto j = this->upper_begin(end - 1);
+    // 没有重叠: 直接添加
+    if (i >= j) return this->Add(begin, end);
+    // 收集区间内的空隙
+    EzContainer::EzVector<Interval> gaps;
+    auto cur = begin;
+    for (auto k = i; k < j; ++k) {
+        const auto& x = m_vIntervals[k];
+        if (x.begin > cur) gaps.push_back(Interval{ cur, x.begin });
+        cur = std::max(cur, std::min(x.end, end));
+    }
+    if (cur < end) gaps.push_back(Interval{ cur, end });
+    // 移除已有, 添加空隙
+    this->Remove(begin, end);
+    for (const auto& x : gaps) this->Add(x.begin, x.end);
+}
+
+/// <summary>
+/// Inserts a value slot at pos, values &gt;= pos move up by 1.
+/// </summary>
+/// <param name="pos">The position.</param>
+/// <param name="set">if set to <c>true</c>, pos is in set after inserting.</param>
+/// <returns></returns>
+void LongUI::CUIIntervalSet::InsertAt(uint32_t pos, bool set) noexcept {
+    auto i = this->lower_end(pos);
+    // 跨过pos的区间一分为二
+    if (i < m_vIntervals.size() && m_vIntervals[i].begin < pos) {
+        const Interval right = { pos, m_vIntervals[i].end };
+        m_vIntervals[i].end = pos;
+        m_vIntervals.insert(++i, right);
+    }
+    // 后面的整体后移
+    for (auto k = i; k < m_vIntervals.size(); ++k) {
+        ++m_vIntervals[k].begin;
+        ++m_vIntervals[k].end;
+    }
+    if (set) this->Add(pos, pos + 1);
+}
+
+/// <summary>
+/// Erases value slot at pos, values &gt; pos move down by 1.
+/// </summary>
+/// <param name="pos">The position.</param>
+/// <returns></returns>
+void LongUI::CUIIntervalSet::EraseAt(uint32_t pos) noexcept {
+    this->Remove(pos, pos + 1);
+    // 后面的整体前移
+    const auto i = this->upper_begin(pos);
+    for (auto k = i; k < m_vIntervals.size(); ++k) {
+        --m_vIntervals[k].begin;
+        --m_vIntervals[k].end;
+    }
+    // 前移后可能相邻
+    if (i && i < m_vIntervals.size() && m_vIntervals[i - 1].end == m_vIntervals[i].begin) {
+        m_vIntervals[i - 1].end = m_vIntervals[i].end;
+        m_vIntervals.erase(i, 1);
+    }
+}
+
+
+/// <summary>
+/// Folds case of string in place with simple 1:1 mapping, covers
+/// Latin-1, Latin Extended-A, Greek, Cyrillic and fullwidth Latin.
+/// </summary>
+/// <param name="str">The string.</param>
+/// <param name="len">The length.</param>
+/// <returns></returns>
+void LongUI::FoldCase(wchar_t str[], uint32_t len) noexcept {
+    for (uint32_t i = 0; i < len; ++i) {
+        const auto ch = uint32_t(uint16_t(str[i]));
+        uint32_t folded = ch;
+        // ASCII
+        if (ch < 0x80) { if (ch - 'A' < 26) folded = ch + 32; }
+        // Latin-1: 除去乘号
+        else if (ch - 0xC0 < 0x1F) { if (ch != 0xD7) folded = ch + 32; }
+        // Latin Extended-A: 大小写成对
+        else if (ch - 0x100 < 0x80) {
+            if (ch == 0x178) folded = 0xFF;
+            else if (ch - 0x139 < 0x10 || ch - 0x179 < 6) { if (ch & 1) folded = ch + 1; }
+            else if (ch != 0x130 && ch != 0x138 && ch < 0x17F) { if (!(ch & 1)) folded = ch + 1; }
+        }
+        // 希腊字母
+        else if (ch - 0x391 < 0x19) { if (ch != 0x3A2) folded = ch + 32; }
+        // 西里尔字母
+        else if (ch - 0x400 < 0x10) folded = ch + 80;
+        else if (ch - 0x410 < 0x20) folded = ch + 32;
+        // 全角拉丁字母
+        else if (ch - 0xFF21 < 26) folded = ch + 32;
+        str[i] = wchar_t(folded);
+    }
+}
+
+/// <summary>
+/// Makes the case-folded prefix key.
+/// </summary>
+/// <param name="str">The string.</param>
+/// <returns></returns>
+auto LongUI::MakeFoldedPrefixKey(const wchar_t* str) noexcept -> uint64_t {
+    assert(str && "bad argument");
+    // 前4个字符, 不足补0
+    wchar_t buf[4] = { 0 };
+    uint32_t len = 0;
+    for (; len < 4 && str[len]; ++len) buf[len] = str[len];
+    LongUI::FoldCase(buf, len);
+    uint64_t key = 0;
+    for (int i = 0; i < 4; ++i) key |= uint64_t(uint16_t(buf[i])) << ((3 - i) * 16);
+    return key;
+}
+
+/// <summary>
+/// Prepares the key buffer of rows with specified count.
+/// </summary>
+/// <param name="count">The count.</param>
+/// <returns>key buffer, null if OOM</returns>
+auto LongUI::CUIPrefixIndex::Prepare(uint32_t count) noexcept -> uint64_t* {
+    m_vEntries.clear();
+    m_vKeys.newsize(count);
+    if (!m_vKeys.isok()) { this->Clear(); return nullptr; }
+    return m_vKeys.data();
+}
+
+/// <summary>
+/// Sorts entries of all rows by key.
+/// </summary>
+/// <returns>false if OOM</returns>
+bool LongUI::CUIPrefixIndex::Build() noexcept {
+    const auto count = m_vKeys.size();
+    m_vEntries.newsize(count);
+    if (count && !m_vEntries.isok()) { this->Clear(); return false; }
+    const auto bn = m_vEntries.data();
+    for (uint32_t i = 0; i != count; ++i) bn[i] = { m_vKeys[i], i };
+    std::sort(bn, bn + count, [](const Entry& a, const Entry& b) noexcept {
+        return a.key < b.key;
+    });
+    return true;
+}
+
+/// <summary>
+/// Inserts rows [row, row + count) with keys.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <param name="keys">The keys.</param>
+/// <param name="count">The count.</param>
+/// <returns>false if OOM, index cleared</returns>
+bool LongUI::CUIPrefixIndex::Insert(uint32_t row, const uint64_t keys[], uint32_t count) noexcept {
+    const auto old = m_vKeys.size();
+    assert(row <= old && "out of range");
+    if (!count) return true;
+    m_vKeys.reserve(old + count);
+    m_vEntries.reserve(old + count);
+    if (m_vKeys.capacity() < old + count || m_vEntries.capacity() < old + count) {
+        this->Clear();
+        return false;
+    }
+    // 行键值后移
+    m_vKeys.newsize(old + count);
+    const auto kn = m_vKeys.data();
+    std::memmove(kn + row + count, kn + row, (old - row) * sizeof(uint64_t));
+    std::memcpy(kn + row, keys, count * sizeof(uint64_t));
+    // 之后的行号整体后移, 键值顺序不变
+    for (auto& entry : m_vEntries) if (entry.row >= row) entry.row += count;
+    auto cmp = [](const Entry& a, const Entry& b) noexcept { return a.key < b.key; };
+    // 单行: 二分插入
+    if (count == 1) {
+        m_vEntries.insert(this->lower_bound(keys[0]), Entry{ keys[0], row });
+        return true;
+    }
+    // 多行: 新项排序后归并
+    m_vEntries.newsize(old + count);
+    const auto bn = m_vEntries.data();
+    for (uint32_t i = 0; i != count; ++i) bn[old + i] = { keys[i], row + i };
+    std::sort(bn + old, bn + old + count, cmp);
+    std::inplace_merge(bn, bn + old, bn + old + count, cmp);
+    return true;
+}
+
+/// <summary>
+/// Erases the row.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <returns></returns>
+void LongUI::CUIPrefixIndex::Erase(uint32_t row) noexcept {
+    assert(row < m_vKeys.size() && "out of range");
+    m_vEntries.erase(this->find(row));
+    m_vKeys.erase(row);
+    // 之后的行号整体前移
+    for (auto& entry : m_vEntries) if (entry.row > row) --entry.row;
+}
+
+/// <summary>
+/// Moves row 'from' to 'to' with new key, rows between shift by 1.
+/// </summary>
+/// <param name="from">The row to move.</param>
+/// <param name="to">The target row.</param>
+/// <param name="key">The new key.</param>
+/// <returns></returns>
+void LongUI::CUIPrefixIndex::Move(uint32_t from, uint32_t to, uint64_t key) noexcept {
+    assert(from < m_vKeys.size() && to < m_vKeys.size() && "out of range");
+    if (from == to && m_vKeys[from] == key) return;
+    m_vEntries.erase(this->find(from));
+    const auto kn = m_vKeys.data();
+    // 向前: [to, from) 后移
+    if (to < from) {
+        std::memmove(kn + to + 1, kn + to, (from - to) * sizeof(uint64_t));
+        for (auto& entry : m_vEntries) if (entry.row >= to && entry.row < from) ++entry.row;
+    }
+    // 向后: (from, to] 前移
+    else if (from < to) {
+        std::memmove(kn + from, kn + from + 1, (to - from) * sizeof(uint64_t));
+        for (auto& entry : m_vEntries) if (entry.row > from && entry.row <= to) --entry.row;
+    }
+    kn[to] = key;
+    // 容量足够, 不会再分配
+    m_vEntries.insert(this->lower_bound(key), Entry{ key, to });
+}
+
+/// <summary>
+/// Reorders rows: new row i was row source[i].
+/// </summary>
+/// <param name="source">The source rows, a permutation of [0, count).</param>
+/// <returns>false if OOM, index cleared</returns>
+bool LongUI::CUIPrefixIndex::Permute(const uint32_t source[]) noexcept {
+    const auto count = m_vKeys.size();
+    EzContainer::EzVector<uint32_t> target;
+    EzContainer::EzVector<uint64_t> keys;
+    target.newsize(count);
+    keys.newsize(count);
+    if (count && !(target.isok() && keys.isok())) { this->Clear(); return false; }
+    for (uint32_t i = 0; i != count; ++i) {
+        target[source[i]] = i;
+        keys[i] = m_vKeys[source[i]];
+    }
+    // 只改行号, 键值顺序不变
+    for (auto& entry : m_vEntries) entry.row = target[entry.row];
+    m_vKeys = std::move(keys);
+    return true;
+}
+
+/// <summary>
+/// Index of first entry whose key &gt;= key.
+/// </summary>
+/// <param name="key">The key.</param>
+/// <returns></returns>
+auto LongUI::CUIPrefixIndex::lower_bound(uint64_t key) const noexcept -> uint32_t {
+    uint32_t lo = 0, hi = m_vEntries.size();
+    while (lo < hi) {
+        const auto mid = (lo + hi) / 2;
+        if (m_vEntries[mid].key < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/// <summary>
+/// Index of entry of row, searched in entries with same key.
+/// </summary>
+/// <param name="row">The row.</param>
+/// <returns></returns>
+auto LongUI::CUIPrefixIndex::find(uint32_t row) const noexcept -> uint32_t {
+    assert(row < m_vKeys.size() && "out of range");
+    auto i = this->lower_bound(m_vKeys[row]);
+    while (m_vEntries[i].row != row) ++i;
+    return i;
+}
+
+/// <summary>
+/// Finds entries [first, last) whose key matches first 4 chars of prefix.
+/// </summary>
+/// <param name="prefix">The prefix.</param>
+/// <param name="first">The first.</param>
+/// <param name="last">The last.</param>
+/// <returns></returns>
+void LongUI::CUIPrefixIndex::EqualRange(const wchar_t* prefix, uint32_t& first, uint32_t& last) const noexcept {
+    assert(prefix && "bad argument");
+    uint32_t len = 0;
+    while (len < 4 && prefix[len]) ++len;
+    // 空前缀: 全部
+    if (!len) { first = 0; last = m_vEntries.size(); return; }
+    // 未指定的低位任意
+    const auto key = LongUI::MakeFoldedPrefixKey(prefix);
+    const auto span = len < 4 ? (uint64_t(1) << ((4 - len) * 16)) : uint64_t(1);
+    first = this->lower_bound(key);
+    last = key + span > key ? this->lower_bound(key + span) : m_vEntries.size();
+}
+
+
+/// <summary>
+/// Finalizes an instance of the <see cref="CUIPieceTable"/> class.
+/// </summary>
+/// <returns></returns>
+LongUI::CUIPieceTable::~CUIPieceTable() noexcept {
+    LongUI::NormalFree(m_pBuffer);
+    LongUI::NormalFree(m_pNodes);
+    LongUI::NormalFree(m_pView);
+}
+
+/// <summary>
+/// Clears the text.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIPieceTable::Clear() noexcept {
+    m_cBuffer = 0;
+    m_cNodes = 0;
+    m_cPiece = 0;
+    m_ixRoot = NIL;
+    m_ixFree = NIL;
+    m_bViewDirty = true;
+}
+
+/// <summary>
+/// Sets the whole text.
+/// </summary>
+/// <param name="str">The string.</param>
+/// <param name="len">The length.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUIPieceTable::Set(const wchar_t* str, uint32_t len) noexcept {
+    this->Clear();
+    if (!len) return true;
+    if (!this->reserve_node(1) || !this->append(str, len)) return false;
+    m_ixRoot = this->new_node(0, len);
+    return true;
+}
+
+/// <summary>
+/// Updates the sum of node.
+/// </summary>
+/// <param name="t">The node.</param>
+/// <returns></returns>
+void LongUI::CUIPieceTable::update(uint32_t t) noexcept {
+    auto& node = m_pNodes[t];
+    node.sum = this->sum(node.left) + node.length + this->sum(node.right);
+}
+
+/// <summary>
+/// Reserves nodes for later new_node.
+/// </summary>
+/// <param name="count">The count.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUIPieceTable::reserve_node(uint32_t count) noexcept {
+    // 空闲链表
+    uint32_t freed = 0;
+    for (auto i = m_ixFree; i != NIL && freed < count; i = m_pNodes[i].left) ++freed;
+    if (m_cNodes + count - freed <= m_cNodeCap) return true;
+    // 扩容
+    const auto cap = std::max(m_cNodeCap * 2, uint32_t(64)) + count;
+    auto nodes = LongUI::NormalAllocT<Node>(cap);
+    if (!nodes) return false;
+    if (m_cNodes) std::memcpy(nodes, m_pNodes, m_cNodes * sizeof(Node));
+    LongUI::NormalFree(m_pNodes);
+    m_pNodes = nodes;
+    m_cNodeCap = cap;
+    return true;
+}
+
+/// <summary>
+/// New node, node pool must be reserved.
+/// </summary>
+/// <param name="offset">The offset in buffer.</param>
+/// <param name="length">The length.</param>
+/// <returns></returns>
+auto LongUI::CUIPieceTable::new_node(uint32_t offset, uint32_t length) noexcept -> uint32_t {
+    uint32_t t;
+    if (m_ixFree != NIL) {
+        t = m_ixFree;
+        m_ixFree = m_pNodes[t].left;
+    }
+    else {
+        assert(m_cNodes < m_cNodeCap && "call reserve_node first");
+        t = m_cNodes++;
+    }
+    // xorshift32
+    m_uSeed ^= m_uSeed << 13;
+    m_uSeed ^= m_uSeed >> 17;
+    m_uSeed ^= m_uSeed << 5;
+    m_pNodes[t] = { offset, length, length, m_uSeed, NIL, NIL };
+    ++m_cPiece;
+    return t;
+}
+
+/// <summary>
+/// Frees nodes of subtree.
+/// </summary>
+/// <param name="t">The subtree.</param>
+/// <returns></returns>
+void LongUI::CUIPieceTable::free_tree(uint32_t t) noexcept {
+    if (t == NIL) return;
+    const auto right = m_pNodes[t].right;
+    this->free_tree(m_pNodes[t].left);
+    m_pNodes[t].left = m_ixFree;
+    m_ixFree = t;
+    --m_cPiece;
+    this->free_tree(right);
+}
+
+/// <summary>
+/// Appends text to buffer.
+/// </summary>
+/// <param name="str">The string.</param>
+/// <param name="len">The length.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUIPieceTable::append(const wchar_t* str, uint32_t len) noexcept {
+    if (m_cBuffer + len > m_cBufferCap) {
+        const auto cap = std::max(m_cBufferCap + m_cBufferCap / 2, m_cBuffer + len) + 256;
+        auto buffer = LongUI::NormalAllocT<wchar_t>(cap);
+        if (!buffer) return false;
+        if (m_cBuffer) std::memcpy(buffer, m_pBuffer, m_cBuffer * sizeof(wchar_t));
+        LongUI::NormalFree(m_pBuffer);
+        m_pBuffer = buffer;
+        m_cBufferCap = cap;
+    }
+    std::memcpy(m_pBuffer + m_cBuffer, str, len * sizeof(wchar_t));
+    m_cBuffer += len;
+    return true;
+}
+
+/// <summary>
+/// Compacts buffer into one piece if unreferenced chars exceed both
+/// LongUIPieceCompactMin and length of text, amortized O(1) per edit.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIPieceTable::compact() noexcept {
+    const auto length = this->GetLength();
+    const auto unused = m_cBuffer - length;
+    if (unused < uint32_t(LongUIPieceCompactMin) || unused < length) return;
+    wchar_t* buffer = nullptr;
+    uint32_t cap = 0;
+    if (length) {
+        cap = length + length / 2 + 256;
+        buffer = LongUI::NormalAllocT<wchar_t>(cap);
+        // 内存不足时保持原样
+        if (!buffer) return;
+        this->copy(m_ixRoot, 0, length, buffer);
+    }
+    LongUI::NormalFree(m_pBuffer);
+    m_pBuffer = buffer;
+    m_cBuffer = length;
+    m_cBufferCap = cap;
+    // 节点池全部回收, 至少还有一个节点的容量
+    m_cNodes = 0;
+    m_cPiece = 0;
+    m_ixFree = NIL;
+    m_ixRoot = length ? this->new_node(0, length) : NIL;
+}
+
+/// <summary>
+/// Cuts the piece containing pos to make pos a boundary of pieces.
+/// </summary>
+/// <param name="pos">The position.</param>
+/// <returns></returns>
+void LongUI::CUIPieceTable::cut(uint32_t pos) noexcept {
+    // 查找包含位置的片段
+    auto t = m_ixRoot;
+    uint32_t k = 0;
+    for (auto x = pos; t != NIL; ) {
+        const auto& node = m_pNodes[t];
+        const auto lsum = this->sum(node.left);
+        if (x <= lsum) { if (x == lsum) return; t = node.left; }
+        else if (x < lsum + node.length) { k = x - lsum; break; }
+        else { x -= lsum + node.length; t = node.right; }
+    }
+    if (t == NIL) return;
+    // 截短片段, 路径上长度减少
+    const auto cut_len = m_pNodes[t].length - k;
+    const auto offset = m_pNodes[t].offset + k;
+    for (auto i = m_ixRoot, x = pos; ; ) {
+        auto& node = m_pNodes[i];
+        node.sum -= cut_len;
+        if (i == t) break;
+        const auto lsum = this->sum(node.left);
+        if (x < lsum) i = node.left;
+        else { x -= lsum + node.length; i = node.right; }
+    }
+    m_pNodes[t].length = k;
+    // 后半部分作为新片段插入
+    const auto node = this->new_node(offset, cut_len);
+    uint32_t l, r;
+    this->split(m_ixRoot, pos, l, r);
+    m_ixRoot = this->merge(this->merge(l, node), r);
+}
+
+/// <summary>
+/// Splits tree into [0, pos) and [pos, end), pos must be a boundary of pieces.
+/// </summary>
+/// <param name="t">The tree.</param>
+/// <param name="pos">The position.</param>
+/// <param name="l">The left tree.</param>
+/// <param name="r">The right tree.</param>
+/// <returns></returns>
+void LongUI::CUIPieceTable::split(uint32_t t, uint32_t pos, uint32_t& l, uint32_t& r) noexcept {
+    if (t == NIL) { l = r = NIL; return; }
+    const auto lsum = this->sum(m_pNodes[t].left);
+    // 在左子树
+    if (pos <= lsum) {
+        this->split(m_pNodes[t].left, pos, l, m_pNodes[t].left);
+        this->update(t);
+        r = t;
+    }
+    // 在右子树
+    else {
+        assert(pos >= lsum + m_pNodes[t].length && "call cut() first");
+        this->split(m_pNodes[t].right, pos - lsum - m_pNodes[t].length, m_pNodes[t].right, r);
+        this->update(t);
+        l = t;
+    }
+}
+
+/// <summary>
+/// Merges 2 trees.
+/// </summary>
+/// <param name="a">The left tree.</param>
+/// <param name="b">The right tree.</param>
+/// <returns></returns>
+auto LongUI::CUIPieceTable::merge(uint32_t a, uint32_t b) noexcept -> uint32_t {
+    if (a == NIL) return b;
+    if (b == NIL) return a;
+    if (m_pNodes[a].priority > m_pNodes[b].priority) {
+        m_pNodes[a].right = this->merge(m_pNodes[a].right, b);
+        this->update(a);
+        return a;
+    }
+    else {
+        m_pNodes[b].left = this->merge(a, m_pNodes[b].left);
+        this->update(b);
+        return b;
+    }
+}
+
+/// <summary>
+/// Inserts the text.
+/// </summary>
+/// <param name="pos">The position.</param>
+/// <param name="str">The string.</param>
+/// <param name="len">The length.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUIPieceTable::Insert(uint32_t pos, const wchar_t* str, uint32_t len) noexcept {
+    assert(pos <= this->GetLength() && "out of range");
+    if (!len) return true;
+    pos = std::min(pos, this->GetLength());
+    // 切开片段最多需要2个节点
+    const auto offset = m_cBuffer;
+    if (!this->reserve_node(2) || !this->append(str, len)) return false;
+    this->cut(pos);
+    uint32_t l, r;
+    this->split(m_ixRoot, pos, l, r);
+    // 连续输入: 左边最后片段正好在缓冲区末尾则直接延长
+    auto last = l;
+    while (last != NIL && m_pNodes[last].right != NIL) last = m_pNodes[last].right;
+    if (last != NIL && m_pNodes[last].offset + m_pNodes[last].length == offset) {
+        m_pNodes[last].length += len;
+        for (auto i = l; i != NIL; i = m_pNodes[i].right) m_pNodes[i].sum += len;
+        m_ixRoot = this->merge(l, r);
+    }
+    // 新片段
+    else {
+        const auto node = this->new_node(offset, len);
+        m_ixRoot = this->merge(this->merge(l, node), r);
+    }
+    this->compact();
+    m_bViewDirty = true;
+    return true;
+}
+
+/// <summary>
+/// Removes the text.
+/// </summary>
+/// <param name="pos">The position.</param>
+/// <param name="len">The length.</param>
+/// <returns></returns>
+void LongUI::CUIPieceTable::Remove(uint32_t pos, uint32_t len) noexcept {
+    const auto length = this->GetLength();
+    assert(pos <= length && pos + len <= length && "out of range");
+    if (pos >= length || !len) return;
+    len = std::min(len, length - pos);
+    // 切开片段最多需要2个节点
+    if (!this->reserve_node(2)) return;
+    this->cut(pos);
+    this->cut(pos + len);
+    uint32_t l, m, r;
+    this->split(m_ixRoot, pos, l, m);
+    this->split(m, len, m, r);
+    this->free_tree(m);
+    m_ixRoot = this->merge(l, r);
+    this->compact();
+    m_bViewDirty = true;
+}
+
+/// <summary>
+/// Gets the char at pos.
+/// </summary>
+/// <param name="pos">The position.</param>
+/// <returns></returns>
+auto LongUI::CUIPieceTable::GetChar(uint32_t pos) const noexcept -> wchar_t {
+    assert(pos < this->GetLength() && "out of range");
+    auto t = m_ixRoot;
+    while (t != NIL) {
+        const auto& node = m_pNodes[t];
+        const auto lsum = this->sum(node.left);
+        if (pos < lsum) t = node.left;
+        else if (pos < lsum + node.length) return m_pBuffer[node.offset + pos - lsum];
+        else { pos -= lsum + node.length; t = node.right; }
+    }
+    return 0;
+}
+
+/// <summary>
+/// Copies subtree range.
+/// </summary>
+/// <param name="t">The subtree.</param>
+/// <param name="pos">The position in subtree.</param>
+/// <param name="len">The length.</param>
+/// <param name="out">The output.</param>
+/// <returns>count copied</returns>
+auto LongUI::CUIPieceTable::copy(uint32_t t, uint32_t pos, uint32_t len, wchar_t* out) const noexcept -> uint32_t {
+    if (t == NIL || !len) return 0;
+    const auto& node = m_pNodes[t];
+    const auto lsum = this->sum(node.left);
+    const auto end = pos + len, nend = lsum + node.length;
+    uint32_t count = 0;
+    // 左子树
+    if (pos < lsum) {
+        count += this->copy(node.left, pos, std::min(end, lsum) - pos, out);
+    }
+    // 本片段
+    const auto a = std::max(pos, lsum), b = std::min(end, nend);
+    if (a < b) {
+        std::memcpy(out + count, m_pBuffer + node.offset + a - lsum, (b - a) * sizeof(wchar_t));
+        count += b - a;
+    }
+    // 右子树
+    if (end > nend) {
+        const auto rpos = std::max(pos, nend);
+        count += this->copy(node.right, rpos - nend, end - rpos, out + count);
+    }
+    return count;
+}
+
+/// <summary>
+/// Copies text in [pos, pos + len) to buffer.
+/// </summary>
+/// <param name="pos">The position.</param>
+/// <param name="len">The length.</param>
+/// <param name="out">The output.</param>
+/// <returns>count copied</returns>
+auto LongUI::CUIPieceTable::Copy(uint32_t pos, uint32_t len, wchar_t* out) const noexcept -> uint32_t {
+    assert(out && "bad argument");
+    const auto length = this->GetLength();
+    if (pos >= length) return 0;
+    return this->copy(m_ixRoot, pos, std::min(len, length - pos), out);
+}
+
+/// <summary>
+/// Contiguous view, rebuilt after text changed, O(n).
+/// </summary>
+/// <returns></returns>
+auto LongUI::CUIPieceTable::c_str() const noexcept -> const wchar_t* {
+    if (!m_bViewDirty) return m_pView;
+    const auto length = this->GetLength();
+    // 扩容
+    if (length + 1 > m_cViewCap) {
+        const auto cap = length + length / 4 + 64;
+        auto view = LongUI::NormalAllocT<wchar_t>(cap);
+        if (!view) {
+            assert(!"OOM");
+            return L"";
+        }
+        LongUI::NormalFree(m_pView);
+        m_pView = view;
+        m_cViewCap = cap;
+    }
+    m_pView[this->Copy(0, length, m_pView)] = 0;
+    m_bViewDirty = false;
+    return m_pView;
+}
+
+
+/// <summary>
+/// Finalizes an instance of the <see cref="CUILineIndex"/> class.
+/// </summary>
+/// <returns></returns>
+LongUI::CUILineIndex::~CUILineIndex() noexcept {
+    LongUI::NormalFree(m_pNodes);
+}
+
+/// <summary>
+/// Gets length of line break at str[i].
+/// </summary>
+/// <param name="str">The string.</param>
+/// <param name="i">The index.</param>
+/// <param name="len">The length of string.</param>
+/// <returns>0 for none, 2 for CRLF</returns>
+auto LongUI::CUILineIndex::BreakLength(const wchar_t* str, uint32_t i, uint32_t len) noexcept -> uint32_t {
+    switch (str[i])
+    {
+    case L'\r':
+        return i + 1 < len && str[i + 1] == L'\n' ? 2 : 1;
+    case L'\n': case 0x85: case 0x2028: case 0x2029:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/// <summary>
+/// Clears the index.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUILineIndex::Clear() noexcept {
+    m_cNodes = 0;
+    m_ixRoot = NIL;
+    m_ixFree = NIL;
+}
+
+/// <summary>
+/// Updates the sum and count of node.
+/// </summary>
+/// <param name="t">The node.</param>
+/// <returns></returns>
+void LongUI::CUILineIndex::update(uint32_t t) noexcept {
+    auto& node = m_pNodes[t];
+    node.sum = this->sum(node.left) + node.length + this->sum(node.right);
+    node.count = this->count(node.left) + 1 + this->count(node.right);
+}
+
+/// <summary>
+/// Reserves nodes for later new_node.
+/// </summary>
+/// <param name="count">The count.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUILineIndex::reserve_node(uint32_t count) noexcept {
+    // 空闲链表
+    uint32_t freed = 0;
+    for (auto i = m_ixFree; i != NIL && freed < count; i = m_pNodes[i].left) ++freed;
+    if (m_cNodes + count - freed <= m_cNodeCap) return true;
+    // 扩容
+    const auto cap = std::max(m_cNodeCap * 2, uint32_t(64)) + count;
+    auto nodes = LongUI::NormalAllocT<Node>(cap);
+    if (!nodes) return false;
+    if (m_cNodes) std::memcpy(nodes, m_pNodes, m_cNodes * sizeof(Node));
+    LongUI::NormalFree(m_pNodes);
+    m_pNodes = nodes;
+    m_cNodeCap = cap;
+    return true;
+}
+
+/// <summary>
+/// New node, node pool must be reserved.
+/// </summary>
+/// <param name="length">The length of line.</param>
+/// <param name="newline">The length of newline.</param>
+/// <returns></returns>
+auto LongUI::CUILineIndex::new_node(uint32_t length, uint32_t newline) noexcept -> uint32_t {
+    uint32_t t;
+    if (m_ixFree != NIL) {
+        t = m_ixFree;
+        m_ixFree = m_pNodes[t].left;
+    }
+    else {
+        assert(m_cNodes < m_cNodeCap && "call reserve_node first");
+        t = m_cNodes++;
+    }
+    // xorshift32
+    m_uSeed ^= m_uSeed << 13;
+    m_uSeed ^= m_uSeed >> 17;
+    m_uSeed ^= m_uSeed << 5;
+    m_pNodes[t] = { length, newline, length, 1, m_uSeed, NIL, NIL };
+    return t;
+}
+
+/// <summary>
+/// Frees nodes of subtree.
+/// </summary>
+/// <param name="t">The subtree.</param>
+/// <returns></returns>
+void LongUI::CUILineIndex::free_tree(uint32_t t) noexcept {
+    if (t == NIL) return;
+    const auto right = m_pNodes[t].right;
+    this->free_tree(m_pNodes[t].left);
+    m_pNodes[t].left = m_ixFree;
+    m_ixFree = t;
+    this->free_tree(right);
+}
+
+/// <summary>
+/// Splits tree into lines [0, line) and [line, end).
+/// </summary>
+/// <param name="t">The tree.</param>
+/// <param name="line">The line.</param>
+/// <param name="l">The left tree.</param>
+/// <param name="r">The right tree.</param>
+/// <returns></returns>
+void LongUI::CUILineIndex::split(uint32_t t, uint32_t line, uint32_t& l, uint32_t& r) noexcept {
+    if (t == NIL) { l = r = NIL; return; }
+    const auto lcount = this->count(m_pNodes[t].left);
+    // 在左子树
+    if (line <= lcount) {
+        this->split(m_pNodes[t].left, line, l, m_pNodes[t].left);
+        this->update(t);
+        r = t;
+    }
+    // 在右子树
+    else {
+        this->split(m_pNodes[t].right, line - lcount - 1, m_pNodes[t].right, r);
+        this->update(t);
+        l = t;
+    }
+}
+
+/// <summary>
+/// Merges 2 trees.
+/// </summary>
+/// <param name="a">The left tree.</param>
+/// <param name="b">The right tree.</param>
+/// <returns></returns>
+auto LongUI::CUILineIndex::merge(uint32_t a, uint32_t b) noexcept -> uint32_t {
+    if (a == NIL) return b;
+    if (b == NIL) return a;
+    if (m_pNodes[a].priority > m_pNodes[b].priority) {
+        m_pNodes[a].right = this->merge(m_pNodes[a].right, b);
+        this->update(a);
+        return a;
+    }
+    else {
+        m_pNodes[b].left = this->merge(a, m_pNodes[b].left);
+        this->update(b);
+        return b;
+    }
+}
+
+/// <summary>
+/// Makes tree of lines in text range [begin, end).
+/// </summary>
+/// <param name="text">The text.</param>
+/// <param name="begin">The begin.</param>
+/// <param name="end">The end.</param>
+/// <param name="tree">The output tree.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUILineIndex::make_lines(const CUIPieceTable& text, 
+    uint32_t begin, uint32_t end, uint32_t& tree) noexcept {
+    tree = NIL;
+    bool ok = false;
+    const auto len = end - begin;
+    const bool at_end = end == text.GetLength();
+    LongUI::SafeBuffer<wchar_t>(len + 1, [&](wchar_t* const buf) noexcept {
+        text.Copy(begin, len, buf);
+        // 统计行数
+        uint32_t lines = 1;
+        for (uint32_t i = 0; i < len; ++i) {
+            if (const auto nl = CUILineIndex::BreakLength(buf, i, len)) { ++lines; i += nl - 1; }
+        }
+        if (!this->reserve_node(lines)) return;
+        uint32_t start = 0;
+        for (uint32_t i = 0; i < len; ++i) {
+            if (const auto nl = CUILineIndex::BreakLength(buf, i, len)) {
+                i += nl - 1;
+                tree = this->merge(tree, this->new_node(i + 1 - start, nl));
+                start = i + 1;
+            }
+        }
+        // 剩余部分, 文本末尾总是保留(可能为空的)行
+        if (start < len || at_end) tree = this->merge(tree, this->new_node(len - start, 0));
+        ok = true;
+    });
+    return ok;
+}
+
+/// <summary>
+/// Builds index of whole text.
+/// </summary>
+/// <param name="text">The text.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUILineIndex::Build(const CUIPieceTable& text) noexcept {
+    this->Clear();
+    return this->make_lines(text, 0, text.GetLength(), m_ixRoot);
+}
+
+/// <summary>
+/// Updates index after [pos, pos + removed) was replaced with 
+/// inserted chars, only lines touched are rescanned.
+/// </summary>
+/// <param name="text">The new text.</param>
+/// <param name="pos">The position.</param>
+/// <param name="removed">The removed length.</param>
+/// <param name="inserted">The inserted length.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUILineIndex::Update(const CUIPieceTable& text, 
+    uint32_t pos, uint32_t removed, uint32_t inserted) noexcept {
+    if (m_ixRoot == NIL) return this->Build(text);
+    const auto lines = this->GetLineCount();
+    const auto length = text.GetLength();
+    // 受影响的行(旧位置)
+    auto first = this->GetLineFromPosition(pos);
+    auto last = this->GetLineFromPosition(pos + removed);
+    uint32_t begin, end;
+    this->find(first, begin);
+    // 前一行以CR结尾: 可能与插入的LF合并
+    if (first && pos == begin && text[pos - 1] == L'\r') this->find(--first, begin);
+    const auto node = this->find(last, end);
+    end += m_pNodes[node].length + inserted - removed;
+    // 以CR结尾: 可能与下一行的LF合并
+    while (last + 1 < lines && end < length && text[end - 1] == L'\r' && text[end] == L'\n') {
+        uint32_t start;
+        end += m_pNodes[this->find(++last, start)].length;
+    }
+    // 到达末尾: 包括末尾空行
+    if (end == length) last = lines - 1;
+    // 替换
+    uint32_t tree, l, m, r;
+    if (!this->make_lines(text, begin, end, tree)) return false;
+    this->split(m_ixRoot, first, l, m);
+    this->split(m, last - first + 1, m, r);
+    this->free_tree(m);
+    m_ixRoot = this->merge(this->merge(l, tree), r);
+    return true;
+}
+
+/// <summary>
+/// Finds node of line.
+/// </summary>
+/// <param name="line">The line.</param>
+/// <param name="start">The text position of line start.</param>
+/// <returns></returns>
+auto LongUI::CUILineIndex::find(uint32_t line, uint32_t& start) const noexcept -> uint32_t {
+    start = 0;
+    auto t = m_ixRoot;
+    while (t != NIL) {
+        const auto& node = m_pNodes[t];
+        const auto lcount = this->count(node.left);
+        if (line < lcount) t = node.left;
+        else if (line == lcount) { start += this->sum(node.left); return t; }
+        else {
+            line -= lcount + 1;
+            start += this->sum(node.left) + node.length;
+            t = node.right;
+        }
+    }
+    return NIL;
+}
+
+/// <summary>
+/// Gets the line containing text position.
+/// </summary>
+/// <param name="pos">The position.</param>
+/// <returns>last line if pos out of text</returns>
+auto LongUI::CUILineIndex::GetLineFromPosition(uint32_t pos) const noexcept -> uint32_t {
+    uint32_t line = 0;
+    auto t = m_ixRoot;
+    while (t != NIL) {
+        const auto& node = m_pNodes[t];
+        const auto lsum = this->sum(node.left);
+        if (pos < lsum) t = node.left;
+        else if (pos < lsum + node.length) return line + this->count(node.left);
+        else {
+            pos -= lsum + node.length;
+            line += this->count(node.left) + 1;
+            t = node.right;
+        }
+    }
+    // 文本末尾
+    const auto count = this->GetLineCount();
+    return count ? count - 1 : 0;
+}
+
+/// <summary>
+/// Gets the text position of line start.
+/// </summary>
+/// <param name="line">The line.</param>
+/// <returns>start of last line if line out of range</returns>
+auto LongUI::CUILineIndex::GetLineStart(uint32_t line) const noexcept -> uint32_t {
+    const auto count = this->GetLineCount();
+    uint32_t start = 0;
+    if (count) this->find(std::min(line, count - 1), start);
+    return start;
+}
+
+/// <summary>
+/// Gets the text position of line end, newline excluded.
+/// </summary>
+/// <param name="line">The line.</param>
+/// <returns>end of last line if line out of range</returns>
+auto LongUI::CUILineIndex::GetLineEnd(uint32_t line) const noexcept -> uint32_t {
+    const auto count = this->GetLineCount();
+    if (!count) return 0;
+    uint32_t start;
+    const auto& node = m_pNodes[this->find(std::min(line, count - 1), start)];
+    return start + node.length - node.newline;
+}
+
+
+/// <summary>
+/// Finalizes an instance of the <see cref="CUIUndoStack"/> class.
+/// </summary>
+/// <returns></returns>
+LongUI::CUIUndoStack::~CUIUndoStack() noexcept {
+    this->Clear();
+    LongUI::NormalFree(m_pScratch);
+}
+
+/// <summary>
+/// Clears all records.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIUndoStack::Clear() noexcept {
+    for (auto record : m_vRecords) LongUI::NormalFree(record);
+    m_vRecords.clear();
+    m_cUsage = 0;
+    m_uTop = 0;
+    m_bSealed = true;
+    m_bReplace = false;
+    // 组的前半部分已经丢失
+    m_bGroupBroken = m_bGrouping;
+    m_bGroupOpen = false;
+}
+
+/// <summary>
+/// Sets the budget in byte.
+/// </summary>
+/// <param name="bytes">The bytes.</param>
+/// <returns></returns>
+void LongUI::CUIUndoStack::SetBudget(uint32_t bytes) noexcept {
+    m_cBudget = bytes;
+    // 旧的重做记录依赖更早的记录: 一起丢弃
+    if (m_cUsage > m_cBudget) {
+        this->drop_redo();
+        this->trim();
+    }
+}
+
+/// <summary>
+/// Drops records to redo.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIUndoStack::drop_redo() noexcept {
+    while (m_vRecords.size() > m_uTop) {
+        auto record = m_vRecords.back();
+        m_cUsage -= uint32_t(sizeof(Record)) + record->capacity;
+        LongUI::NormalFree(record);
+        m_vRecords.pop_back();
+    }
+}
+
+/// <summary>
+/// Drops oldest groups while over budget, a group is never split.
+/// </summary>
+/// <returns>false if history cleared</returns>
+bool LongUI::CUIUndoStack::trim() noexcept {
+    while (m_cUsage > m_cBudget) {
+        // 最早的一组
+        uint32_t count = 1;
+        while (count < m_vRecords.size() && m_vRecords[count]->grouped) ++count;
+        // 最新的一组也超出预算: 更早的记录已经无效
+        if (count >= m_vRecords.size()) {
+            this->Clear();
+            return false;
+        }
+        for (uint32_t i = 0; i != count; ++i) {
+            auto record = m_vRecords[i];
+            m_cUsage -= uint32_t(sizeof(Record)) + record->capacity;
+            LongUI::NormalFree(record);
+        }
+        m_vRecords.erase(0u, count);
+        m_uTop = m_uTop > count ? m_uTop - count : 0;
+    }
+    return true;
+}
+
+/// <summary>
+/// Ensures the capacity of record.
+/// </summary>
+/// <param name="index">The index.</param>
+/// <param name="capacity">The capacity in byte.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUIUndoStack::reserve(uint32_t index, uint32_t capacity) noexcept {
+    auto record = m_vRecords[index];
+    if (capacity <= record->capacity) return true;
+    // 连续输入: 按倍数增长
+    capacity = std::max(capacity, record->capacity * 2);
+    auto grown = reinterpret_cast<Record*>(LongUI::NormalAlloc(sizeof(Record) + capacity));
+    if (!grown) return false;
+    std::memcpy(grown, record, sizeof(Record) + CUIUndoStack::raw_size(record));
+    m_cUsage += capacity - record->capacity;
+    grown->capacity = capacity;
+    LongUI::NormalFree(record);
+    m_vRecords[index] = grown;
+    return true;
+}
+
+/// <summary>
+/// Ensures the scratch buffer.
+/// </summary>
+/// <param name="bytes">The bytes.</param>
+/// <returns>null if OOM</returns>
+auto LongUI::CUIUndoStack::scratch(uint32_t bytes) noexcept -> char* {
+    if (bytes > m_cScratch) {
+        auto buffer = reinterpret_cast<char*>(LongUI::NormalAlloc(bytes));
+        if (!buffer) return nullptr;
+        LongUI::NormalFree(m_pScratch);
+        m_pScratch = buffer;
+        m_cScratch = bytes;
+    }
+    return m_pScratch;
+}
+
+/// <summary>
+/// Records an edit, typing edits are coalesced.
+/// </summary>
+/// <param name="pos">The position.</param>
+/// <param name="removed">The removed text.</param>
+/// <param name="rlen">The length of removed text.</param>
+/// <param name="inserted">The inserted text.</param>
+/// <param name="ilen">The length of inserted text.</param>
+/// <param name="typing">if set to <c>true</c> [typing].</param>
+/// <returns>false if history dropped</returns>
+bool LongUI::CUIUndoStack::Push(uint32_t pos, const wchar_t* removed, uint32_t rlen,
+    const wchar_t* inserted, uint32_t ilen, bool typing) noexcept {
+    if (!rlen && !ilen) return true;
+    // 组的前半部分已经丢失: 不再记录
+    if (m_bGroupBroken) return false;
+    this->drop_redo();
+    const auto sealed = m_bSealed;
+    const auto replace = m_bReplace && rlen && !ilen;
+    // 粘贴等非输入的插入之后不再合并
+    m_bSealed = !typing && ilen;
+    m_bReplace = false;
+    // 尝试合并到最新记录, 组内不合并
+    if (m_uTop && !sealed && !m_bGrouping && !m_vRecords[m_uTop - 1]->packed) {
+        const auto index = m_uTop - 1;
+        const auto top = m_vRecords[index];
+        const auto size = CUIUndoStack::raw_size(top);
+        // 输入: 替换同一次输入删除的选择区, 或者连续输入(空白之后开始新的单词则不合并)
+        if (!rlen && typing && pos == top->position + top->inserted) {
+            const auto text = reinterpret_cast<const wchar_t*>(CUIUndoStack::payload(top));
+            const bool coalesce = top->inserted ? (top->typing
+                && !(std::iswspace(text[top->removed + top->inserted - 1]) && !std::iswspace(inserted[0])))
+                : top->replace;
+            if (coalesce) {
+                if (!this->reserve(index, size + ilen * uint32_t(sizeof(wchar_t)))) {
+                    this->Clear();
+                    return false;
+                }
+                auto record = m_vRecords[index];
+                std::memcpy(CUIUndoStack::payload(record) + size, inserted, ilen * sizeof(wchar_t));
+                record->inserted += ilen;
+                record->typing = typing;
+                return this->trim();
+            }
+        }
+        // 删除: 连续退格或者删除键
+        else if (!ilen && typing && top->typing && !top->inserted
+            && (pos + rlen == top->position || pos == top->position)) {
+            if (!this->reserve(index, size + rlen * uint32_t(sizeof(wchar_t)))) {
+                this->Clear();
+                return false;
+            }
+            auto record = m_vRecords[index];
+            auto data = CUIUndoStack::payload(record);
+            const auto bytes = rlen * sizeof(wchar_t);
+            // 退格: 在前面
+            if (pos + rlen == record->position) {
+                std::memmove(data + bytes, data, size);
+                std::memcpy(data, removed, bytes);
+                record->position = pos;
+            }
+            // 删除键: 在后面
+            else std::memcpy(data + size, removed, bytes);
+            record->removed += rlen;
+            return this->trim();
+        }
+    }
+    // 更早的记录可以压缩了
+    if (m_uTop) this->pack(m_uTop - 1);
+    // 新的记录
+    const auto rbytes = rlen * uint32_t(sizeof(wchar_t));
+    const auto capacity = rbytes + ilen * uint32_t(sizeof(wchar_t));
+    auto record = reinterpret_cast<Record*>(LongUI::NormalAlloc(sizeof(Record) + capacity));
+    if (!record) {
+        this->Clear();
+        return false;
+    }
+    record->position = pos;
+    record->removed = rlen;
+    record->inserted = ilen;
+    record->capacity = capacity;
+    record->packed = 0;
+    record->typing = typing;
+    record->replace = replace;
+    record->grouped = m_bGroupOpen;
+    if (rlen) std::memcpy(CUIUndoStack::payload(record), removed, rbytes);
+    if (ilen) std::memcpy(CUIUndoStack::payload(record) + rbytes, inserted, ilen * sizeof(wchar_t));
+    m_vRecords.push_back(record);
+    if (!m_vRecords.isok()) {
+        LongUI::NormalFree(record);
+        this->Clear();
+        return false;
+    }
+    m_cUsage += uint32_t(sizeof(Record)) + capacity;
+    ++m_uTop;
+    m_bGroupOpen = m_bGrouping;
+    return this->trim();
+}
+
+/// <summary>
+/// Compresses the record with lz4 if LONGUI_WITH_LZ4_UNDO.
+/// </summary>
+/// <param name="index">The index.</param>
+/// <returns></returns>
+void LongUI::CUIUndoStack::pack(uint32_t index) noexcept {
+#ifdef LONGUI_WITH_LZ4_UNDO
+    auto record = m_vRecords[index];
+    const auto size = CUIUndoStack::raw_size(record);
+    if (record->packed || size < LongUIUndoPackThreshold) return;
+    // 压缩到临时缓冲区
+    const auto bound = uint32_t(::LZ4_compressBound(int(size)));
+    auto buffer = this->scratch(bound);
+    if (!buffer) return;
+    const auto packed = ::LZ4_compress_default(CUIUndoStack::payload(record), buffer, int(size), int(bound));
+    if (packed <= 0 || uint32_t(packed) >= size) return;
+    // 替换为压缩后的记录
+    auto compact = reinterpret_cast<Record*>(LongUI::NormalAlloc(sizeof(Record) + packed));
+    if (!compact) return;
+    *compact = *record;
+    compact->capacity = uint32_t(packed);
+    compact->packed = uint32_t(packed);
+    std::memcpy(CUIUndoStack::payload(compact), buffer, packed);
+    m_cUsage -= record->capacity - compact->capacity;
+    LongUI::NormalFree(record);
+    m_vRecords[index] = compact;
+#else
+    UNREFERENCED_PARAMETER(index);
+#endif
+}
+
+/// <summary>
+/// Gets the delta of record.
+/// </summary>
+/// <param name="index">The index.</param>
+/// <param name="delta">The delta.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUIUndoStack::unpack(uint32_t index, Delta& delta) noexcept {
+    auto record = m_vRecords[index];
+    auto data = CUIUndoStack::payload(record);
+#ifdef LONGUI_WITH_LZ4_UNDO
+    // 解压到临时缓冲区
+    if (record->packed) {
+        const auto size = CUIUndoStack::raw_size(record);
+        auto buffer = this->scratch(size);
+        if (!buffer) return false;
+        const auto code = ::LZ4_decompress_safe(data, buffer, int(record->packed), int(size));
+        if (code != int(size)) {
+            assert(!"bad lz4 data");
+            return false;
+        }
+        data = buffer;
+    }
+#else
+    assert(!record->packed && "packed without LONGUI_WITH_LZ4_UNDO");
+#endif
+    const auto text = reinterpret_cast<const wchar_t*>(data);
+    delta.position = record->position;
+    delta.removed_length = record->removed;
+    delta.inserted_length = record->inserted;
+    delta.removed = text;
+    delta.inserted = text + record->removed;
+    delta.chained = false;
+    return true;
+}
+
+/// <summary>
+/// Gets the edit to undo: caller should replace inserted text with removed text.
+/// </summary>
+/// <param name="delta">The delta.</param>
+/// <returns></returns>
+bool LongUI::CUIUndoStack::Undo(Delta& delta) noexcept {
+    if (!m_uTop || !this->unpack(m_uTop - 1, delta)) return false;
+    delta.chained = m_vRecords[m_uTop - 1]->grouped;
+    --m_uTop;
+    m_bSealed = true;
+    return true;
+}
+
+/// <summary>
+/// Gets the edit to redo: caller should replace removed text with inserted text.
+/// </summary>
+/// <param name="delta">The delta.</param>
+/// <returns></returns>
+bool LongUI::CUIUndoStack::Redo(Delta& delta) noexcept {
+    if (m_uTop >= m_vRecords.size() || !this->unpack(m_uTop, delta)) return false;
+    ++m_uTop;
+    delta.chained = m_uTop < m_vRecords.size() && m_vRecords[m_uTop]->grouped;
+    m_bSealed = true;
+    return true;
+}
+
+
+/// <summary>
+/// Finalizes an instance of the <see cref="CUITextFinder"/> class.
+/// </summary>
+/// <returns></returns>
+LongUI::CUITextFinder::~CUITextFinder() noexcept {
+    LongUI::NormalFree(m_pPattern);
+}
+
+/// <summary>
+/// Sets the pattern, builds the Horspool skip table.
+/// </summary>
+/// <param name="pattern">The pattern.</param>
+/// <param name="len">The length.</param>
+/// <returns>false if OOM or empty</returns>
+bool LongUI::CUITextFinder::Set(const wchar_t* pattern, uint32_t len) noexcept {
+    LongUI::NormalFree(m_pPattern);
+    m_pPattern = nullptr;
+    m_cPattern = 0;
+    if (!len) return false;
+    m_pPattern = LongUI::NormalAllocT<wchar_t>(len);
+    if (!m_pPattern) return false;
+    m_cPattern = len;
+    std::memcpy(m_pPattern, pattern, len * sizeof(wchar_t));
+    // 首尾字符
+    m_chFirst = pattern[0];
+    m_chLast = pattern[len - 1];
+    // 跳转表: 低字节相同的字符共用, 取最小跳转
+    for (auto& skip : m_aSkip) skip = len;
+    for (uint32_t i = 0; i + 1 < len; ++i) {
+        m_aSkip[m_pPattern[i] & 0xFF] = len - 1 - i;
+    }
+    return true;
+}
+
+/// <summary>
+/// Verifies the match at text.
+/// </summary>
+/// <param name="text">The text.</param>
+/// <returns></returns>
+bool LongUI::CUITextFinder::verify(const wchar_t* text) const noexcept {
+    return !std::memcmp(text, m_pPattern, m_cPattern * sizeof(wchar_t));
+}
+
+/// <summary>
+/// Finds the first match in text[from, len).
+/// </summary>
+/// <param name="text">The text.</param>
+/// <param name="len">The length.</param>
+/// <param name="from">From.</param>
+/// <returns>position of match, NPOS if not found</returns>
+auto LongUI::CUITextFinder::Find(const wchar_t* text, uint32_t len, uint32_t from) const noexcept -> uint32_t {
+    if (!m_cPattern || from > len || len - from < m_cPattern) return NPOS;
+#ifdef LONGUI_WITH_SSE2
+    if (m_cPattern < HORSPOOL_LENGTH) return this->find_sse2(text, len, from);
+#endif
+    return this->find_horspool(text, len, from);
+}
+
+/// <summary>
+/// Finds all non-overlapped matches.
+/// </summary>
+/// <param name="text">The text.</param>
+/// <param name="len">The length.</param>
+/// <param name="out">The output.</param>
+/// <returns>count of matches</returns>
+auto LongUI::CUITextFinder::FindAll(const wchar_t* text, uint32_t len, 
+    EzContainer::EzVector<uint32_t>& out) const noexcept -> uint32_t {
+    uint32_t count = 0;
+    for (auto pos = this->Find(text, len); pos != NPOS; pos = this->Find(text, len, pos + m_cPattern)) {
+        out.push_back(pos);
+        ++count;
+    }
+    return out.isok() ? count : 0;
+}
+
+/// <summary>
+/// Horspool search, skip by last char of window.
+/// </summary>
+/// <param name="text">The text.</param>
+/// <param name="len">The length.</param>
+/// <param name="from">From.</param>
+/// <returns></returns>
+auto LongUI::CUITextFinder::find_horspool(const wchar_t* text, uint32_t len, uint32_t from) const noexcept -> uint32_t {
+    const auto last = m_cPattern - 1;
+    for (auto i = from; len - i >= m_cPattern; ) {
+        const auto ch = text[i + last];
+        if (ch == m_chLast && this->verify(text + i)) return i;
+        i += m_aSkip[ch & 0xFF];
+    }
+    return NPOS;
+}
+
+#ifdef LONGUI_WITH_SSE2
+/// <summary>
+/// SSE2 search, 8 windows tested at once by first and last 
+/// char, candidates verified, remaining part by Horspool.
+/// </summary>
+/// <param name="text">The text.</param>
+/// <param name="len">The length.</param>
+/// <param name="from">From.</param>
+/// <returns></returns>
+auto LongUI::CUITextFinder::find_sse2(const wchar_t* text, uint32_t len, uint32_t from) const noexcept -> uint32_t {
+    static_assert(sizeof(wchar_t) == sizeof(int16_t), "utf-16 only");
+    const auto last = m_cPattern - 1;
+    const auto first = _mm_set1_epi16(short(m_chFirst));
+    const auto lastch = _mm_set1_epi16(short(m_chLast));
+    auto i = from;
+    for (; len - i >= last + 8; i += 8) {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+        const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + last));
+        const auto eqa = _mm_cmpeq_epi16(a, first);
+        const auto eqb = _mm_cmpeq_epi16(b, lastch);
+        // 每个字符两位
+        auto mask = uint32_t(_mm_movemask_epi8(_mm_and_si128(eqa, eqb)));
+        for (uint32_t j = 0; mask; ++j, mask >>= 2) {
+            if ((mask & 1) && this->verify(text + i + j)) return i + j;
+        }
+    }
+    return this->find_horspool(text, len, i);
+}
+#endif
+
+
+/// <summary>
+/// Appends run, same style as last one will be merged.
+/// </summary>
+/// <param name="position">The position.</param>
+/// <param name="style">The style.</param>
+/// <returns></returns>
+void LongUI::CUIStyleRuns::Append(uint32_t position, uint32_t style) noexcept {
+    if (!m_vRuns.empty()) {
+        auto& last = m_vRuns.back();
+        assert(position >= last.position && "bad position");
+        // 同一位置: 覆盖, 可能与前一个合并
+        if (last.position == position) {
+            last.style = style;
+            const auto size = m_vRuns.size();
+            if (size > 1 && m_vRuns[size - 2].style == style) m_vRuns.pop_back();
+            return;
+        }
+        if (last.style == style) return;
+    }
+    m_vRuns.push_back(Run{ position, style });
+}
+
+/// <summary>
+/// Index of first run whose position &gt; position.
+/// </summary>
+/// <param name="position">The position.</param>
+/// <returns></returns>
+auto LongUI::CUIStyleRuns::upper(uint32_t position) const noexcept -> uint32_t {
+    uint32_t lo = 0, hi = m_vRuns.size();
+    while (lo < hi) {
+        const auto mid = (lo + hi) / 2;
+        if (m_vRuns[mid].position > position) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+/// <summary>
+/// Finds the run containing position.
+/// </summary>
+/// <param name="position">The position.</param>
+/// <returns>count of runs if before first run</returns>
+auto LongUI::CUIStyleRuns::FindRun(uint32_t position) const noexcept -> uint32_t {
+    const auto i = this->upper(position);
+    return i ? i - 1 : m_vRuns.size();
+}
+
+/// <summary>
+/// Gets the style at position.
+/// </summary>
+/// <param name="position">The position.</param>
+/// <returns></returns>
+auto LongUI::CUIStyleRuns::GetStyle(uint32_t position) const noexcept -> uint32_t {
+    const auto i = this->FindRun(position);
+    return i < m_vRuns.size() ? m_vRuns[i].style : 0;
+}
+
+/// <summary>
+/// Replaces runs in old range [begin, old_end) with runs in new range
+/// [begin, new_end), style at old_end kept, later runs shifted.
+/// </summary>
+/// <param name="begin">The begin.</param>
+/// <param name="old_end">The old end.</param>
+/// <param name="new_end">The new end.</param>
+/// <param name="runs">The new runs.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUIStyleRuns::Splice(uint32_t begin, uint32_t old_end, 
+    uint32_t new_end, const CUIStyleRuns& runs) noexcept {
+    assert(begin <= old_end && begin <= new_end && "bad range");
+    const auto size = m_vRuns.size();
+    const auto tail = this->GetStyle(old_end);
+    // [i, j): 位于旧范围内的块
+    const auto i = begin ? this->upper(begin - 1) : 0;
+    auto j = old_end ? this->upper(old_end - 1) : 0;
+    // 中间部分, 与两侧相同样式的合并
+    EzContainer::EzVector<Run> mid;
+    uint32_t count = 0;
+    auto prev = i ? m_vRuns[i - 1].style : 0u;
+    for (const auto& run : runs.m_vRuns) {
+        assert(run.position >= begin && "out of range");
+        // 空行位于末尾
+        if (run.position >= new_end) break;
+        if (run.style == prev) continue;
+        mid.push_back(run); ++count;
+        prev = run.style;
+    }
+    // 旧范围末尾已有块
+    if (j < size && m_vRuns[j].position == old_end) {
+        if (m_vRuns[j].style == prev) ++j;
+    }
+    else if (tail != prev) { mid.push_back(Run{ new_end, tail }); ++count; }
+    if (mid.size() != count) return false;
+    // 替换
+    const auto newsize = size - (j - i) + count;
+    if (newsize > size) {
+        m_vRuns.resize(newsize);
+        if (!m_vRuns.isok()) return false;
+    }
+    const auto data = m_vRuns.data();
+    std::memmove(data + i + count, data + j, (size - j) * sizeof(Run));
+    if (count) std::memcpy(data + i, mid.data(), count * sizeof(Run));
+    // 后续的块仅仅移动位置
+    for (auto index = i + count; index < newsize; ++index) {
+        data[index].position += new_end - old_end;
+    }
+    if (newsize < size) m_vRuns.resize(newsize);
+    return true;
+}
+
+/// <summary>
+/// Tokenizes a line, style of line start reset to default.
+/// </summary>
+/// <param name="str">The line string.</param>
+/// <param name="length">The length.</param>
+/// <param name="base">The text position of line start.</param>
+/// <param name="state">The state at line start.</param>
+/// <param name="runs">The output runs.</param>
+/// <returns>state at line end</returns>
+auto LongUI::CUIHighlighter::tokenize(const wchar_t* str, uint32_t length, 
+    uint32_t base, uint32_t state, CUIStyleRuns& runs) noexcept -> uint32_t {
+    runs.Append(base, 0);
+    return m_pTokenizer->Tokenize(str, length, state, base, runs);
+}
+
+/// <summary>
+/// Tokenizes whole text.
+/// </summary>
+/// <param name="text">The text.</param>
+/// <param name="lines">The line index of text.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUIHighlighter::Build(const CUIPieceTable& text, const CUILineIndex& lines) noexcept {
+    this->Clear();
+    if (!m_pTokenizer) return true;
+    const auto count = lines.GetLineCount();
+    const auto length = text.GetLength();
+    if (!count) return true;
+    m_vStates.resize(count);
+    if (!m_vStates.isok()) return false;
+    bool ok = false;
+    LongUI::SafeBuffer<wchar_t>(length + 1, [&](wchar_t* const buf) noexcept {
+        text.Copy(0, length, buf);
+        uint32_t state = 0;
+        for (uint32_t line = 0; line < count; ++line) {
+            const auto start = lines.GetLineStart(line);
+            m_vStates[line] = state;
+            state = this->tokenize(buf + start, lines.GetLineEnd(line) - start, start, state, m_runs);
+        }
+        ok = m_runs.IsOk();
+    });
+    if (!ok) this->Clear();
+    return ok;
+}
+
+/// <summary>
+/// Updates runs after [pos, pos + removed) was replaced with inserted
+/// chars, lines are re-tokenized from the one before pos until state 
+/// at line start converges after edited lines.
+/// </summary>
+/// <param name="text">The new text.</param>
+/// <param name="lines">The updated line index.</param>
+/// <param name="pos">The position.</param>
+/// <param name="removed">The removed length.</param>
+/// <param name="inserted">The inserted length.</param>
+/// <param name="begin">The begin of restyled range.</param>
+/// <param name="end">The end of restyled range.</param>
+/// <returns>false if OOM</returns>
+bool LongUI::CUIHighlighter::Update(const CUIPieceTable& text, const CUILineIndex& lines,
+    uint32_t pos, uint32_t removed, uint32_t inserted, uint32_t& begin, uint32_t& end) noexcept {
+    begin = end = pos;
+    if (!m_pTokenizer) return true;
+    const auto count = lines.GetLineCount();
+    const auto old_count = m_vStates.size();
+    // 受影响的行: 从前一行开始, 行尾CR可能与插入的LF合并
+    auto first = lines.GetLineFromPosition(pos);
+    if (first) --first;
+    const auto last = lines.GetLineFromPosition(pos + inserted);
+    const auto old_last = last + old_count - count;
+    if (!count || old_last < first || old_last >= old_count) {
+        begin = 0; end = text.GetLength();
+        return this->Build(text, lines);
+    }
+    // 状态: (first, old_last] 替换为 (first, last]
+    if (count > old_count) {
+        m_vStates.resize(count);
+        if (!m_vStates.isok()) { this->Clear(); return false; }
+    }
+    const auto states = m_vStates.data();
+    std::memmove(states + last + 1, states + old_last + 1, (old_count - old_last - 1) * sizeof(uint32_t));
+    if (count < old_count) m_vStates.resize(count);
+    // 重新分词直到行首状态与之前相同
+    CUIStyleRuns runs;
+    auto state = m_vStates[first];
+    auto line = first;
+    while (true) {
+        const auto start = lines.GetLineStart(line);
+        const auto length = lines.GetLineEnd(line) - start;
+        LongUI::SafeBuffer<wchar_t>(length + 1, [&](wchar_t* const buf) noexcept {
+            text.Copy(start, length, buf);
+            state = this->tokenize(buf, length, start, state, runs);
+        });
+        if (++line >= count) break;
+        if (line > last && m_vStates[line] == state) break;
+        m_vStates[line] = state;
+    }
+    begin = lines.GetLineStart(first);
+    end = line < count ? lines.GetLineStart(line) : text.GetLength();
+    if (!runs.IsOk() || !m_runs.Splice(begin, end + removed - inserted, end, runs)) {
+        this->Clear();
+        return false;
+    }
+    return true;
+}
+
+/// <summary>
+/// Tokenizes a line of xml.
+/// </summary>
+/// <param name="str">The line string.</param>
+/// <param name="length">The length.</param>
+/// <param name="state">The state at line start.</param>
+/// <param name="base">The text position of line start.</param>
+/// <param name="runs">The output runs.</param>
+/// <returns>state at line end</returns>
+auto LongUI::CUIXmlTokenizer::Tokenize(const wchar_t* str, uint32_t length, 
+    uint32_t state, uint32_t base, CUIStyleRuns& runs) noexcept -> uint32_t {
+    // 名称字符
+    const auto is_name = [](wchar_t ch) noexcept {
+        return (ch >= L'a' && ch <= L'z') || (ch >= L'A' && ch <= L'Z') || (ch >= L'0' && ch <= L'9')
+            || ch == L'_' || ch == L':' || ch == L'-' || ch == L'.' || ch >= 0x80;
+    };
+    // 检查前缀
+    const auto starts = [=](uint32_t i, const wchar_t* prefix, uint32_t len) noexcept {
+        return i + len <= length && !std::wmemcmp(str + i, prefix, len);
+    };
+    // 查找结束符, 返回结束符之后的位置
+    const auto close = [=, &state](uint32_t i, const wchar_t* token, uint32_t len) noexcept {
+        for (; i + len <= length; ++i) {
+            if (!std::wmemcmp(str + i, token, len)) { state = State_Text; return i + len; }
+        }
+        return length;
+    };
+    uint32_t i = 0;
+    while (i < length) {
+        const auto ch = str[i];
+        switch (state)
+        {
+        case State_Text:
+            if (ch == L'<') {
+                if (starts(i, L"<!--", 4)) {
+                    runs.Append(base + i, Style_Comment);
+                    state = State_Comment; i += 4;
+                }
+                else if (starts(i, L"<![CDATA[", 9)) {
+                    runs.Append(base + i, Style_CData);
+                    state = State_CData; i += 9;
+                }
+                else if (starts(i, L"<?", 2)) {
+                    runs.Append(base + i, Style_Instruction);
+                    state = State_Instruction; i += 2;
+                }
+                else if (starts(i, L"<!", 2)) {
+                    runs.Append(base + i, Style_Declaration);
+                    state = State_Declaration; i += 2;
+                }
+                else {
+                    runs.Append(base + i, Style_Delimiter);
+                    if (++i < length && str[i] == L'/') ++i;
+                    // 元素名
+                    if (i < length && is_name(str[i])) {
+                        runs.Append(base + i, Style_Element);
+                        while (i < length && is_name(str[i])) ++i;
+                    }
+                    state = State_Tag;
+                }
+            }
+            else if (ch == L'&') {
+                runs.Append(base + i, Style_Entity);
+                if (++i < length && str[i] == L'#') ++i;
+                while (i < length && is_name(str[i])) ++i;
+                if (i < length && str[i] == L';') ++i;
+            }
+            else {
+                runs.Append(base + i, Style_Text);
+                while (i < length && str[i] != L'<' && str[i] != L'&') ++i;
+            }
+            break;
+        case State_Tag:
+            if (ch == L'"' || ch == L'\'') {
+                runs.Append(base + i, Style_Value);
+                state = ch == L'"' ? State_ValueDQ : State_ValueSQ;
+                ++i;
+            }
+            else if (ch == L'>' || ch == L'/' || ch == L'=') {
+                runs.Append(base + i, Style_Delimiter);
+                if (ch == L'>') state = State_Text;
+                ++i;
+            }
+            else if (std::iswspace(ch)) {
+                runs.Append(base + i, Style_Text);
+                while (i < length && std::iswspace(str[i])) ++i;
+            }
+            else {
+                runs.Append(base + i, Style_Attribute);
+                do { ++i; } while (i < length && is_name(str[i]));
+            }
+            break;
+        case State_ValueDQ: case State_ValueSQ:
+        {
+            const wchar_t quote = state == State_ValueDQ ? L'"' : L'\'';
+            runs.Append(base + i, Style_Value);
+            while (i < length && str[i] != quote) ++i;
+            if (i < length) { ++i; state = State_Tag; }
+            break;
+        }
+        case State_Comment:
+            runs.Append(base + i, Style_Comment);
+            i = close(i, L"-->", 3);
+            break;
+        case State_CData:
+            runs.Append(base + i, Style_CData);
+            i = close(i, L"]]>", 3);
+            break;
+        case State_Instruction:
+            runs.Append(base + i, Style_Instruction);
+            i = close(i, L"?>", 2);
+            break;
+        case State_Declaration:
+            runs.Append(base + i, Style_Declaration);
+            i = close(i, L">", 1);
+            break;
+        default:
+            state = State_Text;
+        }
+    }
+    return state;
+}
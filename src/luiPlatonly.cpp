@@ -4,11 +4,13 @@
 #include "Platonly/luiPoHlper.h"
 #include "Platless/luiPlUtil.h"
 #include "Platless/luiPlHlper.h"
+#include "Platless/luiPlSort.h"
 #include "Graphics/luiGrD2d.h"
 #include "LongUI/luiUiXml.h"
 #ifdef _DEBUG
 #include "Core/luiManager.h"
 #endif
+#include <algorithm>
 
 
 // longui
@@ -51,6 +53,208 @@ LongUINoinline bool LongUI::Helper::Timer::Update() noexcept {
     return false;
 }
 
+/// <summary>
+/// Gets the remain time in ms.
+/// </summary>
+/// <returns></returns>
+auto LongUI::Helper::Timer::GetRemain() const noexcept -> uint32_t {
+    // 经过时间
+    const uint32_t pass = ::timeGetTime() - m_dwLastCount;
+    // Update() 在超过时间后才返回true
+    return pass > m_dwTime ? 0 : m_dwTime - pass + 1;
+}
+
+/// <summary>
+/// Initializes a new instance of the <see cref="FramePacer"/> class.
+/// </summary>
+LongUI::Helper::FramePacer::FramePacer() noexcept {
+    LARGE_INTEGER freq; ::QueryPerformanceFrequency(&freq);
+    m_i64Freq = freq.QuadPart;
+    this->refresh_period();
+}
+
+/// <summary>
+/// Starts pacing.
+/// </summary>
+/// <returns></returns>
+void LongUI::Helper::FramePacer::Start() noexcept {
+    // Sleep 精度提高到 1ms
+    if (!m_bStarted) ::timeBeginPeriod(1);
+    m_bStarted = true;
+    // 高精度计时器(Win10 1803+), 不支持则退回普通计时器
+    if (!m_hTimer) {
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+        constexpr DWORD CREATE_WAITABLE_TIMER_HIGH_RESOLUTION = 0x00000002;
+#endif
+        m_hTimer = ::CreateWaitableTimerExW(
+            nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS
+        );
+        if (!m_hTimer) m_hTimer = ::CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+    }
+    this->Reset();
+}
+
+/// <summary>
+/// Stops pacing.
+/// </summary>
+/// <returns></returns>
+void LongUI::Helper::FramePacer::Stop() noexcept {
+    if (m_bStarted) ::timeEndPeriod(1);
+    m_bStarted = false;
+    if (m_hTimer) {
+        ::CloseHandle(m_hTimer);
+        m_hTimer = nullptr;
+    }
+}
+
+/// <summary>
+/// Sleeps for the specified ticks.
+/// </summary>
+/// <param name="tick">The time in qpc tick.</param>
+/// <returns></returns>
+void LongUI::Helper::FramePacer::sleep_for(int64_t tick) noexcept {
+    // 计时器: 单位100ns, 负数为相对时间
+    if (m_hTimer) {
+        LARGE_INTEGER due; due.QuadPart = -(tick * 10000000 / m_i64Freq);
+        if (due.QuadPart && ::SetWaitableTimer(m_hTimer, &due, 0, nullptr, nullptr, FALSE)) {
+            ::WaitForSingleObject(m_hTimer, INFINITE);
+            return;
+        }
+    }
+    const auto ms = DWORD(tick * 1000 / m_i64Freq);
+    if (ms) ::Sleep(ms);
+}
+
+/// <summary>
+/// Resets the deadline.
+/// </summary>
+/// <returns></returns>
+void LongUI::Helper::FramePacer::Reset() noexcept {
+    m_i64Deadline = FramePacer::now() + m_i64Period;
+    m_uOnTimeStreak = 0;
+}
+
+/// <summary>
+/// Sets the target rate.
+/// </summary>
+/// <param name="hz">The rate in Hz.</param>
+/// <returns>false if rate is 0</returns>
+bool LongUI::Helper::FramePacer::SetTargetRate(uint32_t hz) noexcept {
+    // 无效速率
+    if (!hz) return false;
+    m_uTargetRate = hz;
+    m_uDivider = 1;
+    this->refresh_period();
+    this->Reset();
+    return true;
+}
+
+/// <summary>
+/// Clears the statistics.
+/// </summary>
+/// <returns></returns>
+void LongUI::Helper::FramePacer::ClearStatistics() noexcept {
+    m_i64SumLate = 0;
+    m_i64MaxLate = 0;
+    m_uFrameCount = 0;
+    m_uMissedCount = 0;
+}
+
+/// <summary>
+/// Refreshes the period.
+/// </summary>
+/// <returns></returns>
+void LongUI::Helper::FramePacer::refresh_period() noexcept {
+    m_i64Period = m_i64Freq * int64_t(m_uDivider) / int64_t(m_uTargetRate);
+    // 初始自旋余量: 1.5ms
+    if (!m_i64Spin) m_i64Spin = m_i64Freq * 3 / 2000;
+}
+
+/// <summary>
+/// Waits for next deadline.
+/// </summary>
+/// <returns>false if deadline missed</returns>
+bool LongUI::Helper::FramePacer::Wait() noexcept {
+    ++m_uFrameCount;
+    auto now = FramePacer::now();
+    const auto slack = m_i64Deadline - now;
+    // 错过截止时间
+    if (slack < 0) {
+        const auto late = -slack;
+        ++m_uMissedCount;
+        m_i64SumLate += late;
+        m_i64MaxLate = std::max(m_i64MaxLate, late);
+        // 跳到下一个对齐的截止时间, 不连续补帧
+        m_i64Deadline += (late / m_i64Period + 1) * m_i64Period;
+        this->adapt(true, slack);
+        return false;
+    }
+    // 计时器睡眠, 留下自旋余量
+    if (slack > m_i64Spin) {
+        const auto wait = slack - m_i64Spin;
+        const auto expected = now + wait;
+        this->sleep_for(wait);
+        now = FramePacer::now();
+        // 根据睡过头的时间调整自旋余量(平滑), 限制在 0.25ms-4ms
+        const auto over = std::max(now - expected, int64_t(0));
+        const auto target = over * 3 / 2;
+        m_i64Spin += (target - m_i64Spin) / 8;
+        m_i64Spin = std::min(std::max(m_i64Spin, m_i64Freq / 4000), m_i64Freq / 250);
+    }
+    // 剩余的余量: 让出时间片的自旋
+    while (FramePacer::now() < m_i64Deadline) ::Sleep(0);
+    m_i64Deadline += m_i64Period;
+    this->adapt(false, slack);
+    return true;
+}
+
+/// <summary>
+/// Degrades or recovers the paced rate.
+/// </summary>
+/// <param name="missed">if set to <c>true</c> [missed].</param>
+/// <param name="slack">The slack before waiting.</param>
+/// <returns></returns>
+void LongUI::Helper::FramePacer::adapt(bool missed, int64_t slack) noexcept {
+    // 最近窗口: 16帧
+    constexpr uint32_t RECENT_WINDOW = 16;
+    // 窗口内错过这么多次就降级
+    constexpr uint32_t DEGRADE_MISSED = 4;
+    ++m_uRecentFrame;
+    if (missed) {
+        ++m_uRecentMissed;
+        m_uOnTimeStreak = 0;
+    }
+    // 连续按时且余量充足才尝试恢复
+    else {
+        m_i64MinSlack = m_uOnTimeStreak ? std::min(m_i64MinSlack, slack) : slack;
+        ++m_uOnTimeStreak;
+    }
+    // 降级: 速率减半
+    if (m_uRecentMissed >= DEGRADE_MISSED) {
+        if (m_uDivider < MAX_DIVIDER) {
+            m_uDivider *= 2;
+            this->refresh_period();
+        }
+        m_uRecentMissed = 0;
+        m_uRecentFrame = 0;
+        m_uOnTimeStreak = 0;
+        return;
+    }
+    if (m_uRecentFrame >= RECENT_WINDOW) {
+        m_uRecentMissed = 0;
+        m_uRecentFrame = 0;
+    }
+    // 恢复: 持续约两秒, 而且速率加倍后的周期也能满足
+    if (m_uDivider > 1 && m_uOnTimeStreak >= this->GetPacedRate() * 2) {
+        const auto faster = m_i64Freq * int64_t(m_uDivider / 2) / int64_t(m_uTargetRate);
+        if (m_i64MinSlack > m_i64Period - faster + faster / 4) {
+            m_uDivider /= 2;
+            this->refresh_period();
+        }
+        m_uOnTimeStreak = 0;
+    }
+}
+
 // longui::impl 命名空间
 namespace LongUI { namespace impl { 
     // 申请全局字符串
@@ -238,15 +442,12 @@ namespace LongUI { namespace Helper {
     LongUINoinline auto MakeFloats(const char* str, float fary[], uint32_t size) noexcept -> const char*{
         // 检查字符串
         if (!str || !*str) return str;
-        const char* rcode = str;
-        impl::make_units<','>([&rcode](float* out, const char* begin, const char* end) noexcept {
-            auto len = static_cast<size_t>(end - begin);
-            char buf[128]; assert(len < lengthof(buf));
-            std::memcpy(buf, begin, len); len[buf] = 0;
-            *out = LongUI::AtoF(buf);
-            rcode = end;
-        }, str, fary, size);
-        return rcode;
+        // 直接解析, 无需复制, 缺少的数值保持原值
+        auto last = str;
+        LongUI::ParseFloats(last, str + std::strlen(str), fary, size);
+        // 停在分隔符上
+        if (last != str) while (white_space(*last)) ++last;
+        return last;
     }
     // 创建整数
     LongUINoinline auto MakeInts(const char* str, int iary[], uint32_t size) noexcept -> const char* {
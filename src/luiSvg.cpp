@@ -12,55 +12,11 @@ namespace LongUI {
 
 // longui::impl
 namespace LongUI { namespace impl {
-    // chars array for float
-    const bool FLOAT_CHARS[128] = {
-        0, 0, 0, 0, 0, 0, 0, 0,        0, 0, 0, 0, 0, 0, 0, 0, 
-        0, 0, 0, 0, 0, 0, 0, 0,        0, 0, 0, 0, 0, 0, 0, 0, 
-        0, 0, 0, 0, 0, 0, 0, 0,        0, 0, 0, 1, 0, 1, 1, 0, 
-        1, 1, 1, 1, 1, 1, 1, 1,        1, 1, 0, 0, 0, 0, 0, 0, 
-        0, 0, 0, 0, 0, 1, 0, 0,        0, 0, 0, 0, 0, 0, 0, 0, 
-        0, 0, 0, 0, 0, 0, 0, 0,        0, 0, 0, 0, 0, 0, 0, 0, 
-        0, 0, 0, 0, 0, 1, 0, 0,        0, 0, 0, 0, 0, 0, 0, 0, 
-        0, 0, 0, 0, 0, 0, 0, 0,        0, 0, 0, 0, 0, 0, 0, 0,
-    };
-    // is float char
-    inline bool is_float_char(const char ch) noexcept {
-        return FLOAT_CHARS[uint8_t(ch) & 127];
-    }
-    // parse float
-    auto parse_float(const char* str, float* f, int c) noexcept {
-        // 根据剩余浮点
-        for (int i = 0; i < c; ++i) {
-            bool done = false;
-            const char* begin = str;
-            // 处理字符串
-            while (const auto ch = *str) {
-                // 浮点 -> 切换到浮点处理状态
-                if (impl::is_float_char(ch)) { 
-                    if (!done) {
-                        begin = str;
-                        done = true;
-                    }
-                }
-                // 其他 -> 准备退出
-                else if(done) break;
-                // 推进索引
-                ++str;
-            }
-            // 处理浮点
-            auto f2get = f+i; *f2get = 0.f;
-            size_t len = str - begin;
-            LongUI::SafeBuffer<char>(len + 1, [=](char* buf) noexcept {
-                std::memcpy(buf, begin, len); buf[len] = 0;
-                *f2get = LongUI::AtoF(buf);
-            });
-        }
-        return str;
-    }
-    // parse float
+    // parse floats, svg path allows "1-2" or ".5.5"
     template<int c>
-    inline auto parse_float(const char* str, float* f) noexcept {
-        return parse_float(str, f, c);
+    inline auto parse_float(const char* str, const char* end, float* f) noexcept {
+        LongUI::ParseFloats(str, end, f, c);
+        return str;
     }
 }}
 
@@ -102,6 +58,7 @@ auto LongUI::SVG::ParserPath(
         };
         cbs = { 0.f };
         auto itr = path;
+        const auto end = path + std::strlen(path);
         bool closed = false;
         //bool smooth = false;
         while (const char ch = *itr) {
@@ -110,32 +67,32 @@ auto LongUI::SVG::ParserPath(
             {
             case 'M': org = { 0.f, 0.f }; case 'm':
                 // M = moveto(x, y)
-                itr = impl::parse_float<2>(itr, &cbs.point1.x);
+                itr = impl::parse_float<2>(itr, end, &cbs.point1.x);
                 org += cbs.point1;
                 sink->BeginFigure(org, D2D1_FIGURE_BEGIN_FILLED);
                 closed = false;
                 break;
             case 'L': org = { 0.f, 0.f }; case 'l':
                 //  L = lineto(x, y)
-                itr = impl::parse_float<2>(itr, &cbs.point1.x);
+                itr = impl::parse_float<2>(itr, end, &cbs.point1.x);
                 org += cbs.point1;
                 sink->AddLine(org);
                 break;
             case 'H': org.x = 0.f; case 'h':
                 // H = horizontal lineto(x)
-                itr = impl::parse_float<1>(itr, &cbs.point1.x);
+                itr = impl::parse_float<1>(itr, end, &cbs.point1.x);
                 org.x += cbs.point1.x; 
                 sink->AddLine(org);
                 break;
             case 'V': org.y = 0.f; case 'v':
                 // vertical lineto(y)
-                itr = impl::parse_float<1>(itr, &cbs.point1.x);
+                itr = impl::parse_float<1>(itr, end, &cbs.point1.x);
                 org.y += cbs.point1.x; 
                 sink->AddLine(org);
                 break;
             case 'C': org = { 0.f, 0.f }; case 'c':
                 // C = curveto
-                itr = impl::parse_float<6>(itr, &cbs.point1.x);
+                itr = impl::parse_float<6>(itr, end, &cbs.point1.x);
                 cbs.point1 += org;
                 cbs.point2 += org;
                 cbs.point3 += org;
@@ -148,7 +105,7 @@ auto LongUI::SVG::ParserPath(
                 cbs.point1.x = org.x + org.x - cbs.point2.x;
                 cbs.point1.y = org.y + org.y - cbs.point2.y;
                 if (ch == 'S') org = { 0.f, 0.f };
-                itr = impl::parse_float<4>(itr, &cbs.point2.x);
+                itr = impl::parse_float<4>(itr, end, &cbs.point2.x);
                 cbs.point2 += org;
                 cbs.point3 += org;
                 //if (!smooth) cbs.point1 = cbs.point2;
@@ -158,7 +115,7 @@ auto LongUI::SVG::ParserPath(
                 break;
             case 'Q': org = { 0.f, 0.f }; case 'q':
                 // Q = quadratic Bézier curve
-                itr = impl::parse_float<4>(itr, &qbs.point1.x);
+                itr = impl::parse_float<4>(itr, end, &qbs.point1.x);
                 qbs.point1 += org;
                 qbs.point2 += org;
                 sink->AddQuadraticBezier(&qbs);
@@ -169,7 +126,7 @@ auto LongUI::SVG::ParserPath(
                 qbs.point1.x = org.x + org.x - qbs.point1.x;
                 qbs.point1.y = org.y + org.y - qbs.point1.y;
                 if (ch == 'T') org = { 0.f, 0.f };
-                itr = impl::parse_float<2>(itr, &qbs.point2.x);
+                itr = impl::parse_float<2>(itr, end, &qbs.point2.x);
                 qbs.point2 += org;
                 //if (!smooth) cbs.point1 = cbs.point2;
                 sink->AddQuadraticBezier(&qbs);
@@ -180,8 +137,8 @@ auto LongUI::SVG::ParserPath(
                 //  A rx ry x-axis-rotation large-arc-flag sweep-flag  x  y
                 //  a rx ry x-axis-rotation large-arc-flag sweep-flag dx dy
             {
-                float arcary[7];
-                itr = impl::parse_float<7>(itr, arcary);
+                float arcary[7] = { 0.f };
+                itr = impl::parse_float<7>(itr, end, arcary);
                 D2D1_ARC_SEGMENT arc;
                 arc.size.width = arcary[0];
                 arc.size.height = arcary[1];
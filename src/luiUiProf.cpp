@@ -0,0 +1,395 @@
+﻿#include "Core/luiManager.h"
+#include "Control/UIControl.h"
+#include "LongUI/luiUiProf.h"
+#include "Platonly/luiPoFile.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+#ifdef LONGUI_WITH_CONTROL_PROFILER
+// session, 0 for disabled
+std::atomic<uint32_t> LongUI::CUIControlProfiler::s_uSession(0);
+// last session
+uint32_t LongUI::CUIControlProfiler::s_uLastSession = 0;
+
+// longui::impl 命名空间
+namespace LongUI { namespace impl {
+    // frame in stack
+    struct profiler_frame {
+        // begin tick
+        int64_t         begin;
+        // time of children
+        int64_t         child;
+        // index of stat
+        uint32_t        index;
+    };
+    // trace event
+    struct profiler_event {
+        // begin tick
+        int64_t         begin;
+        // duration tick
+        int64_t         duration;
+        // index of stat
+        uint32_t        index;
+    };
+    // track for one kind
+    struct profiler_track {
+        // size of hash table
+        enum : uint32_t { HASH_SIZE = CUIControlProfiler::MAX_CONTROL * 2 };
+        // stats
+        CUIControlProfiler::Stat    stats[CUIControlProfiler::MAX_CONTROL];
+        // hash table: index + 1 of stat, 0 for empty
+        uint32_t                    table[HASH_SIZE];
+        // stack
+        profiler_frame              stack[LongUITreeMaxDepth];
+        // trace events ring buffer
+        profiler_event*             events;
+        // capacity of events
+        uint32_t                    event_capacity;
+        // count of events written
+        uint32_t                    event_written;
+        // count of stats
+        uint32_t                    count;
+        // depth of stack
+        uint32_t                    depth;
+    };
+    // tracks
+    profiler_track* g_aProfilerTrack[CUIControlProfiler::KIND_COUNT] = { nullptr };
+    // qpc frequency
+    int64_t g_i64ProfilerFreq = 1;
+    // now tick
+    inline auto profiler_now() noexcept { LARGE_INTEGER t; ::QueryPerformanceCounter(&t); return t.QuadPart; }
+    // tick to ms
+    inline auto profiler_ms(int64_t tick) noexcept { return double(tick) * 1e3 / double(g_i64ProfilerFreq); }
+    // copy name
+    inline void profiler_copy(char* dst, const char* src) noexcept {
+        std::strncpy(dst, src, CUIControlProfiler::NAME_LENGTH - 1);
+        dst[CUIControlProfiler::NAME_LENGTH - 1] = 0;
+    }
+    // hash of control
+    inline auto profiler_hash(const UIControl* ctrl) noexcept {
+        const auto mask = profiler_track::HASH_SIZE - 1;
+        return uint32_t((reinterpret_cast<size_t>(ctrl) >> 4) * 2654435761u) & mask;
+    }
+    // lookup stat, return UINT32_MAX if not found
+    auto profiler_lookup(const profiler_track& track, const UIControl* ctrl) noexcept -> uint32_t {
+        const auto mask = profiler_track::HASH_SIZE - 1;
+        // 释放后的控件留在表中(ctrl为空), 继续探测
+        for (auto hash = profiler_hash(ctrl); const auto slot = track.table[hash]; hash = (hash + 1) & mask) {
+            if (track.stats[slot - 1].ctrl == ctrl) return slot - 1;
+        }
+        return UINT32_MAX;
+    }
+    // find stat or add new one, return UINT32_MAX if full
+    auto profiler_find(profiler_track& track, const UIControl* ctrl) noexcept -> uint32_t {
+        const auto mask = profiler_track::HASH_SIZE - 1;
+        auto hash = profiler_hash(ctrl);
+        while (true) {
+            const auto slot = track.table[hash];
+            // 新的控件
+            if (!slot) break;
+            if (track.stats[slot - 1].ctrl == ctrl) return slot - 1;
+            hash = (hash + 1) & mask;
+        }
+        // 满了
+        if (track.count >= CUIControlProfiler::MAX_CONTROL) return UINT32_MAX;
+        const auto index = track.count++;
+        track.table[hash] = index + 1;
+        auto& stat = track.stats[index];
+        std::memset(&stat, 0, sizeof(stat));
+        stat.ctrl = ctrl;
+        // 父控件先开始采样, 已经记录
+        stat.parent = ctrl->parent ? profiler_lookup(track, ctrl->parent) : UINT32_MAX;
+        profiler_copy(stat.name, ctrl->name.c_str());
+        // 类名: 注册的类名, 没有xml节点创建的控件使用"Control"
+        profiler_copy(stat.klass, *ctrl->class_name ? ctrl->class_name : "Control");
+        return index;
+    }
+    // write string to file
+    inline void profiler_write(CUIFile& file, const char* str) noexcept {
+        file.Write(const_cast<char*>(str), uint32_t(std::strlen(str)));
+    }
+    // write control tree, inclusive time, children linked by first/next
+    void profiler_write_tree(
+        CUIFile& file, const profiler_track& track, 
+        const uint32_t* first, const uint32_t* next, 
+        uint32_t index, uint32_t depth
+    ) noexcept {
+        const auto& stat = track.stats[index];
+        char line[LongUIStringBufferLength];
+        const auto indent = int(std::min(depth, 32ui32) * 2);
+        std::snprintf(
+            line, lengthof(line), "%*s%s#%s%s  %.3fms\r\n",
+            indent, "", stat.klass, stat.name, stat.ctrl ? "" : "(released)",
+            profiler_ms(stat.inclusive)
+        );
+        profiler_write(file, line);
+        if (depth >= LongUITreeMaxDepth) return;
+        for (auto i = first[index]; i != UINT32_MAX; i = next[i]) {
+            profiler_write_tree(file, track, first, next, i, depth + 1);
+        }
+    }
+}}
+
+/// <summary>
+/// Enables or disables the profiler.
+/// </summary>
+/// <param name="enable">if set to <c>true</c> [enable].</param>
+/// <param name="trace">The count of trace events kept for each kind.</param>
+/// <returns></returns>
+void LongUI::CUIControlProfiler::Enable(bool enable, uint32_t trace) noexcept {
+    // 更新与渲染线程都不能在采样中
+    CUIDataAutoLocker data_locker;
+    CUIDxgiAutoLocker dxgi_locker;
+    // 之前开始的采样不会再结束在新的轨道上
+    s_uSession = 0;
+    // 释放
+    for (auto& track : impl::g_aProfilerTrack) {
+        if (track) {
+            LongUI::NormalFree(track->events);
+            LongUI::NormalFree(track);
+            track = nullptr;
+        }
+    }
+    if (!enable) return;
+    LARGE_INTEGER freq; ::QueryPerformanceFrequency(&freq);
+    impl::g_i64ProfilerFreq = freq.QuadPart;
+    // 申请
+    for (auto& track : impl::g_aProfilerTrack) {
+        track = LongUI::NormalAllocT<impl::profiler_track>(1);
+        if (!track) break;
+        std::memset(track, 0, sizeof(*track));
+        if (trace) {
+            track->events = LongUI::NormalAllocT<impl::profiler_event>(trace);
+            track->event_capacity = track->events ? trace : 0;
+        }
+    }
+    // 内存不足
+    if (!impl::g_aProfilerTrack[KIND_COUNT - 1]) {
+        UIManager << DL_Error << L"out of memory" << LongUI::endl;
+        return;
+    }
+    if (!++s_uLastSession) ++s_uLastSession;
+    s_uSession = s_uLastSession;
+}
+
+/// <summary>
+/// Clears the samples.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIControlProfiler::Clear() noexcept {
+    CUIDataAutoLocker data_locker;
+    CUIDxgiAutoLocker dxgi_locker;
+    for (auto track : impl::g_aProfilerTrack) {
+        if (!track) continue;
+        // 保留正在采样的栈
+        std::memset(track->stats, 0, sizeof(track->stats));
+        std::memset(track->table, 0, sizeof(track->table));
+        track->count = 0;
+        track->event_written = 0;
+        for (uint32_t i = 0; i < std::min(track->depth, uint32_t(LongUITreeMaxDepth)); ++i) {
+            track->stack[i].index = UINT32_MAX;
+        }
+    }
+}
+
+/// <summary>
+/// Begins sampling the control.
+/// </summary>
+/// <param name="ctrl">The control.</param>
+/// <param name="kind">The kind.</param>
+/// <returns></returns>
+void LongUI::CUIControlProfiler::Begin(const UIControl* ctrl, Kind kind) noexcept {
+    assert(ctrl && kind < KIND_COUNT && "bad argument");
+    if (!impl::g_aProfilerTrack[kind]) return;
+    auto& track = *impl::g_aProfilerTrack[kind];
+    // 太深了, 只计数
+    if (track.depth++ >= LongUITreeMaxDepth) return;
+    auto& frame = track.stack[track.depth - 1];
+    frame.index = impl::profiler_find(track, ctrl);
+    frame.child = 0;
+    frame.begin = impl::profiler_now();
+}
+
+/// <summary>
+/// Ends sampling the control.
+/// </summary>
+/// <param name="kind">The kind.</param>
+/// <param name="session">The session when begin.</param>
+/// <returns></returns>
+void LongUI::CUIControlProfiler::End(Kind kind, uint32_t session) noexcept {
+    const auto now = impl::profiler_now();
+    // Begin()之后重新启用过
+    if (session != CUIControlProfiler::GetSession()) return;
+    if (!impl::g_aProfilerTrack[kind]) return;
+    auto& track = *impl::g_aProfilerTrack[kind];
+    assert(track.depth && "End() without Begin()");
+    if (!track.depth) return;
+    if (--track.depth >= LongUITreeMaxDepth) return;
+    const auto& frame = track.stack[track.depth];
+    const auto duration = now - frame.begin;
+    // 计入父控件的子控件时间
+    if (track.depth) track.stack[track.depth - 1].child += duration;
+    if (frame.index == UINT32_MAX) return;
+    // 统计
+    auto& stat = track.stats[frame.index];
+    stat.inclusive += duration;
+    stat.exclusive += duration - frame.child;
+    ++stat.calls;
+    // 追踪
+    if (track.event_capacity) {
+        auto& event = track.events[track.event_written++ % track.event_capacity];
+        event.begin = frame.begin;
+        event.duration = duration;
+        event.index = frame.index;
+    }
+}
+
+/// <summary>
+/// Forgets the control, stats kept with name only.
+/// </summary>
+/// <param name="ctrl">The control.</param>
+/// <returns></returns>
+void LongUI::CUIControlProfiler::Forget(const UIControl* ctrl) noexcept {
+    if (!CUIControlProfiler::IsEnabled()) return;
+    // 渲染线程可能在采样
+    CUIDxgiAutoLocker dxgi_locker;
+    for (auto track : impl::g_aProfilerTrack) {
+        if (!track) continue;
+        const auto index = impl::profiler_lookup(*track, ctrl);
+        if (index != UINT32_MAX) track->stats[index].ctrl = nullptr;
+    }
+}
+
+/// <summary>
+/// Dumps the text report.
+/// </summary>
+/// <param name="filename">The filename.</param>
+/// <returns></returns>
+bool LongUI::CUIControlProfiler::DumpReport(const wchar_t* filename) noexcept {
+    assert(filename && "bad argument");
+    CUIDataAutoLocker data_locker;
+    CUIDxgiAutoLocker dxgi_locker;
+    if (!impl::g_aProfilerTrack[KIND_COUNT - 1]) return false;
+    CUIFile file(filename, CUIFile::Flag_Write | CUIFile::Flag_CreateAlways);
+    if (!file.IsOk()) return false;
+    // 排序用索引, 以及树的子结点链表
+    auto indices = LongUI::NormalAllocT<uint32_t>(MAX_CONTROL * 3);
+    if (!indices) return false;
+    const auto first = indices + MAX_CONTROL;
+    const auto next = first + MAX_CONTROL;
+    const char* const kind_names[] = { "update", "render" };
+    static_assert(lengthof(kind_names) == KIND_COUNT, "update this");
+    char line[LongUIStringBufferLength];
+    impl::profiler_write(file, "LongUI control profiler report\r\n");
+    for (uint32_t k = 0; k < KIND_COUNT; ++k) {
+        const auto& track = *impl::g_aProfilerTrack[k];
+        std::snprintf(line, lengthof(line), "\r\n==== %s: %u controls ====\r\n", kind_names[k], track.count);
+        impl::profiler_write(file, line);
+        // 按控件, 独占时间降序
+        for (uint32_t i = 0; i < track.count; ++i) indices[i] = i;
+        std::sort(indices, indices + track.count, [&track](uint32_t a, uint32_t b) noexcept {
+            return track.stats[a].exclusive > track.stats[b].exclusive;
+        });
+        impl::profiler_write(file, "-- control --\r\n     calls   incl(ms)   excl(ms)  excl/call(us)  control\r\n");
+        for (uint32_t i = 0; i < track.count; ++i) {
+            const auto& stat = track.stats[indices[i]];
+            std::snprintf(
+                line, lengthof(line), "%10u %10.3f %10.3f %14.2f  %s#%s\r\n",
+                stat.calls, impl::profiler_ms(stat.inclusive), impl::profiler_ms(stat.exclusive),
+                stat.calls ? impl::profiler_ms(stat.exclusive) * 1e3 / double(stat.calls) : 0.0,
+                stat.klass, stat.name
+            );
+            impl::profiler_write(file, line);
+        }
+        // 按类汇总: 按类名稳定排序后分组
+        std::stable_sort(indices, indices + track.count, [&track](uint32_t a, uint32_t b) noexcept {
+            return std::strcmp(track.stats[a].klass, track.stats[b].klass) < 0;
+        });
+        impl::profiler_write(file, "-- class --\r\n     calls   excl(ms)  controls  class\r\n");
+        for (uint32_t i = 0; i < track.count; ) {
+            const auto& stat = track.stats[indices[i]];
+            uint32_t calls = 0, controls = 0; int64_t exclusive = 0;
+            for (; i < track.count; ++i) {
+                const auto& other = track.stats[indices[i]];
+                if (std::strcmp(other.klass, stat.klass)) break;
+                calls += other.calls; exclusive += other.exclusive; ++controls;
+            }
+            std::snprintf(
+                line, lengthof(line), "%10u %10.3f %9u  %s\r\n",
+                calls, impl::profiler_ms(exclusive), controls, stat.klass
+            );
+            impl::profiler_write(file, line);
+        }
+        // 树: 包含时间, 子结点链表保持记录顺序
+        for (uint32_t i = 0; i < track.count; ++i) first[i] = next[i] = UINT32_MAX;
+        for (uint32_t i = track.count; i--; ) {
+            const auto parent = track.stats[i].parent;
+            if (parent < track.count && parent != i) {
+                next[i] = first[parent];
+                first[parent] = i;
+            }
+        }
+        impl::profiler_write(file, "-- tree(inclusive) --\r\n");
+        for (uint32_t i = 0; i < track.count; ++i) {
+            const auto parent = track.stats[i].parent;
+            if (parent >= track.count || parent == i) {
+                impl::profiler_write_tree(file, track, first, next, i, 0);
+            }
+        }
+    }
+    LongUI::NormalFree(indices);
+    return true;
+}
+
+/// <summary>
+/// Dumps the chrome trace-event json.
+/// </summary>
+/// <param name="filename">The filename.</param>
+/// <returns></returns>
+bool LongUI::CUIControlProfiler::DumpTrace(const wchar_t* filename) noexcept {
+    assert(filename && "bad argument");
+    CUIDataAutoLocker data_locker;
+    CUIDxgiAutoLocker dxgi_locker;
+    if (!impl::g_aProfilerTrack[KIND_COUNT - 1]) return false;
+    CUIFile file(filename, CUIFile::Flag_Write | CUIFile::Flag_CreateAlways);
+    if (!file.IsOk()) return false;
+    // 最早的时间作为零点
+    int64_t origin = INT64_MAX;
+    for (auto track : impl::g_aProfilerTrack) {
+        const auto count = std::min(track->event_written, track->event_capacity);
+        for (uint32_t i = 0; i < count; ++i) origin = std::min(origin, track->events[i].begin);
+    }
+    const char* const kind_names[] = { "update", "render" };
+    char line[LongUIStringBufferLength];
+    bool first = true;
+    impl::profiler_write(file, "{\"traceEvents\":[\n");
+    for (uint32_t k = 0; k < KIND_COUNT; ++k) {
+        const auto& track = *impl::g_aProfilerTrack[k];
+        const auto count = std::min(track.event_written, track.event_capacity);
+        // 环形缓冲区中最老的事件
+        const auto start = track.event_written > track.event_capacity ? track.event_written : 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            const auto& event = track.events[(start + i) % track.event_capacity];
+            const auto& stat = track.stats[event.index];
+            // 名称只保留安全字符
+            char name[NAME_LENGTH * 2];
+            std::snprintf(name, lengthof(name), "%s#%s", stat.klass, stat.name);
+            for (auto itr = name; *itr; ++itr) {
+                if (*itr == '"' || *itr == '\\' || uint8_t(*itr) < 0x20) *itr = '_';
+            }
+            std::snprintf(
+                line, lengthof(line),
+                "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                first ? "" : ",\n", name, kind_names[k],
+                impl::profiler_ms(event.begin - origin) * 1e3,
+                impl::profiler_ms(event.duration) * 1e3, k + 1
+            );
+            impl::profiler_write(file, line);
+            first = false;
+        }
+    }
+    impl::profiler_write(file, "\n]}\n");
+    return true;
+}
+#endif
@@ -121,6 +121,7 @@ LongUI::XUIBaseWindow::XUIBaseWindow(const Config::Window& config) noexcept : m_
     // Xml节点
     auto node = config.node;
     m_vTabstops.reserve(32);
+    m_vDirtyControls.reserve(LongUIDirtyRegionSize);
 #ifdef _DEBUG
     m_baBoolWindow.Test<INDEX_COUNT>();
     m_vInsets.push_back(nullptr);
@@ -170,6 +171,11 @@ LongUI::XUIBaseWindow::XUIBaseWindow(const Config::Window& config) noexcept : m_
     if (node.attribute("hidpi").as_bool(true)) {
         this->set_hidpi_supported();
     }
+    // 脏区域: 祖先控件渲染覆盖子孙控件
+    m_oDirty.SetCoverChecker([](void* outer, void* inner) noexcept {
+        const auto ctrl = static_cast<UIControl*>(outer);
+        return ctrl->IsPosterityForSelf(static_cast<UIControl*>(inner));
+    });
 }
 
 
@@ -189,6 +195,7 @@ namespace LongUI {
 LongUI::XUIBaseWindow::~XUIBaseWindow() noexcept {
     for (auto inset : m_vInsets) inset->Dispose();
     for (auto ctrl : m_vTabstops) ctrl->Release();
+    this->release_dirty_controls();
     LongUI::SafeRelease(m_pDragDropControl);
     LongUI::SafeRelease(m_pCapturedControl);
     LongUI::SafeRelease(m_pFocusedControl);
@@ -506,6 +513,11 @@ auto LongUI::XUIBaseWindow::Recreate() noexcept ->HRESULT {
 /// <returns></returns>
 void LongUI::XUIBaseWindow::Update() noexcept {
     assert(m_pViewport && "no viewport");
+    // 树结构修改后刷新树序
+    if (!m_pViewport->IsTreeOrderValid()) {
+        uint32_t index = 0;
+        m_pViewport->RefreshTreeOrder(index);
+    }
     // 清理插入符渲染
     //this->clear_do_caret();
     // 实现
@@ -517,16 +529,66 @@ void LongUI::XUIBaseWindow::Update() noexcept {
     for (auto inset : m_vInsets) {
         inset->Update();
     }
-    // 复制渲染数据以保证数据安全
-    m_uUnitLengthRender = m_uUnitLength;
-    std::memcpy(m_apUnitRender, m_apUnit, sizeof(m_apUnit[0]) * m_uUnitLengthRender);
-    m_baBoolWindow.SetTo<Index_FullRenderThisFrameRender>(this->is_full_render_this_frame());
+    // 脏控件可能在本帧移动或改变大小, 添加最终的可视区域
+    this->resolve_dirty_controls();
+    // 脏区域过大 -> 全渲染
+    if (m_oDirty.IsOverRatio(float(this->GetWidth()), float(this->GetHeight()))) {
+        this->set_full_render_this_frame();
+    }
+    // 构建帧快照, 渲染线程只读取快照
+    auto& frame = this->back_frame();
+    frame.full = this->is_full_render_this_frame();
+    frame.viewport = m_pViewport->world;
+    frame.caret_in = this->is_caret_in();
+    frame.dirty = m_oDirty;
+    if (!frame.full) {
+        auto world = frame.world;
+        for (const auto& unit : frame.dirty) {
+            const auto ctrl = static_cast<UIControl*>(unit.data);
+            *world = ctrl ? ctrl->world : m_pViewport->world;
+            ++world;
+        }
+    }
+    // 需要渲染时复制控件的渲染状态
+    if (frame.full || !frame.dirty.IsEmpty()) {
+        frame.serial = ++m_uFrameSerial;
+        frame.children.clear();
+        m_pViewport->SnapshotRender(frame.children, m_uFrameBack, frame.serial);
+    }
     // 清理老数据
     this->clear_full_render_this_frame(); 
-    m_uUnitLength = 0; 
-#ifdef _DEBUG
-    std::memset(m_apUnit, 0, sizeof(m_apUnit));
-#endif
+    this->release_dirty_controls();
+    m_oDirty.Clear();
+}
+
+/// <summary>
+/// Gets the idle time after last update.
+/// </summary>
+/// <returns>0 for busy, INFINITE for no timer</returns>
+auto LongUI::XUIBaseWindow::GetIdleTime() const noexcept -> uint32_t {
+    // 本帧还有需要渲染的
+    const auto& frame = m_aFrame[m_uFrameBack];
+    if (frame.full || !frame.dirty.IsEmpty()) return 0;
+    // 等待修改大小
+    if (this->is_new_size()) return 0;
+    // 遍历
+    uint32_t time = INFINITE;
+    for (const auto* inset : m_vInsets) {
+        time = std::min(time, inset->GetIdleTime());
+    }
+    return time;
+}
+
+/// <summary>
+/// Publishes the frame snapshot built in last update.
+/// </summary>
+/// <returns></returns>
+void LongUI::XUIBaseWindow::PublishFrame() noexcept {
+    m_uFrameBack ^= 1;
+    // 遍历
+    for (auto inset : m_vInsets) {
+        inset->PublishFrame();
+    }
 }
 
 /// <summary>
@@ -609,6 +671,15 @@ bool LongUI::XUIBaseWindow::DoEvent(const EventArgument& arg) noexcept {
     return m_pViewport->DoEvent(arg);
 }
 
+/// <summary>
+/// Invalidates the whole window in next frame.
+/// </summary>
+/// <returns></returns>
+void LongUI::XUIBaseWindow::InvalidateWindow() noexcept {
+    this->set_full_render_this_frame();
+    UIManager.WakeUp();
+}
+
 /// <summary>
 /// Invalidates the specified control.
 /// </summary>
@@ -621,86 +692,85 @@ void LongUI::XUIBaseWindow::Invalidate(UIControl* ctrl) noexcept {
     // 检查
     ctrl = ctrl->prerender;
     assert(ctrl->prerender == ctrl && "bad argument");
-    // 就是窗口 或者已满?
-    if (ctrl == m_pViewport || m_uUnitLength >= LongUIDirtyControlSize) {
-        assert(m_uUnitLength <= LongUIDirtyControlSize && "check it");
+    // 唤醒帧线程
+    UIManager.WakeUp();
+    // 就是窗口?
+    if (ctrl == m_pViewport) {
         this->set_full_render_this_frame();
         return;
     }
-#ifdef _DEBUG
-    // 调试信息
-    size_t  debug_backup_leng = m_uUnitLength;
-    UIControl*  debug_backup_unit[LongUIDirtyControlSize];
-    std::memcpy(debug_backup_unit, m_apUnit, sizeof(debug_backup_unit));
-#endif
-    // 一次检查
-    bool changed = false;
-    const auto oldenditr = m_apUnit + m_uUnitLength;
-    for (auto itr = m_apUnit; itr < oldenditr; ++itr) {
-        // 已存在的空间
-        auto existd = *itr;
-        // 一样? --> 不干
-        if (existd == ctrl) return void(assert(changed == false));
-        // 存在深度 < 插入深度 -> 检查插入的是否为存在的子孙结点
-        if (existd->level < ctrl->level) {
-            // 是 -> 什么不干
-            if (existd->IsPosterityForSelf(ctrl)) return void(assert(changed == false));
-            // 否 -> 继续
-            else {
-
-            }
-        }
-        // 存在深度 > 插入深度 -> 检查存在的是否为插入的子孙结点
-        else if (existd->level > ctrl->level) {
-            // 是 -> 替换所有
-            if (ctrl->IsPosterityForSelf(existd)) {
-                *itr = nullptr;
-                changed = true;
-            }
-            // 否 -> 继续
-            else {
-
-            }
-        }
-        // 深度一致 -> 继续
-        else {
-
-        }
-    }
 #ifdef _DEBUG
     if (m_pViewport->debug_this) {
         UIManager << DL_Log << L"[INSERT]: " << ctrl << LongUI::endl;
     }
 #endif
-    // 二次插入
-    if (changed) {
-        // 重置
-        m_uUnitLength = 0;
-        // 只写迭代器
-        auto witr = m_apUnit;
-        // 只读迭代器
-        auto ritr = m_apUnit;
-        for (; ritr < oldenditr; ++ritr) {
-            if (*ritr) {
-                *witr = *ritr;
-                ++witr;
-                ++m_uUnitLength;
-            }
-        }
+    // 添加到脏区域: 当前的可视区域, 移动后旧区域也需要重绘
+    RectLTRB_F rect;
+    rect.left = ctrl->visible_rect.left;
+    rect.top = ctrl->visible_rect.top;
+    rect.right = ctrl->visible_rect.right;
+    rect.bottom = ctrl->visible_rect.bottom;
+    m_oDirty.AddRect(rect, ctrl);
+    // 收集时再添加最终的可视区域
+    if (!ctrl->TestWindowState() && m_vDirtyControls.isok()) {
+        ctrl->SetWindowState(true);
+        ctrl->AddRef();
+        m_vDirtyControls.push_back(ctrl);
     }
-#ifdef _DEBUG
-    // 断言调试
-    {
-        auto endt = m_apUnit + m_uUnitLength;
-        assert(std::find(m_apUnit, endt, ctrl) == endt);
-        std::for_each(m_apUnit, endt, [ctrl](UIControl* tmpc) noexcept {
-            assert(tmpc->IsPosterityForSelf(ctrl) == false && "bad ship");
-            assert(ctrl->IsPosterityForSelf(tmpc) == false && "bad ship");
-        });
+}
+
+/// <summary>
+/// Adds final visible rects of invalidated controls into
+/// dirty region, layout may changed after invalidating.
+/// </summary>
+/// <returns></returns>
+void LongUI::XUIBaseWindow::resolve_dirty_controls() noexcept {
+    // 全渲染不需要
+    if (this->is_full_render_this_frame()) return;
+    for (auto ctrl : m_vDirtyControls) {
+        RectLTRB_F rect;
+        rect.left = ctrl->visible_rect.left;
+        rect.top = ctrl->visible_rect.top;
+        rect.right = ctrl->visible_rect.right;
+        rect.bottom = ctrl->visible_rect.bottom;
+        m_oDirty.AddRect(rect, ctrl);
     }
-#endif
-    // 添加到最后
-    m_apUnit[m_uUnitLength++] = ctrl;
+}
+
+/// <summary>
+/// Releases the invalidated controls.
+/// </summary>
+/// <returns></returns>
+void LongUI::XUIBaseWindow::release_dirty_controls() noexcept {
+    for (auto ctrl : m_vDirtyControls) {
+        ctrl->SetWindowState(false);
+        ctrl->Release();
+    }
+    m_vDirtyControls.clear();
+}
+
+/// <summary>
+/// Invalidates part of the specified control, rect clipped by
+/// visible rect of control, e.g. caret or selection overlay.
+/// </summary>
+/// <param name="ctrl">The control.</param>
+/// <param name="rect">The rect in window space.</param>
+/// <returns></returns>
+void LongUI::XUIBaseWindow::InvalidateRect(UIControl* ctrl, const RectLTRB_F& rect) noexcept {
+    assert(ctrl && "bad argument");
+    // 已经全渲染?
+    if (this->is_full_render_this_frame()) return;
+    ctrl = ctrl->prerender;
+    // 裁剪到可视区域
+    RectLTRB_F clip;
+    clip.left = std::max(rect.left, ctrl->visible_rect.left);
+    clip.top = std::max(rect.top, ctrl->visible_rect.top);
+    clip.right = std::min(rect.right, ctrl->visible_rect.right);
+    clip.bottom = std::min(rect.bottom, ctrl->visible_rect.bottom);
+    if (clip.left >= clip.right || clip.top >= clip.bottom) return;
+    // 唤醒帧线程
+    UIManager.WakeUp();
+    m_oDirty.AddRect(clip, ctrl);
 }
 
 
@@ -732,6 +802,8 @@ namespace LongUI {
     private:
         // release data for this
         void release_data() noexcept;
+        // render rect of caret in next frame
+        void invalidate_caret(UIControl* ctrl) noexcept;
         // is direct composition
         bool is_direct_composition() const noexcept { return true; }
         // get dxgi swapeffect
@@ -746,8 +818,12 @@ namespace LongUI {
         virtual void Dispose() noexcept { delete this; };
         // render 
         virtual void Render() const noexcept override;
+        // wait for swap chain
+        virtual void WaitForRender() const noexcept override;
         // update 
         virtual void Update() noexcept override;
+        // get idle time
+        virtual auto GetIdleTime() const noexcept ->uint32_t override;
         // close window
         virtual void Close() noexcept { ::PostMessageW(m_hwnd, WM_CLOSE, 0, 0); };
         // recreate
@@ -982,6 +1058,8 @@ bool LongUI::CUIBuiltinSystemWindow::MessageHandle(
             m_rcCaret.right = 0.f;
             // 检查属性
             close_window = this->is_close_on_focus_killed();
+            // 唤醒帧线程
+            UIManager.WakeUp();
         }
         // 失去焦点即关闭窗口
         if (close_window) {
@@ -993,6 +1071,7 @@ bool LongUI::CUIBuiltinSystemWindow::MessageHandle(
     // --------------------------  字符输入
     auto on_char = [this, wParam]() noexcept {
         CUIDataAutoLocker locker;
+        UIManager.WakeUp();
         if (m_pFocusedControl) {
             auto ch = static_cast<char16_t>(wParam);
             EventArgument arg;
@@ -1094,6 +1173,7 @@ bool LongUI::CUIBuiltinSystemWindow::MessageHandle(
         // 键入字符
     {
         CUIDataAutoLocker locker;
+        UIManager.WakeUp();
         if (m_pFocusedControl) {
             EventArgument arg;
             arg.sender = m_pViewport;
@@ -1150,6 +1230,7 @@ bool LongUI::CUIBuiltinSystemWindow::MessageHandle(
             float y = ydpi / float(LongUI::BASIC_DPI);
             CUIDataAutoLocker locker;
             m_pViewport->SetZoom(x, y);
+            UIManager.WakeUp();
         }
         return true;
     default:
@@ -1159,6 +1240,8 @@ bool LongUI::CUIBuiltinSystemWindow::MessageHandle(
     {
         // 加锁
         CUIDataAutoLocker locker;
+        // 唤醒帧线程
+        UIManager.WakeUp();
         // 设置鼠标位置
         ma.ptx = this->last_point.x;
         ma.pty = this->last_point.y;
@@ -1190,6 +1273,7 @@ void LongUI::CUIBuiltinSystemWindow::Resize(uint32_t w, uint32_t h) noexcept {
         m_szNew.width = w;
         m_szNew.height = h;
         this->set_new_size();
+        UIManager.WakeUp();
     }
 }
 
@@ -1481,18 +1565,26 @@ void LongUI::CUIBuiltinSystemWindow::Update() noexcept {
     if (m_tmCaret.Update() && m_pFocusedControl) {
         // 反转插入符号
         this->change_caret_in();
-#if 0
-        // 不显示插入符号时候刷新显示焦点控件
-        if (m_pFocusedControl && !this->is_caret_in()) {
-            m_pFocusedControl->InvalidateThis();
-        }
-#else
-        // 刷新显示焦点控件
-        if (m_rcCaret.right > 0.f) {
-            m_pFocusedControl->InvalidateThis();
-        }
-#endif
+        // 仅刷新插入符号区域
+        this->invalidate_caret(m_pFocusedControl);
+    }
+    // 插入符号快照
+    auto& frame = this->back_frame();
+    frame.caret = m_rcCaret;
+    frame.caret_in = this->is_caret_in();
+}
+
+/// <summary>
+/// Gets the idle time after last update.
+/// </summary>
+/// <returns></returns>
+auto LongUI::CUIBuiltinSystemWindow::GetIdleTime() const noexcept -> uint32_t {
+    auto time = Super::GetIdleTime();
+    // 插入符号闪烁
+    if (time && m_pFocusedControl && m_rcCaret.right > 0.f) {
+        time = std::min(time, m_tmCaret.GetRemain());
     }
+    return time;
 }
 
 /// <summary>
@@ -1510,7 +1602,7 @@ void LongUI::CUIBuiltinSystemWindow::BeginRender() const noexcept {
 #if 0
     UIManager_RenderTarget->SetTransform(DX::Matrix3x2F::Identity());
 #else
-    UIManager_RenderTarget->SetTransform(&m_pViewport->world);
+    UIManager_RenderTarget->SetTransform(&this->front_frame().viewport);
 #endif
     // 清空背景
     UIManager_RenderTarget->Clear(this->clear_color);
@@ -1521,11 +1613,12 @@ void LongUI::CUIBuiltinSystemWindow::BeginRender() const noexcept {
 /// </summary>
 /// <returns></returns>
 void LongUI::CUIBuiltinSystemWindow::EndRender() const noexcept {
+    const auto& frame = this->front_frame();
     // 渲染插入符号
-    if (this->is_caret_in() && m_rcCaret.right != 0.f) {
+    if (frame.caret_in && frame.caret.right != 0.f) {
         constexpr auto mode = D2D1_ANTIALIAS_MODE_ALIASED;
         UIManager_RenderTarget->SetTransform(DX::Matrix3x2F::Identity());
-        UIManager_RenderTarget->PushAxisAlignedClip(&m_rcCaret, mode);
+        UIManager_RenderTarget->PushAxisAlignedClip(&frame.caret, mode);
         UIManager_RenderTarget->Clear(D2D1::ColorF(D2D1::ColorF::Black));
         UIManager_RenderTarget->PopAxisAlignedClip();
     }
@@ -1534,7 +1627,7 @@ void LongUI::CUIBuiltinSystemWindow::EndRender() const noexcept {
     hr = S_OK;
     {
         // 全渲染
-        if (this->is_full_render_this_frame_render()) {
+        if (frame.full) {
             hr = m_pSwapChain->Present(0, 0);
             //if (hr == DXGI_ERROR_WAS_STILL_DRAWING) hr = S_FALSE;
             // 呈现
@@ -1544,21 +1637,20 @@ void LongUI::CUIBuiltinSystemWindow::EndRender() const noexcept {
         else {
             // 呈现参数设置
             RECT scroll = { 0, 0, this->GetWidth(), this->GetHeight() };
-            RECT rects[LongUIDirtyControlSize];
+            RECT rects[LongUIDirtyRegionSize];
             DXGI_PRESENT_PARAMETERS present_parameters;
-            present_parameters.DirtyRectsCount = m_uUnitLengthRender;
+            present_parameters.DirtyRectsCount = frame.dirty.GetCount();
             present_parameters.pDirtyRects = rects;
             present_parameters.pScrollRect = &scroll;
             present_parameters.pScrollOffset = nullptr;
             // 设置参数
-            auto control = m_apUnitRender;
-            for (auto itr = rects; itr < rects + m_uUnitLengthRender; ++itr) {
-                const auto& vrt = (*control)->visible_rect;
-                itr->left = static_cast<LONG>(vrt.left);
-                itr->top = static_cast<LONG>(vrt.top);
-                itr->right = static_cast<LONG>(std::ceil(vrt.right));
-                itr->bottom = static_cast<LONG>(std::ceil(vrt.bottom));
-                ++control;
+            auto itr = rects;
+            for (const auto& unit : frame.dirty) {
+                itr->left = static_cast<LONG>(unit.rect.left);
+                itr->top = static_cast<LONG>(unit.rect.top);
+                itr->right = static_cast<LONG>(std::ceil(unit.rect.right));
+                itr->bottom = static_cast<LONG>(std::ceil(unit.rect.bottom));
+                ++itr;
             }
             // 提交
             hr = m_pSwapChain->Present1(0, 0, &present_parameters);
@@ -1582,7 +1674,7 @@ void LongUI::CUIBuiltinSystemWindow::EndRender() const noexcept {
     }
     assert(SUCCEEDED(hr));
     // 调试
-    if (this->is_full_render_this_frame_render()) {
+    if (frame.full) {
         ++force_cast(full_render_counter);
     }
     else {
@@ -1596,7 +1688,7 @@ void LongUI::CUIBuiltinSystemWindow::EndRender() const noexcept {
         m_strTitle.c_str(),
         int(full_render_counter),
         int(dirty_render_counter),
-        int(m_uUnitLengthRender)
+        int(frame.dirty.GetCount())
     );
     // 设置显示
     UIManager.DxgiUnlock();
@@ -1617,32 +1709,49 @@ void LongUI::CUIBuiltinSystemWindow::EndRender() const noexcept {
 }
 
 /// <summary>
-/// Renders this instance.
+/// Waits for swap chain before rendering.
 /// </summary>
 /// <returns></returns>
-void LongUI::CUIBuiltinSystemWindow::Render() const noexcept {
+void LongUI::CUIBuiltinSystemWindow::WaitForRender() const noexcept {
     // 跳过渲染?
     if (this->is_skip_render()) return;
+    const auto& frame = this->front_frame();
     // 无需渲染?
-    if (!this->is_full_render_this_frame_render() && !m_uUnitLengthRender) return;
+    if (!frame.full && frame.dirty.IsEmpty()) return;
     // 等待
     ::WaitForSingleObjectEx(m_hVSync, 100, true);
+}
+
+/// <summary>
+/// Renders this instance.
+/// </summary>
+/// <returns></returns>
+void LongUI::CUIBuiltinSystemWindow::Render() const noexcept {
+    // 跳过渲染?
+    if (this->is_skip_render()) return;
+    const auto& frame = this->front_frame();
+    // 无需渲染?
+    if (!frame.full && frame.dirty.IsEmpty()) return;
     // 开始渲染
     this->BeginRender();
     // 全渲染
-    if (this->is_full_render_this_frame_render()) {
+    if (frame.full) {
         // 实现
         m_pViewport->Render();
     }
     // 脏渲染
     else {
-        auto init_transfrom = DX::Matrix3x2F::Identity();
+        auto world = frame.world;
         // 遍历
-        for (auto itr = m_apUnitRender; itr < m_apUnitRender + m_uUnitLengthRender; ++itr) {
-            auto ctrl = *itr; assert(ctrl != m_pViewport && "check the code");
+        for (const auto& unit : frame.dirty) {
+            const auto& rect = unit.rect;
+            D2D1_RECT_F clip = { rect.left, rect.top, rect.right, rect.bottom };
             UIManager_RenderTarget->SetTransform(DX::Matrix3x2F::Identity());
-            UIManager_RenderTarget->PushAxisAlignedClip(&ctrl->visible_rect, D2D1_ANTIALIAS_MODE_ALIASED);
-            UIManager_RenderTarget->SetTransform(&ctrl->world);
+            UIManager_RenderTarget->PushAxisAlignedClip(&clip, D2D1_ANTIALIAS_MODE_ALIASED);
+            // 合并的区域: 裁剪渲染整个窗口
+            auto ctrl = static_cast<UIControl*>(unit.data);
+            if (!ctrl) ctrl = m_pViewport;
+            UIManager_RenderTarget->SetTransform(world++);
             // 渲染背景笔刷?
             /*if (ctrl->backgroud != ctrl && ctrl->backgroud) {
                 auto bk = ctrl->backgroud;
@@ -1650,8 +1759,8 @@ void LongUI::CUIBuiltinSystemWindow::Render() const noexcept {
                 bk->RenderBackgroudBrush();
                 UIManager_RenderTarget->SetTransform(&ctrl->world);
             }*/
-            // 正常渲染
-            ctrl->Render();
+            // 正常渲染, 跳过快照时已经移出控件树的
+            if (ctrl->RefRenderState().serial == frame.serial) ctrl->Render();
             // 回来
             UIManager_RenderTarget->PopAxisAlignedClip();
         }
@@ -1736,6 +1845,8 @@ void LongUI::CUIBuiltinSystemWindow::SetCaret(UIControl* ctrl, const RectLTWH_F*
         // 位置差不多
         auto xyabs = std::abs(oldx - pt.x) + std::abs(oldy - pt.y);
         if (xyabs < 1.f) return;
+        // 刷新旧位置
+        this->invalidate_caret(ctrl);
         // 继续计算
         m_rcCaret.left = pt.x;
         m_rcCaret.top = pt.y;
@@ -1748,6 +1859,7 @@ void LongUI::CUIBuiltinSystemWindow::SetCaret(UIControl* ctrl, const RectLTWH_F*
         m_rcCaret.bottom=  std::min(ctrl->visible_rect.bottom, m_rcCaret.bottom);
         // 刷新显示
         this->set_caret_in();
+        this->invalidate_caret(ctrl);
         // 重置定时器
         m_tmCaret.Reset();
     }
@@ -1761,6 +1873,21 @@ void LongUI::CUIBuiltinSystemWindow::SetCaret(UIControl* ctrl, const RectLTWH_F*
     }
 }
 
+/// <summary>
+/// Invalidates the rect of caret, aligned to pixel.
+/// </summary>
+/// <param name="ctrl">The control of caret.</param>
+/// <returns></returns>
+void LongUI::CUIBuiltinSystemWindow::invalidate_caret(UIControl* ctrl) noexcept {
+    if (!ctrl || m_rcCaret.right <= 0.f) return;
+    RectLTRB_F rect;
+    rect.left = std::floor(m_rcCaret.left) - 1.f;
+    rect.top = std::floor(m_rcCaret.top) - 1.f;
+    rect.right = std::ceil(m_rcCaret.right) + 1.f;
+    rect.bottom = std::ceil(m_rcCaret.bottom) + 1.f;
+    this->InvalidateRect(ctrl, rect);
+}
+
 
 /// <summary>
 /// Initializes a new instance of the <see cref="CUIBuiltinSystemWindow"/> class.
@@ -264,4 +264,7 @@ LongUI::CUIManager          LongUI::CUIManager::s_instance;
 #pragma comment(lib, "D3D11")
 #pragma comment(lib, "Mfplat")
 #pragma comment(lib, "Dwmapi")
+#ifdef LONGUI_WITH_LZ4_UNDO
+#pragma comment(lib, "lz4")
+#endif
 #endif